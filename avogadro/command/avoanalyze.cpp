@@ -0,0 +1,202 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+#include <avogadro/core/elements.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/structureanalysis.h>
+#include <avogadro/core/version.h>
+#include <avogadro/io/fileformatmanager.h>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Real;
+using Avogadro::Io::FileFormatManager;
+using Avogadro::Core::Elements;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::StructureAnalysis;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+void printHelp();
+
+namespace {
+typedef std::pair<unsigned char, unsigned char> ElementPair;
+
+string pairName(const ElementPair& pair)
+{
+  return string(Elements::symbol(pair.first)) + "-" +
+         Elements::symbol(pair.second);
+}
+
+// Parse a list of pairs such as "Na-Cl,Cl-Cl".
+bool parsePairs(const string& list, vector<ElementPair>& pairs)
+{
+  std::istringstream stream(list);
+  string name;
+  while (getline(stream, name, ',')) {
+    size_t dash = name.find('-');
+    if (dash == string::npos)
+      return false;
+    unsigned char a = Elements::atomicNumberFromSymbol(name.substr(0, dash));
+    unsigned char b = Elements::atomicNumberFromSymbol(name.substr(dash + 1));
+    if (a == Avogadro::InvalidElement || b == Avogadro::InvalidElement)
+      return false;
+    pairs.push_back(ElementPair(a, b));
+  }
+  return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+  // Process the command line arguments, see what has been requested.
+  string inFormat;
+  string inFile;
+  string pairList;
+  Real cutoff = 10.0;
+  Real binWidth = 0.05;
+  int threads = 0;
+  bool msd = false;
+  for (int i = 1; i < argc; ++i) {
+    string current(argv[i]);
+    if (current == "--help" || current == "-h") {
+      printHelp();
+      return 0;
+    } else if (current == "--version" || current == "-v") {
+      cout << "Version: " << Avogadro::version() << endl;
+      return 0;
+    } else if (current == "-i" && i + 1 < argc) {
+      inFormat = argv[++i];
+    } else if (current == "-r" && i + 1 < argc) {
+      cutoff = atof(argv[++i]);
+    } else if (current == "-w" && i + 1 < argc) {
+      binWidth = atof(argv[++i]);
+    } else if (current == "-p" && i + 1 < argc) {
+      pairList = argv[++i];
+    } else if (current == "-j" && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+    } else if (current == "--msd") {
+      msd = true;
+    } else if (inFile.empty()) {
+      inFile = argv[i];
+    }
+  }
+
+  if (inFile.empty()) {
+    printHelp();
+    return 1;
+  }
+  vector<ElementPair> pairs;
+  if (!parsePairs(pairList, pairs)) {
+    cout << "Error, the pairs must be given as <element>-<element>,..."
+         << endl;
+    return 1;
+  }
+
+  FileFormatManager& mgr = FileFormatManager::instance();
+  Molecule mol;
+  if (!mgr.readFile(mol, inFile, inFormat)) {
+    cout << "Failed to read " << inFile << " (" << inFormat << ")" << endl;
+    return 1;
+  }
+
+  StructureAnalysis analysis;
+  analysis.setCutoff(cutoff);
+  analysis.setBinWidth(binWidth);
+  analysis.setMaxThreads(threads);
+  if (!analysis.analyze(mol)) {
+    cout << "Error, the analysis failed. The molecule needs atoms, and the "
+            "cutoff and bin width must be positive."
+         << endl;
+    return 1;
+  }
+
+  const vector<unsigned char>& elements = analysis.elements();
+  cout << std::fixed << std::setprecision(6);
+  if (msd) {
+    cout << "# frame msd";
+    vector<vector<Real>> columns(1, analysis.msd());
+    for (size_t i = 0; i < elements.size(); ++i) {
+      cout << " msd(" << Elements::symbol(elements[i]) << ")";
+      columns.push_back(analysis.msd(elements[i]));
+    }
+    cout << "\n";
+    for (Index f = 0; f < analysis.frameCount(); ++f) {
+      cout << f;
+      for (size_t c = 0; c < columns.size(); ++c)
+        cout << " " << columns[c][f];
+      cout << "\n";
+    }
+    return 0;
+  }
+
+  // By default, every pair of elements.
+  if (pairs.empty()) {
+    for (size_t i = 0; i < elements.size(); ++i) {
+      for (size_t j = i; j < elements.size(); ++j)
+        pairs.push_back(ElementPair(elements[i], elements[j]));
+    }
+  }
+
+  // The g(r) of each pair, and the running coordination numbers around each
+  // of its elements.
+  cout << "# " << analysis.frameCount() << " frames\n# r g(all)";
+  vector<vector<Real>> columns(1, analysis.rdf());
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    const ElementPair& pair = pairs[i];
+    ElementPair reverse(pair.second, pair.first);
+    cout << " g(" << pairName(pair) << ") n(" << pairName(pair) << ")";
+    columns.push_back(analysis.rdf(pair.first, pair.second));
+    columns.push_back(analysis.coordination(pair.first, pair.second));
+    if (pair.first != pair.second) {
+      cout << " n(" << pairName(reverse) << ")";
+      columns.push_back(analysis.coordination(pair.second, pair.first));
+    }
+  }
+  cout << "\n";
+  for (Index bin = 0; bin < analysis.binCount(); ++bin) {
+    cout << analysis.binCenter(bin);
+    // A pair with a missing element has empty columns.
+    for (size_t c = 0; c < columns.size(); ++c)
+      cout << " " << (columns[c].empty() ? 0.0 : columns[c][bin]);
+    cout << "\n";
+  }
+
+  return 0;
+}
+
+void printHelp()
+{
+  cout << "Usage: avoanalyze [-i <input-type>] [-r <cutoff>] [-w <bin-width>] "
+          "[-p <pairs>]\n"
+          "                  [-j <threads>] [--msd] <infilename>\n\n"
+          "Computes the radial distribution functions g(r) and running "
+          "coordination\nnumbers n(r) over all the frames of the input file, "
+          "up to the cutoff (10\nAngstrom by default) in bins of the given "
+          "width (0.05 by default). The pairs\nof elements are given as e.g. "
+          "Na-Cl,Cl-Cl, every pair is reported by default.\nWith --msd, the "
+          "mean-square displacement from the first frame is reported\n"
+          "instead, for all atoms and for each element.\n"
+       << endl;
+}
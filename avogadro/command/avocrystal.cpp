@@ -0,0 +1,477 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+#include <avogadro/core/crystaltools.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/spacegroups.h>
+#include <avogadro/core/version.h>
+#include <avogadro/io/fileformatmanager.h>
+
+#ifdef USE_LIBSPG
+#include <avogadro/core/avospglib.h>
+#endif
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Io::FileFormatManager;
+using Avogadro::Core::CrystalTools;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::SpaceGroups;
+#ifdef USE_LIBSPG
+using Avogadro::Matrix3;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::AvoSpglib;
+#endif
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+void printHelp();
+
+namespace {
+enum StepType
+{
+  Wrap,
+  Niggli,
+  Orient,
+  Primitive,
+  Conventional,
+  Symmetrize,
+  DetectSpaceGroup,
+  Fill,
+  AsymmetricUnit
+};
+
+struct Step
+{
+  const char* name;
+  StepType type;
+  bool needsSpglib;
+  const char* description;
+};
+
+const Step availableSteps[] = {
+  { "wrap", Wrap, false, "wrap the atoms into the unit cell" },
+  { "niggli", Niggli, false, "Niggli-reduce the unit cell" },
+  { "orient", Orient, false, "rotate to the standard orientation" },
+  { "primitive", Primitive, true, "reduce to the primitive cell" },
+  { "conventional", Conventional, true, "refine to the conventional cell" },
+  { "symmetrize", Symmetrize, true, "idealize the primitive cell" },
+  { "spacegroup", DetectSpaceGroup, true, "detect the space group" },
+  { "fill", Fill, true, "fill the unit cell from the space group" },
+  { "asymmetric", AsymmetricUnit, true, "reduce to the asymmetric unit" }
+};
+const size_t availableStepCount =
+  sizeof(availableSteps) / sizeof(availableSteps[0]);
+
+// The outcome of processing one file.
+struct Result
+{
+  Result()
+    : read(false), failedStep(-1), written(false), hallNumber(0), atoms(0)
+  {
+  }
+
+  bool read;
+  // The position of the failed step in the pipeline, -1 if none failed.
+  int failedStep;
+  bool written;
+  unsigned short hallNumber;
+  Index atoms;
+};
+
+#ifdef USE_LIBSPG
+// True if the operations spglib found for the cell are those of its Hall
+// number. The operations of a Hall number only apply to a cell in its
+// setting, not e.g. to the primitive cell of a centered space group.
+bool inHallSetting(const AvoSpglib::Dataset& dataset)
+{
+  Array<Matrix3> rotations;
+  Array<Vector3> translations;
+  if (!SpaceGroups::getOperations(dataset.hallNumber, rotations,
+                                  translations) ||
+      rotations.size() != dataset.rotations.size()) {
+    return false;
+  }
+  const double fractionalTol = 1e-3;
+  for (size_t i = 0; i < dataset.rotations.size(); ++i) {
+    bool found = false;
+    for (size_t j = 0; j < rotations.size() && !found; ++j) {
+      Vector3 shift = dataset.translations[i] - translations[j];
+      for (int k = 0; k < 3; ++k)
+        shift[k] -= std::floor(shift[k] + 0.5);
+      found = (dataset.rotations[i] - rotations[j]).cwiseAbs().maxCoeff() <
+                fractionalTol &&
+              shift.cwiseAbs().maxCoeff() < fractionalTol;
+    }
+    if (!found)
+      return false;
+  }
+  return true;
+}
+#endif
+
+// Run a step of the pipeline on the molecule. The Hall number of the cell is
+// detected by the spacegroup step, or by the steps using it if not known. It
+// is reset by the steps changing the cell, as its setting may change.
+bool runStep(const Step& step, Molecule& mol, double tolerance,
+             unsigned short& hallNumber)
+{
+  bool ok = false;
+  switch (step.type) {
+    case Wrap:
+      return CrystalTools::wrapAtomsToUnitCell(mol);
+    case Niggli:
+      ok = CrystalTools::niggliReduce(mol, CrystalTools::TransformAtoms);
+      break;
+    case Orient:
+      ok = CrystalTools::rotateToStandardOrientation(
+        mol, CrystalTools::TransformAtoms);
+      break;
+#ifdef USE_LIBSPG
+    case Primitive:
+      ok = AvoSpglib::reduceToPrimitive(mol, tolerance);
+      break;
+    case Conventional:
+      ok = AvoSpglib::conventionalizeCell(mol, tolerance);
+      break;
+    case Symmetrize:
+      ok = AvoSpglib::symmetrize(mol, tolerance);
+      break;
+    case DetectSpaceGroup:
+      hallNumber = AvoSpglib::getHallNumber(mol, tolerance);
+      return hallNumber != 0;
+    case Fill:
+    case AsymmetricUnit:
+      if (hallNumber == 0) {
+        AvoSpglib::Dataset dataset;
+        if (!AvoSpglib::getDataset(mol, dataset, tolerance) ||
+            !inHallSetting(dataset)) {
+          return false;
+        }
+        hallNumber = dataset.hallNumber;
+      }
+      if (step.type == Fill)
+        SpaceGroups::fillUnitCell(mol, hallNumber, tolerance);
+      else
+        SpaceGroups::reduceToAsymmetricUnit(mol, hallNumber, tolerance);
+      return true;
+#endif
+    default:
+      AVO_UNUSED(tolerance);
+      return false;
+  }
+  hallNumber = 0;
+  return ok;
+}
+
+// The file name without its directory and last extension.
+string baseName(const string& fileName)
+{
+  size_t slash = fileName.find_last_of("/\\");
+  string name = slash == string::npos ? fileName : fileName.substr(slash + 1);
+  size_t dot = name.find_last_of('.');
+  return dot == string::npos || dot == 0 ? name : name.substr(0, dot);
+}
+
+// The format of an input file from its extension, or from its name if it has
+// none, e.g. POSCAR.
+string formatFromFileName(const string& fileName)
+{
+  size_t slash = fileName.find_last_of("/\\");
+  string name = slash == string::npos ? fileName : fileName.substr(slash + 1);
+  size_t dot = name.find_last_of('.');
+  return dot == string::npos ? name : name.substr(dot + 1);
+}
+
+// Create the directory, unless it exists already.
+bool makeDirectory(const string& dir)
+{
+#ifdef _WIN32
+  if (_mkdir(dir.c_str()) == 0)
+    return true;
+#else
+  if (mkdir(dir.c_str(), 0777) == 0)
+    return true;
+#endif
+  struct stat info;
+  return stat(dir.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
+}
+
+// The output file of each input file, named after the input file. Inputs
+// sharing a name, e.g. POSCAR files in different directories, are numbered.
+vector<string> outputFileNames(const vector<string>& inFiles,
+                               const string& outDir, const string& outFormat)
+{
+  std::map<string, int> nameCount;
+  vector<string> names(inFiles.size());
+  for (size_t i = 0; i < inFiles.size(); ++i) {
+    names[i] = baseName(inFiles[i]);
+    ++nameCount[names[i]];
+  }
+  string prefix = outDir.empty() ? string() : outDir + "/";
+  for (size_t i = 0; i < inFiles.size(); ++i) {
+    std::ostringstream name;
+    name << prefix << names[i];
+    if (nameCount[names[i]] > 1)
+      name << "_" << i + 1;
+    name << "." << outFormat;
+    names[i] = name.str();
+  }
+  return names;
+}
+}
+
+int main(int argc, char* argv[])
+{
+  // Process the command line arguments, see what has been requested.
+  string inFormat;
+  string outFormat;
+  string outDir;
+  string stepList;
+  vector<string> inFiles;
+  double tolerance = 1e-5;
+  int threads = 0;
+  bool quiet = false;
+  for (int i = 1; i < argc; ++i) {
+    string current(argv[i]);
+    if (current == "--help" || current == "-h") {
+      printHelp();
+      return 0;
+    } else if (current == "--version" || current == "-v") {
+      cout << "Version: " << Avogadro::version() << endl;
+      return 0;
+    } else if (current == "-i" && i + 1 < argc) {
+      inFormat = argv[++i];
+    } else if (current == "-o" && i + 1 < argc) {
+      outFormat = argv[++i];
+    } else if (current == "-d" && i + 1 < argc) {
+      outDir = argv[++i];
+    } else if (current == "-s" && i + 1 < argc) {
+      stepList = argv[++i];
+    } else if (current == "-t" && i + 1 < argc) {
+      tolerance = atof(argv[++i]);
+    } else if (current == "-j" && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+    } else if (current == "-f" && i + 1 < argc) {
+      // Read the input file names from a list, one per line.
+      std::ifstream list(argv[++i]);
+      if (!list) {
+        cout << "Error, failed to read the file list " << argv[i] << endl;
+        return 1;
+      }
+      string line;
+      while (getline(list, line)) {
+        if (!line.empty())
+          inFiles.push_back(line);
+      }
+    } else if (current == "-q") {
+      quiet = true;
+    } else {
+      inFiles.push_back(current);
+    }
+  }
+
+  // Set up the pipeline.
+  vector<const Step*> pipeline;
+  std::istringstream steps(stepList);
+  string stepName;
+  while (getline(steps, stepName, ',')) {
+    if (stepName.empty())
+      continue;
+    const Step* step = nullptr;
+    for (size_t i = 0; i < availableStepCount; ++i) {
+      if (stepName == availableSteps[i].name)
+        step = &availableSteps[i];
+    }
+    if (!step) {
+      cout << "Error, unknown step " << stepName << endl;
+      return 1;
+    }
+#ifndef USE_LIBSPG
+    if (step->needsSpglib) {
+      cout << "Error, the " << stepName << " step needs spglib support."
+           << endl;
+      return 1;
+    }
+#endif
+    pipeline.push_back(step);
+  }
+
+  if (inFiles.empty()) {
+    printHelp();
+    return 1;
+  }
+  if (tolerance <= 0.0) {
+    cout << "Error, the tolerance must be positive." << endl;
+    return 1;
+  }
+  if (!outDir.empty() && outFormat.empty())
+    outFormat = "cjson";
+  if (!outDir.empty() && !makeDirectory(outDir)) {
+    cout << "Error, failed to create the output directory " << outDir << endl;
+    return 1;
+  }
+  vector<string> outFiles;
+  if (!outFormat.empty())
+    outFiles = outputFileNames(inFiles, outDir, outFormat);
+
+  // The formats are registered before the threads start, the manager is only
+  // read from then on.
+  FileFormatManager& mgr = FileFormatManager::instance();
+
+  // Hand out the files one by one, as the time taken varies a lot between
+  // structures.
+  if (threads <= 0)
+    threads = static_cast<int>(std::thread::hardware_concurrency());
+  threads = std::max(threads, 1);
+  threads = std::min(threads, static_cast<int>(inFiles.size()));
+  vector<Result> results(inFiles.size());
+  std::atomic<size_t> nextFile(0);
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  auto work = [&]() {
+    for (size_t i = nextFile++; i < inFiles.size(); i = nextFile++) {
+      Result& result = results[i];
+      Molecule mol;
+      string format =
+        inFormat.empty() ? formatFromFileName(inFiles[i]) : inFormat;
+      if (!mgr.readFile(mol, inFiles[i], format))
+        continue;
+      result.read = true;
+      // The space group reported is the last one detected.
+      unsigned short hallNumber = 0;
+      for (size_t s = 0; s < pipeline.size() && result.failedStep < 0; ++s) {
+        if (!runStep(*pipeline[s], mol, tolerance, hallNumber))
+          result.failedStep = static_cast<int>(s);
+        if (hallNumber != 0)
+          result.hallNumber = hallNumber;
+      }
+      result.atoms = mol.atomCount();
+      if (result.failedStep < 0 && !outFiles.empty())
+        result.written = mgr.writeFile(mol, outFiles[i], outFormat);
+    }
+  };
+  vector<std::thread> workers;
+  for (int t = 1; t < threads; ++t)
+    workers.push_back(std::thread(work));
+  work();
+  for (size_t t = 0; t < workers.size(); ++t)
+    workers[t].join();
+  double seconds = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+
+  // Report the results in the order of the input files.
+  size_t readFailures = 0;
+  size_t writeFailures = 0;
+  size_t succeeded = 0;
+  size_t atoms = 0;
+  vector<size_t> stepFailures(pipeline.size(), 0);
+  for (size_t i = 0; i < inFiles.size(); ++i) {
+    const Result& result = results[i];
+    string status = "ok";
+    if (!result.read) {
+      status = "read failed";
+      ++readFailures;
+    } else if (result.failedStep >= 0) {
+      status = string(pipeline[result.failedStep]->name) + " failed";
+      ++stepFailures[result.failedStep];
+    } else if (!outFiles.empty() && !result.written) {
+      status = "write failed";
+      ++writeFailures;
+    } else {
+      ++succeeded;
+    }
+    atoms += result.atoms;
+    if (quiet)
+      continue;
+    cout << inFiles[i] << "\t" << status << "\t" << result.atoms;
+    if (result.hallNumber != 0) {
+      cout << "\t" << SpaceGroups::internationalNumber(result.hallNumber)
+           << "\t" << SpaceGroups::international(result.hallNumber);
+    }
+    cout << "\n";
+  }
+  cout.flush();
+
+  cerr << "Processed " << inFiles.size() << " files with " << threads
+       << " threads in " << std::fixed << std::setprecision(2) << seconds
+       << " s (" << std::setprecision(1)
+       << inFiles.size() / std::max(seconds, 1e-9) << " files/s, "
+       << atoms / std::max(seconds, 1e-9) << " atoms/s)" << endl;
+  cerr << "  Succeeded: " << succeeded << endl;
+  cerr << "  Failed to read: " << readFailures << endl;
+  for (size_t s = 0; s < pipeline.size(); ++s) {
+    cerr << "  Failed " << pipeline[s]->name << " (step " << s + 1
+         << "): " << stepFailures[s] << endl;
+  }
+  if (!outFiles.empty())
+    cerr << "  Failed to write: " << writeFailures << endl;
+
+  return succeeded == inFiles.size() ? 0 : 1;
+}
+
+void printHelp()
+{
+  cout << "Usage: avocrystal [-i <input-type>] [-s <step,...>] "
+          "[-t <tolerance>]\n"
+          "                  [-o <output-type>] [-d <dir>] [-j <threads>] "
+          "[-q]\n"
+          "                  [-f <listfile>] [<infilename> ...]\n\n"
+          "Runs a sequence of crystal operations on each input file, on "
+          "several threads.\nThe files are given on the command line or listed "
+          "one per line in <listfile>.\nWith -o or -d the results are written "
+          "to <dir>, named after the input files,\ncreating <dir> if needed. A "
+          "line per file with its status, atom count and space\ngroup (if "
+          "detected) is printed unless "
+          "-q is given, followed by statistics\non standard error.\n\n"
+          "The steps are applied in the given order, -t is the cartesian "
+          "tolerance in\nAngstrom used by spglib. The fill and asymmetric "
+          "steps fail unless the cell is\nin the setting of its space group, "
+          "e.g. after the conventional step:\n";
+  for (size_t i = 0; i < availableStepCount; ++i) {
+    cout << "  " << std::left << std::setw(14) << availableSteps[i].name
+         << availableSteps[i].description;
+#ifndef USE_LIBSPG
+    if (availableSteps[i].needsSpglib)
+      cout << " (needs spglib)";
+#endif
+    cout << "\n";
+  }
+  cout << endl;
+}
@@ -0,0 +1,269 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+#include <avogadro/core/version.h>
+
+#include <qtaimcriticalpointlocator.h>
+#include <qtaimcubature.h>
+#include <qtaimprogress.h>
+#include <qtaimwavefunction.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Avogadro::QtPlugins::QTAIMCriticalPointLocator;
+using Avogadro::QtPlugins::QTAIMCubature;
+using Avogadro::QtPlugins::QTAIMDensityGrid;
+using Avogadro::QtPlugins::QTAIMProgress;
+using Avogadro::QtPlugins::QTAIMWavefunction;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+void printHelp();
+
+namespace {
+std::mutex outputMutex;
+
+// Prints the stages of the analysis of a file to the standard error.
+class StageReporter : public QTAIMProgress
+{
+public:
+  explicit StageReporter(const string& fileName) : m_fileName(fileName) {}
+
+  void begin(const QString& stage, int steps) override
+  {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    cerr << m_fileName << ": " << stage.toStdString() << " (" << steps
+         << " steps)" << endl;
+  }
+  void update(int) override {}
+  bool isCanceled() const override { return false; }
+
+private:
+  string m_fileName;
+};
+
+QJsonArray toJson(const QVector3D& point)
+{
+  QJsonArray array;
+  array.append(point.x());
+  array.append(point.y());
+  array.append(point.z());
+  return array;
+}
+
+QJsonObject analyze(const string& fileName, bool charges,
+                    QTAIMDensityGrid::Accuracy accuracy, bool verbose)
+{
+  QJsonObject result;
+  result["file"] = QString::fromStdString(fileName);
+
+  QTAIMWavefunction wfn;
+  if (!wfn.initializeWithWFNFile(QString::fromStdString(fileName))) {
+    result["error"] = QString("Cannot read the wavefunction.");
+    return result;
+  }
+
+  StageReporter reporter(fileName);
+  QTAIMProgress* progress = verbose ? &reporter : nullptr;
+
+  QTAIMCriticalPointLocator cpl(wfn);
+  cpl.setProgress(progress);
+  cpl.locateNuclearCriticalPoints();
+  cpl.locateBondCriticalPoints();
+
+  QJsonArray nuclei;
+  QList<QVector3D> ncpList = cpl.nuclearCriticalPoints();
+  QList<qint64> nuclearCharges = wfn.nuclearChargesList();
+  for (int i = 0; i < ncpList.size(); ++i) {
+    QJsonObject nucleus;
+    nucleus["position"] = toJson(ncpList.at(i));
+    if (i < nuclearCharges.size())
+      nucleus["charge"] = nuclearCharges.at(i);
+    nuclei.append(nucleus);
+  }
+  result["nuclearCriticalPoints"] = nuclei;
+
+  QJsonArray bonds;
+  QList<QVector3D> bcpList = cpl.bondCriticalPoints();
+  QList<QList<QVector3D>> bondPaths = cpl.bondPaths();
+  QList<QPair<qint64, qint64>> bondedAtoms = cpl.bondedAtoms();
+  QList<qreal> laplacians = cpl.laplacianAtBondCriticalPoints();
+  QList<qreal> ellipticities = cpl.ellipticityAtBondCriticalPoints();
+  for (int i = 0; i < bcpList.size(); ++i) {
+    QJsonObject bond;
+    bond["position"] = toJson(bcpList.at(i));
+    QJsonArray atoms;
+    atoms.append(bondedAtoms.at(i).first);
+    atoms.append(bondedAtoms.at(i).second);
+    bond["atoms"] = atoms;
+    bond["laplacian"] = laplacians.at(i);
+    bond["ellipticity"] = ellipticities.at(i);
+    QJsonArray path;
+    for (int j = 0; j < bondPaths.at(i).size(); ++j)
+      path.append(toJson(bondPaths.at(i).at(j)));
+    bond["path"] = path;
+    bonds.append(bond);
+  }
+  result["bondCriticalPoints"] = bonds;
+
+  if (charges) {
+    QList<qint64> basins;
+    for (qint64 i = 0; i < ncpList.size(); ++i)
+      basins.append(i);
+
+    QTAIMCubature cub(wfn);
+    cub.setAccuracy(accuracy);
+    cub.setProgress(progress);
+    QList<QPair<qreal, qreal>> integrals = cub.integrate(0, basins);
+
+    QJsonArray basinArray;
+    for (int i = 0; i < integrals.size(); ++i) {
+      QJsonObject basin;
+      basin["population"] = integrals.at(i).first;
+      basin["error"] = integrals.at(i).second;
+      if (i < nuclearCharges.size())
+        basin["charge"] = nuclearCharges.at(i) - integrals.at(i).first;
+      basinArray.append(basin);
+    }
+    result["atomicBasins"] = basinArray;
+  }
+
+  return result;
+}
+}
+
+int main(int argc, char* argv[])
+{
+  // Process the command line arguments, see what has been requested.
+  vector<string> inFiles;
+  string outFile;
+  string accuracyName = "analytic";
+  int jobs = QThread::idealThreadCount();
+  bool charges = false;
+  bool verbose = false;
+  for (int i = 1; i < argc; ++i) {
+    string current(argv[i]);
+    if (current == "--help" || current == "-h") {
+      printHelp();
+      return 0;
+    } else if (current == "--version" || current == "-v") {
+      cout << "Version: " << Avogadro::version() << endl;
+      return 0;
+    } else if (current == "-o" && i + 1 < argc) {
+      outFile = argv[++i];
+    } else if (current == "-a" && i + 1 < argc) {
+      accuracyName = argv[++i];
+    } else if (current == "-j" && i + 1 < argc) {
+      jobs = atoi(argv[++i]);
+    } else if (current == "--charges") {
+      charges = true;
+    } else if (current == "--verbose") {
+      verbose = true;
+    } else {
+      inFiles.push_back(current);
+    }
+  }
+
+  if (inFiles.empty()) {
+    printHelp();
+    return 1;
+  }
+
+  QTAIMDensityGrid::Accuracy accuracy;
+  if (accuracyName == "analytic") {
+    accuracy = QTAIMDensityGrid::Analytic;
+  } else if (accuracyName == "coarse") {
+    accuracy = QTAIMDensityGrid::Coarse;
+  } else if (accuracyName == "medium") {
+    accuracy = QTAIMDensityGrid::Medium;
+  } else if (accuracyName == "fine") {
+    accuracy = QTAIMDensityGrid::Fine;
+  } else {
+    cerr << "Error, unknown accuracy " << accuracyName << endl;
+    return 1;
+  }
+
+  // Each worker takes the next file until none is left. The stages of a file
+  // run on the Qt thread pool, the workers mostly wait for them.
+  vector<QJsonObject> results(inFiles.size());
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < inFiles.size(); i = next++)
+      results[i] = analyze(inFiles[i], charges, accuracy, verbose);
+  };
+  size_t numWorkers = static_cast<size_t>(jobs > 0 ? jobs : 1);
+  numWorkers = std::min(numWorkers, inFiles.size());
+  vector<std::thread> threads;
+  for (size_t i = 1; i < numWorkers; ++i)
+    threads.push_back(std::thread(worker));
+  worker();
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i].join();
+
+  QJsonArray array;
+  bool success = true;
+  for (size_t i = 0; i < results.size(); ++i) {
+    success = success && !results[i].contains("error");
+    array.append(results[i]);
+  }
+  QByteArray json = QJsonDocument(array).toJson();
+
+  if (outFile.empty()) {
+    cout << json.constData();
+  } else {
+    QFile file(QString::fromStdString(outFile));
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size()) {
+      cerr << "Error, cannot write to " << outFile << endl;
+      return 1;
+    }
+  }
+
+  return success ? 0 : 1;
+}
+
+void printHelp()
+{
+  cout << "Usage: avoqtaim [-o <outfilename>] [-j <jobs>] [--charges] "
+          "[-a <accuracy>]\n"
+          "                [--verbose] <infilename> ...\n\n"
+          "Locates the nuclear and bond critical points of the electron "
+          "density of each\nwavefunction (.wfn) file, with the bond paths, "
+          "and writes them as JSON, to the\nstandard output by default. "
+          "Positions are in bohr. The files are processed\nin parallel, "
+          "up to <jobs> at a time.\n\n"
+          "With --charges, the electron density is also integrated over the "
+          "atomic basins,\nwhich gives the atomic charges. The gradient paths "
+          "of the integration are\ntraced analytically, or on a coarse, "
+          "medium or fine density grid with -a.\n"
+          "With --verbose, the stages of the analysis are reported to the "
+          "standard error.\n"
+       << endl;
+}
@@ -0,0 +1,389 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/version.h>
+#include <avogadro/io/fileformatmanager.h>
+#include <avogadro/qtgui/sceneplugin.h>
+#include <avogadro/qtopengl/qttextrenderstrategy.h>
+#include <avogadro/qtplugins/pluginmanager.h>
+#include <avogadro/rendering/ambientocclusionspheregeometry.h>
+#include <avogadro/rendering/cylindergeometry.h>
+#include <avogadro/rendering/geometrynode.h>
+#include <avogadro/rendering/glrenderer.h>
+#include <avogadro/rendering/groupnode.h>
+#include <avogadro/rendering/spheregeometry.h>
+#include <avogadro/rendering/visitor.h>
+
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QStringList>
+#include <QtGui/QImage>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLFramebufferObject>
+#include <QtWidgets/QApplication>
+
+#include <iostream>
+#include <string>
+#include <typeinfo>
+
+using Avogadro::Io::FileFormatManager;
+using Avogadro::Core::Molecule;
+using Avogadro::QtGui::ScenePlugin;
+using Avogadro::QtGui::ScenePluginFactory;
+using Avogadro::QtOpenGL::QtTextRenderStrategy;
+using Avogadro::QtPlugins::PluginManager;
+using Avogadro::Rendering::AmbientOcclusionSphereGeometry;
+using Avogadro::Rendering::CylinderGeometry;
+using Avogadro::Rendering::Drawable;
+using Avogadro::Rendering::GeometryNode;
+using Avogadro::Rendering::GLRenderer;
+using Avogadro::Rendering::GroupNode;
+using Avogadro::Rendering::Node;
+using Avogadro::Rendering::SphereGeometry;
+using Avogadro::Rendering::Visitor;
+using std::cout;
+using std::endl;
+using std::string;
+
+void printHelp();
+
+namespace {
+// Upper bound on the frames rendered to let progressive effects converge.
+const int maxRefinementFrames = 100;
+
+// Move the data of a drawable into one of the same type, which keeps its
+// buffers and shader program. The types that cannot are left untouched.
+class DrawableUpdater : public Visitor
+{
+public:
+  explicit DrawableUpdater(Drawable& next) : m_next(next), m_updated(false) {}
+
+  void visit(SphereGeometry& current) override { update(current); }
+  void visit(AmbientOcclusionSphereGeometry& current) override
+  {
+    update(current);
+  }
+  void visit(CylinderGeometry& current) override { update(current); }
+
+  bool updated() const { return m_updated; }
+
+private:
+  template <typename T>
+  void update(T& current)
+  {
+    if (typeid(current) != typeid(m_next))
+      return;
+    // The swap only exchanges the data, and marks both drawables dirty. The
+    // parents are swapped too, they are set again by the caller.
+    using std::swap;
+    swap(current, static_cast<T&>(m_next));
+    m_updated = true;
+  }
+
+  Drawable& m_next;
+  bool m_updated;
+};
+
+void updateGeometry(GeometryNode& current, GeometryNode& next)
+{
+  std::vector<Drawable*> drawables;
+  drawables.swap(current.drawables());
+  std::vector<Drawable*>& nextDrawables = next.drawables();
+  for (size_t i = 0; i < drawables.size(); ++i) {
+    DrawableUpdater updater(*nextDrawables[i]);
+    drawables[i]->accept(updater);
+    if (!updater.updated()) {
+      // Other drawables are replaced.
+      delete drawables[i];
+      drawables[i] = nextDrawables[i];
+      nextDrawables[i] = nullptr;
+    }
+    current.addDrawable(drawables[i]);
+  }
+}
+
+// Update the nodes of @p current to those of @p next, built for the next
+// image. Where both have the same structure the drawables of @p current are
+// kept, and take the data of those of @p next, so that they are not compiled
+// and uploaded again for each image. Elsewhere the nodes of @p next are moved
+// into @p current.
+void updateScene(GroupNode& current, GroupNode& next)
+{
+  std::vector<Node*>& children = current.children();
+  std::vector<Node*>& nextChildren = next.children();
+  size_t i = 0;
+  for (; i < children.size() && i < nextChildren.size(); ++i) {
+    children[i]->setVisible(nextChildren[i]->isVisible());
+    GroupNode* group = children[i]->cast<GroupNode>();
+    GroupNode* nextGroup = nextChildren[i]->cast<GroupNode>();
+    if (group && nextGroup) {
+      updateScene(*group, *nextGroup);
+      continue;
+    }
+    GeometryNode* geometry = children[i]->cast<GeometryNode>();
+    GeometryNode* nextGeometry = nextChildren[i]->cast<GeometryNode>();
+    if (geometry && nextGeometry &&
+        geometry->drawables().size() == nextGeometry->drawables().size()) {
+      updateGeometry(*geometry, *nextGeometry);
+      continue;
+    }
+    break;
+  }
+
+  // The rest differs, it is replaced.
+  while (children.size() > i) {
+    Node* child = children.back();
+    current.removeChild(child);
+    delete child;
+  }
+  while (nextChildren.size() > i) {
+    Node* child = nextChildren[i];
+    next.removeChild(child);
+    current.addChild(child);
+  }
+}
+
+// Build the scene for the molecule as the GLWidget does, reusing the
+// drawables of the previous image.
+void buildScene(const Molecule& mol, GLRenderer& renderer,
+                const QList<ScenePlugin*>& plugins)
+{
+  GroupNode next;
+  GroupNode* moleculeNode = new GroupNode(&next);
+  foreach (ScenePlugin* plugin, plugins) {
+    GroupNode* engineNode = new GroupNode(moleculeNode);
+    plugin->process(mol, *engineNode);
+  }
+  updateScene(renderer.scene().rootNode(), next);
+}
+
+// Render the scene into the bound framebuffer object and save it.
+bool renderImage(GLRenderer& renderer, QOpenGLFramebufferObject& fbo,
+                 const QString& fileName)
+{
+  fbo.bind();
+  renderer.render();
+  for (int i = 0; renderer.isRefining() && i < maxRefinementFrames; ++i)
+    renderer.render();
+
+  QImage image = fbo.toImage();
+  if (!image.save(fileName, "PNG")) {
+    cout << "Failed to write " << fileName.toStdString() << endl;
+    return false;
+  }
+  return true;
+}
+
+// Insert the frame number before the extension, e.g. movie_0012.png.
+QString frameFileName(const QString& fileName, int frame, int frames)
+{
+  QFileInfo info(fileName);
+  int width = QString::number(frames).size();
+  QString number = QString("%1").arg(frame + 1, width, 10, QChar('0'));
+  return info.dir().filePath(info.completeBaseName() + "_" + number + "." +
+                             info.suffix());
+}
+}
+
+int main(int argc, char* argv[])
+{
+  // The offscreen platform avoids the need for a display, it can be changed
+  // with the usual -platform argument.
+  if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  QApplication app(argc, argv);
+
+  // Process the command line arguments, see what has been requested.
+  string inFormat;
+  QString outFile;
+  QString outDir;
+  QStringList inFiles;
+  QStringList pluginNames;
+  int width = 512;
+  int height = 512;
+  int samples = 4;
+  bool frames = false;
+  bool listPlugins = false;
+  QStringList args = app.arguments();
+  for (int i = 1; i < args.size(); ++i) {
+    QString current(args[i]);
+    if (current == "--help" || current == "-h") {
+      printHelp();
+      return 0;
+    } else if (current == "--version" || current == "-v") {
+      cout << "Version: " << Avogadro::version() << endl;
+      return 0;
+    } else if (current == "-i" && i + 1 < args.size()) {
+      inFormat = args[++i].toStdString();
+    } else if (current == "-o" && i + 1 < args.size()) {
+      outFile = args[++i];
+    } else if (current == "-d" && i + 1 < args.size()) {
+      outDir = args[++i];
+    } else if (current == "--size" && i + 1 < args.size()) {
+      QStringList size = args[++i].split('x');
+      width = size.size() == 2 ? size[0].toInt() : 0;
+      height = size.size() == 2 ? size[1].toInt() : 0;
+    } else if (current == "--samples" && i + 1 < args.size()) {
+      samples = args[++i].toInt();
+    } else if (current == "--plugins" && i + 1 < args.size()) {
+      pluginNames = args[++i].split(',', QString::SkipEmptyParts);
+    } else if (current == "--frames") {
+      frames = true;
+    } else if (current == "--list-plugins") {
+      listPlugins = true;
+    } else if (current.startsWith("-")) {
+      cout << "Error, unknown option " << current.toStdString() << "."
+           << endl;
+      printHelp();
+      return 1;
+    } else {
+      inFiles << current;
+    }
+  }
+
+  if (width <= 0 || height <= 0) {
+    cout << "Error, the image size must be given as <width>x<height>." << endl;
+    return 1;
+  }
+
+  // Create the scene plugins, either the requested ones or those enabled by
+  // default.
+  PluginManager* plugins = PluginManager::instance();
+  plugins->load();
+  QList<ScenePlugin*> scenePlugins;
+  foreach (ScenePluginFactory* factory,
+           plugins->pluginFactories<ScenePluginFactory>()) {
+    ScenePlugin* plugin = factory->createInstance();
+    if (listPlugins) {
+      cout << factory->identifier().toStdString() << ": "
+           << plugin->name().toStdString() << endl;
+    }
+    bool enabled = pluginNames.isEmpty()
+                     ? plugin->isEnabled()
+                     : pluginNames.contains(plugin->name()) ||
+                         pluginNames.contains(factory->identifier());
+    if (enabled) {
+      plugin->setEnabled(true);
+      scenePlugins << plugin;
+    } else {
+      delete plugin;
+    }
+  }
+  if (listPlugins)
+    return 0;
+
+  if (inFiles.isEmpty()) {
+    printHelp();
+    return 1;
+  }
+  if (!outFile.isEmpty() && inFiles.size() > 1) {
+    cout << "Error, -o can only be used with a single input file." << endl;
+    return 1;
+  }
+
+  // Set up a single context and framebuffer, reused for every image.
+  QSurfaceFormat format;
+  format.setDepthBufferSize(24);
+  QOffscreenSurface surface;
+  surface.setFormat(format);
+  surface.create();
+  QOpenGLContext context;
+  context.setFormat(format);
+  if (!context.create() || !context.makeCurrent(&surface)) {
+    cout << "Error, failed to create an OpenGL context." << endl;
+    return 1;
+  }
+
+  QOpenGLFramebufferObjectFormat fboFormat;
+  fboFormat.setAttachment(QOpenGLFramebufferObject::Depth);
+  fboFormat.setSamples(samples);
+  QOpenGLFramebufferObject fbo(width, height, fboFormat);
+  if (!fbo.isValid()) {
+    cout << "Error, failed to create the framebuffer object." << endl;
+    return 1;
+  }
+
+  GLRenderer renderer;
+  renderer.initialize();
+  if (!renderer.isValid()) {
+    cout << "Error, " << renderer.error() << endl;
+    return 1;
+  }
+  renderer.resize(width, height);
+  renderer.setTextRenderStrategy(new QtTextRenderStrategy);
+
+  FileFormatManager& mgr = FileFormatManager::instance();
+  int failures = 0;
+  foreach (const QString& inFile, inFiles) {
+    Molecule mol;
+    if (!mgr.readFile(mol, inFile.toStdString(), inFormat)) {
+      cout << "Failed to read " << inFile.toStdString() << " (" << inFormat
+           << ")" << endl;
+      ++failures;
+      continue;
+    }
+
+    QString fileName = outFile;
+    if (fileName.isEmpty())
+      fileName = QFileInfo(inFile).completeBaseName() + ".png";
+    if (!outDir.isEmpty())
+      fileName = QDir(outDir).filePath(QFileInfo(fileName).fileName());
+
+    int frameCount = frames ? mol.coordinate3dCount() : 0;
+    if (frameCount < 2) {
+      buildScene(mol, renderer, scenePlugins);
+      renderer.resetCamera();
+      if (!renderImage(renderer, fbo, fileName))
+        ++failures;
+      continue;
+    }
+
+    // Keep the camera of the first frame, so that the frames line up.
+    for (int frame = 0; frame < frameCount; ++frame) {
+      mol.setCoordinate3d(frame);
+      buildScene(mol, renderer, scenePlugins);
+      if (frame == 0)
+        renderer.resetCamera();
+      else
+        renderer.resetGeometry();
+      if (!renderImage(renderer, fbo, frameFileName(fileName, frame,
+                                                    frameCount))) {
+        ++failures;
+        break;
+      }
+    }
+  }
+
+  // Release the GL resources while the context is still current.
+  renderer.scene().clear();
+  qDeleteAll(scenePlugins);
+
+  return failures == 0 ? 0 : 1;
+}
+
+void printHelp()
+{
+  cout << "Usage: avorender [-i <input-type>] [-o <outfilename>] [-d <dir>] "
+          "[--size <width>x<height>]\n"
+          "                 [--samples <n>] [--plugins <name,...>] "
+          "[--frames] [--list-plugins]\n"
+          "                 <infilename> [<infilename> ...]\n\n"
+          "Renders each input file offscreen to a PNG image, named after the "
+          "input file\nunless -o is given. With --frames every coordinate set "
+          "of a trajectory is\nrendered to a numbered image.\n"
+       << endl;
+}
@@ -0,0 +1,280 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "adaptivecube.h"
+
+#include "molecule.h"
+#include "mutex.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Avogadro {
+namespace Core {
+
+namespace {
+// The top nodes of the octree span 2^octreeLevels bricks along each axis.
+const int octreeLevels = 2;
+
+// The number of samples along each edge of a node, to judge whether a surface
+// may pass through it.
+const int nodeSamples = 3;
+
+// A node is refined when its samples reach this fraction of the isovalue,
+// unless they all exceed it by insideFactor with the same sign, deep inside a
+// lobe.
+const double nearFraction = 0.2;
+const double insideFactor = 5.0;
+
+// A function evaluation is worth many elementary operations.
+const Index evaluationCost = 1 << 10;
+}
+
+const int AdaptiveCube::brickCells;
+const int AdaptiveCube::brickPoints;
+
+AdaptiveCube::AdaptiveCube()
+  : m_min(0.0, 0.0, 0.0), m_spacing(0.0, 0.0, 0.0), m_points(0, 0, 0),
+    m_bricks(0, 0, 0), m_iso(0.0), m_minValue(0.0), m_maxValue(0.0),
+    m_lock(new Mutex)
+{
+}
+
+AdaptiveCube::~AdaptiveCube()
+{
+  delete m_lock;
+  m_lock = nullptr;
+}
+
+bool AdaptiveCube::setLimits(const Vector3& min_, const Vector3i& dim,
+                             double spacing_)
+{
+  if (spacing_ <= 0.0 || dim.minCoeff() < 2)
+    return false;
+
+  m_min = min_;
+  m_spacing = Vector3(spacing_, spacing_, spacing_);
+  for (int i = 0; i < 3; ++i) {
+    m_bricks[i] = (dim[i] - 2) / brickCells + 1;
+    m_points[i] = m_bricks[i] * brickCells + 1;
+  }
+  m_centers.clear();
+  m_brickIndices.assign(static_cast<size_t>(m_bricks.prod()), -1);
+  m_activeBricks.clear();
+  m_data.clear();
+  m_iso = m_minValue = m_maxValue = 0.0;
+  return true;
+}
+
+bool AdaptiveCube::setLimits(const Molecule& mol, double spacing_,
+                             double padding)
+{
+  if (spacing_ <= 0.0)
+    return false;
+  const Array<Vector3>& positions = mol.atomPositions3d();
+  Vector3 min_ = Vector3::Zero();
+  Vector3 max_ = Vector3::Zero();
+  if (!positions.empty()) {
+    min_ = max_ = positions[0];
+    for (size_t i = 1; i < positions.size(); ++i) {
+      min_ = min_.cwiseMin(positions[i]);
+      max_ = max_.cwiseMax(positions[i]);
+    }
+  }
+  min_ -= Vector3(padding, padding, padding);
+  max_ += Vector3(padding, padding, padding);
+
+  Vector3i dim;
+  for (int i = 0; i < 3; ++i)
+    dim[i] = static_cast<int>(std::ceil((max_[i] - min_[i]) / spacing_)) + 1;
+  if (!setLimits(min_, dim, spacing_))
+    return false;
+  m_centers.assign(positions.begin(), positions.end());
+  return true;
+}
+
+bool AdaptiveCube::evaluate(const Function& function, double iso)
+{
+  if (!function || iso <= 0.0 || m_bricks.minCoeff() < 1)
+    return false;
+  m_iso = iso;
+
+  // The top nodes are refined in parallel, each marks its own bricks.
+  const int topSize = 1 << octreeLevels;
+  const Vector3i nodes = (m_bricks + Vector3i::Constant(topSize - 1)) / topSize;
+  std::vector<char> active(m_brickIndices.size(), 0);
+  const Index nodeCost =
+    evaluationCost * nodeSamples * nodeSamples * nodeSamples;
+  parallelFor(static_cast<Index>(nodes.prod()), nodeCost,
+              [&](Index first, Index last) {
+                for (Index n = first; n < last; ++n) {
+                  const int i = static_cast<int>(n);
+                  Vector3i node(i / (nodes.y() * nodes.z()),
+                                i / nodes.z() % nodes.y(), i % nodes.z());
+                  refine(function, node * topSize, octreeLevels, active);
+                }
+              });
+
+  m_activeBricks.clear();
+  for (size_t i = 0; i < active.size(); ++i) {
+    m_brickIndices[i] = -1;
+    if (active[i]) {
+      const int n = static_cast<int>(i);
+      m_brickIndices[i] = static_cast<int>(m_activeBricks.size());
+      m_activeBricks.push_back(Vector3i(n / (m_bricks.y() * m_bricks.z()),
+                                        n / m_bricks.z() % m_bricks.y(),
+                                        n % m_bricks.z()));
+    }
+  }
+
+  m_data.assign(m_activeBricks.size() * brickPoints, 0.0);
+  parallelFor(m_activeBricks.size(), evaluationCost * brickPoints,
+              [&](Index first, Index last) {
+                for (Index n = first; n < last; ++n)
+                  evaluateBrick(function, n);
+              });
+
+  m_minValue = m_maxValue = 0.0;
+  if (!m_data.empty()) {
+    m_minValue = *std::min_element(m_data.begin(), m_data.end());
+    m_maxValue = *std::max_element(m_data.begin(), m_data.end());
+  }
+  return true;
+}
+
+bool AdaptiveCube::isActive(const Vector3i& brick) const
+{
+  if ((brick.array() < 0).any() || (brick.array() >= m_bricks.array()).any())
+    return false;
+  return m_brickIndices[brickIndex(brick)] >= 0;
+}
+
+double AdaptiveCube::value(int i, int j, int k) const
+{
+  const Vector3i point(i, j, k);
+  if ((point.array() < 0).any() || (point.array() >= m_points.array()).any())
+    return 0.0;
+
+  // A point on the face of a brick also belongs to the previous brick.
+  Vector3i first, last;
+  for (int a = 0; a < 3; ++a) {
+    last[a] = std::min(point[a] / brickCells, m_bricks[a] - 1);
+    first[a] = point[a] > 0 && point[a] % brickCells == 0
+                 ? point[a] / brickCells - 1
+                 : last[a];
+  }
+  for (int x = first.x(); x <= last.x(); ++x) {
+    for (int y = first.y(); y <= last.y(); ++y) {
+      for (int z = first.z(); z <= last.z(); ++z) {
+        const Vector3i brick(x, y, z);
+        const int n = m_brickIndices[brickIndex(brick)];
+        if (n >= 0) {
+          const Vector3i local = point - brick * brickCells;
+          return brickValue(n, local.x(), local.y(), local.z());
+        }
+      }
+    }
+  }
+  return 0.0;
+}
+
+bool AdaptiveCube::isNear(const Function& function, const Vector3i& brick,
+                          int size) const
+{
+  // The box of the node, clipped to the grid.
+  const Vector3i begin = brick * brickCells;
+  const Vector3i end = ((brick + Vector3i::Constant(size)) * brickCells)
+                         .cwiseMin(m_points - Vector3i::Ones());
+  const Vector3 lower = m_min + begin.cast<double>().cwiseProduct(m_spacing);
+  const Vector3 upper = m_min + end.cast<double>().cwiseProduct(m_spacing);
+
+  // Close to an atom, the function varies faster than the samples can show.
+  const double margin = brickCells * m_spacing.maxCoeff();
+  for (size_t i = 0; i < m_centers.size(); ++i) {
+    if ((m_centers[i].array() >= lower.array() - margin).all() &&
+        (m_centers[i].array() <= upper.array() + margin).all()) {
+      return true;
+    }
+  }
+
+  double minValue = std::numeric_limits<double>::max();
+  double maxValue = -std::numeric_limits<double>::max();
+  double maxMagnitude = 0.0;
+  for (int i = 0; i < nodeSamples; ++i) {
+    for (int j = 0; j < nodeSamples; ++j) {
+      for (int k = 0; k < nodeSamples; ++k) {
+        const Vector3 t = Vector3(i, j, k) / double(nodeSamples - 1);
+        const double v = function(lower + (upper - lower).cwiseProduct(t));
+        minValue = std::min(minValue, v);
+        maxValue = std::max(maxValue, v);
+        maxMagnitude = std::max(maxMagnitude, std::fabs(v));
+      }
+    }
+  }
+
+  if (maxMagnitude < nearFraction * m_iso)
+    return false;
+  if (minValue > insideFactor * m_iso || maxValue < -insideFactor * m_iso)
+    return false;
+  return true;
+}
+
+void AdaptiveCube::refine(const Function& function, const Vector3i& brick,
+                          int level, std::vector<char>& active) const
+{
+  if ((brick.array() >= m_bricks.array()).any())
+    return;
+  const int size = 1 << level;
+  if (!isNear(function, brick, size))
+    return;
+  if (level == 0) {
+    active[brickIndex(brick)] = 1;
+    return;
+  }
+
+  const int half = size / 2;
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 2; ++j) {
+      for (int k = 0; k < 2; ++k)
+        refine(function, brick + Vector3i(i, j, k) * half, level - 1, active);
+    }
+  }
+}
+
+void AdaptiveCube::evaluateBrick(const Function& function, size_t n)
+{
+  const Vector3i origin = m_activeBricks[n] * brickCells;
+  double* values = &m_data[n * brickPoints];
+  for (int i = 0; i <= brickCells; ++i) {
+    for (int j = 0; j <= brickCells; ++j) {
+      for (int k = 0; k <= brickCells; ++k) {
+        const Vector3i point = origin + Vector3i(i, j, k);
+        *values++ = function(
+          m_min + point.cast<double>().cwiseProduct(m_spacing));
+      }
+    }
+  }
+}
+
+int AdaptiveCube::brickIndex(const Vector3i& brick) const
+{
+  return (brick.x() * m_bricks.y() + brick.y()) * m_bricks.z() + brick.z();
+}
+
+} // End Core namespace
+} // End Avogadro namespace
@@ -0,0 +1,183 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_ADAPTIVECUBE_H
+#define AVOGADRO_CORE_ADAPTIVECUBE_H
+
+#include "avogadrocore.h"
+
+#include "vector.h"
+
+#include <functional>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class Molecule;
+class Mutex;
+
+/**
+ * @class AdaptiveCube adaptivecube.h <avogadro/core/adaptivecube.h>
+ * @brief Provide a sparse, regularly spaced 3D grid, only evaluated close to
+ * an isosurface.
+ *
+ * The grid is divided in bricks of brickCells cells along each axis. An
+ * octree over the bricks is refined where the isosurfaces at +iso and -iso may
+ * pass, judged from a few samples of each node, and around the atoms, where
+ * the functions have their sharpest features. Only the bricks at the leaves
+ * are stored and evaluated at every point, the vacuum around a molecule and
+ * the inside of the surfaces are skipped.
+ *
+ * The points on the faces of a brick are stored in each of the bricks sharing
+ * them, so that every cell of an active brick can be polygonized from the
+ * brick alone.
+ */
+
+class AVOGADROCORE_EXPORT AdaptiveCube
+{
+public:
+  /** The function evaluated at the points of the grid. */
+  typedef std::function<double(const Vector3&)> Function;
+
+  /** The number of cells along each axis of a brick. */
+  static const int brickCells = 8;
+
+  /** The number of points of a brick, faces included. */
+  static const int brickPoints =
+    (brickCells + 1) * (brickCells + 1) * (brickCells + 1);
+
+  AdaptiveCube();
+  ~AdaptiveCube();
+
+  /**
+   * @return The minimum point in the grid.
+   */
+  Vector3 min() const { return m_min; }
+
+  /**
+   * @return The spacing of the grid.
+   */
+  Vector3 spacing() const { return m_spacing; }
+
+  /**
+   * @return The x, y and z dimensions of the grid in points.
+   */
+  Vector3i dimensions() const { return m_points; }
+
+  /**
+   * @return The x, y and z dimensions of the grid in bricks.
+   */
+  Vector3i brickDimensions() const { return m_bricks; }
+
+  /**
+   * Set the limits of the grid, with no atoms to refine around. The
+   * dimensions are rounded up to a whole number of bricks. Any values are
+   * discarded.
+   * @param min The minimum point in the grid.
+   * @param dim The integer dimensions of the grid in x, y and z.
+   * @param spacing The interval between points in the grid.
+   */
+  bool setLimits(const Vector3& min, const Vector3i& dim, double spacing);
+
+  /**
+   * Set the limits of the grid around a molecule, as Cube::setLimits does,
+   * and refine it around the atoms of the molecule.
+   * @param mol Molecule to take limits from
+   * @param spacing The spacing of the regular grid
+   * @param padding Padding around the molecule
+   */
+  bool setLimits(const Molecule& mol, double spacing, double padding);
+
+  /**
+   * Refine the grid where the isosurfaces at @p iso and -@p iso of
+   * @p function may pass, and evaluate the function at every point of the
+   * bricks retained. The bricks are evaluated in parallel, @p function must be
+   * safe to call from several threads.
+   * @return False if the grid or @p iso are not valid.
+   */
+  bool evaluate(const Function& function, double iso);
+
+  /**
+   * @return The isovalue of the last evaluation.
+   */
+  double isoValue() const { return m_iso; }
+
+  /**
+   * @return The bricks evaluated, by their x, y and z index.
+   */
+  const std::vector<Vector3i>& activeBricks() const { return m_activeBricks; }
+
+  /**
+   * @return True if the brick at @p brick was evaluated.
+   */
+  bool isActive(const Vector3i& brick) const;
+
+  /**
+   * @return The value at the point i, j, k of the @p n th active brick, each
+   * index between 0 and brickCells included.
+   */
+  double brickValue(size_t n, int i, int j, int k) const
+  {
+    return m_data[n * brickPoints +
+                  (i * (brickCells + 1) + j) * (brickCells + 1) + k];
+  }
+
+  /**
+   * @return The value at the integer point i, j, k of the grid, or 0 if no
+   * active brick contains it.
+   */
+  double value(int i, int j, int k) const;
+
+  /**
+   * @return The minimum value at any evaluated point.
+   */
+  double minValue() const { return m_minValue; }
+
+  /**
+   * @return The maximum value at any evaluated point.
+   */
+  double maxValue() const { return m_maxValue; }
+
+  /**
+   * Provides locking.
+   */
+  Mutex* lock() const { return m_lock; }
+
+private:
+  AVO_DISABLE_COPY(AdaptiveCube)
+
+  bool isNear(const Function& function, const Vector3i& brick, int size) const;
+  void refine(const Function& function, const Vector3i& brick, int level,
+              std::vector<char>& active) const;
+  void evaluateBrick(const Function& function, size_t n);
+  int brickIndex(const Vector3i& brick) const;
+
+  Vector3 m_min, m_spacing;
+  Vector3i m_points, m_bricks;
+  double m_iso;
+  double m_minValue, m_maxValue;
+  std::vector<Vector3> m_centers;
+  std::vector<int> m_brickIndices;
+  std::vector<Vector3i> m_activeBricks;
+  std::vector<double> m_data;
+  Mutex* m_lock;
+};
+
+} // End Core namespace
+} // End Avogadro namespace
+
+#endif // AVOGADRO_CORE_ADAPTIVECUBE_H
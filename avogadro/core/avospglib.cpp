@@ -22,7 +22,11 @@
 #include "unitcell.h"
 #include "vector.h"
 
+#include <algorithm>
 #include <iostream>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 extern "C" {
 #include "spglib/spglib.h"
@@ -31,56 +35,238 @@ extern "C" {
 namespace Avogadro {
 namespace Core {
 
-unsigned short AvoSpglib::getHallNumber(const Molecule& mol, double cartTol)
+namespace {
+// The number of structures whose results are kept.
+const size_t maxCacheEntries = 8;
+
+// A hash of everything spglib looks at, FNV-1a over the raw values.
+class StructureHash
 {
-  if (!mol.unitCell())
-    return 0;
+public:
+  StructureHash() : m_hash(14695981039346656037ULL) {}
+
+  void add(const void* data, size_t size)
+  {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      m_hash ^= bytes[i];
+      m_hash *= 1099511628211ULL;
+    }
+  }
 
-  const UnitCell* uc = mol.unitCell();
-  Matrix3 cellMat = uc->cellMatrix();
+  unsigned long long value() const { return m_hash; }
 
-  double lattice[3][3];
+private:
+  unsigned long long m_hash;
+};
+
+// Everything spglib looks at, kept whole so a hit never rests on the hash.
+struct StructureKey
+{
+  StructureKey(const Molecule& mol, double cartTol_, bool toPrimitive_ = false,
+               bool idealize_ = false)
+    : cellMatrix(mol.unitCell()->cellMatrix()), cartTol(cartTol_),
+      toPrimitive(toPrimitive_), idealize(idealize_),
+      atomicNumbers(mol.atomicNumbers()), fractional(mol.atomCount())
+  {
+    const UnitCell* uc = mol.unitCell();
+    const Array<Vector3>& pos = mol.atomPositions3d();
+    for (Index i = 0; i < fractional.size(); ++i)
+      fractional[i] = uc->toFractional(pos[i]);
+
+    StructureHash h;
+    h.add(cellMatrix.data(), sizeof(Real) * 9);
+    h.add(&cartTol, sizeof(cartTol));
+    h.add(&toPrimitive, sizeof(toPrimitive));
+    h.add(&idealize, sizeof(idealize));
+    Index numAtoms = fractional.size();
+    h.add(&numAtoms, sizeof(numAtoms));
+    if (numAtoms > 0) {
+      h.add(atomicNumbers.constData(), numAtoms);
+      h.add(fractional.constData(), sizeof(Vector3) * numAtoms);
+    }
+    hash = h.value();
+  }
+
+  bool operator==(const StructureKey& other) const
+  {
+    return hash == other.hash && cartTol == other.cartTol &&
+           toPrimitive == other.toPrimitive && idealize == other.idealize &&
+           cellMatrix == other.cellMatrix &&
+           atomicNumbers == other.atomicNumbers &&
+           fractional == other.fractional;
+  }
+
+  unsigned long long hash;
+  Matrix3 cellMatrix;
+  double cartTol;
+  bool toPrimitive;
+  bool idealize;
+  Array<unsigned char> atomicNumbers;
+  Array<Vector3> fractional;
+};
+
+// A standardized cell, as returned by spg_standardize_cell().
+struct StandardCell
+{
+  StandardCell() : valid(false) {}
+  bool valid;
+  Matrix3 cellMatrix;
+  Array<unsigned char> atomicNumbers;
+  Array<Vector3> fractional;
+};
+
+// The results for the last few structures, most recently used first.
+template <typename T>
+class ResultCache
+{
+public:
+  bool find(const StructureKey& key, T& result)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+      if (m_entries[i].first == key) {
+        std::rotate(m_entries.begin(), m_entries.begin() + i,
+                    m_entries.begin() + i + 1);
+        result = m_entries.front().second;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void insert(const StructureKey& key, const T& result)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.insert(m_entries.begin(), std::make_pair(key, result));
+    if (m_entries.size() > maxCacheEntries)
+      m_entries.pop_back();
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+  }
+
+private:
+  std::mutex m_mutex;
+  std::vector<std::pair<StructureKey, T>> m_entries;
+};
+
+ResultCache<AvoSpglib::Dataset>& datasetCache()
+{
+  static ResultCache<AvoSpglib::Dataset> cache;
+  return cache;
+}
+
+ResultCache<StandardCell>& standardCellCache()
+{
+  static ResultCache<StandardCell> cache;
+  return cache;
+}
+
+// Fill the spglib input buffers from @a key, reusing their memory between
+// calls. The buffers hold @a capacity atoms.
+void fillBuffers(const StructureKey& key, double lattice[3][3],
+                 std::vector<double>& positions, std::vector<int>& types,
+                 Index capacity)
+{
   // Spglib expects column vectors
   for (Index i = 0; i < 3; ++i) {
     for (Index j = 0; j < 3; ++j) {
-      lattice[i][j] = cellMat(i, j);
+      lattice[i][j] = key.cellMatrix(i, j);
     }
   }
 
-  Index numAtoms = mol.atomCount();
-  double(*positions)[3] = new double[numAtoms][3];
-  int* types = new int[numAtoms];
-
-  const Array<unsigned char>& atomicNums = mol.atomicNumbers();
-  const Array<Vector3>& pos = mol.atomPositions3d();
+  Index numAtoms = key.fractional.size();
+  positions.resize(3 * capacity);
+  types.resize(capacity);
 
-  // Positions need to be in fractional coordinates
+  // The key already holds the positions in fractional coordinates
   for (Index i = 0; i < numAtoms; ++i) {
-    Vector3 fracCoords = uc->toFractional(pos[i]);
-    positions[i][0] = fracCoords[0];
-    positions[i][1] = fracCoords[1];
-    positions[i][2] = fracCoords[2];
-    types[i] = atomicNums[i];
+    const Vector3& fracCoords = key.fractional[i];
+    positions[3 * i] = fracCoords[0];
+    positions[3 * i + 1] = fracCoords[1];
+    positions[3 * i + 2] = fracCoords[2];
+    types[i] = key.atomicNumbers[i];
   }
+}
+
+std::vector<double>& positionBuffer()
+{
+  static thread_local std::vector<double> buffer;
+  return buffer;
+}
+
+std::vector<int>& typeBuffer()
+{
+  static thread_local std::vector<int> buffer;
+  return buffer;
+}
+}
+
+bool AvoSpglib::getDataset(const Molecule& mol, Dataset& dataset,
+                           double cartTol)
+{
+  dataset = Dataset();
+  if (!mol.unitCell() || mol.atomPositions3d().size() != mol.atomCount())
+    return false;
 
-  SpglibDataset* data =
-    spg_get_dataset(lattice, positions, types, numAtoms, cartTol);
+  StructureKey key(mol, cartTol);
+  if (datasetCache().find(key, dataset))
+    return dataset.hallNumber != 0;
+
+  double lattice[3][3];
+  std::vector<double>& positions = positionBuffer();
+  std::vector<int>& types = typeBuffer();
+  Index numAtoms = mol.atomCount();
+  fillBuffers(key, lattice, positions, types, numAtoms);
+
+  SpglibDataset* data = spg_get_dataset(
+    lattice, reinterpret_cast<double(*)[3]>(positions.data()), types.data(),
+    static_cast<int>(numAtoms), cartTol);
 
   if (!data) {
     std::cerr << "Cannot determine spacegroup.\n";
-    delete[] positions;
-    delete[] types;
-    return 0;
+    // Remember the failure too, it would fail again.
+    datasetCache().insert(key, dataset);
+    return false;
   }
 
-  unsigned short hallNumber = data->hall_number;
+  dataset.hallNumber = static_cast<unsigned short>(data->hall_number);
+  dataset.spaceGroupNumber =
+    static_cast<unsigned short>(data->spacegroup_number);
+  dataset.international = data->international_symbol;
+  for (int i = 0; i < data->n_operations; ++i) {
+    Matrix3 rotation;
+    for (int row = 0; row < 3; ++row) {
+      for (int col = 0; col < 3; ++col)
+        rotation(row, col) = data->rotations[i][row][col];
+    }
+    dataset.rotations.push_back(rotation);
+    dataset.translations.push_back(Vector3(data->translations[i][0],
+                                           data->translations[i][1],
+                                           data->translations[i][2]));
+  }
+  for (int i = 0; i < data->n_atoms; ++i) {
+    dataset.wyckoffs += static_cast<char>('a' + data->wyckoffs[i]);
+    dataset.equivalentAtoms.push_back(
+      static_cast<Index>(data->equivalent_atoms[i]));
+  }
 
   // Cleanup time
   spg_free_dataset(data);
-  delete[] positions;
-  delete[] types;
 
-  return hallNumber;
+  datasetCache().insert(key, dataset);
+  return dataset.hallNumber != 0;
+}
+
+unsigned short AvoSpglib::getHallNumber(const Molecule& mol, double cartTol)
+{
+  Dataset dataset;
+  getDataset(mol, dataset, cartTol);
+  return dataset.hallNumber;
 }
 
 bool AvoSpglib::reduceToPrimitive(Molecule& mol, double cartTol)
@@ -98,80 +284,74 @@ bool AvoSpglib::symmetrize(Molecule& mol, double cartTol)
   return standardizeCell(mol, cartTol, true, true);
 }
 
+void AvoSpglib::clearCache()
+{
+  datasetCache().clear();
+  standardCellCache().clear();
+}
+
 bool AvoSpglib::standardizeCell(Molecule& mol, double cartTol, bool toPrimitive,
                                 bool idealize)
 {
-  if (!mol.unitCell())
+  if (!mol.unitCell() || mol.atomPositions3d().size() != mol.atomCount())
     return false;
 
-  const UnitCell* uc = mol.unitCell();
-  Matrix3 cellMat = uc->cellMatrix();
-
-  double lattice[3][3];
-  // Spglib expects column vectors
-  for (Index i = 0; i < 3; ++i) {
-    for (Index j = 0; j < 3; ++j) {
-      lattice[i][j] = cellMat(i, j);
+  // The options are part of the key.
+  StructureKey key(mol, cartTol, toPrimitive, idealize);
+
+  StandardCell result;
+  if (!standardCellCache().find(key, result)) {
+    double lattice[3][3];
+    std::vector<double>& positions = positionBuffer();
+    std::vector<int>& types = typeBuffer();
+    Index numAtoms = mol.atomCount();
+    // spg_standardize_cell() can cause the number of atoms to increase by
+    // as much as 4x if toPrimitive is false.
+    // So, we must make these arrays at least 4x the number of atoms.
+    // If toPrimitive is true, then we will just use the number of atoms.
+    // See http://atztogo.github.io/spglib/api.html#spg-standardize-cell
+    int numAtomsMultiplier = toPrimitive ? 1 : 4;
+    fillBuffers(key, lattice, positions, types, numAtoms * numAtomsMultiplier);
+
+    // Run the spglib algorithm
+    Index newNumAtoms = spg_standardize_cell(
+      lattice, reinterpret_cast<double(*)[3]>(positions.data()), types.data(),
+      static_cast<int>(numAtoms), toPrimitive, !idealize, cartTol);
+
+    // If 0 is returned, the algorithm failed.
+    if (newNumAtoms > 0) {
+      result.valid = true;
+      for (Index i = 0; i < 3; ++i) {
+        for (Index j = 0; j < 3; ++j) {
+          result.cellMatrix(i, j) = lattice[i][j];
+        }
+      }
+      result.atomicNumbers.reserve(newNumAtoms);
+      result.fractional.reserve(newNumAtoms);
+      for (Index i = 0; i < newNumAtoms; ++i) {
+        result.atomicNumbers.push_back(static_cast<unsigned char>(types[i]));
+        result.fractional.push_back(Vector3(
+          positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]));
+      }
     }
+    standardCellCache().insert(key, result);
   }
 
-  Index numAtoms = mol.atomCount();
-  // spg_standardize_cell() can cause the number of atoms to increase by
-  // as much as 4x if toPrimitive is false.
-  // So, we must make these arrays at least 4x the number of atoms.
-  // If toPrimitive is true, then we will just use the number of atoms.
-  // See http://atztogo.github.io/spglib/api.html#spg-standardize-cell
-  int numAtomsMultiplier = toPrimitive ? 1 : 4;
-  double(*positions)[3] = new double[numAtoms * numAtomsMultiplier][3];
-  int* types = new int[numAtoms * numAtomsMultiplier];
-
-  const Array<unsigned char>& atomicNums = mol.atomicNumbers();
-  const Array<Vector3>& pos = mol.atomPositions3d();
-
-  // Positions need to be in fractional coordinates
-  for (Index i = 0; i < numAtoms; ++i) {
-    Vector3 fracCoords = uc->toFractional(pos[i]);
-    positions[i][0] = fracCoords[0];
-    positions[i][1] = fracCoords[1];
-    positions[i][2] = fracCoords[2];
-    types[i] = atomicNums[i];
-  }
-
-  // Run the spglib algorithm
-  Index newNumAtoms = spg_standardize_cell(lattice, positions, types, numAtoms,
-                                           toPrimitive, !idealize, cartTol);
-
-  // If 0 is returned, the algorithm failed.
-  if (newNumAtoms == 0) {
-    delete[] positions;
-    delete[] types;
+  if (!result.valid)
     return false;
-  }
 
   // Let's create a new molecule with the information
   Molecule newMol;
 
   // First, we will make the unit cell
-  Matrix3 newCellMat;
-  for (Index i = 0; i < 3; ++i) {
-    for (Index j = 0; j < 3; ++j) {
-      newCellMat(i, j) = lattice[i][j];
-    }
-  }
-
-  UnitCell* newCell = new UnitCell(newCellMat);
+  UnitCell* newCell = new UnitCell(result.cellMatrix);
   newMol.setUnitCell(newCell);
 
-  // Next, add in the atoms
-  for (Index i = 0; i < newNumAtoms; ++i) {
-    Atom newAtom = newMol.addAtom(types[i]);
-    Vector3 newAtomPos(positions[i][0], positions[i][1], positions[i][2]);
-    // We must convert it back to cartesian before adding it
-    newAtom.setPosition3d(newCell->toCartesian(newAtomPos));
-  }
-
-  delete[] positions;
-  delete[] types;
+  // Next, add in the atoms. We must convert them back to cartesian.
+  Array<Vector3> newPositions(result.fractional.size());
+  for (Index i = 0; i < result.fractional.size(); ++i)
+    newPositions[i] = newCell->toCartesian(result.fractional[i]);
+  newMol.addAtoms(result.atomicNumbers, newPositions);
 
   // Set the new molecule
   mol = newMol;
@@ -18,7 +18,12 @@
 #define AVOGADRO_CORE_AVO_SPGLIB_H
 
 #include "avogadrocore.h"
+#include "array.h"
+#include "matrix.h"
 #include "molecule.h"
+#include "vector.h"
+
+#include <string>
 
 namespace Avogadro {
 namespace Core {
@@ -26,6 +31,11 @@ namespace Core {
 /**
  * @class AvoSpglib avospglib.h <avogadro/core/avospglib.h>
  * @brief The AvoSpglib class provides an interface between Avogadro and Spglib.
+ *
+ * The results of spglib are cached for the last few structures, keyed by a
+ * hash of the unit cell, atomic numbers and positions along with the
+ * tolerance. Querying an unchanged structure again does not run spglib, and
+ * any change to the structure results in a new key.
  */
 
 class AVOGADROCORE_EXPORT AvoSpglib
@@ -34,6 +44,45 @@ public:
   AvoSpglib();
   ~AvoSpglib();
 
+  /**
+   * The symmetry information found by spglib for a crystal.
+   */
+  struct Dataset
+  {
+    Dataset() : hallNumber(0), spaceGroupNumber(0) {}
+
+    /** The Hall number, 0 if spglib failed. */
+    unsigned short hallNumber;
+    /** The international space group number. */
+    unsigned short spaceGroupNumber;
+    /** The international space group symbol. */
+    std::string international;
+    /**
+     * The symmetry operations, acting on fractional coordinates of the input
+     * cell: the operation i maps v to rotations[i] * v + translations[i].
+     * @{
+     */
+    Array<Matrix3> rotations;
+    Array<Vector3> translations;
+    /** @} */
+    /** The Wyckoff letter of each atom. */
+    std::string wyckoffs;
+    /** The index of the first atom symmetrically equivalent to each atom. */
+    Array<Index> equivalentAtoms;
+  };
+
+  /**
+   * Use spglib to find the symmetry of a crystal.
+   *
+   * @param mol The crystal.
+   * @param dataset Set to the symmetry information of the crystal.
+   * @param cartTol The cartesian tolerance for spglib.
+   * @return False if the molecule has no unit cell or if the spglib algorithm
+   *         failed. True otherwise.
+   */
+  static bool getDataset(const Molecule& mol, Dataset& dataset,
+                         double cartTol = 1e-5);
+
   /**
    * Use spglib to find the Hall number for a crystal. If the unit cell does not
    * exist or if the algorithm fails, 0 will be returned.
@@ -80,6 +129,11 @@ public:
    */
   static bool symmetrize(Molecule& mol, double cartTol = 1e-5);
 
+  /**
+   * Discard the cached spglib results.
+   */
+  static void clearCache();
+
 private:
   // Called by reduceToPrimitive(), conventionalizeCell(), and symmetrize()
   // Calls spg_standardize_cell()
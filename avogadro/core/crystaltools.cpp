@@ -17,10 +17,13 @@
 #include "crystaltools.h"
 
 #include "molecule.h"
+#include "parallel.h"
 #include "unitcell.h"
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 namespace Avogadro {
 namespace Core {
@@ -545,6 +548,25 @@ bool CrystalTools::isNiggliReduced(const Molecule& molecule)
   return true;
 }
 
+namespace {
+inline int positiveModulo(int x, int n)
+{
+  return ((x % n) + n) % n;
+}
+
+// Copy the per-atom values of the first cell to every other cell.
+template <typename T>
+void replicateAtomData(Array<T>& data, Index numAtoms, Index numCells)
+{
+  if (data.size() != numAtoms || numAtoms == 0)
+    return;
+  data.resize(numAtoms * numCells);
+  T* values = data.data();
+  for (Index cell = 1; cell < numCells; ++cell)
+    std::copy(values, values + numAtoms, values + cell * numAtoms);
+}
+}
+
 bool CrystalTools::buildSupercell(Molecule& molecule, unsigned int a,
                                   unsigned int b, unsigned int c)
 {
@@ -559,39 +581,114 @@ bool CrystalTools::buildSupercell(Molecule& molecule, unsigned int a,
   }
 
   // Get the old vectors
-  Vector3 oldA = molecule.unitCell()->aVector();
-  Vector3 oldB = molecule.unitCell()->bVector();
-  Vector3 oldC = molecule.unitCell()->cVector();
-
-  // Calculate new vectors
-  Vector3 newA = oldA * a;
-  Vector3 newB = oldB * b;
-  Vector3 newC = oldC * c;
-
-  // Add in the atoms to the new subcells of the supercell
-  Index numAtoms = molecule.atomCount();
-  Array<Vector3> atoms = molecule.atomPositions3d();
-  Array<unsigned char> atomicNums = molecule.atomicNumbers();
-  for (Index ind_a = 0; ind_a < a; ++ind_a) {
-    for (Index ind_b = 0; ind_b < b; ++ind_b) {
-      for (Index ind_c = 0; ind_c < c; ++ind_c) {
-        // Skip over the subcell that already exists
-        if (ind_a == 0 && ind_b == 0 && ind_c == 0)
-          continue;
+  UnitCell& unitCell = *molecule.unitCell();
+  const Vector3 oldA = unitCell.aVector();
+  const Vector3 oldB = unitCell.bVector();
+  const Vector3 oldC = unitCell.cVector();
+
+  // The atoms of the subcell (i, j, k) of the supercell are copies of the
+  // original atoms, stored in the same order in block (i * b + j) * c + k.
+  // Block zero holds the original atoms.
+  const Index numAtoms = molecule.atomCount();
+  const Index numCells = static_cast<Index>(a) * b * c;
+  const Index numNewAtoms = numAtoms * (numCells - 1);
+
+  if (numNewAtoms > 0) {
+    Array<Vector3> positions = molecule.atomPositions3d();
+    positions.resize(numAtoms, Vector3::Zero());
+    const Vector3* oldPositions = positions.constData();
+    const unsigned char* oldNumbers = molecule.atomicNumbers().constData();
+
+    // Resize once, then fill the new subcells in parallel.
+    Array<unsigned char> newNumbers(numNewAtoms);
+    Array<Vector3> newPositions(numNewAtoms);
+    unsigned char* numbersOut = newNumbers.data();
+    Vector3* positionsOut = newPositions.data();
+    parallelFor(numCells - 1, numAtoms, [&](Index first, Index last) {
+      for (Index block = first + 1; block <= last; ++block) {
+        Index ind_a = block / (b * c);
+        Index ind_b = (block / c) % b;
+        Index ind_c = block % c;
         // The positions of the new atoms are displacements of the old atoms
-        Vector3 displacement = ind_a * oldA + ind_b * oldB + ind_c * oldC;
+        Vector3 displacement = static_cast<Real>(ind_a) * oldA +
+                               static_cast<Real>(ind_b) * oldB +
+                               static_cast<Real>(ind_c) * oldC;
+        Index offset = (block - 1) * numAtoms;
         for (Index i = 0; i < numAtoms; ++i) {
-          Atom newAtom = molecule.addAtom(atomicNums.at(i));
-          newAtom.setPosition3d(atoms.at(i) + displacement);
+          numbersOut[offset + i] = oldNumbers[i];
+          positionsOut[offset + i] = oldPositions[i] + displacement;
         }
       }
+    });
+
+    molecule.addAtoms(newNumbers, newPositions);
+    replicateAtomData(molecule.hybridizations(), numAtoms, numCells);
+    replicateAtomData(molecule.formalCharges(), numAtoms, numCells);
+
+    const Index numBonds = molecule.bondCount();
+    if (numBonds > 0) {
+      // The image shift of each bond, so that the second atom in the cell
+      // offset by the shift is the minimum image of the first.
+      std::vector<int> shifts(numBonds * 3);
+      for (Index bond = 0; bond < numBonds; ++bond) {
+        const std::pair<Index, Index>& pair = molecule.bondPairs()[bond];
+        Vector3 delta = unitCell.toFractional(oldPositions[pair.second] -
+                                              oldPositions[pair.first]);
+        for (int dim = 0; dim < 3; ++dim)
+          shifts[bond * 3 + dim] = -static_cast<int>(rint(delta[dim]));
+      }
+
+      // Replicate the bonds in each subcell, and connect the bonds that cross
+      // a cell boundary to the neighboring subcell, wrapping around the faces
+      // of the supercell.
+      const int dims[3] = { static_cast<int>(a), static_cast<int>(b),
+                            static_cast<int>(c) };
+      const std::pair<Index, Index>* oldPairs =
+        molecule.bondPairs().constData();
+      Array<std::pair<Index, Index>> bondPairs(numBonds * numCells);
+      std::pair<Index, Index>* pairsOut = bondPairs.data();
+      parallelFor(numCells, numBonds, [&](Index first, Index last) {
+        for (Index block = first; block < last; ++block) {
+          int index[3] = { static_cast<int>(block / (b * c)),
+                           static_cast<int>((block / c) % b),
+                           static_cast<int>(block % c) };
+          for (Index bond = 0; bond < numBonds; ++bond) {
+            int other[3];
+            for (int dim = 0; dim < 3; ++dim) {
+              other[dim] =
+                positiveModulo(index[dim] + shifts[bond * 3 + dim], dims[dim]);
+            }
+            Index otherBlock = (other[0] * b + other[1]) * c + other[2];
+            Index atom1 = block * numAtoms + oldPairs[bond].first;
+            Index atom2 = otherBlock * numAtoms + oldPairs[bond].second;
+            pairsOut[block * numBonds + bond] =
+              atom1 < atom2 ? std::make_pair(atom1, atom2)
+                            : std::make_pair(atom2, atom1);
+          }
+        }
+      });
+
+      Array<unsigned char> bondOrders;
+      bondOrders.reserve(numBonds * (numCells - 1));
+      for (Index block = 1; block < numCells; ++block) {
+        bondOrders.insert(bondOrders.end(), molecule.bondOrders().begin(),
+                          molecule.bondOrders().end());
+      }
+
+      // Rewire the original bonds, then add those of the new subcells.
+      for (Index bond = 0; bond < numBonds; ++bond)
+        molecule.setBondPair(bond, bondPairs[bond]);
+      molecule.addBonds(
+        Array<std::pair<Index, Index>>(bondPairs.begin() + numBonds,
+                                       bondPairs.end()),
+        bondOrders);
     }
   }
 
   // Now set the unit cell
-  molecule.unitCell()->setAVector(newA);
-  molecule.unitCell()->setBVector(newB);
-  molecule.unitCell()->setCVector(newC);
+  unitCell.setAVector(oldA * a);
+  unitCell.setBVector(oldB * b);
+  unitCell.setCVector(oldC * c);
 
   // We're done!
   return true;
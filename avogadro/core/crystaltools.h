@@ -106,6 +106,9 @@ public:
    * Build a supercell by expanding upon the unit cell of @a molecule. It will
    * only return false if the molecule does not have a unit cell or if a, b, or
    * c is set to zero.
+   * The bonds of @a molecule are replicated in every subcell. Bonds between
+   * periodic images, which cross a cell boundary, connect the nearest images
+   * of their atoms in the supercell.
    * @param a The number of units along lattice vector a for the supercell
    * @param b The number of units along lattice vector b for the supercell
    * @param c The number of units along lattice vector c for the supercell
@@ -20,8 +20,10 @@
 
 #include "molecule.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
 
 using std::cout;
 using std::endl;
@@ -31,7 +33,30 @@ using std::vector;
 namespace Avogadro {
 namespace Core {
 
-GaussianSet::GaussianSet() : m_numMOs(0), m_init(false)
+namespace {
+// C diag(n) C^T, as a symmetric rank-k update with the columns of C scaled by
+// the square roots of the positive weights n.
+MatrixX weightedProduct(const MatrixX& c, const vector<double>& n)
+{
+  typedef MatrixX::Index Index;
+  const Index count = std::min(c.cols(), static_cast<Index>(n.size()));
+  MatrixX occupied(c.rows(), count);
+  Index k = 0;
+  for (Index j = 0; j < count; ++j) {
+    if (n[j] > 0.0)
+      occupied.col(k++) = std::sqrt(n[j]) * c.col(j);
+  }
+
+  MatrixX product = MatrixX::Zero(c.rows(), c.rows());
+  product.selfadjointView<Eigen::Lower>().rankUpdate(occupied.leftCols(k));
+  product.triangularView<Eigen::StrictlyUpper>() = product.transpose();
+  return product;
+}
+}
+
+GaussianSet::GaussianSet()
+  : m_cutoffPrecision(1e-10), m_densityGenerated(false), m_numMOs(0),
+    m_init(false)
 {
   m_scfType = Rhf;
 }
@@ -99,6 +124,7 @@ void GaussianSet::setMolecularOrbitals(const vector<double>& MOs,
     return;
 
   m_init = false;
+  clearGeneratedDensity();
 
   size_t index(0);
   if (type == Beta)
@@ -128,12 +154,23 @@ void GaussianSet::setMolecularOrbitalEnergy(const vector<double>& energies,
 void GaussianSet::setMolecularOrbitalOccupancy(const vector<unsigned char>& occ,
                                                ElectronType type)
 {
+  clearGeneratedDensity();
   if (type == Beta)
     m_moOccupancy[1] = occ;
   else
     m_moOccupancy[0] = occ;
 }
 
+void GaussianSet::setMolecularOrbitalOccupancy(const vector<double>& occ,
+                                               ElectronType type)
+{
+  clearGeneratedDensity();
+  if (type == Beta)
+    m_moFractionalOccupancy[1] = occ;
+  else
+    m_moFractionalOccupancy[0] = occ;
+}
+
 void GaussianSet::setMolecularOrbitalNumber(const vector<unsigned int>& nums,
                                             ElectronType type)
 {
@@ -147,6 +184,7 @@ bool GaussianSet::setDensityMatrix(const MatrixX& m)
 {
   m_density.resize(m.rows(), m.cols());
   m_density = m;
+  m_densityGenerated = false;
   return true;
 }
 
@@ -159,10 +197,36 @@ bool GaussianSet::setSpinDensityMatrix(const MatrixX& m)
 
 bool GaussianSet::generateDensityMatrix()
 {
-  // FIXME: Finish me!
+  if (m_density.size() > 0)
+    return true;
+
+  if (m_densityLoader) {
+    // The loader is only tried once, the file may have gone since.
+    DensityLoader loader;
+    std::swap(loader, m_densityLoader);
+    MatrixX density;
+    MatrixX spinDensity;
+    if (loader(density, spinDensity) && density.size() > 0) {
+      m_density.swap(density);
+      if (spinDensity.size() > 0)
+        m_spinDensity.swap(spinDensity);
+      m_densityGenerated = false;
+      return true;
+    }
+  }
+
+  if (!generateDensity())
+    return false;
+  m_densityGenerated = true;
   return true;
 }
 
+void GaussianSet::setElectronCount(unsigned int n, ElectronType type)
+{
+  clearGeneratedDensity();
+  BasisSet::setElectronCount(n, type);
+}
+
 unsigned int GaussianSet::molecularOrbitalCount(ElectronType type)
 {
   size_t index(0);
@@ -285,6 +349,7 @@ void GaussianSet::initCalculation()
 
   // This currently just involves normalising all contraction coefficients
   m_gtoCN.clear();
+  m_cIndices.clear();
 
   // Initialise the new data structures that are hopefully more efficient
   unsigned int indexMO = 0;
@@ -292,6 +357,7 @@ void GaussianSet::initCalculation()
 
   m_moIndices.resize(m_symmetry.size());
   // Add a final entry to the gtoIndices
+  m_gtoIndices.resize(m_symmetry.size());
   m_gtoIndices.push_back(static_cast<unsigned int>(m_gtoA.size()));
   for (unsigned int i = 0; i < m_symmetry.size(); ++i) {
     switch (m_symmetry[i]) {
@@ -449,80 +515,179 @@ void GaussianSet::initCalculation()
       skip = 0;
     }
   }
+  buildEvaluationPlan();
   m_init = true;
 }
 
-bool GaussianSet::generateDensity()
+void GaussianSet::setCutoffPrecision(double precision)
 {
-  if (m_scfType == Unknown)
-    return false;
+  m_cutoffPrecision = precision;
+  // Tools already set up keep the plan, it is rebuilt in place.
+  if (m_init)
+    buildEvaluationPlan();
+}
 
-  m_density.resize(m_numMOs, m_numMOs);
-  m_density = MatrixX::Zero(m_numMOs, m_numMOs);
-  for (unsigned int iBasis = 0; iBasis < m_numMOs; ++iBasis) {
-    for (unsigned int jBasis = 0; jBasis <= iBasis; ++jBasis) {
-      switch (m_scfType) {
-        case Rhf:
-          for (unsigned int iMO = 0; iMO < m_electrons[0] / 2; ++iMO) {
-            double icoeff = m_moMatrix[0](iBasis, iMO);
-            double jcoeff = m_moMatrix[0](jBasis, iMO);
-            m_density(jBasis, iBasis) += 2.0 * icoeff * jcoeff;
-            m_density(iBasis, jBasis) = m_density(jBasis, iBasis);
-          }
-          cout << iBasis << ", " << jBasis << ": " << m_density(iBasis, jBasis)
-               << endl;
-          break;
-        case Uhf:
-          for (unsigned int iaMO = 0; iaMO < m_electrons[0]; ++iaMO) {
-            double icoeff = m_moMatrix[0](iBasis, iaMO);
-            double jcoeff = m_moMatrix[0](jBasis, iaMO);
-            m_density(jBasis, iBasis) += icoeff * jcoeff;
-            m_density(iBasis, jBasis) = m_density(jBasis, iBasis);
-          }
-          for (unsigned int ibMO = 0; ibMO < m_electrons[1]; ibMO++) {
-            double icoeff = m_moMatrix[1](iBasis, ibMO);
-            double jcoeff = m_moMatrix[1](jBasis, ibMO);
-            m_density(jBasis, iBasis) += icoeff * jcoeff;
-            m_density(iBasis, jBasis) = m_density(jBasis, iBasis);
-          }
-          cout << iBasis << ", " << jBasis << ": " << m_density(iBasis, jBasis)
-               << endl;
-          break;
-        default:
-          cout << "Unhandled scf type:" << m_scfType << endl;
+void GaussianSet::buildEvaluationPlan()
+{
+  m_plan.shells.clear();
+  m_plan.exponents.clear();
+  m_plan.coefficients.clear();
+
+  // Stable, so that the shells of an atom keep their order.
+  vector<unsigned int> order(m_symmetry.size());
+  for (size_t i = 0; i < order.size(); ++i)
+    order[i] = static_cast<unsigned int>(i);
+  std::stable_sort(order.begin(), order.end(),
+                   [this](unsigned int a, unsigned int b) {
+                     return m_atomIndices[a] < m_atomIndices[b];
+                   });
+
+  for (size_t k = 0; k < order.size(); ++k) {
+    unsigned int i = order[k];
+    int l;
+    unsigned int components;
+    switch (m_symmetry[i]) {
+      case S:
+        l = 0;
+        components = 1;
+        break;
+      case P:
+        l = 1;
+        components = 3;
+        break;
+      case D:
+        l = 2;
+        components = 6;
+        break;
+      case D5:
+        l = 2;
+        components = 5;
+        break;
+      case F:
+        l = 3;
+        components = 10;
+        break;
+      case F7:
+        l = 3;
+        components = 7;
+        break;
+      default:
+        // Not evaluated, the values stay zero.
+        continue;
+    }
+
+    EvaluationShell shell;
+    shell.type = m_symmetry[i];
+    shell.atom = m_atomIndices[i];
+    shell.moIndex = m_moIndices[i];
+    shell.gtoBegin = static_cast<unsigned int>(m_plan.exponents.size());
+    shell.cIndex = static_cast<unsigned int>(m_plan.coefficients.size());
+    shell.cutoffSquared = 0.0;
+
+    unsigned int cIndex = m_cIndices[i];
+    for (unsigned int j = m_gtoIndices[i]; j < m_gtoIndices[i + 1]; ++j) {
+      const double a = m_gtoA[j];
+      double c = 0.0;
+      for (unsigned int m = 0; m < components; ++m) {
+        c = std::max(c, std::fabs(m_gtoCN[cIndex]));
+        m_plan.coefficients.push_back(m_gtoCN[cIndex++]);
+      }
+      m_plan.exponents.push_back(a);
+
+      // The largest r where 4 c r^l exp(-a r^2) reaches the precision, the
+      // factor 4 bounds the angular parts. Beyond the maximum at
+      // sqrt(l / 2a), r = sqrt((log(4 c / precision) + l log(r)) / a)
+      // converges to it.
+      if (m_cutoffPrecision <= 0.0) {
+        shell.cutoffSquared = std::numeric_limits<double>::infinity();
+        continue;
+      }
+      const double logRatio = std::log(4.0 * c / m_cutoffPrecision);
+      const double peak = std::sqrt(l / (2.0 * a));
+      double r = std::sqrt(std::max(logRatio, 0.0) / a);
+      for (int iteration = 0; l > 0 && iteration < 20; ++iteration) {
+        r = std::max(r, peak);
+        r = std::sqrt(std::max(logRatio + l * std::log(r), 0.0) / a);
       }
+      r = std::max(r, peak);
+      shell.cutoffSquared = std::max(shell.cutoffSquared, r * r);
     }
+    shell.gtoEnd = static_cast<unsigned int>(m_plan.exponents.size());
+    m_plan.shells.push_back(shell);
   }
-  return true;
 }
 
-bool GaussianSet::generateSpinDensity()
+bool GaussianSet::generateDensity()
 {
-  if (m_scfType != Uhf)
+  if (m_scfType == Unknown || m_moMatrix[0].size() == 0)
     return false;
 
-  m_spinDensity.resize(m_numMOs, m_numMOs);
-  m_spinDensity = MatrixX::Zero(m_numMOs, m_numMOs);
-  for (unsigned int iBasis = 0; iBasis < m_numMOs; ++iBasis) {
-    for (unsigned int jBasis = 0; jBasis <= iBasis; ++jBasis) {
-      for (unsigned int iaMO = 0; iaMO < m_electrons[0]; ++iaMO) {
-        double icoeff = m_moMatrix[0](iBasis, iaMO);
-        double jcoeff = m_moMatrix[0](jBasis, iaMO);
-        m_spinDensity(jBasis, iBasis) += icoeff * jcoeff;
-        m_spinDensity(iBasis, jBasis) = m_spinDensity(jBasis, iBasis);
-      }
-      for (unsigned int ibMO = 0; ibMO < m_electrons[1]; ++ibMO) {
-        double icoeff = m_moMatrix[1](iBasis, ibMO);
-        double jcoeff = m_moMatrix[1](jBasis, ibMO);
-        m_spinDensity(jBasis, iBasis) -= icoeff * jcoeff;
-        m_spinDensity(iBasis, jBasis) = m_spinDensity(jBasis, iBasis);
+  switch (m_scfType) {
+    case Rhf:
+      m_density = weightedProduct(m_moMatrix[0], occupancies(0));
+      break;
+    case Uhf: {
+      if (m_moMatrix[1].rows() != m_moMatrix[0].rows())
+        return false;
+      MatrixX alpha = weightedProduct(m_moMatrix[0], occupancies(0));
+      MatrixX beta = weightedProduct(m_moMatrix[1], occupancies(1));
+      m_density = alpha + beta;
+      if (m_spinDensity.size() == 0)
+        m_spinDensity = alpha - beta;
+    } break;
+    case Rohf: {
+      // The alpha electrons fill each orbital first, the spin density is
+      // carried by the singly occupied orbitals.
+      vector<double> occ(occupancies(0));
+      m_density = weightedProduct(m_moMatrix[0], occ);
+      if (m_spinDensity.size() == 0) {
+        for (size_t i = 0; i < occ.size(); ++i)
+          occ[i] = std::min(occ[i], 2.0 - occ[i]);
+        m_spinDensity = weightedProduct(m_moMatrix[0], occ);
       }
-      cout << iBasis << ", " << jBasis << ": " << m_spinDensity(iBasis, jBasis)
-           << endl;
-    }
+    } break;
+    default:
+      cout << "Unhandled scf type:" << m_scfType << endl;
+      return false;
   }
   return true;
 }
 
+vector<double> GaussianSet::occupancies(size_t index) const
+{
+  const size_t count = static_cast<size_t>(m_moMatrix[index].cols());
+  if (m_moFractionalOccupancy[index].size() >= count)
+    return m_moFractionalOccupancy[index];
+  if (m_moOccupancy[index].size() >= count) {
+    return vector<double>(m_moOccupancy[index].begin(),
+                          m_moOccupancy[index].end());
+  }
+
+  // Fill the lowest orbitals. Closed shells have one electron count, split
+  // between alpha and beta for restricted open shells unless both are set.
+  vector<double> occ(count, 0.0);
+  unsigned int alpha = m_electrons[index];
+  unsigned int beta = 0;
+  if (m_scfType == Rhf || (m_scfType == Rohf && m_electrons[1] == 0)) {
+    alpha = (m_electrons[0] + 1) / 2;
+    beta = m_electrons[0] / 2;
+  } else if (m_scfType == Rohf) {
+    beta = m_electrons[1];
+  }
+  for (size_t i = 0; i < count; ++i)
+    occ[i] = (i < alpha ? 1.0 : 0.0) + (i < beta ? 1.0 : 0.0);
+  return occ;
+}
+
+void GaussianSet::clearGeneratedDensity()
+{
+  if (!m_densityGenerated)
+    return;
+
+  m_density.resize(0, 0);
+  m_spinDensity.resize(0, 0);
+  m_densityGenerated = false;
+}
+
 } // End namespace Core
 } // End namespace Avogadro
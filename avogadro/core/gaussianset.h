@@ -24,6 +24,7 @@
 #include <avogadro/core/matrix.h>
 #include <avogadro/core/vector.h>
 
+#include <functional>
 #include <vector>
 
 namespace Avogadro {
@@ -138,6 +139,16 @@ public:
   void setMolecularOrbitalOccupancy(const std::vector<unsigned char>& occ,
                                     ElectronType type = Paired);
 
+  /**
+   * @brief Set fractional molecular orbital occupancies, such as those of
+   * natural orbitals. They take precedence over the integer occupancies when
+   * the density matrix is generated.
+   * @param occ The occupancies for the MOs of type.
+   * @param type The type of the electrons being set.
+   */
+  void setMolecularOrbitalOccupancy(const std::vector<double>& occ,
+                                    ElectronType type = Paired);
+
   /**
    * @brief This enables support of sparse orbital sets, and provides a mapping
    * from the index in memory to the actual molecular orbital number.
@@ -158,11 +169,40 @@ public:
   bool setSpinDensityMatrix(const MatrixX& m);
 
   /**
-   * @brief Generate the density matrix if we have the required information.
+   * A function loading the density and spin density matrices, left empty if
+   * they are not available.
+   * @return True if the density matrix was loaded.
+   */
+  typedef std::function<bool(MatrixX& density, MatrixX& spinDensity)>
+    DensityLoader;
+
+  /**
+   * Set a function loading the density matrices when they are first needed,
+   * such as from the file the basis set was read from, rather than storing
+   * them up front. It is called once, by generateDensityMatrix(), if no
+   * density matrix was set.
+   */
+  void setDensityLoader(const DensityLoader& loader)
+  {
+    m_densityLoader = loader;
+  }
+
+  /**
+   * @brief Generate the density matrix, and the spin density matrix for open
+   * shell calculations, from the occupied molecular orbitals, unless the
+   * density loader provides them. Matrices that were set, or already
+   * generated, are kept. Generated matrices are discarded
+   * when the molecular orbitals, their occupancies, the electron counts or
+   * the SCF type change.
    * @return True on success, false on failure.
    */
   bool generateDensityMatrix();
 
+  /**
+   * Set the number of electrons, discarding the generated density matrices.
+   */
+  void setElectronCount(unsigned int n, ElectronType type = Paired) override;
+
   /**
    * @return The number of molecular orbitals in the GaussianSet.
    */
@@ -183,7 +223,11 @@ public:
   /**
    * Set the SCF type for the object.
    */
-  void setScfType(ScfType type) { m_scfType = type; }
+  void setScfType(ScfType type)
+  {
+    m_scfType = type;
+    clearGeneratedDensity();
+  }
 
   /**
    * Get the SCF type for the object.
@@ -192,9 +236,50 @@ public:
 
   /**
    * Initialize the calculation, this must normally be done before anything.
+   * It normalizes the contraction coefficients and builds the evaluation plan.
    */
   void initCalculation();
 
+  /**
+   * @brief A shell of the evaluation plan.
+   */
+  struct EvaluationShell
+  {
+    int type;              //! Symmetry of the shell, S, P...
+    unsigned int atom;     //! Index of the atom of the shell
+    unsigned int moIndex;  //! Index of the first basis function
+    unsigned int gtoBegin; //! First GTO in the plan exponents
+    unsigned int gtoEnd;   //! Past the last GTO in the plan exponents
+    unsigned int cIndex;   //! First coefficient in the plan coefficients
+    double cutoffSquared;  //! Squared radius in bohr beyond which it is zero
+  };
+
+  /**
+   * @brief The basis set laid out for the evaluation at many points: the
+   * shells grouped by atom, with their exponents and normalized contraction
+   * coefficients in contiguous arrays in the same order.
+   */
+  struct EvaluationPlan
+  {
+    std::vector<EvaluationShell> shells;
+    std::vector<double> exponents;
+    std::vector<double> coefficients;
+  };
+
+  /**
+   * @return The evaluation plan built by initCalculation(), shared by all of
+   * the evaluations of the basis set.
+   */
+  const EvaluationPlan& evaluationPlan() const { return m_plan; }
+
+  /**
+   * @brief Set the precision of the evaluation: a shell is neglected beyond
+   * the distance where all of its primitives are smaller than @p precision.
+   * The default is 1e-10, 0 disables the screening.
+   */
+  void setCutoffPrecision(double precision);
+  double cutoffPrecision() const { return m_cutoffPrecision; }
+
   /**
    * Accessors for the various properties of the GaussianSet.
    */
@@ -308,14 +393,24 @@ private:
    */
   std::vector<unsigned char> m_moOccupancy[2];
 
+  /**
+   * @brief The fractional occupancy of the molecular orbitals, if set.
+   */
+  std::vector<double> m_moFractionalOccupancy[2];
+
   /**
    * @brief This stores the molecular orbital number (when they are sparse). It
    * is used to lookup the actual index of the molecular orbital data.
    */
   std::vector<unsigned int> m_moNumber[2];
 
+  EvaluationPlan m_plan;    //! Built by initCalculation
+  double m_cutoffPrecision; //! Precision of the screening of the shells
+
   MatrixX m_density;     //! Density matrix
   MatrixX m_spinDensity; //! Spin Density matrix
+  bool m_densityGenerated; //! Were the density matrices generated?
+  DensityLoader m_densityLoader; //! Loads the density matrices on demand
 
   unsigned int m_numMOs; //! The number of GTOs (not always!)
   bool m_init;           //! Has the calculation been initialised?
@@ -323,17 +418,29 @@ private:
   ScfType m_scfType;
 
   /**
-   * @brief Generate the density matrix if we have the required information.
+   * @brief Generate the density matrix, and the spin density matrix for open
+   * shells if it is not set, as C diag(n) C^T over the occupied orbitals.
    * @return True on success, false on failure.
    */
   bool generateDensity();
 
   /**
-   * @brief Generate the spin density matrix if we have the required
-   * information.
-   * @return True on success, false on failure.
+   * @brief The occupancy of each molecular orbital of the set @p index: the
+   * fractional or integer occupancies if they are set, the lowest orbitals
+   * filled with the electrons otherwise.
+   */
+  std::vector<double> occupancies(size_t index) const;
+
+  /**
+   * @brief Discard the density matrices if they were generated, they are out
+   * of date.
+   */
+  void clearGeneratedDensity();
+
+  /**
+   * @brief Build the evaluation plan from the normalized shells.
    */
-  bool generateSpinDensity();
+  void buildEvaluationPlan();
 };
 
 } // End Core namespace
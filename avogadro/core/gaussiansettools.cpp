@@ -18,6 +18,7 @@
 
 #include "gaussiansettools.h"
 
+#include "adaptivecube.h"
 #include "cube.h"
 #include "gaussianset.h"
 #include "molecule.h"
@@ -32,10 +33,18 @@ using std::vector;
 namespace Avogadro {
 namespace Core {
 
-GaussianSetTools::GaussianSetTools(Molecule* mol) : m_molecule(mol)
+GaussianSetTools::GaussianSetTools(Molecule* mol)
+  : m_molecule(mol), m_basis(nullptr)
 {
   if (m_molecule)
     m_basis = dynamic_cast<GaussianSet*>(m_molecule->basisSet());
+  // The evaluation plan is built once, not at each point, and the density
+  // matrices are loaded or generated before the points are evaluated, maybe
+  // concurrently.
+  if (m_basis) {
+    m_basis->initCalculation();
+    m_basis->generateDensityMatrix();
+  }
 }
 
 GaussianSetTools::~GaussianSetTools()
@@ -51,6 +60,21 @@ bool GaussianSetTools::calculateMolecularOrbital(Cube& cube, int moNumber) const
   return true;
 }
 
+bool GaussianSetTools::calculateMolecularOrbital(AdaptiveCube& cube,
+                                                 int moNumber,
+                                                 double isoValue) const
+{
+  if (moNumber < 0 ||
+      moNumber >= static_cast<int>(m_basis->molecularOrbitalCount())) {
+    return false;
+  }
+  return cube.evaluate(
+    [this, moNumber](const Vector3& position) {
+      return calculateMolecularOrbital(position, moNumber);
+    },
+    isoValue);
+}
+
 double GaussianSetTools::calculateMolecularOrbital(const Vector3& position,
                                                    int mo) const
 {
@@ -78,19 +102,24 @@ double GaussianSetTools::calculateElectronDensity(const Vector3& position) const
     return 0.0;
   }
 
-  vector<double> values(calculateValues(position));
+  return calculateDensity(matrix, calculateValues(position));
+}
 
-  // Now calculate the value of the density at this point in space
-  double rho(0.0);
-  for (int i = 0; i < matrixSize; ++i) {
-    // Calculate the off-diagonal parts of the matrix
-    for (int j = 0; j < i; ++j)
-      rho += 2.0 * matrix(i, j) * (values[i] * values[j]);
-    // Now calculate the matrix diagonal
-    rho += matrix(i, i) * (values[i] * values[i]);
-  }
+bool GaussianSetTools::calculateElectronDensity(AdaptiveCube& cube,
+                                                double isoValue) const
+{
+  // The density matrix may still have to be loaded or generated.
+  m_basis->generateDensityMatrix();
+  const MatrixX& matrix = m_basis->densityMatrix();
+  int matrixSize(static_cast<int>(m_basis->moMatrix().rows()));
+  if (matrix.rows() != matrixSize || matrix.cols() != matrixSize)
+    return false;
 
-  return rho;
+  return cube.evaluate(
+    [this](const Vector3& position) {
+      return calculateElectronDensity(position);
+    },
+    isoValue);
 }
 
 double GaussianSetTools::calculateSpinDensity(const Vector3& position) const
@@ -101,19 +130,46 @@ double GaussianSetTools::calculateSpinDensity(const Vector3& position) const
     return 0.0;
   }
 
+  return calculateDensity(matrix, calculateValues(position));
+}
+
+vector<double> GaussianSetTools::calculateMolecularOrbitals(
+  const Vector3& position, const vector<int>& mos, bool electronDensity) const
+{
+  vector<double> results(mos.size() + (electronDensity ? 1 : 0), 0.0);
+
+  // The basis functions are evaluated once, and contracted with each orbital.
   vector<double> values(calculateValues(position));
+  const MatrixX& matrix = m_basis->moMatrix();
+  Eigen::Map<const Eigen::VectorXd> basisValues(values.data(), matrix.rows());
+  for (size_t i = 0; i < mos.size(); ++i) {
+    if (mos[i] >= 0 && mos[i] < matrix.cols())
+      results[i] = matrix.col(mos[i]).dot(basisValues);
+  }
 
-  // Now calculate the value of the density at this point in space
-  double rho(0.0);
-  for (int i = 0; i < matrixSize; ++i) {
-    // Calculate the off-diagonal parts of the matrix
-    for (int j = 0; j < i; ++j)
-      rho += 2.0 * matrix(i, j) * (values[i] * values[j]);
-    // Now calculate the matrix diagonal
-    rho += matrix(i, i) * (values[i] * values[i]);
+  if (electronDensity) {
+    const MatrixX& density = m_basis->densityMatrix();
+    if (density.rows() == matrix.rows() && density.cols() == matrix.rows())
+      results.back() = calculateDensity(density, values);
   }
 
-  return rho;
+  return results;
+}
+
+bool GaussianSetTools::calculateMolecularOrbitals(
+  const vector<Cube*>& cubes, const vector<int>& molecularOrbitalNumbers) const
+{
+  if (cubes.empty() || cubes.size() != molecularOrbitalNumbers.size())
+    return false;
+
+  const Cube& grid = *cubes.front();
+  for (size_t i = 0; i < grid.data()->size(); ++i) {
+    vector<double> results(
+      calculateMolecularOrbitals(grid.position(i), molecularOrbitalNumbers));
+    for (size_t j = 0; j < cubes.size(); ++j)
+      cubes[j]->setValue(i, results[j]);
+  }
+  return true;
 }
 
 bool GaussianSetTools::isValid() const
@@ -132,54 +188,71 @@ inline bool GaussianSetTools::isSmall(double val) const
     return false;
 }
 
+double GaussianSetTools::calculateDensity(const MatrixX& matrix,
+                                          const vector<double>& values) const
+{
+  int matrixSize(static_cast<int>(matrix.rows()));
+
+  // Now calculate the value of the density at this point in space
+  double rho(0.0);
+  for (int i = 0; i < matrixSize; ++i) {
+    // Calculate the off-diagonal parts of the matrix
+    for (int j = 0; j < i; ++j)
+      rho += 2.0 * matrix(i, j) * (values[i] * values[j]);
+    // Now calculate the matrix diagonal
+    rho += matrix(i, i) * (values[i] * values[i]);
+  }
+
+  return rho;
+}
+
 inline vector<double> GaussianSetTools::calculateValues(
   const Vector3& position) const
 {
-  m_basis->initCalculation();
-  Index atomsSize = m_molecule->atomCount();
-  size_t basisSize = m_basis->symmetry().size();
-  const std::vector<int>& basis = m_basis->symmetry();
-  const std::vector<unsigned int>& atomIndices = m_basis->atomIndices();
-  vector<Vector3> deltas;
-  vector<double> dr2;
-  deltas.reserve(atomsSize);
-  dr2.reserve(atomsSize);
+  const GaussianSet::EvaluationPlan& plan = m_basis->evaluationPlan();
 
   // Calculate our position
   Vector3 pos(position * ANGSTROM_TO_BOHR);
 
-  // Calculate the deltas for the position
-  for (Index i = 0; i < atomsSize; ++i) {
-    deltas.push_back(pos -
-                     (m_molecule->atom(i).position3d() * ANGSTROM_TO_BOHR));
-    dr2.push_back(deltas[i].squaredNorm());
-  }
-
   // Allocate space for the values to be calculated.
   size_t matrixSize = m_basis->moMatrix().rows();
   vector<double> values;
   values.resize(matrixSize, 0.0);
 
-  // Now calculate the values at this point in space
-  for (unsigned int i = 0; i < basisSize; ++i) {
-    switch (basis[i]) {
+  // Now calculate the values at this point in space, the shells are grouped
+  // by atom so the delta is calculated once per atom.
+  Vector3 delta(Vector3::Zero());
+  double dr2 = 0.0;
+  unsigned int atom = static_cast<unsigned int>(-1);
+  for (size_t i = 0; i < plan.shells.size(); ++i) {
+    const GaussianSet::EvaluationShell& shell = plan.shells[i];
+    if (shell.atom != atom) {
+      atom = shell.atom;
+      delta = pos - m_molecule->atomPosition3d(atom) * ANGSTROM_TO_BOHR;
+      dr2 = delta.squaredNorm();
+    }
+    // The shell is negligible this far from its atom.
+    if (dr2 > shell.cutoffSquared)
+      continue;
+
+    switch (shell.type) {
       case GaussianSet::S:
-        pointS(i, dr2[atomIndices[i]], values);
+        pointS(shell, dr2, values);
         break;
       case GaussianSet::P:
-        pointP(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+        pointP(shell, delta, dr2, values);
         break;
       case GaussianSet::D:
-        pointD(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+        pointD(shell, delta, dr2, values);
         break;
       case GaussianSet::D5:
-        pointD5(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+        pointD5(shell, delta, dr2, values);
         break;
       case GaussianSet::F:
-        pointF(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+        pointF(shell, delta, dr2, values);
         break;
       case GaussianSet::F7:
-        pointF7(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+        pointF7(shell, delta, dr2, values);
         break;
       default:
         // Not handled - return a zero contribution
@@ -190,62 +263,61 @@ inline vector<double> GaussianSetTools::calculateValues(
   return values;
 }
 
-inline void GaussianSetTools::pointS(unsigned int moIndex, double dr2,
-                                     vector<double>& values) const
+inline void GaussianSetTools::pointS(const GaussianSet::EvaluationShell& shell,
+                                     double dr2, vector<double>& values) const
 {
+  const GaussianSet::EvaluationPlan& plan = m_basis->evaluationPlan();
+
   // S type orbitals - the simplest of the calculations with one component
   double tmp = 0.0;
-  unsigned int cIndex = m_basis->cIndices()[moIndex];
-  for (unsigned int i = m_basis->gtoIndices()[moIndex];
-       i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
-    tmp += m_basis->gtoCN()[cIndex++] * exp(-m_basis->gtoA()[i] * dr2);
-  }
+  unsigned int cIndex = shell.cIndex;
+  for (unsigned int i = shell.gtoBegin; i < shell.gtoEnd; ++i)
+    tmp += plan.coefficients[cIndex++] * exp(-plan.exponents[i] * dr2);
   // There is one MO coefficient per S shell basis.
-  values[m_basis->moIndices()[moIndex]] = tmp;
+  values[shell.moIndex] = tmp;
 }
 
-inline void GaussianSetTools::pointP(unsigned int moIndex, const Vector3& delta,
-                                     double dr2, vector<double>& values) const
+inline void GaussianSetTools::pointP(const GaussianSet::EvaluationShell& shell,
+                                     const Vector3& delta, double dr2,
+                                     vector<double>& values) const
 {
+  const GaussianSet::EvaluationPlan& plan = m_basis->evaluationPlan();
+
   // P type orbitals have three components and each component has a different
   // independent MO weighting. Many things can be cached to save time though.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
+  unsigned int baseIndex = shell.moIndex;
   Vector3 components(Vector3::Zero());
 
   // Now iterate through the P type GTOs and sum their contributions
-  unsigned int cIndex = m_basis->cIndices()[moIndex];
-  for (unsigned int i = m_basis->gtoIndices()[moIndex];
-       i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
-    double tmpGTO = exp(-m_basis->gtoA()[i] * dr2);
-    for (unsigned int j = 0; j < 3; ++j) {
-      // m_values[baseIndex + i] = m_basis->gtoCN()[cIndex++] * tmpGTO;
-      components[j] += m_basis->gtoCN()[cIndex++] * tmpGTO;
-    }
+  unsigned int cIndex = shell.cIndex;
+  for (unsigned int i = shell.gtoBegin; i < shell.gtoEnd; ++i) {
+    double tmpGTO = exp(-plan.exponents[i] * dr2);
+    for (unsigned int j = 0; j < 3; ++j)
+      components[j] += plan.coefficients[cIndex++] * tmpGTO;
   }
   for (unsigned int i = 0; i < 3; ++i)
     values[baseIndex + i] = components[i] * delta[i];
 }
 
-inline void GaussianSetTools::pointD(unsigned int moIndex, const Vector3& delta,
-                                     double dr2, vector<double>& values) const
+inline void GaussianSetTools::pointD(const GaussianSet::EvaluationShell& shell,
+                                     const Vector3& delta, double dr2,
+                                     vector<double>& values) const
 {
+  const GaussianSet::EvaluationPlan& plan = m_basis->evaluationPlan();
+
   // D type orbitals have six components and each component has a different
   // independent MO weighting. Many things can be cached to save time though.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
+  unsigned int baseIndex = shell.moIndex;
 
   double components[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 
-  vector<double>& gtoA = m_basis->gtoA();
-  vector<double>& gtoCN = m_basis->gtoCN();
-
   // Now iterate through the D type GTOs and sum their contributions
-  unsigned int cIndex = m_basis->cIndices()[moIndex];
-  for (unsigned int i = m_basis->gtoIndices()[moIndex];
-       i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
+  unsigned int cIndex = shell.cIndex;
+  for (unsigned int i = shell.gtoBegin; i < shell.gtoEnd; ++i) {
     // Calculate the common factor
-    double tmpGTO = exp(-gtoA[i] * dr2);
+    double tmpGTO = exp(-plan.exponents[i] * dr2);
     for (int j = 0; j < 6; ++j)
-      components[j] += gtoCN[cIndex++] * tmpGTO;
+      components[j] += plan.coefficients[cIndex++] * tmpGTO;
   }
 
   double componentsD[6] = { delta.x() * delta.x(),   // xx
@@ -259,26 +331,24 @@ inline void GaussianSetTools::pointD(unsigned int moIndex, const Vector3& delta,
     values[baseIndex + i] += components[i] * componentsD[i];
 }
 
-inline void GaussianSetTools::pointD5(unsigned int moIndex,
-                                      const Vector3& delta, double dr2,
-                                      vector<double>& values) const
+inline void GaussianSetTools::pointD5(
+  const GaussianSet::EvaluationShell& shell, const Vector3& delta, double dr2,
+  vector<double>& values) const
 {
+  const GaussianSet::EvaluationPlan& plan = m_basis->evaluationPlan();
+
   // D type orbitals have five components and each component has a different
   // MO weighting. Many things can be cached to save time.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
+  unsigned int baseIndex = shell.moIndex;
   double components[5] = { 0.0, 0.0, 0.0, 0.0, 0.0 };
 
-  vector<double>& gtoA = m_basis->gtoA();
-  vector<double>& gtoCN = m_basis->gtoCN();
-
   // Now iterate through the D type GTOs and sum their contributions
-  unsigned int cIndex = m_basis->cIndices()[moIndex];
-  for (unsigned int i = m_basis->gtoIndices()[moIndex];
-       i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
+  unsigned int cIndex = shell.cIndex;
+  for (unsigned int i = shell.gtoBegin; i < shell.gtoEnd; ++i) {
     // Calculate the common factor
-    double tmpGTO = exp(-gtoA[i] * dr2);
+    double tmpGTO = exp(-plan.exponents[i] * dr2);
     for (int j = 0; j < 5; ++j)
-      components[j] += gtoCN[cIndex++] * tmpGTO;
+      components[j] += plan.coefficients[cIndex++] * tmpGTO;
   }
 
   // Calculate the prefactors
@@ -298,26 +368,25 @@ inline void GaussianSetTools::pointD5(unsigned int moIndex,
   for (int i = 0; i < 5; ++i)
     values[baseIndex + i] += componentsD[i] * components[i];
 }
-inline void GaussianSetTools::pointF(unsigned int moIndex, const Vector3& delta,
-                                     double dr2, vector<double>& values) const
+inline void GaussianSetTools::pointF(const GaussianSet::EvaluationShell& shell,
+                                     const Vector3& delta, double dr2,
+                                     vector<double>& values) const
 {
+  const GaussianSet::EvaluationPlan& plan = m_basis->evaluationPlan();
+
   // F type orbitals have 10 components and each component has a different
   // independent MO weighting. Many things can be cached to save time though.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
+  unsigned int baseIndex = shell.moIndex;
 
   double components[10] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 
-  vector<double>& gtoA = m_basis->gtoA();
-  vector<double>& gtoCN = m_basis->gtoCN();
-
   // Now iterate through the D type GTOs and sum their contributions
-  unsigned int cIndex = m_basis->cIndices()[moIndex];
-  for (unsigned int i = m_basis->gtoIndices()[moIndex];
-       i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
+  unsigned int cIndex = shell.cIndex;
+  for (unsigned int i = shell.gtoBegin; i < shell.gtoEnd; ++i) {
     // Calculate the common factor
-    double tmpGTO = exp(-gtoA[i] * dr2);
+    double tmpGTO = exp(-plan.exponents[i] * dr2);
     for (int j = 0; j < 10; ++j)
-      components[j] += gtoCN[cIndex++] * tmpGTO;
+      components[j] += plan.coefficients[cIndex++] * tmpGTO;
   }
   double componentsF[10] = {
     delta.x() * delta.x() * delta.x(), // xxx
@@ -336,27 +405,25 @@ inline void GaussianSetTools::pointF(unsigned int moIndex, const Vector3& delta,
     values[baseIndex + i] += components[i] * componentsF[i];
 }
 
-inline void GaussianSetTools::pointF7(unsigned int moIndex,
-                                      const Vector3& delta, double dr2,
-                                      vector<double>& values) const
+inline void GaussianSetTools::pointF7(
+  const GaussianSet::EvaluationShell& shell, const Vector3& delta, double dr2,
+  vector<double>& values) const
 {
+  const GaussianSet::EvaluationPlan& plan = m_basis->evaluationPlan();
+
   // F type orbitals have 7 components and each component has a different
   // independent MO weighting. Many things can be cached to save time though.
-  unsigned int baseIndex = m_basis->moIndices()[moIndex];
+  unsigned int baseIndex = shell.moIndex;
 
   double components[7] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 
-  vector<double>& gtoA = m_basis->gtoA();
-  vector<double>& gtoCN = m_basis->gtoCN();
-
   // Now iterate through the D type GTOs and sum their contributions
-  unsigned int cIndex = m_basis->cIndices()[moIndex];
-  for (unsigned int i = m_basis->gtoIndices()[moIndex];
-       i < m_basis->gtoIndices()[moIndex + 1]; ++i) {
+  unsigned int cIndex = shell.cIndex;
+  for (unsigned int i = shell.gtoBegin; i < shell.gtoEnd; ++i) {
     // Calculate the common factor
-    double tmpGTO = exp(-gtoA[i] * dr2);
+    double tmpGTO = exp(-plan.exponents[i] * dr2);
     for (int j = 0; j < 7; ++j)
-      components[j] += gtoCN[cIndex++] * tmpGTO;
+      components[j] += plan.coefficients[cIndex++] * tmpGTO;
   }
 
   double xxx = delta.x() * delta.x() * delta.x(); // xxx
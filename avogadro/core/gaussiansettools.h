@@ -21,6 +21,7 @@
 
 #include "avogadrocore.h"
 
+#include "gaussianset.h"
 #include "vector.h"
 
 #include <vector>
@@ -28,8 +29,8 @@
 namespace Avogadro {
 namespace Core {
 
+class AdaptiveCube;
 class Cube;
-class GaussianSet;
 class Molecule;
 
 /**
@@ -37,6 +38,10 @@ class Molecule;
  * @brief Provide tools to calculate molecular orbitals, electron densities and
  * other derived data stored in a GaussianSet result.
  * @author Marcus D. Hanwell
+ *
+ * The evaluation plan of the basis set is built, and its density matrices
+ * loaded or generated, when the tools are constructed. The shells must not
+ * change afterwards.
  */
 
 class AVOGADROCORE_EXPORT GaussianSetTools
@@ -53,6 +58,17 @@ public:
    */
   bool calculateMolecularOrbital(Cube& cube, int molecularOrbitalNumber) const;
 
+  /**
+   * @brief Evaluate the molecular orbital on the adaptive cube, refined where
+   * its isosurfaces at @p isoValue and -@p isoValue may pass.
+   * @param cube The adaptive cube, with its limits set.
+   * @param molecularOrbitalNumber The molecular orbital number.
+   * @param isoValue The isovalue of the surfaces.
+   * @return True on success, false on failure.
+   */
+  bool calculateMolecularOrbital(AdaptiveCube& cube, int molecularOrbitalNumber,
+                                 double isoValue) const;
+
   /**
    * @brief Calculate the value of the specified molecular orbital at the
    * position specified.
@@ -71,6 +87,13 @@ public:
    */
   double calculateElectronDensity(const Vector3& position) const;
 
+  /**
+   * @brief Evaluate the electron density on the adaptive cube, refined where
+   * its isosurface at @p isoValue may pass.
+   * @return True on success, false on failure.
+   */
+  bool calculateElectronDensity(AdaptiveCube& cube, double isoValue) const;
+
   /**
    * @brief Calculate the value of the electron spin density at the position
    * specified.
@@ -79,6 +102,31 @@ public:
    */
   double calculateSpinDensity(const Vector3& position) const;
 
+  /**
+   * @brief Calculate the values of several molecular orbitals at the position
+   * specified. The basis functions are evaluated once for all of them.
+   * @param position The position in space to calculate the values.
+   * @param molecularOrbitalNumbers The molecular orbital numbers.
+   * @param electronDensity Also calculate the electron density.
+   * @return The values of the molecular orbitals, in the order of the numbers,
+   * followed by the electron density if requested.
+   */
+  std::vector<double> calculateMolecularOrbitals(
+    const Vector3& position, const std::vector<int>& molecularOrbitalNumbers,
+    bool electronDensity = false) const;
+
+  /**
+   * @brief Populate the cubes with values for the molecular orbitals, in one
+   * sweep over the points.
+   * @param cubes The cubes to be populated, one per molecular orbital. They
+   * must have the same limits.
+   * @param molecularOrbitalNumbers The molecular orbital numbers.
+   * @return True on success, false on failure.
+   */
+  bool calculateMolecularOrbitals(
+    const std::vector<Cube*>& cubes,
+    const std::vector<int>& molecularOrbitalNumbers) const;
+
   /**
    * @brief Check that the basis set is valid and can be used.
    * @return True if valid, false otherwise.
@@ -91,6 +139,12 @@ private:
 
   bool isSmall(double value) const;
 
+  /**
+   * @brief Contract the values of the basis functions with a density matrix.
+   */
+  double calculateDensity(const MatrixX& matrix,
+                          const std::vector<double>& values) const;
+
   /**
    * @brief Calculate the values at this position in space. The public calculate
    * functions call this function to prepare values before multiplying by the
@@ -99,18 +153,18 @@ private:
    */
   std::vector<double> calculateValues(const Vector3& position) const;
 
-  void pointS(unsigned int index, double dr2,
-              std::vector<double>& values) const;
-  void pointP(unsigned int index, const Vector3& delta, double dr2,
-              std::vector<double>& values) const;
-  void pointD(unsigned int index, const Vector3& delta, double dr2,
-              std::vector<double>& values) const;
-  void pointD5(unsigned int index, const Vector3& delta, double dr2,
-               std::vector<double>& values) const;
-  void pointF(unsigned int index, const Vector3& delta, double dr2,
+  void pointS(const GaussianSet::EvaluationShell& shell, double dr2,
               std::vector<double>& values) const;
-  void pointF7(unsigned int index, const Vector3& delta, double dr2,
-               std::vector<double>& values) const;
+  void pointP(const GaussianSet::EvaluationShell& shell, const Vector3& delta,
+              double dr2, std::vector<double>& values) const;
+  void pointD(const GaussianSet::EvaluationShell& shell, const Vector3& delta,
+              double dr2, std::vector<double>& values) const;
+  void pointD5(const GaussianSet::EvaluationShell& shell, const Vector3& delta,
+               double dr2, std::vector<double>& values) const;
+  void pointF(const GaussianSet::EvaluationShell& shell, const Vector3& delta,
+              double dr2, std::vector<double>& values) const;
+  void pointF7(const GaussianSet::EvaluationShell& shell, const Vector3& delta,
+               double dr2, std::vector<double>& values) const;
 };
 
 } // End Core namespace
@@ -323,6 +323,28 @@ Molecule::AtomType Molecule::addAtom(unsigned char number)
   return AtomType(this, static_cast<Index>(m_atomicNumbers.size() - 1));
 }
 
+bool Molecule::addAtoms(const Array<unsigned char>& atomicNumbers,
+                        const Array<Vector3>& positions)
+{
+  if (!positions.empty() && positions.size() != atomicNumbers.size())
+    return false;
+  if (atomicNumbers.empty())
+    return true;
+
+  m_graphDirty = true;
+  const Index oldSize = atomCount();
+  m_atomicNumbers.insert(m_atomicNumbers.end(), atomicNumbers.begin(),
+                         atomicNumbers.end());
+  if (!positions.empty()) {
+    // Atoms added without positions are placed at the origin, as with
+    // setAtomPosition3d().
+    m_positions3d.resize(oldSize, Vector3::Zero());
+    m_positions3d.insert(m_positions3d.end(), positions.begin(),
+                         positions.end());
+  }
+  return true;
+}
+
 bool Molecule::removeAtom(Index index)
 {
   if (index >= atomCount())
@@ -380,6 +402,79 @@ bool Molecule::removeAtom(const AtomType& atom_)
   return removeAtom(atom_.index());
 }
 
+bool Molecule::removeAtoms(const Array<Index>& indices)
+{
+  // Map the old atom indices to the new ones, MaxIndex marks removed atoms.
+  const Index numAtoms = atomCount();
+  std::vector<Index> newIndices(numAtoms, 0);
+  bool removed = false;
+  for (Array<Index>::const_iterator it = indices.begin(), itEnd = indices.end();
+       it != itEnd; ++it) {
+    if (*it < numAtoms) {
+      newIndices[*it] = MaxIndex;
+      removed = true;
+    }
+  }
+  if (!removed)
+    return false;
+
+  // Compact the atom arrays, keeping the order of the remaining atoms.
+  const bool has2d = m_positions2d.size() == numAtoms;
+  const bool has3d = m_positions3d.size() == numAtoms;
+  const bool hasHybridizations = m_hybridizations.size() == numAtoms;
+  const bool hasCharges = m_formalCharges.size() == numAtoms;
+  const bool hasSelection = m_selectedAtoms.size() == numAtoms;
+  Index newSize = 0;
+  for (Index i = 0; i < numAtoms; ++i) {
+    if (newIndices[i] == MaxIndex)
+      continue;
+    newIndices[i] = newSize;
+    if (i != newSize) {
+      m_atomicNumbers[newSize] = m_atomicNumbers[i];
+      if (has2d)
+        m_positions2d[newSize] = m_positions2d[i];
+      if (has3d)
+        m_positions3d[newSize] = m_positions3d[i];
+      if (hasHybridizations)
+        m_hybridizations[newSize] = m_hybridizations[i];
+      if (hasCharges)
+        m_formalCharges[newSize] = m_formalCharges[i];
+      if (hasSelection)
+        m_selectedAtoms[newSize] = m_selectedAtoms[i];
+    }
+    ++newSize;
+  }
+  m_atomicNumbers.resize(newSize);
+  if (has2d)
+    m_positions2d.resize(newSize);
+  if (has3d)
+    m_positions3d.resize(newSize);
+  if (hasHybridizations)
+    m_hybridizations.resize(newSize);
+  if (hasCharges)
+    m_formalCharges.resize(newSize);
+  if (hasSelection)
+    m_selectedAtoms.resize(newSize);
+
+  // Drop the bonds to removed atoms, and renumber the others.
+  Index newBondCount = 0;
+  for (Index i = 0; i < m_bondPairs.size(); ++i) {
+    std::pair<Index, Index> pair = m_bondPairs[i];
+    pair.first = newIndices[pair.first];
+    pair.second = newIndices[pair.second];
+    if (pair.first == MaxIndex || pair.second == MaxIndex)
+      continue;
+    m_bondPairs[newBondCount] = pair;
+    m_bondOrders[newBondCount] = m_bondOrders[i];
+    ++newBondCount;
+  }
+  m_bondPairs.resize(newBondCount);
+  m_bondOrders.resize(newBondCount);
+
+  m_graphDirty = true;
+  return true;
+}
+
 void Molecule::clearAtoms()
 {
   while (atomCount() != 0)
@@ -444,6 +539,32 @@ Molecule::BondType Molecule::addBond(const AtomType& a, const AtomType& b,
   return BondType(this, static_cast<Index>(m_bondPairs.size() - 1));
 }
 
+bool Molecule::addBonds(const Array<std::pair<Index, Index>>& pairs,
+                        const Array<unsigned char>& orders)
+{
+  if (pairs.size() != orders.size())
+    return false;
+  const Index numAtoms = atomCount();
+  for (Array<std::pair<Index, Index>>::const_iterator it = pairs.begin(),
+                                                      itEnd = pairs.end();
+       it != itEnd; ++it) {
+    if (it->first >= numAtoms || it->second >= numAtoms)
+      return false;
+  }
+  if (pairs.empty())
+    return true;
+
+  m_graphDirty = true;
+  m_bondPairs.reserve(m_bondPairs.size() + pairs.size());
+  for (Array<std::pair<Index, Index>>::const_iterator it = pairs.begin(),
+                                                      itEnd = pairs.end();
+       it != itEnd; ++it) {
+    m_bondPairs.push_back(makeBondPair(it->first, it->second));
+  }
+  m_bondOrders.insert(m_bondOrders.end(), orders.begin(), orders.end());
+  return true;
+}
+
 bool Molecule::removeBond(Index index)
 {
   if (index >= bondCount())
@@ -743,7 +864,7 @@ void Molecule::perceiveBondsSimple()
   }
 }
 
-int Molecule::coordinate3dCount()
+int Molecule::coordinate3dCount() const
 {
   return static_cast<int>(m_coordinates3d.size());
 }
@@ -343,6 +343,16 @@ public:
   /**  Adds an atom to the molecule. */
   virtual AtomType addAtom(unsigned char atomicNumber);
 
+  /**
+   * @brief Add several atoms to the end of the molecule at once.
+   * @param atomicNumbers The atomic numbers of the new atoms.
+   * @param positions The 3D positions of the new atoms, either empty or of the
+   * same size as @a atomicNumbers.
+   * @return False if the sizes do not match, in which case nothing is added.
+   */
+  virtual bool addAtoms(const Array<unsigned char>& atomicNumbers,
+                        const Array<Vector3>& positions = Array<Vector3>());
+
   /**
    * @brief Remove the specified atom from the molecule.
    * @param index The index of the atom to be removed.
@@ -358,6 +368,16 @@ public:
    */
   virtual bool removeAtom(const AtomType& atom);
 
+  /**
+   * @brief Remove several atoms from the molecule at once, along with any
+   * bonds to them. The remaining atoms keep their relative order. This is much
+   * faster than calling removeAtom() for each atom of a large molecule.
+   * @param indices The indices of the atoms to be removed, in any order.
+   * Invalid and repeated indices are ignored.
+   * @return True if any atom was removed.
+   */
+  virtual bool removeAtoms(const Array<Index>& indices);
+
   /**
    * Remove all atoms from the molecule.
    */
@@ -394,6 +414,16 @@ public:
                            unsigned char order = 1);
   /** @} */
 
+  /**
+   * @brief Add several bonds to the molecule at once.
+   * @param pairs The indices of the atoms of each new bond.
+   * @param orders The bond orders, of the same size as @a pairs.
+   * @return False if the sizes do not match or an atom does not exist, in
+   * which case nothing is added.
+   */
+  virtual bool addBonds(const Array<std::pair<Index, Index>>& pairs,
+                        const Array<unsigned char>& orders);
+
   /**
    * @brief Remove the specified bond.
    * @param index The index of the bond to be removed.
@@ -528,11 +558,19 @@ public:
    */
   void perceiveBondsSimple();
 
-  int coordinate3dCount();
+  int coordinate3dCount() const;
   bool setCoordinate3d(int coord);
   int coordinate3d() const;
   bool setCoordinate3d(const Array<Vector3>& coords, int index);
 
+  /**
+   * @return The 3D coordinate set @a index, e.g. a frame of a trajectory.
+   */
+  const Array<Vector3>& coordinate3dSet(int index) const
+  {
+    return m_coordinates3d[index];
+  }
+
 protected:
   mutable Graph m_graph;     // A transformation of the molecule to a graph.
   mutable bool m_graphDirty; // Should the graph be rebuilt before returning it?
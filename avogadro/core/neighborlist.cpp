@@ -0,0 +1,290 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "neighborlist.h"
+
+#include "parallel.h"
+#include "unitcell.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace Avogadro {
+namespace Core {
+
+namespace {
+// Keep the number of grid cells proportional to the number of atoms.
+const Index maxGridCellsPerAtom = 2;
+const int maxGridCells = 1 << 10;
+
+// Division rounding towards negative infinity.
+inline int floorDiv(int a, int b)
+{
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// The candidates found by one thread, for a contiguous range of atoms.
+struct SearchBlock
+{
+  std::vector<Index> counts;
+  std::vector<Index> neighbors;
+  std::vector<Vector3i> images;
+};
+}
+
+NeighborList::NeighborList()
+  : m_cutoff(0.0), m_skin(0.0), m_maxThreads(0), m_rebuilt(false),
+    m_searchCutoff(0.0), m_searchCell(Matrix3::Zero())
+{
+}
+
+NeighborList::~NeighborList()
+{
+}
+
+bool NeighborList::build(const UnitCell& cell, const Array<Vector3>& positions)
+{
+  m_rebuilt = true;
+  if (m_cutoff <= 0.0 || cell.volume() <= 1e-8 || !search(cell, positions)) {
+    clear();
+    return false;
+  }
+  filter(cell, positions);
+  return true;
+}
+
+bool NeighborList::update(const UnitCell& cell,
+                          const Array<Vector3>& positions)
+{
+  if (m_skin <= 0.0 || m_candidateOffsets.empty() ||
+      positions.size() != m_searchPositions.size() ||
+      cell.cellMatrix() != m_searchCell ||
+      m_cutoff + m_skin != m_searchCutoff) {
+    return build(cell, positions);
+  }
+
+  // The candidates are still complete while no atom moved by more than half
+  // of the skin.
+  const Real maxDisplacement2 = 0.25 * m_skin * m_skin;
+  for (Index i = 0; i < positions.size(); ++i) {
+    if ((positions[i] - m_searchPositions[i]).squaredNorm() >
+        maxDisplacement2) {
+      return build(cell, positions);
+    }
+  }
+
+  m_rebuilt = false;
+  filter(cell, positions);
+  return true;
+}
+
+void NeighborList::clear()
+{
+  m_searchCutoff = 0.0;
+  m_searchCell = Matrix3::Zero();
+  m_searchPositions.clear();
+  m_candidateOffsets.clear();
+  m_candidates.clear();
+  m_candidateImages.clear();
+  m_offsets.clear();
+  m_neighbors.clear();
+  m_images.clear();
+  m_distances.clear();
+}
+
+bool NeighborList::search(const UnitCell& cell,
+                          const Array<Vector3>& positions)
+{
+  const Matrix3& cellMatrix = cell.cellMatrix();
+  const Matrix3& fracMatrix = cell.fractionalMatrix();
+  const Real cutoff = m_cutoff + m_skin;
+  const Real cutoff2 = cutoff * cutoff;
+  const Index numAtoms = positions.size();
+
+  // The grid cells are at least as wide as the cutoff, measured between the
+  // opposite faces, unless the unit cell is thinner than that.
+  int dims[3];
+  for (int i = 0; i < 3; ++i) {
+    Real cells = std::floor(1.0 / (cutoff * fracMatrix.row(i).norm()));
+    dims[i] = static_cast<int>(std::max(
+      static_cast<Real>(1.0),
+      std::min(cells, static_cast<Real>(maxGridCells))));
+  }
+  const Index maxCells = maxGridCellsPerAtom * numAtoms + 8;
+  while (static_cast<Index>(dims[0]) * dims[1] * dims[2] > maxCells) {
+    int* largest = std::max_element(dims, dims + 3);
+    *largest = (*largest + 1) / 2;
+  }
+  // The number of grid cells to search on each side, more than one when the
+  // cutoff reaches past the next periodic image.
+  int reach[3];
+  for (int i = 0; i < 3; ++i) {
+    reach[i] = static_cast<int>(
+      std::ceil(cutoff * fracMatrix.row(i).norm() * dims[i] - 1e-10));
+    reach[i] = std::max(reach[i], 1);
+  }
+  const Index numCells = static_cast<Index>(dims[0]) * dims[1] * dims[2];
+
+  // Wrap the atoms into the unit cell (in cartesian coordinates), remembering
+  // the image they came from, and sort them by grid cell.
+  std::vector<Vector3> wrapped(numAtoms);
+  std::vector<Vector3i> shifts(numAtoms);
+  std::vector<Vector3i> atomCells(numAtoms);
+  std::vector<Index> cellStart(numCells + 1, 0);
+  for (Index i = 0; i < numAtoms; ++i) {
+    Vector3 frac = fracMatrix * positions[i];
+    for (int dim = 0; dim < 3; ++dim) {
+      Real shift = std::floor(frac[dim]);
+      frac[dim] -= shift;
+      shifts[i][dim] = static_cast<int>(shift);
+      atomCells[i][dim] =
+        std::min(static_cast<int>(frac[dim] * dims[dim]), dims[dim] - 1);
+    }
+    wrapped[i] = cellMatrix * frac;
+    ++cellStart[(atomCells[i][0] * dims[1] + atomCells[i][1]) * dims[2] +
+                atomCells[i][2] + 1];
+  }
+  for (Index c = 0; c < numCells; ++c)
+    cellStart[c + 1] += cellStart[c];
+  std::vector<Index> cellAtoms(numAtoms);
+  {
+    std::vector<Index> next(cellStart.begin(), cellStart.end() - 1);
+    for (Index i = 0; i < numAtoms; ++i) {
+      const Vector3i& c = atomCells[i];
+      cellAtoms[next[(c[0] * dims[1] + c[1]) * dims[2] + c[2]]++] = i;
+    }
+  }
+
+  // Compare each atom with the atoms of the grid cells around it, in every
+  // periodic image those grid cells are reached in.
+  std::mutex blocksMutex;
+  std::map<Index, SearchBlock> blocks;
+  Index searchedCells = static_cast<Index>(2 * reach[0] + 1) *
+                        (2 * reach[1] + 1) * (2 * reach[2] + 1);
+  Index cost = searchedCells * (numAtoms / numCells + 1);
+  parallelFor(
+    numAtoms, cost,
+    [&](Index first, Index last) {
+      SearchBlock block;
+      block.counts.resize(last - first, 0);
+      for (Index i = first; i < last; ++i) {
+        const Vector3i& home = atomCells[i];
+        for (int a = home[0] - reach[0]; a <= home[0] + reach[0]; ++a) {
+          int imageA = floorDiv(a, dims[0]);
+          int cellA = a - imageA * dims[0];
+          for (int b = home[1] - reach[1]; b <= home[1] + reach[1]; ++b) {
+            int imageB = floorDiv(b, dims[1]);
+            int cellB = b - imageB * dims[1];
+            for (int c = home[2] - reach[2]; c <= home[2] + reach[2]; ++c) {
+              int imageC = floorDiv(c, dims[2]);
+              int cellC = c - imageC * dims[2];
+              Index gridCell = (cellA * dims[1] + cellB) * dims[2] + cellC;
+              // The position of the home atom relative to the image.
+              Vector3 origin =
+                wrapped[i] - cellMatrix * Vector3(static_cast<Real>(imageA),
+                                                  static_cast<Real>(imageB),
+                                                  static_cast<Real>(imageC));
+              bool sameImage = imageA == 0 && imageB == 0 && imageC == 0;
+              for (Index k = cellStart[gridCell]; k < cellStart[gridCell + 1];
+                   ++k) {
+                Index j = cellAtoms[k];
+                if (j == i && sameImage)
+                  continue;
+                if ((wrapped[j] - origin).squaredNorm() > cutoff2)
+                  continue;
+                // The image relative to the unwrapped positions.
+                block.neighbors.push_back(j);
+                block.images.push_back(Vector3i(imageA, imageB, imageC) +
+                                       shifts[i] - shifts[j]);
+                ++block.counts[i - first];
+              }
+            }
+          }
+        }
+      }
+      std::lock_guard<std::mutex> lock(blocksMutex);
+      std::swap(blocks[first], block);
+    },
+    m_maxThreads);
+
+  // Gather the blocks, which cover contiguous ranges of atoms, in order.
+  m_candidateOffsets.assign(numAtoms + 1, 0);
+  m_candidates.clear();
+  m_candidateImages.clear();
+  for (std::map<Index, SearchBlock>::iterator it = blocks.begin();
+       it != blocks.end(); ++it) {
+    const SearchBlock& block = it->second;
+    for (Index i = 0; i < block.counts.size(); ++i) {
+      m_candidateOffsets[it->first + i + 1] =
+        m_candidateOffsets[it->first + i] + block.counts[i];
+    }
+    m_candidates.insert(m_candidates.end(), block.neighbors.begin(),
+                        block.neighbors.end());
+    m_candidateImages.insert(m_candidateImages.end(), block.images.begin(),
+                             block.images.end());
+  }
+
+  m_searchCutoff = cutoff;
+  m_searchCell = cellMatrix;
+  m_searchPositions = positions;
+  return true;
+}
+
+void NeighborList::filter(const UnitCell& cell,
+                          const Array<Vector3>& positions)
+{
+  const Matrix3& cellMatrix = cell.cellMatrix();
+  const Real cutoff2 = m_cutoff * m_cutoff;
+  const Index numAtoms = positions.size();
+  const Index numCandidates = m_candidates.size();
+
+  // The distance of every candidate pair, negative when out of range.
+  std::vector<Real> distances(numCandidates);
+  parallelFor(
+    numAtoms, numCandidates / (numAtoms + 1) + 1,
+    [&](Index first, Index last) {
+      for (Index i = first; i < last; ++i) {
+        for (Index k = m_candidateOffsets[i]; k < m_candidateOffsets[i + 1];
+             ++k) {
+          Vector3 delta = positions[m_candidates[k]] - positions[i] +
+                          cellMatrix * m_candidateImages[k].cast<Real>();
+          Real distance2 = delta.squaredNorm();
+          distances[k] = distance2 <= cutoff2 ? std::sqrt(distance2) : -1.0;
+        }
+      }
+    },
+    m_maxThreads);
+
+  m_offsets.assign(numAtoms + 1, 0);
+  m_neighbors.clear();
+  m_images.clear();
+  m_distances.clear();
+  for (Index i = 0; i < numAtoms; ++i) {
+    for (Index k = m_candidateOffsets[i]; k < m_candidateOffsets[i + 1]; ++k) {
+      if (distances[k] < 0.0)
+        continue;
+      m_neighbors.push_back(m_candidates[k]);
+      m_images.push_back(m_candidateImages[k]);
+      m_distances.push_back(distances[k]);
+    }
+    m_offsets[i + 1] = m_neighbors.size();
+  }
+}
+
+} // end Core namespace
+} // end Avogadro namespace
@@ -0,0 +1,163 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_NEIGHBORLIST_H
+#define AVOGADRO_CORE_NEIGHBORLIST_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "matrix.h"
+#include "vector.h"
+
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class UnitCell;
+
+/**
+ * @class NeighborList neighborlist.h <avogadro/core/neighborlist.h>
+ * @brief The NeighborList class finds the pairs of atoms of a periodic system
+ * that are closer than a cutoff distance.
+ *
+ * The atoms are sorted into a grid of cells over the (possibly triclinic) unit
+ * cell, and each atom is only compared with the atoms of the nearby grid
+ * cells. Cutoffs larger than half of the unit cell are handled by searching
+ * the periodic images further away, so an atom may be a neighbor of several
+ * images of another atom, or of its own images.
+ *
+ * The result is stored in compressed sparse row form: the neighbors of atom
+ * @c i are the entries from offsets()[i] up to offsets()[i + 1] of
+ * neighbors(), images() and distances(). Every pair is listed for both of its
+ * atoms. The neighbor @c j with image @c n is at the position
+ * positions[j] + cell.imageOffset(n[0], n[1], n[2]).
+ *
+ * For trajectories, a Verlet skin avoids repeating the search in every frame:
+ * the candidate pairs closer than cutoff() + skin() are kept, and update()
+ * only searches again once an atom moved by more than half of the skin.
+ */
+class AVOGADROCORE_EXPORT NeighborList
+{
+public:
+  NeighborList();
+  ~NeighborList();
+
+  /**
+   * The cutoff distance in Angstrom, 0 by default.
+   * @{
+   */
+  void setCutoff(Real cutoff) { m_cutoff = cutoff; }
+  Real cutoff() const { return m_cutoff; }
+  /** @} */
+
+  /**
+   * The Verlet skin in Angstrom, 0 by default so that every update() searches
+   * again.
+   * @{
+   */
+  void setSkin(Real skin) { m_skin = skin; }
+  Real skin() const { return m_skin; }
+  /** @} */
+
+  /**
+   * The maximum number of threads used, or 0 (the default) to use one per
+   * hardware thread.
+   * @{
+   */
+  void setMaxThreads(int threads) { m_maxThreads = threads; }
+  int maxThreads() const { return m_maxThreads; }
+  /** @} */
+
+  /**
+   * Find the neighbors of the atoms at @a positions (in cartesian
+   * coordinates) in the periodic system described by @a cell.
+   * @return False if the cutoff is not positive or the cell is degenerate, in
+   * which case the list is cleared.
+   */
+  bool build(const UnitCell& cell, const Array<Vector3>& positions);
+
+  /**
+   * Update the neighbors for new @a positions, e.g. from the next frame of a
+   * trajectory. The search is only repeated if the cell, the number of atoms
+   * or the parameters changed, or if an atom moved by more than half of the
+   * skin since the last search. Otherwise only the distances of the candidate
+   * pairs are updated.
+   * @return False if the cutoff is not positive or the cell is degenerate.
+   */
+  bool update(const UnitCell& cell, const Array<Vector3>& positions);
+
+  /**
+   * @return True if the last build() or update() searched for the candidate
+   * pairs.
+   */
+  bool wasRebuilt() const { return m_rebuilt; }
+
+  /** Clear the neighbors and the candidate pairs. */
+  void clear();
+
+  /** @return The number of atoms of the last build() or update(). */
+  Index atomCount() const
+  {
+    return m_offsets.empty() ? 0 : m_offsets.size() - 1;
+  }
+
+  /** @return The number of neighbors of @a atom. */
+  Index neighborCount(Index atom) const
+  {
+    return m_offsets[atom + 1] - m_offsets[atom];
+  }
+
+  /**
+   * The neighbors in compressed sparse row form: the start of the neighbors
+   * of each atom (with an extra entry for the end), the index of each
+   * neighbor, its image and its distance to the atom.
+   * @{
+   */
+  const std::vector<Index>& offsets() const { return m_offsets; }
+  const std::vector<Index>& neighbors() const { return m_neighbors; }
+  const std::vector<Vector3i>& images() const { return m_images; }
+  const std::vector<Real>& distances() const { return m_distances; }
+  /** @} */
+
+private:
+  bool search(const UnitCell& cell, const Array<Vector3>& positions);
+  void filter(const UnitCell& cell, const Array<Vector3>& positions);
+
+  Real m_cutoff;
+  Real m_skin;
+  int m_maxThreads;
+  bool m_rebuilt;
+
+  // The candidate pairs, closer than the cutoff plus the skin when searched.
+  Real m_searchCutoff;
+  Matrix3 m_searchCell;
+  Array<Vector3> m_searchPositions;
+  std::vector<Index> m_candidateOffsets;
+  std::vector<Index> m_candidates;
+  std::vector<Vector3i> m_candidateImages;
+
+  std::vector<Index> m_offsets;
+  std::vector<Index> m_neighbors;
+  std::vector<Vector3i> m_images;
+  std::vector<Real> m_distances;
+};
+
+} // end Core namespace
+} // end Avogadro namespace
+
+#endif // AVOGADRO_CORE_NEIGHBORLIST_H
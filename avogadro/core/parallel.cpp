@@ -0,0 +1,56 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+void parallelFor(Index count, Index cost,
+                 const std::function<void(Index, Index)>& body, int maxThreads)
+{
+  if (count == 0)
+    return;
+
+  // Below this much work per thread, starting a thread costs more than it
+  // saves.
+  const Index minCostPerThread = 1 << 14;
+  Index numThreads = maxThreads > 0
+                       ? static_cast<Index>(maxThreads)
+                       : std::max(std::thread::hardware_concurrency(), 1u);
+  numThreads = std::min(numThreads, std::max(count * cost, Index(1)) /
+                                      minCostPerThread);
+  numThreads = std::min(numThreads, count);
+  if (numThreads <= 1) {
+    body(0, count);
+    return;
+  }
+
+  Index chunk = (count + numThreads - 1) / numThreads;
+  std::vector<std::thread> threads;
+  for (Index first = chunk; first < count; first += chunk)
+    threads.push_back(std::thread(body, first, std::min(first + chunk, count)));
+  body(0, chunk);
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i].join();
+}
+
+} // end Core namespace
+} // end Avogadro namespace
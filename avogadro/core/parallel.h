@@ -0,0 +1,49 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_PARALLEL_H
+#define AVOGADRO_CORE_PARALLEL_H
+
+#include "avogadrocore.h"
+
+#include <functional>
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @brief Run a loop over the indices [0, @p count) on several threads.
+ *
+ * The range is split into contiguous blocks, and @p body is called once per
+ * block with its first index and one past its last index. The calling thread
+ * processes the first block, and the call returns once all blocks are done.
+ * Loops with a total cost (@p count times @p cost, roughly the number of
+ * elementary operations of an index) too small to pay for starting threads
+ * run on the calling thread only.
+ * @param count The number of indices.
+ * @param cost The relative cost of processing one index.
+ * @param body The function processing a block of indices.
+ * @param maxThreads The maximum number of threads to use, or 0 to use one per
+ * hardware thread.
+ */
+AVOGADROCORE_EXPORT void parallelFor(
+  Index count, Index cost, const std::function<void(Index, Index)>& body,
+  int maxThreads = 0);
+
+} // end Core namespace
+} // end Avogadro namespace
+
+#endif // AVOGADRO_CORE_PARALLEL_H
@@ -17,8 +17,10 @@
 
 #include "slaterset.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
 
 #include <Eigen/LU>
 
@@ -30,7 +32,7 @@ using Eigen::SelfAdjointEigenSolver;
 namespace Avogadro {
 namespace Core {
 
-SlaterSet::SlaterSet() : m_initialized(false)
+SlaterSet::SlaterSet() : m_initialized(false), m_cutoffPrecision(1e-10)
 {
 }
 
@@ -161,9 +163,82 @@ void SlaterSet::initCalculation()
   for (size_t i = 0; i < m_zetas.size(); ++i)
     m_zetas[i] = m_zetas[i] / BOHR_TO_ANGSTROM_D;
 
+  buildEvaluationPlan();
   m_initialized = true;
 }
 
+void SlaterSet::setCutoffPrecision(double precision)
+{
+  m_cutoffPrecision = precision;
+  // The exponents are converted in place, only the plan can be rebuilt.
+  if (m_initialized)
+    buildEvaluationPlan();
+}
+
+void SlaterSet::buildEvaluationPlan()
+{
+  m_plan.clear();
+  for (size_t i = 0; i < m_zetas.size(); ++i) {
+    int l;
+    switch (m_slaterTypes[i]) {
+      case S:
+        l = 0;
+        break;
+      case PX:
+      case PY:
+      case PZ:
+        l = 1;
+        break;
+      case X2:
+      case XZ:
+      case Z2:
+      case YZ:
+      case XY:
+        l = 2;
+        break;
+      default:
+        // Not evaluated, the value stays zero.
+        continue;
+    }
+
+    EvaluationFunction function;
+    function.type = m_slaterTypes[i];
+    function.pqn = m_PQNs[i];
+    function.atom = static_cast<unsigned int>(m_slaterIndices[i]);
+    function.index = static_cast<unsigned int>(i);
+    function.factor = m_factors[i];
+    function.zeta = m_zetas[i];
+
+    // The largest r where 2 |factor| r^n exp(-zeta r) reaches the precision,
+    // with n the total power of r, the factor 2 bounds the angular parts.
+    // Beyond the maximum at n / zeta, r = (log(2 |factor| / precision) +
+    // n log(r)) / zeta converges to it.
+    if (m_cutoffPrecision <= 0.0 || function.zeta <= 0.0) {
+      function.cutoffSquared = std::numeric_limits<double>::infinity();
+    } else {
+      const int n = function.pqn + l;
+      const double logRatio =
+        std::log(2.0 * std::fabs(function.factor) / m_cutoffPrecision);
+      const double peak = n / function.zeta;
+      double r = std::max(logRatio, 0.0) / function.zeta;
+      for (int iteration = 0; n > 0 && iteration < 20; ++iteration) {
+        r = std::max(r, peak);
+        r = std::max(logRatio + n * std::log(r), 0.0) / function.zeta;
+      }
+      r = std::max(r, peak);
+      function.cutoffSquared = r * r;
+    }
+    m_plan.push_back(function);
+  }
+
+  // Stable, so that the functions of an atom keep their order.
+  std::stable_sort(
+    m_plan.begin(), m_plan.end(),
+    [](const EvaluationFunction& a, const EvaluationFunction& b) {
+      return a.atom < b.atom;
+    });
+}
+
 inline unsigned int SlaterSet::factorial(unsigned int n)
 {
   if (n <= 1)
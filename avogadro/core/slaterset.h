@@ -139,9 +139,43 @@ public:
 
   /**
    * Initialize the calculation, this must normally be done before anything.
+   * It normalizes the orbitals and builds the evaluation plan.
    */
   void initCalculation();
 
+  /**
+   * @brief A Slater function of the evaluation plan, with its normalization
+   * and exponent, so that its value is
+   * factor * r^pqn * exp(-zeta * r) * angular part.
+   */
+  struct EvaluationFunction
+  {
+    int type;             //! Symmetry of the function, S, PX...
+    int pqn;              //! Power of r of the radial part
+    unsigned int atom;    //! Index of the atom of the function
+    unsigned int index;   //! Index of the function in the basis
+    double factor;        //! Normalization
+    double zeta;          //! Exponent in inverse Angstrom
+    double cutoffSquared; //! Squared radius in Angstrom beyond which it is zero
+  };
+
+  /**
+   * @return The functions of the basis set grouped by atom, built by
+   * initCalculation() and shared by all of the evaluations of the basis set.
+   */
+  const std::vector<EvaluationFunction>& evaluationPlan() const
+  {
+    return m_plan;
+  }
+
+  /**
+   * @brief Set the precision of the evaluation: a function is neglected beyond
+   * the distance where it is smaller than @p precision. The default is 1e-10,
+   * 0 disables the screening.
+   */
+  void setCutoffPrecision(double precision);
+  double cutoffPrecision() const { return m_cutoffPrecision; }
+
   /**
    * Accessors for the various properties of the GaussianSet.
    */
@@ -168,7 +202,11 @@ private:
   MatrixX m_normalized;
   bool m_initialized;
 
+  std::vector<EvaluationFunction> m_plan;
+  double m_cutoffPrecision;
+
   unsigned int factorial(unsigned int n);
+  void buildEvaluationPlan();
 };
 
 } // End Core namespace
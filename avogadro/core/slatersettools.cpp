@@ -18,19 +18,24 @@
 
 #include "slatersettools.h"
 
+#include "cube.h"
 #include "molecule.h"
 #include "slaterset.h"
 
-#include <iostream>
-
-using std::cout;
-using std::endl;
+#include <algorithm>
+#include <limits>
 
 using std::vector;
 
 namespace Avogadro {
 namespace Core {
 
+namespace {
+// The number of points evaluated together, enough for the array operations
+// over the points to vectorize, few enough for the block to stay in cache.
+const size_t blockSize = 64;
+}
+
 SlaterSetTools::SlaterSetTools(Molecule* mol) : m_molecule(mol)
 {
   if (m_molecule)
@@ -41,24 +46,44 @@ SlaterSetTools::~SlaterSetTools()
 {
 }
 
+bool SlaterSetTools::calculateMolecularOrbital(Cube& cube, int moNumber) const
+{
+  return calculateMolecularOrbital(cube, moNumber, 0, cube.data()->size());
+}
+
+bool SlaterSetTools::calculateMolecularOrbital(Cube& cube, int mo, size_t begin,
+                                               size_t end) const
+{
+  m_basis->initCalculation();
+  const MatrixX& matrix = m_basis->normalizedMatrix();
+  if (mo < 1 || mo > matrix.cols())
+    return false;
+
+  end = std::min(end, cube.data()->size());
+  vector<Vector3> positions;
+  MatrixX values;
+  Eigen::VectorXd results;
+  for (size_t i = begin; i < end; i += blockSize) {
+    blockPositions(cube, i, end, positions);
+    calculateValues(positions, values);
+    results.noalias() = values * matrix.col(mo - 1);
+    for (size_t j = 0; j < positions.size(); ++j)
+      cube.setValue(static_cast<unsigned int>(i + j), results[j]);
+  }
+  return true;
+}
+
 double SlaterSetTools::calculateMolecularOrbital(const Vector3& position,
                                                  int mo) const
 {
-  if (mo > static_cast<int>(m_basis->molecularOrbitalCount()))
+  if (mo < 1 || mo > static_cast<int>(m_basis->molecularOrbitalCount()))
     return 0.0;
 
   vector<double> values(calculateValues(position));
 
   const MatrixX& matrix = m_basis->normalizedMatrix();
-  int matrixSize(static_cast<int>(matrix.rows()));
-  int indexMO(mo - 1);
-
-  // Now calculate the value of the density at this point in space
-  double result(0.0);
-  for (int i = 0; i < matrixSize; ++i)
-    result += matrix(i, indexMO) * values[i];
-
-  return result;
+  Eigen::Map<const Eigen::VectorXd> basisValues(values.data(), matrix.rows());
+  return matrix.col(mo - 1).dot(basisValues);
 }
 
 double SlaterSetTools::calculateElectronDensity(const Vector3& position) const
@@ -68,19 +93,90 @@ double SlaterSetTools::calculateElectronDensity(const Vector3& position) const
   if (matrix.rows() != matrixSize || matrix.cols() != matrixSize)
     return 0.0;
 
+  return calculateDensity(matrix, calculateValues(position));
+}
+
+bool SlaterSetTools::calculateElectronDensity(Cube& cube, size_t begin,
+                                              size_t end) const
+{
+  m_basis->initCalculation();
+  const MatrixX& matrix = m_basis->densityMatrix();
+  const Eigen::Index matrixSize = m_basis->normalizedMatrix().rows();
+  if (matrix.rows() != matrixSize || matrix.cols() != matrixSize)
+    return false;
+
+  // The density of each point is the row of V D times the row of V, with V
+  // the values of the basis functions of the block.
+  end = std::min(end, cube.data()->size());
+  vector<Vector3> positions;
+  MatrixX values;
+  MatrixX contracted;
+  Eigen::VectorXd results;
+  for (size_t i = begin; i < end; i += blockSize) {
+    blockPositions(cube, i, end, positions);
+    calculateValues(positions, values);
+    contracted.noalias() = values * matrix.selfadjointView<Eigen::Lower>();
+    results = contracted.cwiseProduct(values).rowwise().sum();
+    for (size_t j = 0; j < positions.size(); ++j)
+      cube.setValue(static_cast<unsigned int>(i + j), results[j]);
+  }
+  return true;
+}
+
+vector<double> SlaterSetTools::calculateMolecularOrbitals(
+  const Vector3& position, const vector<int>& mos, bool electronDensity) const
+{
+  vector<double> results(mos.size() + (electronDensity ? 1 : 0), 0.0);
+
+  // The basis functions are evaluated once, and contracted with each orbital.
   vector<double> values(calculateValues(position));
+  const MatrixX& matrix = m_basis->normalizedMatrix();
+  Eigen::Map<const Eigen::VectorXd> basisValues(values.data(), matrix.rows());
+  for (size_t i = 0; i < mos.size(); ++i) {
+    if (mos[i] >= 1 && mos[i] <= matrix.cols())
+      results[i] = matrix.col(mos[i] - 1).dot(basisValues);
+  }
+
+  if (electronDensity) {
+    const MatrixX& density = m_basis->densityMatrix();
+    if (density.rows() == matrix.rows() && density.cols() == matrix.rows())
+      results.back() = calculateDensity(density, values);
+  }
+
+  return results;
+}
+
+bool SlaterSetTools::calculateMolecularOrbitals(
+  const vector<Cube*>& cubes, const vector<int>& mos, size_t begin,
+  size_t end) const
+{
+  if (cubes.empty() || cubes.size() != mos.size())
+    return false;
 
-  // Now calculate the value of the density at this point in space
-  double rho(0.0);
-  for (int i = 0; i < matrixSize; ++i) {
-    // Calculate the off-diagonal parts of the matrix
-    for (int j = 0; j < i; ++j)
-      rho += 2.0 * matrix(i, j) * (values[i] * values[j]);
-    // Now calculate the matrix diagonal
-    rho += matrix(i, i) * (values[i] * values[i]);
+  // The coefficients of the orbitals side by side, a missing orbital is zero.
+  m_basis->initCalculation();
+  const MatrixX& matrix = m_basis->normalizedMatrix();
+  MatrixX coefficients = MatrixX::Zero(matrix.rows(), mos.size());
+  for (size_t i = 0; i < mos.size(); ++i) {
+    if (mos[i] >= 1 && mos[i] <= matrix.cols())
+      coefficients.col(i) = matrix.col(mos[i] - 1);
   }
 
-  return rho;
+  const Cube& grid = *cubes.front();
+  end = std::min(end, grid.data()->size());
+  vector<Vector3> positions;
+  MatrixX values;
+  MatrixX results;
+  for (size_t i = begin; i < end; i += blockSize) {
+    blockPositions(grid, i, end, positions);
+    calculateValues(positions, values);
+    results.noalias() = values * coefficients;
+    for (size_t k = 0; k < cubes.size(); ++k) {
+      for (size_t j = 0; j < positions.size(); ++j)
+        cubes[k]->setValue(static_cast<unsigned int>(i + j), results(j, k));
+    }
+  }
+  return true;
 }
 
 double SlaterSetTools::calculateSpinDensity(const Vector3&) const
@@ -104,76 +200,107 @@ inline bool SlaterSetTools::isSmall(double val) const
     return false;
 }
 
-vector<double> SlaterSetTools::calculateValues(const Vector3& position) const
+double SlaterSetTools::calculateDensity(const MatrixX& matrix,
+                                        const vector<double>& values) const
 {
-  m_basis->initCalculation();
-
-  Index atomsSize = m_molecule->atomCount();
-  size_t basisSize = m_basis->zetas().size();
+  // Only the lower triangle of the density matrix is used.
+  Eigen::Map<const Eigen::VectorXd> basisValues(values.data(), matrix.rows());
+  return basisValues.dot(matrix.selfadjointView<Eigen::Lower>() * basisValues);
+}
 
-  const vector<int>& slaterIndices = m_basis->slaterIndices();
-  const vector<int>& slaterTypes = m_basis->slaterTypes();
-  const vector<int>& PQNs = m_basis->PQNs();
-  const vector<double>& factors = m_basis->factors();
-  const vector<double>& zetas = m_basis->zetas();
+vector<double> SlaterSetTools::calculateValues(const Vector3& position) const
+{
+  MatrixX values;
+  calculateValues(vector<Vector3>(1, position), values);
+  return vector<double>(values.data(), values.data() + values.size());
+}
 
-  vector<Vector3> deltas;
-  vector<double> dr2;
-  deltas.reserve(atomsSize);
-  dr2.reserve(atomsSize);
+void SlaterSetTools::calculateValues(const vector<Vector3>& positions,
+                                     MatrixX& values) const
+{
+  m_basis->initCalculation();
 
-  // Calculate the deltas for the position
-  for (Index i = 0; i < atomsSize; ++i) {
-    deltas.push_back(position - m_molecule->atom(i).position3d());
-    dr2.push_back(deltas[i].squaredNorm());
-  }
+  const vector<SlaterSet::EvaluationFunction>& plan = m_basis->evaluationPlan();
+  const Eigen::Index count = static_cast<Eigen::Index>(positions.size());
+  values.setZero(count, m_basis->zetas().size());
+
+  Eigen::ArrayXd x(count), y(count), z(count), r(count), radial(count);
+  double minDr2 = 0.0;
+  unsigned int atom = std::numeric_limits<unsigned int>::max();
+  const SlaterSet::EvaluationFunction* radialFunction = nullptr;
+  for (size_t i = 0; i < plan.size(); ++i) {
+    const SlaterSet::EvaluationFunction& function = plan[i];
+
+    // The deltas of the block are calculated once per atom.
+    if (function.atom != atom) {
+      atom = function.atom;
+      const Vector3 center = m_molecule->atomPosition3d(atom);
+      for (Eigen::Index j = 0; j < count; ++j) {
+        x[j] = positions[j].x() - center.x();
+        y[j] = positions[j].y() - center.y();
+        z[j] = positions[j].z() - center.z();
+      }
+      r = x.square() + y.square() + z.square();
+      minDr2 = r.minCoeff();
+      r = r.sqrt();
+      radialFunction = nullptr;
+    }
+    // Screened out, the values stay zero.
+    if (minDr2 > function.cutoffSquared)
+      continue;
+
+    // The functions of a shell, like the three p functions, share the radial
+    // part.
+    if (!radialFunction || radialFunction->zeta != function.zeta ||
+        radialFunction->pqn != function.pqn) {
+      radial = (-function.zeta * r).exp();
+      for (int j = 0; j < function.pqn; ++j)
+        radial *= r;
+      radialFunction = &function;
+    }
 
-  // Allocate space for the values to be calculated.
-  vector<double> values;
-  values.resize(basisSize);
-
-  // Now calculate the values at this point in space
-  for (size_t i = 0; i < basisSize; ++i) {
-    double dr(dr2[slaterIndices[i]]);
-    Vector3 delta(deltas[slaterIndices[i]]);
-    values[i] = factors[i] * exp(-zetas[i] * dr);
-    // Radial part with effective PQNs
-    for (int j = 0; j < PQNs[i]; ++j)
-      values[i] *= dr;
-    switch (slaterTypes[i]) {
+    auto column = values.col(function.index).array();
+    switch (function.type) {
       case SlaterSet::S:
+        column = function.factor * radial;
         break;
       case SlaterSet::PX:
-        values[i] *= delta.x();
+        column = function.factor * radial * x;
         break;
       case SlaterSet::PY:
-        values[i] *= delta.y();
+        column = function.factor * radial * y;
         break;
       case SlaterSet::PZ:
-        values[i] *= delta.z();
+        column = function.factor * radial * z;
         break;
       case SlaterSet::X2: // (x^2 - y^2)r^n
-        values[i] *= delta.x() * delta.x() - delta.y() * delta.y();
+        column = function.factor * radial * (x.square() - y.square());
         break;
       case SlaterSet::XZ: // xzr^n
-        values[i] *= delta.x() * delta.z();
+        column = function.factor * radial * x * z;
         break;
       case SlaterSet::Z2: // (2z^2 - x^2 - y^2)r^n
-        values[i] *= 2.0 * delta.z() * delta.z() - delta.x() * delta.x() -
-                     delta.y() * delta.y();
+        column = function.factor * radial *
+                 (2.0 * z.square() - x.square() - y.square());
         break;
       case SlaterSet::YZ: // yzr^n
-        values[i] *= delta.y() * delta.z();
+        column = function.factor * radial * y * z;
         break;
       case SlaterSet::XY: // xyr^n
-        values[i] *= delta.x() * delta.y();
+        column = function.factor * radial * x * y;
         break;
       default:
-        values[i] = 0.0;
+        break;
     }
   }
+}
 
-  return values;
+void SlaterSetTools::blockPositions(const Cube& cube, size_t begin, size_t end,
+                                    vector<Vector3>& positions) const
+{
+  positions.clear();
+  for (size_t i = begin; i < end && positions.size() < blockSize; ++i)
+    positions.push_back(cube.position(static_cast<unsigned int>(i)));
 }
 
 } // End Core namespace
@@ -21,6 +21,7 @@
 
 #include "avogadrocore.h"
 
+#include "matrix.h"
 #include "vector.h"
 
 #include <vector>
@@ -28,6 +29,7 @@
 namespace Avogadro {
 namespace Core {
 
+class Cube;
 class Molecule;
 class SlaterSet;
 
@@ -44,6 +46,24 @@ public:
   explicit SlaterSetTools(Molecule* mol = 0);
   ~SlaterSetTools();
 
+  /**
+   * @brief Populate the cube with values for the molecular orbital.
+   * @param cube The cube to put the values in.
+   * @param molecularOrbitalNumber The molecular orbital number.
+   * @return True on success, false on failure.
+   */
+  bool calculateMolecularOrbital(Cube& cube, int molecularOrbitalNumber) const;
+
+  /**
+   * @brief Calculate the values of the molecular orbital at the points
+   * @p begin to @p end (excluded) of the cube, and put them in the cube. The
+   * points are evaluated in blocks, ranges of a cube can be calculated in
+   * parallel.
+   * @return True on success, false on failure.
+   */
+  bool calculateMolecularOrbital(Cube& cube, int molecularOrbitalNumber,
+                                 size_t begin, size_t end) const;
+
   /**
    * @brief Calculate the value of the specified molecular orbital at the
    * position specified.
@@ -62,6 +82,13 @@ public:
    */
   double calculateElectronDensity(const Vector3& position) const;
 
+  /**
+   * @brief Calculate the electron density at the points @p begin to @p end
+   * (excluded) of the cube, and put it in the cube.
+   * @return True on success, false on failure.
+   */
+  bool calculateElectronDensity(Cube& cube, size_t begin, size_t end) const;
+
   /**
    * @brief Calculate the value of the electron spin density at the position
    * specified.
@@ -70,6 +97,30 @@ public:
    */
   double calculateSpinDensity(const Vector3& position) const;
 
+  /**
+   * @brief Calculate the values of several molecular orbitals at the position
+   * specified. The basis functions are evaluated once for all of them.
+   * @param position The position in space to calculate the values.
+   * @param molecularOrbitalNumbers The molecular orbital numbers.
+   * @param electronDensity Also calculate the electron density.
+   * @return The values of the molecular orbitals, in the order of the numbers,
+   * followed by the electron density if requested.
+   */
+  std::vector<double> calculateMolecularOrbitals(
+    const Vector3& position, const std::vector<int>& molecularOrbitalNumbers,
+    bool electronDensity = false) const;
+
+  /**
+   * @brief Calculate several molecular orbitals at the points @p begin to
+   * @p end (excluded) of the cubes, one cube per orbital. The cubes must have
+   * the same limits.
+   * @return True on success, false on failure.
+   */
+  bool calculateMolecularOrbitals(
+    const std::vector<Cube*>& cubes,
+    const std::vector<int>& molecularOrbitalNumbers, size_t begin,
+    size_t end) const;
+
   /**
    * @brief Check that the basis set is valid and can be used.
    * @return True if valid, false otherwise.
@@ -82,6 +133,12 @@ private:
 
   bool isSmall(double value) const;
 
+  /**
+   * @brief Contract the values of the basis functions with a density matrix.
+   */
+  double calculateDensity(const MatrixX& matrix,
+                          const std::vector<double>& values) const;
+
   /**
    * @brief Calculate the values at this position in space. The public calculate
    * functions call this function to prepare values before multiplying by the
@@ -89,6 +146,23 @@ private:
    * @param position The position in space to calculate the value.
    */
   std::vector<double> calculateValues(const Vector3& position) const;
+
+  /**
+   * @brief Calculate the values of the basis functions at a block of points,
+   * one row per point and one column per basis function. The points of the
+   * block are evaluated together, each function over all of them at once.
+   * @param positions The positions of the points of the block.
+   * @param values The values, resized as needed.
+   */
+  void calculateValues(const std::vector<Vector3>& positions,
+                       MatrixX& values) const;
+
+  /**
+   * @brief The positions of the points @p begin to @p end of the cube, at most
+   * a block of them.
+   */
+  void blockPositions(const Cube& cube, size_t begin, size_t end,
+                      std::vector<Vector3>& positions) const;
 };
 
 } // End Core namespace
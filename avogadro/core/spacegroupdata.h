@@ -2425,7 +2425,7 @@ const char* space_group_transforms[] = {
   "x,1/2-y,1/2+z 1/2+x,y,1/2+z 1/2-x,-y,1/2+z 1/2+x,-y,1/2-z 1/2-x,y,1/2-z "
   "1/2-x,1/2-y,-z 1/2+x,1/2+y,-z 1/2-x,1/2+y,z 1/2+x,1/2-y,z",
   "x,y,z -x,1/2-y,1/2+z x,1/2-y,-z -x,y,1/2-z -x,-y,-z x,1/2+y,1/2-z "
-  "-x,1/2+y,z x,-y,1/2+z 1/2+x,y,1/2+z 1/2-x,1/2-y,z+ 1/2+x,1/2-y,1/2-z "
+  "-x,1/2+y,z x,-y,1/2+z 1/2+x,y,1/2+z 1/2-x,1/2-y,z 1/2+x,1/2-y,1/2-z "
   "1/2-x,y,-z 1/2-x,-y,1/2-z 1/2+x,1/2+y,-z 1/2-x,1/2+y,1/2+z 1/2+x,-y,z",
   "x,y,z -x,-y,z x,-y,-z -x,y,-z -x,1/2-y,1/2-z x,1/2+y,1/2-z -x,1/2+y,1/2+z "
   "x,1/2-y,1/2+z 1/2+x,y,1/2+z 1/2-x,-y,1/2+z 1/2+x,-y,1/2-z 1/2-x,y,1/2-z "
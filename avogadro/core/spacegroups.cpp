@@ -14,10 +14,12 @@
 
 ******************************************************************************/
 
-#include <algorithm> // for std::count()
+#include <algorithm>
 #include <cassert>
 #include <cctype> // for isdigit()
+#include <cmath>
 #include <iostream>
+#include <unordered_map>
 
 #include "array.h"
 #include "crystaltools.h"
@@ -139,14 +141,13 @@ const char* SpaceGroups::setting(unsigned short hallNumber)
 
 unsigned short SpaceGroups::transformsCount(unsigned short hallNumber)
 {
-  if (hallNumber <= 530) {
-    std::string s = transformsString(hallNumber);
-    return std::count(s.begin(), s.end(), ' ') + 1;
-  } else {
+  if (hallNumber == 0 || hallNumber > 530)
     return 0;
-  }
+  return static_cast<unsigned short>(
+    operationTables()[hallNumber].rotations.size());
 }
 
+namespace {
 Real readTransformCoordinate(const std::string& coordinate, const Vector3& v)
 {
   // The coordinate should be at least 1 character
@@ -203,18 +204,66 @@ Real readTransformCoordinate(const std::string& coordinate, const Vector3& v)
   return ret;
 }
 
-Vector3 getSingleTransform(const std::string& transform, const Vector3& v)
+// Parse an "x,-y+1/2,z"-style transform into a rotation and a translation.
+// The coordinates are affine in x, y and z, so evaluating them at the origin
+// and at the unit vectors gives the translation and the rotation columns.
+void parseTransform(const std::string& transform, Matrix3& rotation,
+                    Vector3& translation)
 {
-  Vector3 ret;
   std::vector<std::string> coordinates = split(transform, ',');
 
   // This should be 3 in size. Something very bad happened if it is not.
   assert(coordinates.size() == 3);
 
-  ret[0] = readTransformCoordinate(coordinates[0], v);
-  ret[1] = readTransformCoordinate(coordinates[1], v);
-  ret[2] = readTransformCoordinate(coordinates[2], v);
-  return ret;
+  for (int row = 0; row < 3; ++row) {
+    translation[row] = readTransformCoordinate(coordinates[row],
+                                               Vector3::Zero());
+    for (int col = 0; col < 3; ++col) {
+      rotation(row, col) =
+        readTransformCoordinate(coordinates[row], Vector3::Unit(col)) -
+        translation[row];
+    }
+  }
+}
+}
+
+const std::vector<SpaceGroups::OperationTable>& SpaceGroups::operationTables()
+{
+  // Parse every Hall setting once, on first use. The initialization of a
+  // local static is thread safe.
+  static const std::vector<OperationTable> tables = buildOperationTables();
+  return tables;
+}
+
+std::vector<SpaceGroups::OperationTable> SpaceGroups::buildOperationTables()
+{
+  std::vector<OperationTable> tables(531);
+  for (unsigned short hall = 1; hall <= 530; ++hall) {
+    // These transforms are separated by spaces
+    std::vector<std::string> transforms = split(transformsString(hall), ' ');
+    OperationTable& table = tables[hall];
+    table.rotations.resize(transforms.size());
+    table.translations.resize(transforms.size());
+    for (size_t i = 0; i < transforms.size(); ++i)
+      parseTransform(transforms[i], table.rotations[i], table.translations[i]);
+  }
+  return tables;
+}
+
+bool SpaceGroups::getOperations(unsigned short hallNumber,
+                                Array<Matrix3>& rotations,
+                                Array<Vector3>& translations)
+{
+  rotations.clear();
+  translations.clear();
+  if (hallNumber == 0 || hallNumber > 530)
+    return false;
+
+  const OperationTable& table = operationTables()[hallNumber];
+  rotations = Array<Matrix3>(table.rotations.begin(), table.rotations.end());
+  translations =
+    Array<Vector3>(table.translations.begin(), table.translations.end());
+  return true;
 }
 
 Array<Vector3> SpaceGroups::getTransforms(unsigned short hallNumber,
@@ -223,18 +272,108 @@ Array<Vector3> SpaceGroups::getTransforms(unsigned short hallNumber,
   if (hallNumber == 0 || hallNumber > 530)
     return Array<Vector3>();
 
-  Array<Vector3> ret;
+  const OperationTable& table = operationTables()[hallNumber];
+  Array<Vector3> ret(table.rotations.size());
+  for (size_t i = 0; i < table.rotations.size(); ++i)
+    ret[i] = table.rotations[i] * v + table.translations[i];
+
+  return ret;
+}
 
-  std::string transformsStr = transformsString(hallNumber);
-  // These transforms are separated by spaces
-  std::vector<std::string> transforms = split(transformsStr, ' ');
+Array<Vector3> SpaceGroups::applyTransforms(unsigned short hallNumber,
+                                            const Array<Vector3>& positions)
+{
+  if (hallNumber == 0 || hallNumber > 530)
+    return Array<Vector3>();
 
-  for (Index i = 0; i < transforms.size(); ++i)
-    ret.push_back(getSingleTransform(transforms[i], v));
+  const OperationTable& table = operationTables()[hallNumber];
+  const size_t numOps = table.rotations.size();
+  Array<Vector3> ret;
+  ret.reserve(positions.size() * numOps);
+  for (size_t i = 0; i < positions.size(); ++i) {
+    const Vector3& v = positions[i];
+    for (size_t j = 0; j < numOps; ++j)
+      ret.push_back(table.rotations[j] * v + table.translations[j]);
+  }
 
   return ret;
 }
 
+namespace {
+// A hash grid over the fractional coordinates of a unit cell, used to find
+// the atoms within a cartesian tolerance of a position. The bins are at least
+// as wide as the tolerance, and wrap around the faces of the cell, so only the
+// bins next to that of the position have to be searched.
+class PeriodicGrid
+{
+public:
+  PeriodicGrid(const UnitCell& unitCell, Real cartTol) : m_unitCell(unitCell)
+  {
+    // Keep the keys within 64 bits.
+    const int maxBins = 1 << 20;
+    for (int i = 0; i < 3; ++i) {
+      // The largest change of fractional coordinate i over the tolerance.
+      Real reach = cartTol * unitCell.fractionalMatrix().row(i).norm();
+      Real bins = reach > 0.0 ? std::floor(1.0 / reach) : maxBins;
+      bins = std::min(bins, static_cast<Real>(maxBins));
+      m_bins[i] = std::max(static_cast<int>(bins), 1);
+    }
+  }
+
+  void insert(Index index, const Vector3& cart)
+  {
+    int bin[3];
+    binOf(cart, bin);
+    m_cells[key(bin[0], bin[1], bin[2])].push_back(index);
+  }
+
+  // Append the indices of the atoms in the bins around @a cart to @a result.
+  void candidates(const Vector3& cart, std::vector<Index>& result) const
+  {
+    int bin[3];
+    binOf(cart, bin);
+    int neighbors[3][3];
+    int counts[3];
+    for (int i = 0; i < 3; ++i) {
+      // With fewer than three bins the neighbors would repeat.
+      counts[i] = std::min(m_bins[i], 3);
+      for (int j = 0; j < counts[i]; ++j)
+        neighbors[i][j] = (bin[i] + j - 1 + m_bins[i]) % m_bins[i];
+    }
+    for (int a = 0; a < counts[0]; ++a) {
+      for (int b = 0; b < counts[1]; ++b) {
+        for (int c = 0; c < counts[2]; ++c) {
+          CellMap::const_iterator it =
+            m_cells.find(key(neighbors[0][a], neighbors[1][b],
+                             neighbors[2][c]));
+          if (it != m_cells.end())
+            result.insert(result.end(), it->second.begin(), it->second.end());
+        }
+      }
+    }
+  }
+
+private:
+  typedef std::unordered_map<long long, std::vector<Index>> CellMap;
+
+  void binOf(const Vector3& cart, int bin[3]) const
+  {
+    Vector3 frac = m_unitCell.wrapFractional(m_unitCell.toFractional(cart));
+    for (int i = 0; i < 3; ++i)
+      bin[i] = std::min(static_cast<int>(frac[i] * m_bins[i]), m_bins[i] - 1);
+  }
+
+  long long key(int a, int b, int c) const
+  {
+    return (static_cast<long long>(a) * m_bins[1] + b) * m_bins[2] + c;
+  }
+
+  const UnitCell& m_unitCell;
+  int m_bins[3];
+  CellMap m_cells;
+};
+}
+
 void SpaceGroups::fillUnitCell(Molecule& mol, unsigned short hallNumber,
                                double cartTol)
 {
@@ -245,30 +384,43 @@ void SpaceGroups::fillUnitCell(Molecule& mol, unsigned short hallNumber,
   Array<unsigned char> atomicNumbers = mol.atomicNumbers();
   Array<Vector3> positions = mol.atomPositions3d();
   Index numAtoms = mol.atomCount();
+  Index numOps = transformsCount(hallNumber);
+
+  // Apply every operation to all of the original atoms at once.
+  Array<Vector3> fractional(numAtoms);
+  for (Index i = 0; i < numAtoms; ++i)
+    fractional[i] = uc->toFractional(positions[i]);
+  Array<Vector3> transformed = applyTransforms(hallNumber, fractional);
+
+  PeriodicGrid grid(*uc, cartTol);
+  for (Index i = 0; i < numAtoms; ++i)
+    grid.insert(i, positions[i]);
 
   // We are going to loop through the original atoms. That is why
   // we have numAtoms cached instead of using atomCount().
+  std::vector<Index> nearby;
   for (Index i = 0; i < numAtoms; ++i) {
     unsigned char atomicNum = atomicNumbers[i];
-    Vector3 pos = uc->toFractional(positions[i]);
-
-    Array<Vector3> newAtoms = getTransforms(hallNumber, pos);
 
     // We skip 0 because it is the original atom.
-    for (Index j = 1; j < newAtoms.size(); ++j) {
+    for (Index j = 1; j < numOps; ++j) {
       // The new atoms are in fractional coordinates. Convert to cartesian.
-      Vector3 newCandidate = uc->toCartesian(newAtoms[j]);
+      Vector3 newCandidate = uc->toCartesian(transformed[i * numOps + j]);
 
       // If there is already an atom in this location within a
       // certain tolerance, do not add the atom.
       bool atomAlreadyPresent = false;
-      for (Index k = 0; k < mol.atomCount(); k++) {
+      nearby.clear();
+      grid.candidates(newCandidate, nearby);
+      for (size_t k = 0; k < nearby.size(); ++k) {
         // If it does not have the same atomic number, skip over it.
-        if (mol.atomicNumber(k) != atomicNum)
+        if (atomicNumbers[nearby[k]] != atomicNum)
           continue;
-        Real distance = uc->distance(mol.atomPosition3d(k), newCandidate);
-        if (distance <= cartTol)
+        Real distance = uc->distance(positions[nearby[k]], newCandidate);
+        if (distance <= cartTol) {
           atomAlreadyPresent = true;
+          break;
+        }
       }
 
       // If there is already an atom present here, just continue
@@ -276,6 +428,9 @@ void SpaceGroups::fillUnitCell(Molecule& mol, unsigned short hallNumber,
         continue;
 
       // If we got this far, add the atom!
+      grid.insert(positions.size(), newCandidate);
+      positions.push_back(newCandidate);
+      atomicNumbers.push_back(atomicNum);
       Atom newAtom = mol.addAtom(atomicNum);
       newAtom.setPosition3d(newCandidate);
     }
@@ -291,39 +446,49 @@ void SpaceGroups::reduceToAsymmetricUnit(Molecule& mol,
     return;
   UnitCell* uc = mol.unitCell();
 
-  // The number of atoms may change as we remove atoms, so don't cache
-  // the number of atoms, atomic positions, or atomic numbers
-  // There's no point in looking at the last atom
-  for (Index i = 0; i + 1 < mol.atomCount(); ++i) {
-    unsigned char atomicNum = mol.atomicNumber(i);
-    Vector3 pos = uc->toFractional(mol.atomPosition3d(i));
-    Array<Vector3> transformAtoms = getTransforms(hallNumber, pos);
-
-    // Loop through the rest of the atoms in this crystal and see if any match
-    // up with a transform
-    for (Index j = i + 1; j < mol.atomCount(); ++j) {
-      // If the atomic number does not match, skip over it
-      if (mol.atomicNumber(j) != atomicNum)
-        continue;
+  Array<unsigned char> atomicNumbers = mol.atomicNumbers();
+  Array<Vector3> positions = mol.atomPositions3d();
+  Index numAtoms = mol.atomCount();
+
+  PeriodicGrid grid(*uc, cartTol);
+  for (Index i = 0; i < numAtoms; ++i)
+    grid.insert(i, positions[i]);
 
-      Vector3 trialPos = mol.atomPosition3d(j);
-      // Loop through the transform atoms
-      // We skip 0 because it is the original atom.
-      for (Index k = 1; k < transformAtoms.size(); ++k) {
-        // The transform atoms are in fractional coordinates. Convert to
-        // cartesian.
-        Vector3 transformPos = uc->toCartesian(transformAtoms[k]);
-        Real distance = uc->distance(trialPos, transformPos);
+  // Mark the atoms that are symmetry equivalent to an earlier atom that is
+  // kept, and remove them all at the end.
+  std::vector<bool> removed(numAtoms, false);
+  Array<Index> toRemove;
+  std::vector<Index> nearby;
+  for (Index i = 0; i < numAtoms; ++i) {
+    if (removed[i])
+      continue;
+    unsigned char atomicNum = atomicNumbers[i];
+    // Only the atoms that are kept need to be transformed.
+    Array<Vector3> transformAtoms =
+      getTransforms(hallNumber, uc->toFractional(positions[i]));
+
+    // We skip 0 because it is the original atom.
+    for (Index k = 1; k < transformAtoms.size(); ++k) {
+      // The transform atoms are in fractional coordinates. Convert to
+      // cartesian.
+      Vector3 transformPos = uc->toCartesian(transformAtoms[k]);
+      nearby.clear();
+      grid.candidates(transformPos, nearby);
+      for (size_t n = 0; n < nearby.size(); ++n) {
+        Index j = nearby[n];
+        // Only look at the rest of the atoms with the same atomic number
+        if (j <= i || removed[j] || atomicNumbers[j] != atomicNum)
+          continue;
         // Is the atom within the cartesian tolerance distance?
-        if (distance <= cartTol) {
-          // Remove this atom and adjust the index
-          mol.removeAtom(j);
-          --j;
-          break;
+        if (uc->distance(positions[j], transformPos) <= cartTol) {
+          removed[j] = true;
+          toRemove.push_back(j);
         }
       }
     }
   }
+
+  mol.removeAtoms(toRemove);
 }
 
 const char* SpaceGroups::transformsString(unsigned short hallNumber)
@@ -19,6 +19,12 @@
 
 #include "avogadrocore.h"
 
+#include "array.h"
+#include "matrix.h"
+#include "vector.h"
+
+#include <vector>
+
 namespace Avogadro {
 namespace Core {
 
@@ -116,6 +122,27 @@ public:
   static Array<Vector3> getTransforms(unsigned short hallNumber,
                                       const Vector3& v);
 
+  /**
+   * Get the symmetry operations for a given hall number, as rotation matrices
+   * and translation vectors acting on fractional coordinates. Operation i
+   * maps v to rotations[i] * v + translations[i].
+   * The operations of all hall numbers are parsed once, on first use.
+   * If an invalid hall number is given, false will be returned.
+   */
+  static bool getOperations(unsigned short hallNumber,
+                            Array<Matrix3>& rotations,
+                            Array<Vector3>& translations);
+
+  /**
+   * Apply every transform of a given hall number to an array of positions in
+   * fractional coordinates. The result holds transformsCount() positions per
+   * input position, i.e. transform j of position i is at index
+   * i * transformsCount(hallNumber) + j, in the order of getTransforms().
+   * If an invalid hall number is given, an empty array will be returned.
+   */
+  static Array<Vector3> applyTransforms(unsigned short hallNumber,
+                                        const Array<Vector3>& positions);
+
   /**
    * Fill a crystal with atoms by using transforms from a hall number.
    * Nothing will be done if the molecule does not have a unit cell.
@@ -137,6 +164,23 @@ public:
                                      double cartTol = 1e-5);
 
 private:
+  /**
+   * The parsed transforms of a hall number.
+   */
+  struct OperationTable
+  {
+    std::vector<Matrix3> rotations;
+    std::vector<Vector3> translations;
+  };
+
+  /**
+   * The operation tables of all hall numbers, indexed by hall number.
+   * @{
+   */
+  static const std::vector<OperationTable>& operationTables();
+  static std::vector<OperationTable> buildOperationTables();
+  /** @} */
+
   /**
    * Get the transforms string stored in the database.
    */
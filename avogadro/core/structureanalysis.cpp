@@ -0,0 +1,363 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "structureanalysis.h"
+
+#include "matrix.h"
+#include "molecule.h"
+#include "parallel.h"
+#include "unitcell.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace Avogadro {
+namespace Core {
+
+namespace {
+// Lets the neighbor lists skip the search between close frames.
+const Real neighborSkin = 0.5;
+
+// The pair histograms of a range of frames.
+struct Histograms
+{
+  std::vector<double> counts;
+  std::vector<double> weighted;
+};
+
+// The position of element in the sorted elements, elements.size() if missing.
+Index findElement(const std::vector<unsigned char>& elements,
+                  unsigned char element)
+{
+  std::vector<unsigned char>::const_iterator it =
+    std::lower_bound(elements.begin(), elements.end(), element);
+  return it != elements.end() && *it == element
+           ? static_cast<Index>(it - elements.begin())
+           : elements.size();
+}
+
+// Find the pairs of atoms in range. Without a unit cell, the atoms are placed
+// in a box wide enough that their periodic images are out of range.
+// @return The volume normalizing the frame, 0 on failure.
+Real findNeighbors(NeighborList& list, const Array<Vector3>& positions,
+                   const UnitCell* cell)
+{
+  if (cell)
+    return list.update(*cell, positions) ? cell->volume() : 0.0;
+
+  Vector3 low = positions[0];
+  Vector3 high = positions[0];
+  for (Index i = 1; i < positions.size(); ++i) {
+    low = low.cwiseMin(positions[i]);
+    high = high.cwiseMax(positions[i]);
+  }
+  Vector3 extent = high - low;
+  Real margin = list.cutoff() + list.skin() + 1.0;
+  Matrix3 boxMatrix = Matrix3::Zero();
+  boxMatrix.diagonal() = extent + Vector3::Constant(margin);
+  UnitCell box(boxMatrix);
+  Array<Vector3> shifted(positions.size());
+  for (Index i = 0; i < positions.size(); ++i)
+    shifted[i] = positions[i] - low;
+  if (!list.update(box, shifted))
+    return 0.0;
+
+  Real volume = 1.0;
+  for (int i = 0; i < 3; ++i)
+    volume *= std::max(extent[i], static_cast<Real>(1.0));
+  return volume;
+}
+
+// Add the pairs of the frame to the histograms of their elements.
+void accumulatePairs(const NeighborList& list, const std::vector<Index>& types,
+                     Index typeCount, Real binWidth, Index binCount,
+                     Real volume, std::vector<double>& counts,
+                     std::vector<double>& weighted)
+{
+  const std::vector<Index>& offsets = list.offsets();
+  const std::vector<Index>& neighbors = list.neighbors();
+  const std::vector<Real>& distances = list.distances();
+  for (Index i = 0; i < list.atomCount(); ++i) {
+    Index row = types[i] * typeCount;
+    for (Index k = offsets[i]; k < offsets[i + 1]; ++k) {
+      Index bin = static_cast<Index>(distances[k] / binWidth);
+      if (bin >= binCount)
+        continue;
+      Index index = (row + types[neighbors[k]]) * binCount + bin;
+      counts[index] += 1.0;
+      weighted[index] += volume;
+    }
+  }
+}
+}
+
+StructureAnalysis::StructureAnalysis()
+  : m_cutoff(10.0), m_binWidth(0.05), m_maxThreads(0), m_binCount(0),
+    m_frameCount(0)
+{
+}
+
+StructureAnalysis::~StructureAnalysis()
+{
+}
+
+bool StructureAnalysis::analyze(const Molecule& mol)
+{
+  if (!reset(mol.atomicNumbers()))
+    return false;
+
+  const int sets = mol.coordinate3dCount();
+  const Index frames = sets > 0 ? static_cast<Index>(sets) : 1;
+  const Index atoms = m_atomTypes.size();
+  for (int i = 0; i < sets; ++i) {
+    if (mol.coordinate3dSet(i).size() != atoms)
+      return false;
+  }
+  if (sets == 0 && mol.atomPositions3d().size() != atoms)
+    return false;
+  const UnitCell* cell = mol.unitCell();
+
+  // Each thread analyzes a range of consecutive frames, with its own neighbor
+  // list and histograms.
+  const Index typeCount = m_elements.size();
+  const Index histogramSize = typeCount * typeCount * m_binCount;
+  std::mutex blocksMutex;
+  std::map<Index, Histograms> blocks;
+  parallelFor(
+    frames, atoms * 100,
+    [&](Index first, Index last) {
+      NeighborList list;
+      list.setCutoff(m_binCount * m_binWidth);
+      list.setSkin(neighborSkin);
+      list.setMaxThreads(frames > 1 ? 1 : m_maxThreads);
+      Histograms block;
+      block.counts.assign(histogramSize, 0.0);
+      block.weighted.assign(histogramSize, 0.0);
+      for (Index f = first; f < last; ++f) {
+        const Array<Vector3>& positions =
+          sets > 0 ? mol.coordinate3dSet(static_cast<int>(f))
+                   : mol.atomPositions3d();
+        Real volume = findNeighbors(list, positions, cell);
+        if (volume > 0.0) {
+          accumulatePairs(list, m_atomTypes, typeCount, m_binWidth,
+                          m_binCount, volume, block.counts, block.weighted);
+        }
+      }
+      std::lock_guard<std::mutex> lock(blocksMutex);
+      std::swap(blocks[first], block);
+    },
+    m_maxThreads);
+
+  // Sum the blocks in order, so that the results do not depend on timing.
+  for (std::map<Index, Histograms>::const_iterator it = blocks.begin();
+       it != blocks.end(); ++it) {
+    for (Index i = 0; i < histogramSize; ++i) {
+      m_pairCounts[i] += it->second.counts[i];
+      m_weightedCounts[i] += it->second.weighted[i];
+    }
+  }
+  m_frameCount = frames;
+
+  // The displacements depend on the previous frame, they are cheap enough to
+  // follow in order.
+  for (Index f = 0; f < frames; ++f) {
+    addDisplacements(sets > 0 ? mol.coordinate3dSet(static_cast<int>(f))
+                              : mol.atomPositions3d(),
+                     cell);
+  }
+  return true;
+}
+
+bool StructureAnalysis::begin(const Array<unsigned char>& atomicNumbers)
+{
+  m_neighbors.clear();
+  if (!reset(atomicNumbers))
+    return false;
+  m_neighbors.setCutoff(m_binCount * m_binWidth);
+  m_neighbors.setSkin(neighborSkin);
+  m_neighbors.setMaxThreads(m_maxThreads);
+  return true;
+}
+
+bool StructureAnalysis::addFrame(const Array<Vector3>& positions,
+                                 const UnitCell* cell)
+{
+  if (positions.size() != m_atomTypes.size() || positions.empty())
+    return false;
+
+  Real volume = findNeighbors(m_neighbors, positions, cell);
+  if (volume > 0.0) {
+    accumulatePairs(m_neighbors, m_atomTypes, m_elements.size(), m_binWidth,
+                    m_binCount, volume, m_pairCounts, m_weightedCounts);
+  }
+  ++m_frameCount;
+  addDisplacements(positions, cell);
+  return true;
+}
+
+std::vector<Real> StructureAnalysis::rdf(unsigned char a,
+                                         unsigned char b) const
+{
+  std::vector<Real> result;
+  Index typeA = findElement(m_elements, a);
+  Index typeB = findElement(m_elements, b);
+  if (typeA == m_elements.size() || typeB == m_elements.size())
+    return result;
+
+  // The number of pairs expected in each shell, for a uniform density.
+  const Real pairs = static_cast<Real>(m_frameCount) * m_typeCounts[typeA] *
+                     m_typeCounts[typeB];
+  const Index offset = (typeA * m_elements.size() + typeB) * m_binCount;
+  result.resize(m_binCount, 0.0);
+  for (Index bin = 0; bin < m_binCount && pairs > 0.0; ++bin) {
+    Real shell = 4.0 / 3.0 * PI * std::pow(m_binWidth, 3) *
+                 (std::pow(bin + 1.0, 3) - std::pow(bin, 3));
+    result[bin] = m_weightedCounts[offset + bin] / (pairs * shell);
+  }
+  return result;
+}
+
+std::vector<Real> StructureAnalysis::rdf() const
+{
+  std::vector<Real> result(m_binCount, 0.0);
+  const Real atoms = static_cast<Real>(m_atomTypes.size());
+  const Real pairs = static_cast<Real>(m_frameCount) * atoms * atoms;
+  const Index typePairs = m_elements.size() * m_elements.size();
+  for (Index bin = 0; bin < m_binCount && pairs > 0.0; ++bin) {
+    double sum = 0.0;
+    for (Index pair = 0; pair < typePairs; ++pair)
+      sum += m_weightedCounts[pair * m_binCount + bin];
+    Real shell = 4.0 / 3.0 * PI * std::pow(m_binWidth, 3) *
+                 (std::pow(bin + 1.0, 3) - std::pow(bin, 3));
+    result[bin] = sum / (pairs * shell);
+  }
+  return result;
+}
+
+std::vector<Real> StructureAnalysis::coordination(unsigned char a,
+                                                  unsigned char b) const
+{
+  std::vector<Real> result;
+  Index typeA = findElement(m_elements, a);
+  Index typeB = findElement(m_elements, b);
+  if (typeA == m_elements.size() || typeB == m_elements.size())
+    return result;
+
+  const Real centers = static_cast<Real>(m_frameCount) * m_typeCounts[typeA];
+  const Index offset = (typeA * m_elements.size() + typeB) * m_binCount;
+  result.resize(m_binCount, 0.0);
+  double sum = 0.0;
+  for (Index bin = 0; bin < m_binCount && centers > 0.0; ++bin) {
+    sum += m_pairCounts[offset + bin];
+    result[bin] = sum / centers;
+  }
+  return result;
+}
+
+std::vector<Real> StructureAnalysis::msd() const
+{
+  const Index typeCount = m_elements.size();
+  const Index frames = typeCount > 0 ? m_displacements.size() / typeCount : 0;
+  std::vector<Real> result(frames, 0.0);
+  for (Index f = 0; f < frames; ++f) {
+    double sum = 0.0;
+    for (Index type = 0; type < typeCount; ++type)
+      sum += m_displacements[f * typeCount + type];
+    result[f] = sum / m_atomTypes.size();
+  }
+  return result;
+}
+
+std::vector<Real> StructureAnalysis::msd(unsigned char element) const
+{
+  std::vector<Real> result;
+  const Index typeCount = m_elements.size();
+  Index type = findElement(m_elements, element);
+  if (type == typeCount)
+    return result;
+
+  const Index frames = m_displacements.size() / typeCount;
+  result.resize(frames, 0.0);
+  for (Index f = 0; f < frames; ++f)
+    result[f] = m_displacements[f * typeCount + type] / m_typeCounts[type];
+  return result;
+}
+
+bool StructureAnalysis::reset(const Array<unsigned char>& atomicNumbers)
+{
+  m_frameCount = 0;
+  m_binCount = 0;
+  m_elements.clear();
+  m_atomTypes.clear();
+  m_typeCounts.clear();
+  m_pairCounts.clear();
+  m_weightedCounts.clear();
+  m_displacements.clear();
+  m_origin.clear();
+  m_previous.clear();
+  m_unwrapped.clear();
+  if (atomicNumbers.empty() || m_cutoff <= 0.0 || m_binWidth <= 0.0)
+    return false;
+
+  m_elements.assign(atomicNumbers.begin(), atomicNumbers.end());
+  std::sort(m_elements.begin(), m_elements.end());
+  m_elements.erase(std::unique(m_elements.begin(), m_elements.end()),
+                   m_elements.end());
+  m_typeCounts.assign(m_elements.size(), 0);
+  m_atomTypes.resize(atomicNumbers.size());
+  for (Index i = 0; i < atomicNumbers.size(); ++i) {
+    m_atomTypes[i] = findElement(m_elements, atomicNumbers[i]);
+    ++m_typeCounts[m_atomTypes[i]];
+  }
+
+  m_binCount = std::max(
+    static_cast<Index>(std::ceil(m_cutoff / m_binWidth - 1e-8)), Index(1));
+  Index histogramSize = m_elements.size() * m_elements.size() * m_binCount;
+  m_pairCounts.assign(histogramSize, 0.0);
+  m_weightedCounts.assign(histogramSize, 0.0);
+  return true;
+}
+
+void StructureAnalysis::addDisplacements(const Array<Vector3>& positions,
+                                         const UnitCell* cell)
+{
+  const Index typeCount = m_elements.size();
+  const Index offset = m_displacements.size();
+  m_displacements.resize(offset + typeCount, 0.0);
+  if (m_origin.empty()) {
+    m_origin = positions;
+    m_previous = positions;
+    m_unwrapped = positions;
+    return;
+  }
+
+  // Follow the atoms across the cell boundaries, taking the shortest step
+  // from the previous frame.
+  for (Index i = 0; i < positions.size(); ++i) {
+    Vector3 step = positions[i] - m_previous[i];
+    if (cell)
+      step = cell->minimumImage(step);
+    m_unwrapped[i] += step;
+    m_displacements[offset + m_atomTypes[i]] +=
+      (m_unwrapped[i] - m_origin[i]).squaredNorm();
+  }
+  m_previous = positions;
+}
+
+} // end Core namespace
+} // end Avogadro namespace
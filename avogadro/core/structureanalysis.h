@@ -0,0 +1,183 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_STRUCTUREANALYSIS_H
+#define AVOGADRO_CORE_STRUCTUREANALYSIS_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "neighborlist.h"
+#include "vector.h"
+
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class Molecule;
+class UnitCell;
+
+/**
+ * @class StructureAnalysis structureanalysis.h
+ * <avogadro/core/structureanalysis.h>
+ * @brief The StructureAnalysis class computes radial distribution functions,
+ * coordination numbers and the mean-square displacement of the atoms over the
+ * frames of a trajectory.
+ *
+ * The frames are either all the coordinate sets of a molecule, see analyze(),
+ * or are added one at a time with begin() and addFrame(), e.g. while reading
+ * a trajectory. Only the histograms and the positions needed for the
+ * displacements are kept, never the frames themselves.
+ *
+ * The pairs of atoms are found with a NeighborList. In a unit cell, the
+ * distances are those between the atoms and all the periodic images in range,
+ * and the radial distribution functions are normalized with the volume of the
+ * cell. Without a unit cell, the normalization uses the volume of the box
+ * bounding the atoms. The displacements of periodic systems follow the atoms
+ * across the cell boundaries, assuming that no atom moves by more than half
+ * of the cell between two frames.
+ */
+class AVOGADROCORE_EXPORT StructureAnalysis
+{
+public:
+  StructureAnalysis();
+  ~StructureAnalysis();
+
+  /**
+   * The largest distance in Angstrom of the radial distribution functions,
+   * 10 by default.
+   * @{
+   */
+  void setCutoff(Real cutoff) { m_cutoff = cutoff; }
+  Real cutoff() const { return m_cutoff; }
+  /** @} */
+
+  /**
+   * The width in Angstrom of the bins of the radial distribution functions,
+   * 0.05 by default.
+   * @{
+   */
+  void setBinWidth(Real width) { m_binWidth = width; }
+  Real binWidth() const { return m_binWidth; }
+  /** @} */
+
+  /**
+   * The maximum number of threads used, or 0 (the default) to use one per
+   * hardware thread.
+   * @{
+   */
+  void setMaxThreads(int threads) { m_maxThreads = threads; }
+  int maxThreads() const { return m_maxThreads; }
+  /** @} */
+
+  /**
+   * Analyze every coordinate set of @a mol, or its current positions if it
+   * has none. The frames are processed in parallel.
+   * @return False if the molecule has no atoms or the parameters are not
+   * positive.
+   */
+  bool analyze(const Molecule& mol);
+
+  /**
+   * Clear the results and start analyzing a trajectory of the atoms with
+   * @a atomicNumbers, whose frames are given to addFrame().
+   * @return False if there are no atoms or the parameters are not positive.
+   */
+  bool begin(const Array<unsigned char>& atomicNumbers);
+
+  /**
+   * Add the next frame of the trajectory, with the atoms at @a positions in
+   * the periodic system described by @a cell, or not periodic if @a cell is
+   * nullptr.
+   * @return False if the number of atoms differs from begin().
+   */
+  bool addFrame(const Array<Vector3>& positions,
+                const UnitCell* cell = nullptr);
+
+  /** @return The number of frames analyzed. */
+  Index frameCount() const { return m_frameCount; }
+
+  /** @return The number of bins of the radial distribution functions. */
+  Index binCount() const { return m_binCount; }
+
+  /** @return The distance at the center of @a bin. */
+  Real binCenter(Index bin) const { return (bin + 0.5) * m_binWidth; }
+
+  /** @return The atomic numbers of the atoms, sorted and without repeats. */
+  const std::vector<unsigned char>& elements() const { return m_elements; }
+
+  /**
+   * @return The partial radial distribution function g(r) of the atoms of
+   * element @a b around the atoms of element @a a, one value per bin. Empty if
+   * either element is missing.
+   */
+  std::vector<Real> rdf(unsigned char a, unsigned char b) const;
+
+  /** @return The radial distribution function of all atoms. */
+  std::vector<Real> rdf() const;
+
+  /**
+   * @return The mean number of atoms of element @a b within the upper edge of
+   * each bin of an atom of element @a a, i.e. the running coordination number.
+   * Empty if either element is missing.
+   */
+  std::vector<Real> coordination(unsigned char a, unsigned char b) const;
+
+  /**
+   * @return The mean-square displacement of all atoms from the first frame,
+   * one value per frame, in square Angstrom.
+   */
+  std::vector<Real> msd() const;
+
+  /** @return The mean-square displacement of the atoms of @a element. */
+  std::vector<Real> msd(unsigned char element) const;
+
+private:
+  bool reset(const Array<unsigned char>& atomicNumbers);
+  void addDisplacements(const Array<Vector3>& positions,
+                        const UnitCell* cell);
+
+  Real m_cutoff;
+  Real m_binWidth;
+  int m_maxThreads;
+
+  Index m_binCount;
+  Index m_frameCount;
+  std::vector<unsigned char> m_elements;
+  // The position of the element of each atom in m_elements.
+  std::vector<Index> m_atomTypes;
+  std::vector<Index> m_typeCounts;
+
+  // The pair counts of each pair of elements, by bin, and the same counts
+  // weighted with the volume of their frame.
+  std::vector<double> m_pairCounts;
+  std::vector<double> m_weightedCounts;
+
+  // The sum of the square displacements of each element, by frame.
+  std::vector<double> m_displacements;
+  Array<Vector3> m_origin;
+  Array<Vector3> m_previous;
+  Array<Vector3> m_unwrapped;
+
+  // Reused by addFrame() so the search is skipped for small moves.
+  NeighborList m_neighbors;
+};
+
+} // end Core namespace
+} // end Avogadro namespace
+
+#endif // AVOGADRO_CORE_STRUCTUREANALYSIS_H
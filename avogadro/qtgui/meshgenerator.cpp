@@ -17,6 +17,7 @@
 
 #include "meshgenerator.h"
 
+#include <avogadro/core/adaptivecube.h>
 #include <avogadro/core/cube.h>
 #include <avogadro/core/mesh.h>
 #include <avogadro/core/mutex.h>
@@ -27,13 +28,14 @@
 namespace Avogadro {
 namespace QtGui {
 
+using Core::AdaptiveCube;
 using Core::Cube;
 using Core::Mesh;
 
 MeshGenerator::MeshGenerator(QObject* p)
   : QThread(p), m_iso(0.0), m_reverseWinding(false), m_cube(0), m_mesh(0),
     m_stepSize(0.0, 0.0, 0.0), m_min(0.0, 0.0, 0.0), m_dim(0, 0, 0),
-    m_progmin(0), m_progmax(0)
+    m_progmin(0), m_progmax(0), m_adaptiveCube(0)
 {
 }
 
@@ -41,7 +43,7 @@ MeshGenerator::MeshGenerator(const Cube* cube_, Mesh* mesh_, float iso,
                              bool reverse, QObject* p)
   : QThread(p), m_iso(0.0), m_reverseWinding(reverse), m_cube(0), m_mesh(0),
     m_stepSize(0.0, 0.0, 0.0), m_min(0.0, 0.0, 0.0), m_dim(0, 0, 0),
-    m_progmin(0), m_progmax(0)
+    m_progmin(0), m_progmax(0), m_adaptiveCube(0)
 {
   initialize(cube_, mesh_, iso);
 }
@@ -56,6 +58,7 @@ bool MeshGenerator::initialize(const Cube* cube_, Mesh* mesh_, float iso,
   if (!cube_ || !mesh_)
     return false;
   m_cube = cube_;
+  m_adaptiveCube = 0;
   m_mesh = mesh_;
   m_iso = iso;
   m_reverseWinding = reverse;
@@ -72,39 +75,68 @@ bool MeshGenerator::initialize(const Cube* cube_, Mesh* mesh_, float iso,
   return true;
 }
 
+bool MeshGenerator::initialize(const AdaptiveCube* cube_, Mesh* mesh_,
+                               float iso, bool reverse)
+{
+  if (!cube_ || !mesh_)
+    return false;
+  m_cube = 0;
+  m_adaptiveCube = cube_;
+  m_mesh = mesh_;
+  m_iso = iso;
+  m_reverseWinding = reverse;
+  if (!m_adaptiveCube->lock()->tryLock()) {
+    qDebug() << "Cannot get a read lock...";
+    return false;
+  }
+  for (unsigned int i = 0; i < 3; ++i)
+    m_stepSize[i] = static_cast<float>(m_adaptiveCube->spacing()[i]);
+  m_min = m_adaptiveCube->min().cast<float>();
+  m_dim = m_adaptiveCube->dimensions();
+  m_progmax = static_cast<int>(m_adaptiveCube->activeBricks().size());
+  m_adaptiveCube->lock()->unlock();
+  return true;
+}
+
 void MeshGenerator::run()
 {
-  if (!m_cube || !m_mesh) {
+  if ((!m_cube && !m_adaptiveCube) || !m_mesh) {
     qDebug() << "No mesh or cube set - nothing to find isosurface of...";
     return;
   }
 
   // Attempt to obtain a lock, wait one second between attempts.
-  while (!m_cube->lock()->tryLock())
+  Core::Mutex* lock = m_cube ? m_cube->lock() : m_adaptiveCube->lock();
+  while (!lock->tryLock())
     sleep(1);
 
   // Mark the mesh as being worked on and clear it
   m_mesh->setStable(false);
   m_mesh->clear();
 
-  m_vertices.reserve(m_dim.x() * m_dim.y() * m_dim.z() * 3);
-  m_normals.reserve(m_dim.x() * m_dim.y() * m_dim.z() * 3);
-
-  // Now to march the cube
-  for (int i = 0; i < m_dim.x() - 1; ++i) {
-    for (int j = 0; j < m_dim.y() - 1; ++j) {
-      for (int k = 0; k < m_dim.z() - 1; ++k) {
-        marchingCube(Vector3i(i, j, k));
+  if (m_adaptiveCube) {
+    marchBricks();
+  } else {
+    m_vertices.reserve(m_dim.x() * m_dim.y() * m_dim.z() * 3);
+    m_normals.reserve(m_dim.x() * m_dim.y() * m_dim.z() * 3);
+
+    // Now to march the cube
+    for (int i = 0; i < m_dim.x() - 1; ++i) {
+      for (int j = 0; j < m_dim.y() - 1; ++j) {
+        for (int k = 0; k < m_dim.z() - 1; ++k) {
+          marchingCube(Vector3i(i, j, k));
+        }
       }
+      if (m_vertices.capacity() <
+          m_vertices.size() + m_dim.y() * m_dim.x() * 3) {
+        m_vertices.reserve(m_vertices.capacity() * 2);
+        m_normals.reserve(m_normals.capacity() * 2);
+      }
+      emit progressValueChanged(i);
     }
-    if (m_vertices.capacity() < m_vertices.size() + m_dim.y() * m_dim.x() * 3) {
-      m_vertices.reserve(m_vertices.capacity() * 2);
-      m_normals.reserve(m_normals.capacity() * 2);
-    }
-    emit progressValueChanged(i);
   }
 
-  m_cube->lock()->unlock();
+  lock->unlock();
 
   // Copy the data across
   m_mesh->setVertices(m_vertices);
@@ -120,6 +152,7 @@ void MeshGenerator::clear()
 {
   m_iso = 0.0;
   m_cube = 0;
+  m_adaptiveCube = 0;
   m_mesh = 0;
   m_stepSize.setZero();
   m_min.setZero();
@@ -147,15 +180,76 @@ inline float MeshGenerator::offset(float val1, float val2)
   return (m_iso - val1) / (val2 - val1);
 }
 
+Vector3f MeshGenerator::cellNormal(const float values[8],
+                                   const Vector3f& offset) const
+{
+  // The gradient of the trilinear interpolation in the cell, pointing down
+  // the values as normal() does.
+  Vector3f gradient(0.0f, 0.0f, 0.0f);
+  for (int i = 0; i < 8; ++i) {
+    Vector3f weights, derivatives;
+    for (int j = 0; j < 3; ++j) {
+      weights[j] = a2iVertexOffset[i][j] ? offset[j] : 1.0f - offset[j];
+      derivatives[j] = a2iVertexOffset[i][j] ? 1.0f : -1.0f;
+    }
+    gradient.x() += values[i] * derivatives.x() * weights.y() * weights.z();
+    gradient.y() += values[i] * weights.x() * derivatives.y() * weights.z();
+    gradient.z() += values[i] * weights.x() * weights.y() * derivatives.z();
+  }
+  Vector3f norm = -gradient.cwiseQuotient(m_stepSize);
+  norm.normalize();
+  return norm;
+}
+
 unsigned long MeshGenerator::duplicate(const Vector3i&, const Vector3f&)
 {
   // FIXME Not implemented yet.
   return 0;
 }
 
+void MeshGenerator::marchBricks()
+{
+  // The grid is made of whole bricks, every cell of a brick can be marched.
+  const int cells = AdaptiveCube::brickCells;
+  const std::vector<Vector3i>& bricks = m_adaptiveCube->activeBricks();
+  m_vertices.reserve(bricks.size() * cells * cells * 3);
+  m_normals.reserve(bricks.size() * cells * cells * 3);
+
+  float afCubeValue[8];
+  for (size_t n = 0; n < bricks.size(); ++n) {
+    const Vector3i origin = bricks[n] * cells;
+    for (int i = 0; i < cells; ++i) {
+      for (int j = 0; j < cells; ++j) {
+        for (int k = 0; k < cells; ++k) {
+          for (int c = 0; c < 8; ++c) {
+            afCubeValue[c] = static_cast<float>(m_adaptiveCube->brickValue(
+              n, i + a2iVertexOffset[c][0], j + a2iVertexOffset[c][1],
+              k + a2iVertexOffset[c][2]));
+          }
+          marchingCube(origin + Vector3i(i, j, k), afCubeValue);
+        }
+      }
+    }
+    emit progressValueChanged(static_cast<int>(n));
+  }
+}
+
 bool MeshGenerator::marchingCube(const Vector3i& pos)
 {
   float afCubeValue[8];
+
+  // Make a local copy of the values at the cube's corners
+  for (int i = 0; i < 8; ++i) {
+    afCubeValue[i] = static_cast<float>(
+      m_cube->value(Vector3i(pos + Vector3i(a2iVertexOffset[i]))));
+  }
+
+  return marchingCube(pos, afCubeValue);
+}
+
+bool MeshGenerator::marchingCube(const Vector3i& pos, const float values[8])
+{
+  const float* afCubeValue = values;
   Vector3f asEdgeVertex[12];
   Vector3f asEdgeNorm[12];
 
@@ -164,12 +258,6 @@ bool MeshGenerator::marchingCube(const Vector3i& pos)
   for (unsigned int i = 0; i < 3; ++i)
     fPos[i] = static_cast<float>(pos[i]) * m_stepSize[i] + m_min[i];
 
-  // Make a local copy of the values at the cube's corners
-  for (int i = 0; i < 8; ++i) {
-    afCubeValue[i] = static_cast<float>(
-      m_cube->value(Vector3i(pos + Vector3i(a2iVertexOffset[i]))));
-  }
-
   // Find which vertices are inside of the surface and which are outside
   long iFlagIndex = 0;
   for (int i = 0; i < 8; ++i) {
@@ -209,7 +297,17 @@ bool MeshGenerator::marchingCube(const Vector3i& pos)
                      m_stepSize[2]);
 
       /// FIXME Optimize this to only calculate normals when required
-      asEdgeNorm[i] = normal(asEdgeVertex[i]);
+      if (m_adaptiveCube) {
+        Vector3f offset(a2fVertexOffset[a2iEdgeConnection[i][0]][0] +
+                          fOffset * a2fEdgeDirection[i][0],
+                        a2fVertexOffset[a2iEdgeConnection[i][0]][1] +
+                          fOffset * a2fEdgeDirection[i][1],
+                        a2fVertexOffset[a2iEdgeConnection[i][0]][2] +
+                          fOffset * a2fEdgeDirection[i][2]);
+        asEdgeNorm[i] = cellNormal(afCubeValue, offset);
+      } else {
+        asEdgeNorm[i] = normal(asEdgeVertex[i]);
+      }
     }
   }
 
@@ -28,6 +28,7 @@
 namespace Avogadro {
 
 namespace Core {
+class AdaptiveCube;
 class Cube;
 class Mesh;
 }
@@ -46,6 +47,9 @@ namespace QtGui {
  * by Cory Bloyd (marchingsource.cpp) and available at,
  * http://local.wasp.uwa.edu.au/~pbourke/geometry/polygonise/
  *
+ * An AdaptiveCube can be polygonized too, only its active bricks are
+ * marched then, and the normals are taken from the cells themselves.
+ *
  * You must first initialize the class and then call run() to actually
  * polygonize the isosurface. Connect to the classes finished() signal to
  * do something once the polygonization is complete.
@@ -85,6 +89,16 @@ public:
   bool initialize(const Core::Cube* cube, Core::Mesh* mesh, float iso,
                   bool reverse = false);
 
+  /**
+   * Initialization function, set up the MeshGenerator ready to find an
+   * isosurface of the supplied AdaptiveCube.
+   * @param cube The source AdaptiveCube, already evaluated.
+   * @param mesh The Mesh that will hold the isosurface.
+   * @param iso The iso value of the surface.
+   */
+  bool initialize(const Core::AdaptiveCube* cube, Core::Mesh* mesh, float iso,
+                  bool reverse = false);
+
   /**
    * Use this function to begin Mesh generation. Uses an asynchronous thread,
    * and so avoids locking the user interface while the isosurface is found.
@@ -146,6 +160,23 @@ protected:
    */
   bool marchingCube(const Vector3i& pos);
 
+  /**
+   * Perform a marching cubes step on a single cube, with the values at its
+   * corners supplied.
+   */
+  bool marchingCube(const Vector3i& pos, const float values[8]);
+
+  /**
+   * Get the normal at @p offset, relative to the first corner of a cube in
+   * steps, from the trilinear interpolation of the values at its corners.
+   */
+  Vector3f cellNormal(const float values[8], const Vector3f& offset) const;
+
+  /**
+   * March the active bricks of the adaptive cube.
+   */
+  void marchBricks();
+
   float m_iso;              /** The value of the isosurface. */
   bool m_reverseWinding;    /** Whether the winding and normals are reversed */
   const Core::Cube* m_cube; /** The cube that we are generating a Mesh from. */
@@ -158,6 +189,9 @@ protected:
   int m_progmin;
   int m_progmax;
 
+  /** The adaptive cube that we are generating a Mesh from, if not m_cube. */
+  const Core::AdaptiveCube* m_adaptiveCube;
+
   /**
    * These are the tables of constants for the marching cubes and tetrahedra
    * algorithms. They are taken from the public domain source at
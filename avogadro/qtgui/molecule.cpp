@@ -17,18 +17,22 @@
 #include "molecule.h"
 #include "rwmolecule.h"
 
+#include <avogadro/core/unitcell.h>
+
 namespace Avogadro {
 namespace QtGui {
 
 Molecule::Molecule(QObject* parent_)
-  : QObject(parent_), m_undoMolecule(new RWMolecule(*this, this))
+  : QObject(parent_), m_undoMolecule(new RWMolecule(*this, this)),
+    m_periodicImages(1, 1, 1)
 {
   m_undoMolecule->setInteractive(true);
 }
 
 Molecule::Molecule(const Molecule& other)
   : QObject(), Core::Molecule(other),
-    m_undoMolecule(new RWMolecule(*this, this))
+    m_undoMolecule(new RWMolecule(*this, this)),
+    m_periodicImages(other.m_periodicImages)
 {
   m_undoMolecule->setInteractive(true);
   // Now assign the unique ids
@@ -40,7 +44,7 @@ Molecule::Molecule(const Molecule& other)
 }
 
 Molecule::Molecule(const Core::Molecule& other)
-  : QObject(), Core::Molecule(other)
+  : QObject(), Core::Molecule(other), m_periodicImages(1, 1, 1)
 {
   // Now assign the unique ids
   for (Index i = 0; i < atomCount(); i++)
@@ -58,6 +62,7 @@ Molecule& Molecule::operator=(const Molecule& other)
   // Copy over the unique ids
   m_atomUniqueIds = other.m_atomUniqueIds;
   m_bondUniqueIds = other.m_bondUniqueIds;
+  m_periodicImages = other.m_periodicImages;
 
   return *this;
 }
@@ -102,6 +107,18 @@ Molecule::AtomType Molecule::addAtom(unsigned char number, Index uniqueId)
   return a;
 }
 
+bool Molecule::addAtoms(const Core::Array<unsigned char>& atomicNumbers,
+                        const Core::Array<Vector3>& positions)
+{
+  const Index oldSize = atomCount();
+  if (!Core::Molecule::addAtoms(atomicNumbers, positions))
+    return false;
+  m_atomUniqueIds.reserve(m_atomUniqueIds.size() + atomicNumbers.size());
+  for (Index i = oldSize; i < atomCount(); ++i)
+    m_atomUniqueIds.push_back(i);
+  return true;
+}
+
 bool Molecule::removeAtom(Index index)
 {
   if (index >= atomCount())
@@ -159,6 +176,49 @@ bool Molecule::removeAtom(const AtomType& atom_)
   return removeAtom(atom_.index());
 }
 
+bool Molecule::removeAtoms(const Core::Array<Index>& indices)
+{
+  // The base class keeps the order of the remaining atoms and bonds, so the
+  // unique IDs can be renumbered up front.
+  const Index numAtoms = atomCount();
+  std::vector<Index> newAtomIndices(numAtoms, 0);
+  bool removed = false;
+  foreach (Index index, indices) {
+    if (index < numAtoms) {
+      newAtomIndices[index] = MaxIndex;
+      removed = true;
+    }
+  }
+  if (!removed)
+    return false;
+
+  Index newIndex = 0;
+  for (Index i = 0; i < numAtoms; ++i) {
+    if (newAtomIndices[i] != MaxIndex)
+      newAtomIndices[i] = newIndex++;
+  }
+  std::vector<Index> newBondIndices(bondCount(), MaxIndex);
+  newIndex = 0;
+  for (Index i = 0; i < bondCount(); ++i) {
+    const std::pair<Index, Index>& pair = m_bondPairs[i];
+    if (newAtomIndices[pair.first] != MaxIndex &&
+        newAtomIndices[pair.second] != MaxIndex) {
+      newBondIndices[i] = newIndex++;
+    }
+  }
+
+  for (Index i = 0; i < m_atomUniqueIds.size(); ++i) {
+    if (m_atomUniqueIds[i] != MaxIndex)
+      m_atomUniqueIds[i] = newAtomIndices[m_atomUniqueIds[i]];
+  }
+  for (Index i = 0; i < m_bondUniqueIds.size(); ++i) {
+    if (m_bondUniqueIds[i] != MaxIndex)
+      m_bondUniqueIds[i] = newBondIndices[m_bondUniqueIds[i]];
+  }
+
+  return Core::Molecule::removeAtoms(indices);
+}
+
 Molecule::AtomType Molecule::atomByUniqueId(Index uniqueId)
 {
   if (uniqueId >= static_cast<Index>(m_atomUniqueIds.size()) ||
@@ -209,6 +269,18 @@ Molecule::BondType Molecule::addBond(const AtomType& a, const AtomType& b,
   return Core::Molecule::addBond(a, b, order);
 }
 
+bool Molecule::addBonds(const Core::Array<std::pair<Index, Index>>& pairs,
+                        const Core::Array<unsigned char>& orders)
+{
+  const Index oldSize = bondCount();
+  if (!Core::Molecule::addBonds(pairs, orders))
+    return false;
+  m_bondUniqueIds.reserve(m_bondUniqueIds.size() + pairs.size());
+  for (Index i = oldSize; i < bondCount(); ++i)
+    m_bondUniqueIds.push_back(i);
+  return true;
+}
+
 bool Molecule::removeBond(Index index)
 {
   if (index >= bondCount())
@@ -301,5 +373,27 @@ RWMolecule* Molecule::undoMolecule()
   return m_undoMolecule;
 }
 
+std::vector<Vector3f> Molecule::periodicImageTranslations() const
+{
+  std::vector<Vector3f> translations;
+  const Core::UnitCell* cell = unitCell();
+  if (!cell || m_periodicImages == Vector3i(1, 1, 1) ||
+      m_periodicImages.minCoeff() < 1) {
+    return translations;
+  }
+
+  // An odd number of images is centered on the cell, an even number has one
+  // more image on the positive side.
+  Vector3i first = -(m_periodicImages - Vector3i(1, 1, 1)) / 2;
+  translations.reserve(m_periodicImages.prod());
+  for (int a = first[0]; a < first[0] + m_periodicImages[0]; ++a) {
+    for (int b = first[1]; b < first[1] + m_periodicImages[1]; ++b) {
+      for (int c = first[2]; c < first[2] + m_periodicImages[2]; ++c)
+        translations.push_back(cell->imageOffset(a, b, c).cast<float>());
+    }
+  }
+  return translations;
+}
+
 } // end QtGui namespace
 } // end Avogadro namespace
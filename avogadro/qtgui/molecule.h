@@ -27,6 +27,8 @@
 
 #include <QtCore/QObject>
 
+#include <vector>
+
 namespace Avogadro {
 namespace QtGui {
 
@@ -98,6 +100,14 @@ public:
    */
   virtual AtomType addAtom(unsigned char atomicNumber, Index uniqueId);
 
+  /**
+   * Add several atoms to the end of the molecule at once, with new unique IDs.
+   * @return False if the sizes do not match, in which case nothing is added.
+   */
+  bool addAtoms(
+    const Core::Array<unsigned char>& atomicNumbers,
+    const Core::Array<Vector3>& positions = Core::Array<Vector3>()) override;
+
   /**
    * @brief Remove the specified atom from the molecule.
    * @param index The index of the atom to be removed.
@@ -113,6 +123,14 @@ public:
    */
   bool removeAtom(const AtomType& atom) override;
 
+  /**
+   * @brief Remove several atoms from the molecule at once, along with any
+   * bonds to them, keeping the unique IDs of the remaining atoms and bonds.
+   * @param indices The indices of the atoms to be removed, in any order.
+   * @return True if any atom was removed.
+   */
+  bool removeAtoms(const Core::Array<Index>& indices) override;
+
   /**
    * @brief Get the atom referenced by the @p uniqueId, the isValid method
    * should be queried to ensure the id still referenced a valid atom.
@@ -167,6 +185,14 @@ public:
   virtual BondType addBond(const AtomType& a, const AtomType& b,
                            unsigned char bondOrder, Index uniqueId);
 
+  /**
+   * @brief Add several bonds to the molecule at once, with new unique IDs.
+   * @return False if the sizes do not match or an atom does not exist, in
+   * which case nothing is added.
+   */
+  bool addBonds(const Core::Array<std::pair<Index, Index>>& pairs,
+                const Core::Array<unsigned char>& orders) override;
+
   /**
    * @brief Remove the specified bond.
    * @param index The index of the bond to be removed.
@@ -221,6 +247,23 @@ public:
 
   RWMolecule* undoMolecule();
 
+  /**
+   * The number of periodic images of the unit cell shown along each of the
+   * cell vectors, (1, 1, 1) by default. The scene plugins draw the images as
+   * translated copies of the geometry, the atoms are not duplicated.
+   * @{
+   */
+  void setPeriodicImages(const Vector3i& images) { m_periodicImages = images; }
+  Vector3i periodicImages() const { return m_periodicImages; }
+  /** @} */
+
+  /**
+   * @return The translations of the periodic images, centered on the unit
+   * cell itself, which has the zero translation. Empty if the molecule has no
+   * unit cell or a single image is shown.
+   */
+  std::vector<Vector3f> periodicImageTranslations() const;
+
 public slots:
   /**
    * @brief Force the molecule to emit the changed() signal.
@@ -246,6 +289,7 @@ private:
   friend class RWMolecule;
 
   RWMolecule* m_undoMolecule;
+  Vector3i m_periodicImages;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(Molecule::MoleculeChanges)
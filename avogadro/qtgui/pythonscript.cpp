@@ -17,6 +17,7 @@
 #include "pythonscript.h"
 
 #include "avogadropython.h"
+#include "pythonworkerpool_p.h"
 
 #include <QtCore/QDebug>
 #include <QtCore/QProcess>
@@ -25,15 +26,29 @@
 namespace Avogadro {
 namespace QtGui {
 
+namespace {
+bool persistentByDefault()
+{
+  return !qgetenv("AVO_PYTHON_SCRIPT_PERSISTENT").isEmpty() ||
+         QSettings().value("interpreters/pythonPersistent", false).toBool();
+}
+
+// The default longest wait for a script, as long as for a process to start
+// and finish.
+const int scriptTimeout = 10000;
+}
+
 PythonScript::PythonScript(const QString& scriptFilePath_, QObject* parent_)
   : QObject(parent_), m_debug(!qgetenv("AVO_PYTHON_SCRIPT_DEBUG").isEmpty()),
+    m_persistent(persistentByDefault()), m_timeout(scriptTimeout),
     m_scriptFilePath(scriptFilePath_)
 {
   setDefaultPythonInterpretor();
 }
 
 PythonScript::PythonScript(QObject* parent_)
-  : QObject(parent_), m_debug(!qgetenv("AVO_PYTHON_SCRIPT_DEBUG").isEmpty())
+  : QObject(parent_), m_debug(!qgetenv("AVO_PYTHON_SCRIPT_DEBUG").isEmpty()),
+    m_persistent(persistentByDefault()), m_timeout(scriptTimeout)
 {
   setDefaultPythonInterpretor();
 }
@@ -61,6 +76,9 @@ QByteArray PythonScript::execute(const QStringList& args,
                                  const QByteArray& scriptStdin)
 {
   clearErrors();
+  if (m_persistent)
+    return executePersistent(args, scriptStdin);
+
   QProcess proc;
 
   // Merge stdout and stderr
@@ -131,6 +149,42 @@ QByteArray PythonScript::execute(const QStringList& args,
   return result;
 }
 
+QByteArray PythonScript::executePersistent(const QStringList& args,
+                                           const QByteArray& scriptStdin)
+{
+  // Add debugging flag if needed.
+  QStringList realArgs(args);
+  if (m_debug) {
+    realArgs.prepend("--debug");
+    qDebug() << "Executing" << m_scriptFilePath << realArgs.join(" ")
+             << "in a persistent" << m_pythonInterpreter << "<" << scriptStdin;
+  }
+
+  PythonWorkerPool::Result result = PythonWorkerPool::instance()->execute(
+    m_pythonInterpreter, m_scriptFilePath, realArgs, scriptStdin, m_timeout);
+
+  if (!result.error.isEmpty()) {
+    m_errors << tr("Error running script '%1 %2': %3")
+                  .arg(m_scriptFilePath, realArgs.join(" "), result.error);
+    return QByteArray();
+  }
+
+  if (result.exitCode != 0) {
+    m_errors << tr("Error running script '%1 %2': Abnormal exit status %3"
+                   "\n\nOutput:\n%4")
+                  .arg(m_scriptFilePath)
+                  .arg(realArgs.join(" "))
+                  .arg(result.exitCode)
+                  .arg(QString(result.output));
+    return QByteArray();
+  }
+
+  if (m_debug)
+    qDebug() << "Output:" << result.output;
+
+  return result.output;
+}
+
 QString PythonScript::processErrorString(const QProcess& proc) const
 {
   QString result;
@@ -34,6 +34,10 @@ namespace QtGui {
 /**
  * @brief The PythonScript class implements a interface for calling short-lived
  * python utility scripts.
+ *
+ * Each call starts a new interpreter, unless persistent mode is enabled, in
+ * which case the scripts are run by a pool of long-lived interpreters shared
+ * by all the PythonScript objects.
  */
 class AVOGADROQTGUI_EXPORT PythonScript : public QObject
 {
@@ -56,6 +60,35 @@ public:
    */
   bool debug() const { return m_debug; }
 
+  /**
+   * @return True if the script is run in a persistent interpreter.
+   */
+  bool persistent() const { return m_persistent; }
+
+  /**
+   * Run the script in one of a pool of long-lived interpreters, rather than
+   * starting a new one for each call, saving the startup of the interpreter
+   * and of the modules the script imports. The script is run as the main
+   * program, but must not rely on a fresh interpreter, and must write its
+   * output through sys.stdout. The default is enabled if the
+   * AVO_PYTHON_SCRIPT_PERSISTENT environment variable is set, or the
+   * "interpreters/pythonPersistent" QSettings value is true.
+   */
+  void setPersistent(bool persistent_) { m_persistent = persistent_; }
+
+  /**
+   * @return The longest time, in milliseconds, a persistent worker is given
+   * to run the script.
+   */
+  int timeout() const { return m_timeout; }
+
+  /**
+   * Set the longest time, in milliseconds, a persistent worker is given to
+   * run the script, 10 seconds by default. A worker that does not answer in
+   * time is replaced.
+   */
+  void setTimeout(int msecs) { m_timeout = msecs; }
+
   /**
    * @return The path to the generator file.
    */
@@ -95,7 +128,9 @@ public:
    * Start a new process to execute:
    * "<m_pythonInterpreter> <scriptFilePath()> [args ...]",
    * optionally passing scriptStdin to the processes standard input. Returns
-   * the standard output of the process when finished.
+   * the standard output of the process when finished. In persistent mode, the
+   * script is run by a worker of the pool instead, with the same arguments
+   * and input.
    */
   QByteArray execute(const QStringList& args,
                      const QByteArray& scriptStdin = QByteArray());
@@ -108,11 +143,15 @@ public slots:
 
 protected:
   bool m_debug;
+  bool m_persistent;
+  int m_timeout;
   QString m_pythonInterpreter;
   QString m_scriptFilePath;
   QStringList m_errors;
 
 private:
+  QByteArray executePersistent(const QStringList& args,
+                               const QByteArray& scriptStdin);
   QString processErrorString(const QProcess& proc) const;
 };
 
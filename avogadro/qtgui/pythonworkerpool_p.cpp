@@ -0,0 +1,389 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "pythonworkerpool_p.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QThread>
+
+namespace Avogadro {
+namespace QtGui {
+
+namespace {
+// The loop run by each worker, for python 2 and 3. The script runs with its
+// directory first in sys.path, and its standard streams replaced, as if it
+// was started on its own.
+const char* workerSource = R"py(
+import json, os, runpy, sys, traceback
+inp = getattr(sys.stdin, 'buffer', sys.stdin)
+# The frames are written to a copy of fd 1, and fd 1 is sent to stderr, so a
+# script writing to sys.__stdout__ or fd 1 directly cannot break them.
+sys.stdout.flush()
+out = os.fdopen(os.dup(1), 'wb')
+os.dup2(2, 1)
+if sys.platform == 'win32':
+    import msvcrt
+    msvcrt.setmode(inp.fileno(), os.O_BINARY)
+    msvcrt.setmode(out.fileno(), os.O_BINARY)
+def readFrame():
+    line = inp.readline()
+    if not line:
+        sys.exit(0)
+    return inp.read(int(line))
+def writeFrame(data):
+    out.write(str(len(data)).encode('ascii') + b'\n' + data)
+streams = (sys.stdin, sys.stdout, sys.stderr, list(sys.path))
+while True:
+    request = json.loads(readFrame().decode('utf-8'))
+    data = readFrame()
+    if sys.version_info[0] < 3:
+        from StringIO import StringIO
+        sys.stdin, output = StringIO(data), StringIO()
+    else:
+        import io
+        sys.stdin = io.TextIOWrapper(io.BytesIO(data), encoding='utf-8')
+        buffer = io.BytesIO()
+        output = io.TextIOWrapper(buffer, encoding='utf-8', write_through=True)
+    script = request['script']
+    sys.stdout = sys.stderr = output
+    sys.argv = [script] + request['args']
+    sys.path[:] = [os.path.dirname(script)] + streams[3][1:]
+    exitCode = 0
+    try:
+        runpy.run_path(script, run_name='__main__')
+    except SystemExit as e:
+        if e.code is not None and not isinstance(e.code, int):
+            output.write(str(e.code) + '\n')
+            exitCode = 1
+        else:
+            exitCode = e.code or 0
+    except Exception:
+        traceback.print_exc()
+        exitCode = 1
+    sys.stdin, sys.stdout, sys.stderr = streams[:3]
+    output.flush()
+    if sys.version_info[0] < 3:
+        result = output.getvalue()
+        if not isinstance(result, str):
+            result = result.encode('utf-8')
+    else:
+        result = buffer.getvalue()
+    writeFrame(json.dumps({'exitCode': exitCode}).encode('utf-8'))
+    writeFrame(result)
+    out.flush()
+)py";
+
+QMutex poolMutex;
+PythonWorkerPool* pool = nullptr;
+
+QByteArray frame(const QByteArray& data)
+{
+  return QByteArray::number(data.size()) + '\n' + data;
+}
+
+// Take the frame starting at @p pos in @p buffer, if it is complete.
+bool takeFrame(const QByteArray& buffer, int& pos, QByteArray& data)
+{
+  int newline = buffer.indexOf('\n', pos);
+  if (newline < 0)
+    return false;
+  bool ok = false;
+  int length = buffer.mid(pos, newline - pos).toInt(&ok);
+  if (!ok || length < 0 || buffer.size() - newline - 1 < length)
+    return false;
+  data = buffer.mid(newline + 1, length);
+  pos = newline + 1 + length;
+  return true;
+}
+}
+
+struct PythonWorkerPool::Request
+{
+  Request() : done(false), cancelled(false) {}
+
+  QString interpreter;
+  QString scriptFilePath;
+  QStringList args;
+  QByteArray input;
+  bool done;
+  bool cancelled;
+  Result result;
+};
+
+struct PythonWorkerPool::Worker
+{
+  QProcess* process;
+  QString interpreter;
+  QSharedPointer<Request> request;
+  QByteArray buffer;
+};
+
+const int PythonWorkerPool::maximumWorkers;
+
+PythonWorkerPool::PythonWorkerPool() : m_thread(new QThread)
+{
+  moveToThread(m_thread);
+}
+
+PythonWorkerPool::~PythonWorkerPool()
+{
+  delete m_thread;
+}
+
+PythonWorkerPool* PythonWorkerPool::instance()
+{
+  QMutexLocker locker(&poolMutex);
+  if (!pool) {
+    pool = new PythonWorkerPool;
+    pool->m_thread->start();
+    qAddPostRoutine(shutDown);
+  }
+  return pool;
+}
+
+void PythonWorkerPool::shutDown()
+{
+  QMutexLocker locker(&poolMutex);
+  if (!pool)
+    return;
+  QMetaObject::invokeMethod(pool, "stopWorkers",
+                            Qt::BlockingQueuedConnection);
+  pool->m_thread->quit();
+  pool->m_thread->wait();
+  delete pool;
+  pool = nullptr;
+}
+
+PythonWorkerPool::Result PythonWorkerPool::execute(
+  const QString& interpreter, const QString& scriptFilePath,
+  const QStringList& args, const QByteArray& scriptStdin, int timeout)
+{
+  QSharedPointer<Request> request(new Request);
+  request->interpreter = interpreter;
+  request->scriptFilePath = scriptFilePath;
+  request->args = args;
+  request->input = scriptStdin;
+
+  QMutexLocker locker(&m_mutex);
+  m_pending.append(request);
+  QMetaObject::invokeMethod(this, "dispatch", Qt::QueuedConnection);
+
+  QElapsedTimer timer;
+  timer.start();
+  while (!request->done) {
+    qint64 remaining = timeout - timer.elapsed();
+    if (remaining <= 0 ||
+        !m_finished.wait(&m_mutex, static_cast<unsigned long>(remaining))) {
+      if (request->done)
+        break;
+      // The worker may be stuck, it is replaced.
+      request->cancelled = true;
+      QMetaObject::invokeMethod(this, "dispatch", Qt::QueuedConnection);
+      Result result;
+      result.exitCode = -1;
+      result.error = tr("Timed out waiting for the script to finish.");
+      return result;
+    }
+  }
+  return request->result;
+}
+
+void PythonWorkerPool::dispatch()
+{
+  QMutexLocker locker(&m_mutex);
+
+  foreach (Worker* worker, m_workers) {
+    if (worker->request && worker->request->cancelled)
+      discardWorker(worker);
+  }
+
+  while (!m_pending.isEmpty()) {
+    QSharedPointer<Request> request = m_pending.first();
+    if (request->cancelled) {
+      m_pending.removeFirst();
+      continue;
+    }
+
+    // An idle worker of the interpreter, or a new one.
+    Worker* worker = nullptr;
+    Worker* idle = nullptr;
+    foreach (Worker* w, m_workers) {
+      if (w->request)
+        continue;
+      if (w->interpreter == request->interpreter) {
+        worker = w;
+        break;
+      }
+      idle = w;
+    }
+    if (!worker) {
+      if (m_workers.size() >= maximumWorkers) {
+        // Wait for a worker to finish, unless one of another interpreter is
+        // idle and can make room.
+        if (!idle)
+          break;
+        discardWorker(idle);
+      }
+      worker = startWorker(request->interpreter);
+    }
+
+    m_pending.removeFirst();
+    worker->request = request;
+    QJsonObject header;
+    header["script"] = request->scriptFilePath;
+    header["args"] = QJsonArray::fromStringList(request->args);
+    worker->process->write(
+      frame(QJsonDocument(header).toJson(QJsonDocument::Compact)) +
+      frame(request->input));
+  }
+}
+
+void PythonWorkerPool::readResponse()
+{
+  Worker* worker = findWorker(sender());
+  if (!worker)
+    return;
+
+  worker->buffer.append(worker->process->readAllStandardOutput());
+  int pos = 0;
+  QByteArray header;
+  QByteArray output;
+  if (!takeFrame(worker->buffer, pos, header) ||
+      !takeFrame(worker->buffer, pos, output)) {
+    return;
+  }
+  worker->buffer.remove(0, pos);
+  // Stray writes of the script to the descriptors of the worker are dropped.
+  worker->process->readAllStandardError();
+
+  QJsonObject object = QJsonDocument::fromJson(header).object();
+  {
+    QMutexLocker locker(&m_mutex);
+    finishRequest(worker, object.value("exitCode").toInt(), output,
+                  QString());
+  }
+  dispatch();
+}
+
+void PythonWorkerPool::workerFinished()
+{
+  Worker* worker = findWorker(sender());
+  if (!worker)
+    return;
+
+  {
+    QMutexLocker locker(&m_mutex);
+    finishRequest(worker, -1, QByteArray(),
+                  tr("The python worker stopped (%1).\n\nOutput:\n%2")
+                    .arg(worker->process->errorString())
+                    .arg(QString(worker->process->readAllStandardError())));
+    discardWorker(worker);
+  }
+  // Any pending request starts a new worker.
+  dispatch();
+}
+
+void PythonWorkerPool::stopWorkers()
+{
+  QMutexLocker locker(&m_mutex);
+  foreach (Worker* worker, m_workers) {
+    // The loop of the worker ends with its standard input.
+    worker->process->disconnect(this);
+    worker->process->closeWriteChannel();
+    if (!worker->process->waitForFinished(1000)) {
+      worker->process->kill();
+      worker->process->waitForFinished(1000);
+    }
+    finishRequest(worker, -1, QByteArray(),
+                  tr("The python workers were stopped."));
+    delete worker->process;
+    delete worker;
+  }
+  m_workers.clear();
+
+  foreach (const QSharedPointer<Request>& request, m_pending) {
+    request->result.exitCode = -1;
+    request->result.error = tr("The python workers were stopped.");
+    request->done = true;
+  }
+  m_pending.clear();
+  m_finished.wakeAll();
+}
+
+PythonWorkerPool::Worker* PythonWorkerPool::startWorker(
+  const QString& interpreter)
+{
+  Worker* worker = new Worker;
+  worker->interpreter = interpreter;
+  worker->process = new QProcess(this);
+  connect(worker->process, SIGNAL(readyReadStandardOutput()),
+          SLOT(readResponse()));
+  // Queued, as a failure to start may be signaled from start() itself.
+  connect(worker->process, SIGNAL(finished(int, QProcess::ExitStatus)),
+          SLOT(workerFinished()), Qt::QueuedConnection);
+  connect(worker->process, SIGNAL(error(QProcess::ProcessError)),
+          SLOT(workerFinished()), Qt::QueuedConnection);
+  worker->process->start(interpreter, QStringList() << "-u"
+                                                    << "-c" << workerSource);
+  m_workers.append(worker);
+  return worker;
+}
+
+PythonWorkerPool::Worker* PythonWorkerPool::findWorker(QObject* process) const
+{
+  foreach (Worker* worker, m_workers) {
+    if (worker->process == process)
+      return worker;
+  }
+  return nullptr;
+}
+
+void PythonWorkerPool::discardWorker(Worker* worker)
+{
+  finishRequest(worker, -1, QByteArray(),
+                tr("The python worker was stopped."));
+  worker->process->disconnect(this);
+  // Reaped before it is deleted, which QProcess warns about otherwise.
+  if (worker->process->state() != QProcess::NotRunning) {
+    worker->process->kill();
+    worker->process->waitForFinished(1000);
+  }
+  worker->process->deleteLater();
+  m_workers.removeOne(worker);
+  delete worker;
+}
+
+void PythonWorkerPool::finishRequest(Worker* worker, int exitCode,
+                                     const QByteArray& output,
+                                     const QString& error)
+{
+  QSharedPointer<Request> request = worker->request;
+  worker->request.clear();
+  if (!request)
+    return;
+  request->result.exitCode = exitCode;
+  request->result.output = output;
+  request->result.error = error;
+  request->done = true;
+  m_finished.wakeAll();
+}
+
+} // namespace QtGui
+} // namespace Avogadro
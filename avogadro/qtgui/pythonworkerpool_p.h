@@ -0,0 +1,118 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_QTGUI_PYTHONWORKERPOOL_P_H
+#define AVOGADRO_QTGUI_PYTHONWORKERPOOL_P_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QProcess>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QWaitCondition>
+
+class QThread;
+
+namespace Avogadro {
+namespace QtGui {
+
+/**
+ * @class PythonWorkerPool
+ * @internal
+ * @brief A pool of long-lived python interpreters, running scripts on request.
+ *
+ * Each worker runs a loop reading requests on its standard input, each naming
+ * a script, its arguments and the data for its standard input. The script is
+ * run in the worker as if it was the main program, and its exit code and
+ * output, standard error included, are written back. Requests and responses
+ * are sent as frames, a length in ASCII digits and a newline followed by as
+ * many bytes. The modules a script imports stay loaded, so only the first
+ * request to a worker pays for the startup of the interpreter.
+ *
+ * The workers belong to a thread of the pool. Requests may be made from any
+ * thread, and are run concurrently by up to maximumWorkers workers. A worker
+ * that crashes, or does not answer in time, is discarded and replaced on the
+ * next request.
+ */
+class PythonWorkerPool : public QObject
+{
+  Q_OBJECT
+public:
+  /** The result of a request, @a error is set if the script could not run. */
+  struct Result
+  {
+    int exitCode;
+    QByteArray output;
+    QString error;
+  };
+
+  /** The largest number of workers running at once. */
+  static const int maximumWorkers = 4;
+
+  /**
+   * @return The pool, started on first use and stopped when the application
+   * exits.
+   */
+  static PythonWorkerPool* instance();
+
+  /**
+   * Run @p scriptFilePath with the arguments @p args and @p scriptStdin as its
+   * standard input in a worker of @p interpreter, waiting at most @p timeout
+   * milliseconds for it to finish.
+   */
+  Result execute(const QString& interpreter, const QString& scriptFilePath,
+                 const QStringList& args, const QByteArray& scriptStdin,
+                 int timeout);
+
+private slots:
+  void dispatch();
+  void readResponse();
+  void workerFinished();
+  void stopWorkers();
+
+private:
+  struct Request;
+  struct Worker;
+
+  PythonWorkerPool();
+  ~PythonWorkerPool() override;
+
+  static void shutDown();
+
+  Worker* startWorker(const QString& interpreter);
+  Worker* findWorker(QObject* process) const;
+  void discardWorker(Worker* worker);
+  void finishRequest(Worker* worker, int exitCode, const QByteArray& output,
+                     const QString& error);
+
+  QThread* m_thread;
+
+  // Only used in the thread of the pool.
+  QList<Worker*> m_workers;
+
+  // Shared with the threads making requests.
+  QMutex m_mutex;
+  QWaitCondition m_finished;
+  QList<QSharedPointer<Request>> m_pending;
+};
+
+} // namespace QtGui
+} // namespace Avogadro
+
+#endif // AVOGADRO_QTGUI_PYTHONWORKERPOOL_P_H
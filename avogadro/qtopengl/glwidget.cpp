@@ -25,6 +25,7 @@
 
 #include <avogadro/rendering/camera.h>
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QTimer>
 #include <QtGui/QKeyEvent>
 #include <QtGui/QMouseEvent>
@@ -85,10 +86,16 @@ void GLWidget::updateScene()
     node.clear();
     Rendering::GroupNode* moleculeNode = new Rendering::GroupNode(&node);
 
+    Rendering::RenderStatistics& stats = m_renderer.statistics();
+    stats.beginScene();
+    QElapsedTimer timer;
     foreach (QtGui::ScenePlugin* scenePlugin,
              m_scenePlugins.activeScenePlugins()) {
       Rendering::GroupNode* engineNode = new Rendering::GroupNode(moleculeNode);
+      timer.start();
       scenePlugin->process(*mol, *engineNode);
+      stats.addSceneTime("plugin/" + scenePlugin->name().toStdString(),
+                         timer.nsecsElapsed() / 1.0e6);
     }
 
     // Let the tools perform any drawing they need to do.
@@ -242,6 +249,9 @@ void GLWidget::resizeGL(int width_, int height_)
 void GLWidget::paintGL()
 {
   m_renderer.render();
+  // Keep rendering while the scene is being refined progressively.
+  if (m_renderer.isRefining())
+    requestUpdate();
 }
 
 void GLWidget::mouseDoubleClickEvent(QMouseEvent* e)
@@ -74,6 +74,25 @@ public:
   /** Get a reference to the renderer for the widget. */
   Rendering::GLRenderer& renderer() { return m_renderer; }
 
+  /**
+   * Timings of the last frame and scene update, including the time spent in
+   * each scene plugin. Disabled by default, use toJson() to dump them.
+   * @{
+   */
+  void setRenderStatisticsEnabled(bool enable)
+  {
+    m_renderer.statistics().setEnabled(enable);
+  }
+  bool renderStatisticsEnabled() const
+  {
+    return m_renderer.statistics().isEnabled();
+  }
+  const Rendering::RenderStatistics& renderStatistics() const
+  {
+    return m_renderer.statistics();
+  }
+  /** @} */
+
   /**
    * @return A list of the ToolPlugins owned by the GLWidget.
    */
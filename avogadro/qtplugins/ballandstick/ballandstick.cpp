@@ -18,6 +18,7 @@
 
 #include <avogadro/core/elements.h>
 #include <avogadro/core/molecule.h>
+#include <avogadro/qtgui/molecule.h>
 #include <avogadro/qtgui/rwmolecule.h>
 #include <avogadro/rendering/cylindergeometry.h>
 #include <avogadro/rendering/geometrynode.h>
@@ -64,6 +65,14 @@ void BallAndStick::process(const Molecule& molecule, Rendering::GroupNode& node)
   spheres->identifier().type = Rendering::AtomType;
   geometry->addDrawable(spheres);
 
+  // Periodic images are drawn as translated copies of the geometry.
+  std::vector<Vector3f> translations;
+  const QtGui::Molecule* qtMolecule =
+    dynamic_cast<const QtGui::Molecule*>(&molecule);
+  if (qtMolecule)
+    translations = qtMolecule->periodicImageTranslations();
+  spheres->setTranslations(translations);
+
   for (Index i = 0; i < molecule.atomCount(); ++i) {
     Core::Atom atom = molecule.atom(i);
     unsigned char atomicNumber = atom.atomicNumber();
@@ -84,6 +93,7 @@ void BallAndStick::process(const Molecule& molecule, Rendering::GroupNode& node)
   cylinders->identifier().molecule = &molecule;
   cylinders->identifier().type = Rendering::BondType;
   geometry->addDrawable(cylinders);
+  cylinders->setTranslations(translations);
   for (Index i = 0; i < molecule.bondCount(); ++i) {
     Core::Bond bond = molecule.bond(i);
     if (!m_showHydrogens && (bond.atom1().atomicNumber() == 1 ||
@@ -132,6 +142,11 @@ void BallAndStick::processEditable(const QtGui::RWMolecule& molecule,
   spheres->identifier().type = Rendering::AtomType;
   geometry->addDrawable(spheres);
 
+  // Periodic images are drawn as translated copies of the geometry.
+  std::vector<Vector3f> translations =
+    molecule.molecule().periodicImageTranslations();
+  spheres->setTranslations(translations);
+
   for (Index i = 0; i < molecule.atomCount(); ++i) {
     QtGui::RWAtom atom = molecule.atom(i);
     unsigned char atomicNumber = atom.atomicNumber();
@@ -149,6 +164,7 @@ void BallAndStick::processEditable(const QtGui::RWMolecule& molecule,
   cylinders->identifier().molecule = &molecule;
   cylinders->identifier().type = Rendering::BondType;
   geometry->addDrawable(cylinders);
+  cylinders->setTranslations(translations);
   for (Index i = 0; i < molecule.bondCount(); ++i) {
     QtGui::RWBond bond = molecule.bond(i);
     if (!m_showHydrogens && (bond.atom1().atomicNumber() == 1 ||
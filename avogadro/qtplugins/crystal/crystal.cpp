@@ -45,6 +45,7 @@ Crystal::Crystal(QObject* parent_)
     m_importCrystalClipboardAction(new QAction(this)),
     m_editUnitCellAction(new QAction(this)),
     m_buildSupercellAction(new QAction(this)),
+    m_periodicImagesAction(new QAction(this)),
     m_niggliReduceAction(new QAction(this)),
     m_scaleVolumeAction(new QAction(this)),
     m_standardOrientationAction(new QAction(this)),
@@ -90,6 +91,12 @@ Crystal::Crystal(QObject* parent_)
   m_actions.push_back(m_buildSupercellAction);
   m_buildSupercellAction->setProperty("menu priority", 150);
 
+  m_periodicImagesAction->setText(tr("Show Periodic &Images..."));
+  connect(m_periodicImagesAction, SIGNAL(triggered()),
+          SLOT(showPeriodicImages()));
+  m_actions.push_back(m_periodicImagesAction);
+  m_periodicImagesAction->setProperty("menu priority", 145);
+
   m_niggliReduceAction->setText(tr("Reduce Cell (&Niggli)"));
   connect(m_niggliReduceAction, SIGNAL(triggered()), SLOT(niggliReduce()));
   m_actions.push_back(m_niggliReduceAction);
@@ -200,6 +207,12 @@ void Crystal::buildSupercell()
   d.buildSupercell(*m_molecule);
 }
 
+void Crystal::showPeriodicImages()
+{
+  SupercellDialog d;
+  d.showPeriodicImages(*m_molecule);
+}
+
 void Crystal::niggliReduce()
 {
   if (CrystalTools::isNiggliReduced(*m_molecule)) {
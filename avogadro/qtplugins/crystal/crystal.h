@@ -49,6 +49,7 @@ private slots:
   void importCrystalClipboard();
   void editUnitCell();
   void buildSupercell();
+  void showPeriodicImages();
   void niggliReduce();
   void scaleVolume();
   void standardOrientation();
@@ -63,6 +64,7 @@ private:
   QAction* m_importCrystalClipboardAction;
   QAction* m_editUnitCellAction;
   QAction* m_buildSupercellAction;
+  QAction* m_periodicImagesAction;
   QAction* m_niggliReduceAction;
   QAction* m_scaleVolumeAction;
   QAction* m_standardOrientationAction;
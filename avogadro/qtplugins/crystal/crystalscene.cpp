@@ -19,6 +19,7 @@
 #include <avogadro/core/array.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/unitcell.h>
+#include <avogadro/qtgui/molecule.h>
 #include <avogadro/rendering/geometrynode.h>
 #include <avogadro/rendering/groupnode.h>
 #include <avogadro/rendering/linestripgeometry.h>
@@ -57,39 +58,50 @@ void CrystalScene::process(const Molecule& molecule, GroupNode& node)
     Vector3f b = cell->bVector().cast<float>();
     Vector3f c = cell->cVector().cast<float>();
 
-    Vector3f vertex(Vector3f::Zero());
-
-    Array<Vector3f> strip;
-    strip.reserve(5);
-    strip.push_back(vertex);
-    strip.push_back(vertex += a);
-    strip.push_back(vertex += b);
-    strip.push_back(vertex -= a);
-    strip.push_back(vertex -= b);
-    lines->addLineStrip(strip, width);
-
-    for (Array<Vector3f>::iterator it = strip.begin(), itEnd = strip.end();
-         it != itEnd; ++it) {
-      *it += c;
+    // Outline every periodic image shown, or just the cell.
+    std::vector<Vector3f> translations;
+    const QtGui::Molecule* qtMolecule =
+      dynamic_cast<const QtGui::Molecule*>(&molecule);
+    if (qtMolecule)
+      translations = qtMolecule->periodicImageTranslations();
+    if (translations.empty())
+      translations.push_back(Vector3f::Zero());
+
+    for (size_t i = 0; i < translations.size(); ++i) {
+      Vector3f vertex(translations[i]);
+
+      Array<Vector3f> strip;
+      strip.reserve(5);
+      strip.push_back(vertex);
+      strip.push_back(vertex += a);
+      strip.push_back(vertex += b);
+      strip.push_back(vertex -= a);
+      strip.push_back(vertex -= b);
+      lines->addLineStrip(strip, width);
+
+      for (Array<Vector3f>::iterator it = strip.begin(), itEnd = strip.end();
+           it != itEnd; ++it) {
+        *it += c;
+      }
+      lines->addLineStrip(strip, width);
+
+      strip.resize(2);
+      strip[0] = translations[i];
+      strip[1] = translations[i] + c;
+      lines->addLineStrip(strip, width);
+
+      strip[0] += a;
+      strip[1] += a;
+      lines->addLineStrip(strip, width);
+
+      strip[0] += b;
+      strip[1] += b;
+      lines->addLineStrip(strip, width);
+
+      strip[0] -= a;
+      strip[1] -= a;
+      lines->addLineStrip(strip, width);
     }
-    lines->addLineStrip(strip, width);
-
-    strip.resize(2);
-    strip[0] = Vector3f::Zero();
-    strip[1] = c;
-    lines->addLineStrip(strip, width);
-
-    strip[0] += a;
-    strip[1] += a;
-    lines->addLineStrip(strip, width);
-
-    strip[0] += b;
-    strip[1] += b;
-    lines->addLineStrip(strip, width);
-
-    strip[0] -= a;
-    strip[1] -= a;
-    lines->addLineStrip(strip, width);
   }
 }
 
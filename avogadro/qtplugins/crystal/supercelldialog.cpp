@@ -59,5 +59,28 @@ bool SupercellDialog::buildSupercell(Avogadro::QtGui::Molecule& mol)
   return true;
 }
 
+bool SupercellDialog::showPeriodicImages(Avogadro::QtGui::Molecule& mol)
+{
+  setWindowTitle(tr("Periodic Images"));
+  m_ui->groupBox->setTitle(tr("Images Shown"));
+  Vector3i images = mol.periodicImages();
+  m_ui->aCellSpinBox->setValue(images[0]);
+  m_ui->bCellSpinBox->setValue(images[1]);
+  m_ui->cCellSpinBox->setValue(images[2]);
+
+  if (this->exec() == QDialog::Rejected)
+    return false;
+
+  Vector3i newImages(m_ui->aCellSpinBox->value(), m_ui->bCellSpinBox->value(),
+                     m_ui->cCellSpinBox->value());
+  if (newImages == images)
+    return true;
+
+  // Only the scene changes, the atoms are not duplicated.
+  mol.setPeriodicImages(newImages);
+  mol.emitChanged(QtGui::Molecule::UnitCell | QtGui::Molecule::Modified);
+  return true;
+}
+
 } // namespace QtPlugins
 } // namespace Avogadro
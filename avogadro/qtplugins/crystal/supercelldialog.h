@@ -47,6 +47,13 @@ public:
 
   bool buildSupercell(Avogadro::QtGui::Molecule& mol);
 
+  /**
+   * Ask for the number of periodic images of the unit cell to show instead,
+   * and set them on @a mol.
+   * @return False if the dialog was rejected.
+   */
+  bool showPeriodicImages(Avogadro::QtGui::Molecule& mol);
+
   void displayInvalidFormatMessage();
 
 private:
@@ -18,6 +18,7 @@
 
 #include <avogadro/core/elements.h>
 #include <avogadro/core/molecule.h>
+#include <avogadro/qtgui/molecule.h>
 #include <avogadro/rendering/cylindergeometry.h>
 #include <avogadro/rendering/geometrynode.h>
 #include <avogadro/rendering/groupnode.h>
@@ -53,6 +54,15 @@ void Licorice::process(const Molecule& molecule, Rendering::GroupNode& node)
   spheres->identifier().molecule = &molecule;
   spheres->identifier().type = Rendering::AtomType;
   geometry->addDrawable(spheres);
+
+  // Periodic images are drawn as translated copies of the geometry.
+  std::vector<Vector3f> translations;
+  const QtGui::Molecule* qtMolecule =
+    dynamic_cast<const QtGui::Molecule*>(&molecule);
+  if (qtMolecule)
+    translations = qtMolecule->periodicImageTranslations();
+  spheres->setTranslations(translations);
+
   for (Index i = 0; i < molecule.atomCount(); ++i) {
     Core::Atom atom = molecule.atom(i);
     Vector3ub color(Elements::color(atom.atomicNumber()));
@@ -63,6 +73,7 @@ void Licorice::process(const Molecule& molecule, Rendering::GroupNode& node)
   cylinders->identifier().molecule = &molecule;
   cylinders->identifier().type = Rendering::BondType;
   geometry->addDrawable(cylinders);
+  cylinders->setTranslations(translations);
   for (Index i = 0; i < molecule.bondCount(); ++i) {
     Core::Bond bond = molecule.bond(i);
     Vector3f pos1 = bond.atom1().position3d().cast<float>();
@@ -26,16 +26,9 @@
 
 #include <QtConcurrent/QtConcurrentMap>
 
-#include <QDataStream>
-#include <QDir>
-#include <QFile>
-#include <QTemporaryFile>
-
 #include <QVariant>
 
 #include <QFuture>
-#include <QFutureWatcher>
-#include <QProgressDialog>
 
 using namespace std;
 using namespace Eigen;
@@ -48,19 +41,17 @@ namespace QtPlugins {
 
 QList<QVariant> QTAIMLocateNuclearCriticalPoint(QList<QVariant> input)
 {
-  const QString fileName = input.at(0).toString();
+  const QTAIMSharedWavefunction wfn =
+    input.at(0).value<QTAIMSharedWavefunction>();
   const qint64 nucleus = input.at(1).toInt();
   const QVector3D x0y0z0(input.at(2).toReal(), input.at(3).toReal(),
                          input.at(4).toReal());
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(fileName);
-
-  QTAIMWavefunctionEvaluator eval(wfn);
+  QTAIMWavefunctionEvaluator eval(*wfn);
 
   QVector3D result;
 
-  if (wfn.nuclearCharge(nucleus) < 4) {
+  if (wfn->nuclearCharge(nucleus) < 4) {
     //      QTAIMODEIntegrator
     //      ode(eval,QTAIMODEIntegrator::CMBPMinusThreeGradientInElectronDensity);
     QTAIMLSODAIntegrator ode(
@@ -101,32 +92,23 @@ QList<QVariant> QTAIMLocateBondCriticalPoint(QList<QVariant> input)
   QList<QVariant> value;
   value.clear();
 
-  const QString wfnFileName = input.at(0).toString();
-  const QString nuclearCriticalPointsFileName = input.at(1).toString();
+  const QTAIMSharedWavefunction wfn =
+    input.at(0).value<QTAIMSharedWavefunction>();
+  const QVariantList nuclearCriticalPoints = input.at(1).toList();
   const qint64 nucleusA = input.at(2).toInt();
   const qint64 nucleusB = input.at(3).toInt();
   const QVector3D x0y0z0(input.at(4).toReal(), input.at(5).toReal(),
                          input.at(6).toReal());
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-
-  QList<QVector3D> nuclearCriticalPoints;
-  QFile nuclearCriticalPointsFile(nuclearCriticalPointsFileName);
-  nuclearCriticalPointsFile.open(QIODevice::ReadOnly);
-  QDataStream nuclearCriticalPointsFileIn(&nuclearCriticalPointsFile);
-  nuclearCriticalPointsFileIn >> nuclearCriticalPoints;
-  nuclearCriticalPointsFile.close();
-
   QList<QPair<QVector3D, qreal>> betaSpheres;
   for (qint64 i = 0; i < nuclearCriticalPoints.length(); ++i) {
     QPair<QVector3D, qreal> thisBetaSphere;
-    thisBetaSphere.first = nuclearCriticalPoints.at(i);
+    thisBetaSphere.first = nuclearCriticalPoints.at(i).value<QVector3D>();
     thisBetaSphere.second = 0.1;
     betaSpheres.append(thisBetaSphere);
   }
 
-  QTAIMWavefunctionEvaluator eval(wfn);
+  QTAIMWavefunctionEvaluator eval(*wfn);
 
   QList<QVector3D> ncpList;
 
@@ -188,11 +170,12 @@ QList<QVariant> QTAIMLocateBondCriticalPoint(QList<QVariant> input)
   qreal smallestDistance = HUGE_REAL_NUMBER;
   qint64 smallestDistanceIndex = 0;
 
-  for (qint64 n = 0; n < wfn.numberOfNuclei(); ++n) {
+  for (qint64 n = 0; n < wfn->numberOfNuclei(); ++n) {
     Matrix<qreal, 3, 1> a(forwardEndpoint.x(), forwardEndpoint.y(),
                           forwardEndpoint.z());
-    Matrix<qreal, 3, 1> b(wfn.xNuclearCoordinate(n), wfn.yNuclearCoordinate(n),
-                          wfn.zNuclearCoordinate(n));
+    Matrix<qreal, 3, 1> b(wfn->xNuclearCoordinate(n),
+                          wfn->yNuclearCoordinate(n),
+                          wfn->zNuclearCoordinate(n));
 
     qreal distance = QTAIMMathUtilities::distance(a, b);
 
@@ -206,11 +189,12 @@ QList<QVariant> QTAIMLocateBondCriticalPoint(QList<QVariant> input)
   smallestDistance = HUGE_REAL_NUMBER;
   smallestDistanceIndex = 0;
 
-  for (qint64 n = 0; n < wfn.numberOfNuclei(); ++n) {
+  for (qint64 n = 0; n < wfn->numberOfNuclei(); ++n) {
     Matrix<qreal, 3, 1> a(backwardEndpoint.x(), backwardEndpoint.y(),
                           backwardEndpoint.z());
-    Matrix<qreal, 3, 1> b(wfn.xNuclearCoordinate(n), wfn.yNuclearCoordinate(n),
-                          wfn.zNuclearCoordinate(n));
+    Matrix<qreal, 3, 1> b(wfn->xNuclearCoordinate(n),
+                          wfn->yNuclearCoordinate(n),
+                          wfn->zNuclearCoordinate(n));
 
     qreal distance = QTAIMMathUtilities::distance(a, b);
 
@@ -284,7 +268,8 @@ QList<QVariant> QTAIMLocateBondCriticalPoint(QList<QVariant> input)
 QList<QVariant> QTAIMLocateElectronDensitySink(QList<QVariant> input)
 {
   qint64 counter = 0;
-  const QString fileName = input.at(counter).toString();
+  const QTAIMSharedWavefunction wfn =
+    input.at(counter).value<QTAIMSharedWavefunction>();
   counter++;
   //    const qint64 nucleus=input.at(counter).toInt(); counter++
   qreal x0 = input.at(counter).toReal();
@@ -296,10 +281,8 @@ QList<QVariant> QTAIMLocateElectronDensitySink(QList<QVariant> input)
 
   const QVector3D x0y0z0(x0, y0, z0);
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(fileName);
 
-  QTAIMWavefunctionEvaluator eval(wfn);
+  QTAIMWavefunctionEvaluator eval(*wfn);
 
   bool correctSignature;
   QVector3D result;
@@ -348,7 +331,8 @@ QList<QVariant> QTAIMLocateElectronDensitySink(QList<QVariant> input)
 QList<QVariant> QTAIMLocateElectronDensitySource(QList<QVariant> input)
 {
   qint64 counter = 0;
-  const QString fileName = input.at(counter).toString();
+  const QTAIMSharedWavefunction wfn =
+    input.at(counter).value<QTAIMSharedWavefunction>();
   counter++;
   //    const qint64 nucleus=input.at(counter).toInt(); counter++
   qreal x0 = input.at(counter).toReal();
@@ -360,10 +344,8 @@ QList<QVariant> QTAIMLocateElectronDensitySource(QList<QVariant> input)
 
   const QVector3D x0y0z0(x0, y0, z0);
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(fileName);
 
-  QTAIMWavefunctionEvaluator eval(wfn);
+  QTAIMWavefunctionEvaluator eval(*wfn);
 
   bool correctSignature;
   QVector3D result;
@@ -409,10 +391,10 @@ QList<QVariant> QTAIMLocateElectronDensitySource(QList<QVariant> input)
   return value;
 }
 
-QTAIMCriticalPointLocator::QTAIMCriticalPointLocator(QTAIMWavefunction& wfn)
+QTAIMCriticalPointLocator::QTAIMCriticalPointLocator(
+  const QTAIMWavefunction& wfn)
+  : m_wfn(new QTAIMWavefunction(wfn)), m_progress(nullptr)
 {
-  m_wfn = &wfn;
-
   m_nuclearCriticalPoints.empty();
   m_bondCriticalPoints.empty();
   m_ringCriticalPoints.empty();
@@ -431,15 +413,13 @@ QTAIMCriticalPointLocator::QTAIMCriticalPointLocator(QTAIMWavefunction& wfn)
 void QTAIMCriticalPointLocator::locateNuclearCriticalPoints()
 {
 
-  QString tempFileName = QTAIMCriticalPointLocator::temporaryFileName();
-
   QList<QList<QVariant>> inputList;
 
   const qint64 numberOfNuclei = m_wfn->numberOfNuclei();
 
   for (qint64 n = 0; n < numberOfNuclei; ++n) {
     QList<QVariant> input;
-    input.append(tempFileName);
+    input.append(QVariant::fromValue(m_wfn));
     input.append(n);
     input.append(m_wfn->xNuclearCoordinate(n));
     input.append(m_wfn->yNuclearCoordinate(n));
@@ -448,36 +428,18 @@ void QTAIMCriticalPointLocator::locateNuclearCriticalPoints()
     inputList.append(input);
   }
 
-  m_wfn->saveToBinaryFile(tempFileName);
-
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Nuclear Critical Points Search"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)),
-                   &dialog, SLOT(setRange(int, int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
-                   SLOT(setValue(int)));
-
   QFuture<QList<QVariant>> future =
     QtConcurrent::mapped(inputList, QTAIMLocateNuclearCriticalPoint);
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
+  QTAIMWaitForStage(future, "Nuclear Critical Points Search",
+                    inputList.length(), m_progress);
 
   QList<QList<QVariant>> results;
-  if (futureWatcher.future().isCanceled()) {
+  if (future.isCanceled()) {
     results.clear();
   } else {
     results = future.results();
   }
 
-  QFile file;
-  file.remove(tempFileName);
-
   for (qint64 n = 0; n < results.length(); ++n) {
 
     bool correctSignature = results.at(n).at(0).toBool();
@@ -506,15 +468,12 @@ void QTAIMCriticalPointLocator::locateBondCriticalPoints()
     return;
   }
 
-  QString tempFileName = QTAIMCriticalPointLocator::temporaryFileName();
-
-  QString nuclearCriticalPointsFileName =
-    QTAIMCriticalPointLocator::temporaryFileName();
-  QFile nuclearCriticalPointsFile(nuclearCriticalPointsFileName);
-  nuclearCriticalPointsFile.open(QIODevice::WriteOnly);
-  QDataStream nuclearCriticalPointsOut(&nuclearCriticalPointsFile);
-  nuclearCriticalPointsOut << m_nuclearCriticalPoints;
-  nuclearCriticalPointsFile.close();
+  // Shared by all the tasks, like the wavefunction.
+  QVariantList nuclearCriticalPoints;
+  for (qint64 i = 0; i < m_nuclearCriticalPoints.length(); ++i) {
+    nuclearCriticalPoints.append(
+      QVariant::fromValue(m_nuclearCriticalPoints.at(i)));
+  }
 
   QList<QList<QVariant>> inputList;
 
@@ -538,8 +497,8 @@ void QTAIMCriticalPointLocator::locateBondCriticalPoints()
           (m_wfn->zNuclearCoordinate(M) + m_wfn->zNuclearCoordinate(N)) / 2.0);
 
         QList<QVariant> input;
-        input.append(tempFileName);
-        input.append(nuclearCriticalPointsFileName);
+        input.append(QVariant::fromValue(m_wfn));
+        input.append(QVariant(nuclearCriticalPoints));
         input.append(M);
         input.append(N);
         input.append(x0y0z0.x());
@@ -551,38 +510,18 @@ void QTAIMCriticalPointLocator::locateBondCriticalPoints()
     } // end N
   }   // end M
 
-  m_wfn->saveToBinaryFile(tempFileName);
-
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Bond Critical Points Search"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)),
-                   &dialog, SLOT(setRange(int, int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
-                   SLOT(setValue(int)));
-
   QFuture<QList<QVariant>> future =
     QtConcurrent::mapped(inputList, QTAIMLocateBondCriticalPoint);
-  ;
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
+  QTAIMWaitForStage(future, "Bond Critical Points Search",
+                    inputList.length(), m_progress);
 
   QList<QList<QVariant>> results;
-  if (futureWatcher.future().isCanceled()) {
+  if (future.isCanceled()) {
     results.clear();
   } else {
     results = future.results();
   }
 
-  QFile file;
-  file.remove(tempFileName);
-  file.remove(nuclearCriticalPointsFileName);
-
   for (qint64 i = 0; i < results.length(); ++i) {
     QList<QVariant> thisCriticalPoint = results.at(i);
 
@@ -623,8 +562,6 @@ void QTAIMCriticalPointLocator::locateBondCriticalPoints()
 void QTAIMCriticalPointLocator::locateElectronDensitySources()
 {
 
-  QString tempFileName = QTAIMCriticalPointLocator::temporaryFileName();
-
   QList<QList<QVariant>> inputList;
 
   qreal xmin, ymin, zmin;
@@ -689,7 +626,7 @@ void QTAIMCriticalPointLocator::locateElectronDensitySources()
     for (qreal y = ymin; y < ymax + ystep; y = y + ystep) {
       for (qreal z = zmin; z < zmax + zstep; z = z + zstep) {
         QList<QVariant> input;
-        input.append(tempFileName);
+        input.append(QVariant::fromValue(m_wfn));
         //          input.append( n );
         input.append(x);
         input.append(y);
@@ -700,36 +637,18 @@ void QTAIMCriticalPointLocator::locateElectronDensitySources()
     }
   }
 
-  m_wfn->saveToBinaryFile(tempFileName);
-
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Electron Density Sources Search"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)),
-                   &dialog, SLOT(setRange(int, int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
-                   SLOT(setValue(int)));
-
   QFuture<QList<QVariant>> future =
     QtConcurrent::mapped(inputList, QTAIMLocateElectronDensitySource);
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
+  QTAIMWaitForStage(future, "Electron Density Sources Search",
+                    inputList.length(), m_progress);
 
   QList<QList<QVariant>> results;
-  if (futureWatcher.future().isCanceled()) {
+  if (future.isCanceled()) {
     results.clear();
   } else {
     results = future.results();
   }
 
-  QFile file;
-  file.remove(tempFileName);
-
   for (qint64 n = 0; n < results.length(); ++n) {
 
     qint64 counter = 0;
@@ -776,8 +695,6 @@ void QTAIMCriticalPointLocator::locateElectronDensitySources()
 void QTAIMCriticalPointLocator::locateElectronDensitySinks()
 {
 
-  QString tempFileName = QTAIMCriticalPointLocator::temporaryFileName();
-
   QList<QList<QVariant>> inputList;
 
   qreal xmin, ymin, zmin;
@@ -842,7 +759,7 @@ void QTAIMCriticalPointLocator::locateElectronDensitySinks()
     for (qreal y = ymin; y < ymax + ystep; y = y + ystep) {
       for (qreal z = zmin; z < zmax + zstep; z = z + zstep) {
         QList<QVariant> input;
-        input.append(tempFileName);
+        input.append(QVariant::fromValue(m_wfn));
         //          input.append( n );
         input.append(x);
         input.append(y);
@@ -853,36 +770,18 @@ void QTAIMCriticalPointLocator::locateElectronDensitySinks()
     }
   }
 
-  m_wfn->saveToBinaryFile(tempFileName);
-
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Electron Density Sinks Search"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)),
-                   &dialog, SLOT(setRange(int, int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
-                   SLOT(setValue(int)));
-
   QFuture<QList<QVariant>> future =
     QtConcurrent::mapped(inputList, QTAIMLocateElectronDensitySink);
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
+  QTAIMWaitForStage(future, "Electron Density Sinks Search",
+                    inputList.length(), m_progress);
 
   QList<QList<QVariant>> results;
-  if (futureWatcher.future().isCanceled()) {
+  if (future.isCanceled()) {
     results.clear();
   } else {
     results = future.results();
   }
 
-  QFile file;
-  file.remove(tempFileName);
-
   for (qint64 n = 0; n < results.length(); ++n) {
 
     qint64 counter = 0;
@@ -926,22 +825,5 @@ void QTAIMCriticalPointLocator::locateElectronDensitySinks()
   //    qDebug() << "SINKS" << m_electronDensitySinks;
 }
 
-QString QTAIMCriticalPointLocator::temporaryFileName()
-{
-  QTemporaryFile temporaryFile;
-  temporaryFile.open();
-  QString tempFileName = temporaryFile.fileName();
-  temporaryFile.close();
-  temporaryFile.remove();
-
-  // wait for temporary file to be deleted
-  QDir dir;
-  do {
-    // Nothing
-  } while (dir.exists(tempFileName));
-
-  return tempFileName;
-}
-
 } // namespace QtPlugins
 } // namespace Avogadro
@@ -23,6 +23,7 @@
 #include <QVector3D>
 
 #include "qtaimmathutilities.h"
+#include "qtaimprogress.h"
 #include "qtaimwavefunction.h"
 #include "qtaimwavefunctionevaluator.h"
 
@@ -33,7 +34,12 @@ class QTAIMCriticalPointLocator
 {
 
 public:
-  explicit QTAIMCriticalPointLocator(QTAIMWavefunction& wfn);
+  explicit QTAIMCriticalPointLocator(const QTAIMWavefunction& wfn);
+
+  // The progress of the searches is reported to progress, which can cancel
+  // them. It is not owned, and may be null.
+  void setProgress(QTAIMProgress* progress) { m_progress = progress; }
+
   void locateNuclearCriticalPoints();
   void locateBondCriticalPoints();
 
@@ -70,7 +76,8 @@ public:
   }
 
 private:
-  QTAIMWavefunction* m_wfn;
+  QTAIMSharedWavefunction m_wfn;
+  QTAIMProgress* m_progress;
 
   QList<QVector3D> m_nuclearCriticalPoints;
   QList<QVector3D> m_bondCriticalPoints;
@@ -84,8 +91,6 @@ private:
 
   QList<QVector3D> m_electronDensitySources;
   QList<QVector3D> m_electronDensitySinks;
-
-  QString temporaryFileName();
 };
 
 } // namespace QtPlugins
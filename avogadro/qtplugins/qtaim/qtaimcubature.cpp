@@ -49,25 +49,15 @@
  *
  */
 
-#include <QDataStream>
 #include <QDebug>
-#include <QDir>
-#include <QFile>
-#include <QTemporaryFile>
 #include <QTextStream>
 
 #include <QPair>
 #include <QVariantList>
 #include <QVector3D>
 
-#include <QDataStream>
-#include <QDir>
-#include <QFile>
 #include <QFuture>
-#include <QFutureWatcher>
 #include <QList>
-#include <QProgressDialog>
-#include <QTemporaryFile>
 #include <QVariant>
 #include <QtConcurrent/QtConcurrentMap>
 
@@ -1184,7 +1174,8 @@ QList<QVariant> QTAIMEvaluateProperty(QList<QVariant> variantList)
 {
   /*
      Order of variantList:
-     QString wfnFileName
+     QTAIMSharedWavefunction wfn
+     QTAIMSharedDensityGrid grid
      qreal x0
      qreal y0
      qreal z0
@@ -1206,7 +1197,11 @@ QList<QVariant> QTAIMEvaluateProperty(QList<QVariant> variantList)
      ...
   */
   qint64 counter = 0;
-  QString wfnFileName = variantList.at(counter).toString();
+  QTAIMSharedWavefunction wfn =
+    variantList.at(counter).value<QTAIMSharedWavefunction>();
+  counter++;
+  QTAIMSharedDensityGrid grid =
+    variantList.at(counter).value<QTAIMSharedDensityGrid>();
   counter++;
   qreal x0 = variantList.at(counter).toDouble();
   counter++;
@@ -1248,10 +1243,8 @@ QList<QVariant> QTAIMEvaluateProperty(QList<QVariant> variantList)
   }
   QSet<qint64> basinSet = basinList.toSet();
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
 
-  QTAIMWavefunctionEvaluator eval(wfn);
+  QTAIMWavefunctionEvaluator eval(*wfn);
 
   QList<QVariant> valueList;
 
@@ -1278,6 +1271,7 @@ QList<QVariant> QTAIMEvaluateProperty(QList<QVariant> variantList)
     //  Avogadro::QTAIMODEIntegrator ode(eval,0);
 
     ode.setBetaSpheres(betaSpheres);
+    ode.setDensityGrid(grid.data());
 
     QVector3D endpoint = ode.integrate(QVector3D(x0, y0, z0));
 // QList<QVector3D> path=ode.path();
@@ -1338,7 +1332,14 @@ void property_v(unsigned int /* ndim */, unsigned int npts, const double* xyz,
   QVariantList paramVariantList = *paramVariantListPtr;
 
   qint64 counter = 0;
-  QString wfnFileName = paramVariantList.at(counter).toString();
+  QTAIMSharedWavefunction wfn =
+    paramVariantList.at(counter).value<QTAIMSharedWavefunction>();
+  counter++;
+  QTAIMSharedDensityGrid grid =
+    paramVariantList.at(counter).value<QTAIMSharedDensityGrid>();
+  counter++;
+  QTAIMProgress* progress =
+    paramVariantList.at(counter).value<QTAIMProgress*>();
   counter++;
 
   qint64 nncp = paramVariantList.at(counter).toLongLong();
@@ -1375,7 +1376,8 @@ void property_v(unsigned int /* ndim */, unsigned int npts, const double* xyz,
 
     QList<QVariant> variantList;
 
-    variantList.append(wfnFileName);
+    variantList.append(QVariant::fromValue(wfn));
+    variantList.append(QVariant::fromValue(grid));
 
     variantList.append(x0);
     variantList.append(y0);
@@ -1404,35 +1406,23 @@ void property_v(unsigned int /* ndim */, unsigned int npts, const double* xyz,
 
   // calculate
 
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Atomic Basin Integration"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)),
-                   &dialog, SLOT(setRange(int, int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
-                   SLOT(setValue(int)));
-
   QFuture<QList<QVariant>> future =
     QtConcurrent::mapped(inputList, QTAIMEvaluateProperty);
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
+  QTAIMWaitForStage(future, "Atomic Basin Integration",
+                    inputList.length(), progress);
 
   QList<QList<QVariant>> results;
-  if (futureWatcher.future().isCanceled()) {
+  if (future.isCanceled()) {
     results.clear();
   } else {
     results = future.results();
   }
 
-  // harvest results
+  // harvest results, a canceled stage contributes nothing
   for (qint64 i = 0; i < npts; ++i) {
     for (qint64 m = 0; m < nmode; ++m) {
-      fval[m * nmode + i] = results.at(i).at(m).toDouble();
+      fval[m * nmode + i] =
+        results.isEmpty() ? 0.0 : results.at(i).at(m).toDouble();
     }
   }
 }
@@ -1444,7 +1434,8 @@ QList<QVariant> QTAIMEvaluatePropertyRTP(QList<QVariant> variantList)
 {
   /*
      Order of variantList:
-     QString wfnFileName
+     QTAIMSharedWavefunction wfn
+     QTAIMSharedDensityGrid grid
      qreal r0
      qreal t0
      qreal p0
@@ -1466,7 +1457,11 @@ QList<QVariant> QTAIMEvaluatePropertyRTP(QList<QVariant> variantList)
      ...
   */
   qint64 counter = 0;
-  QString wfnFileName = variantList.at(counter).toString();
+  QTAIMSharedWavefunction wfn =
+    variantList.at(counter).value<QTAIMSharedWavefunction>();
+  counter++;
+  QTAIMSharedDensityGrid grid =
+    variantList.at(counter).value<QTAIMSharedDensityGrid>();
   counter++;
   qreal r0 = variantList.at(counter).toDouble();
   counter++;
@@ -1521,10 +1516,8 @@ QList<QVariant> QTAIMEvaluatePropertyRTP(QList<QVariant> variantList)
   qreal y0 = x0y0z0(1);
   qreal z0 = x0y0z0(2);
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
 
-  QTAIMWavefunctionEvaluator eval(wfn);
+  QTAIMWavefunctionEvaluator eval(*wfn);
 
   QList<QVariant> valueList;
 
@@ -1551,6 +1544,7 @@ QList<QVariant> QTAIMEvaluatePropertyRTP(QList<QVariant> variantList)
     //  Avogadro::QTAIMODEIntegrator ode(eval,0);
 
     ode.setBetaSpheres(betaSpheres);
+    ode.setDensityGrid(grid.data());
 
     QVector3D endpoint = ode.integrate(QVector3D(x0, y0, z0));
 // QList<QVector3D> path=ode.path();
@@ -1618,7 +1612,14 @@ void property_v_rtp(unsigned int /* ndim */, unsigned int npts,
   QVariantList paramVariantList = *paramVariantListPtr;
 
   qint64 counter = 0;
-  QString wfnFileName = paramVariantList.at(counter).toString();
+  QTAIMSharedWavefunction wfn =
+    paramVariantList.at(counter).value<QTAIMSharedWavefunction>();
+  counter++;
+  QTAIMSharedDensityGrid grid =
+    paramVariantList.at(counter).value<QTAIMSharedDensityGrid>();
+  counter++;
+  QTAIMProgress* progress =
+    paramVariantList.at(counter).value<QTAIMProgress*>();
   counter++;
 
   qint64 nncp = paramVariantList.at(counter).toLongLong();
@@ -1655,7 +1656,8 @@ void property_v_rtp(unsigned int /* ndim */, unsigned int npts,
 
     QList<QVariant> variantList;
 
-    variantList.append(wfnFileName);
+    variantList.append(QVariant::fromValue(wfn));
+    variantList.append(QVariant::fromValue(grid));
 
     variantList.append(x0);
     variantList.append(y0);
@@ -1684,35 +1686,23 @@ void property_v_rtp(unsigned int /* ndim */, unsigned int npts,
 
   // calculate
 
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Atomic Basin Integration"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)),
-                   &dialog, SLOT(setRange(int, int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
-                   SLOT(setValue(int)));
-
   QFuture<QList<QVariant>> future =
     QtConcurrent::mapped(inputList, QTAIMEvaluatePropertyRTP);
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
+  QTAIMWaitForStage(future, "Atomic Basin Integration",
+                    inputList.length(), progress);
 
   QList<QList<QVariant>> results;
-  if (futureWatcher.future().isCanceled()) {
+  if (future.isCanceled()) {
     results.clear();
   } else {
     results = future.results();
   }
 
-  // harvest results
+  // harvest results, a canceled stage contributes nothing
   for (qint64 i = 0; i < npts; ++i) {
     for (qint64 m = 0; m < nmode; ++m) {
-      fval[m * nmode + i] = results.at(i).at(m).toDouble();
+      fval[m * nmode + i] =
+        results.isEmpty() ? 0.0 : results.at(i).at(m).toDouble();
     }
   }
 }
@@ -1728,7 +1718,8 @@ void property_r(unsigned int ndim, const double* xyz, void* param,
   QVariantList paramVariantList = *paramVariantListPtr;
 
   qint64 counter = 0;
-  QString wfnFileName = paramVariantList.at(counter).toString();
+  QTAIMSharedWavefunction wfn =
+    paramVariantList.at(counter).value<QTAIMSharedWavefunction>();
   counter++;
 
   qreal r = xyz[0];
@@ -1772,12 +1763,8 @@ void property_r(unsigned int ndim, const double* xyz, void* param,
   qreal y = XYZ(1);
   qreal z = XYZ(2);
 
-  // This routine reads the wavefunction file repeatedly.
-  // Let's hope that this time is dwarfed by the time
-  // taken to delineate the atomic basins in the calling routine.
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-  QTAIMWavefunctionEvaluator eval(wfn);
+  // The evaluator only maps the shared wavefunction, it is cheap to build.
+  QTAIMWavefunctionEvaluator eval(*wfn);
 
   for (qint64 m = 0; m < nmode; ++m) {
     if (mode == 0) {
@@ -1791,7 +1778,8 @@ QList<QVariant> QTAIMEvaluatePropertyTP(QList<QVariant> variantList)
 
   /*
      Order of variantList:
-     QString wfnFileName
+     QTAIMSharedWavefunction wfn
+     QTAIMSharedDensityGrid grid
      qreal t
      qreal p
      qint64 nncp
@@ -1812,7 +1800,11 @@ QList<QVariant> QTAIMEvaluatePropertyTP(QList<QVariant> variantList)
      ...
   */
   qint64 counter = 0;
-  QString wfnFileName = variantList.at(counter).toString();
+  QTAIMSharedWavefunction wfn =
+    variantList.at(counter).value<QTAIMSharedWavefunction>();
+  counter++;
+  QTAIMSharedDensityGrid grid =
+    variantList.at(counter).value<QTAIMSharedDensityGrid>();
   counter++;
   qreal t = variantList.at(counter).toDouble();
   counter++;
@@ -1852,9 +1844,7 @@ QList<QVariant> QTAIMEvaluatePropertyTP(QList<QVariant> variantList)
   }
   QSet<qint64> basinSet = basinList.toSet();
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-  QTAIMWavefunctionEvaluator eval(wfn);
+  QTAIMWavefunctionEvaluator eval(*wfn);
 
   // Set up steepest ascent integrator and beta spheres
   QList<QPair<QVector3D, qreal>> betaSpheres;
@@ -1870,6 +1860,7 @@ QList<QVariant> QTAIMEvaluatePropertyTP(QList<QVariant> variantList)
   //  Avogadro::QTAIMODEIntegrator ode(eval,0);
 
   ode.setBetaSpheres(betaSpheres);
+  ode.setDensityGrid(grid.data());
 
   // Determine radial basin limit via bisection
   // Bisection Algorithm courtesey of Wikipedia
@@ -2058,7 +2049,7 @@ endOfBisection:
   xmax[0] = rf;
 
   QVariantList paramVariantList;
-  paramVariantList.append(wfnFileName);
+  paramVariantList.append(QVariant::fromValue(wfn));
   paramVariantList.append(t);
   paramVariantList.append(p);
   paramVariantList.append(
@@ -2082,13 +2073,13 @@ endOfBisection:
   free(val);
   free(err);
 
-  //  QList<QVariant> variantList;
+  QList<QVariant> valueList;
 
-  variantList.append(sin(t) * Rval);
+  valueList.append(sin(t) * Rval);
 
   //  qDebug() << rf << t << p << sin(t) * Rval;
 
-  return variantList;
+  return valueList;
 }
 
 void property_v_tp(unsigned int /* ndim */, unsigned int npts,
@@ -2100,7 +2091,14 @@ void property_v_tp(unsigned int /* ndim */, unsigned int npts,
   QVariantList paramVariantList = *paramVariantListPtr;
 
   qint64 counter = 0;
-  QString wfnFileName = paramVariantList.at(counter).toString();
+  QTAIMSharedWavefunction wfn =
+    paramVariantList.at(counter).value<QTAIMSharedWavefunction>();
+  counter++;
+  QTAIMSharedDensityGrid grid =
+    paramVariantList.at(counter).value<QTAIMSharedDensityGrid>();
+  counter++;
+  QTAIMProgress* progress =
+    paramVariantList.at(counter).value<QTAIMProgress*>();
   counter++;
 
   qint64 nncp = paramVariantList.at(counter).toLongLong();
@@ -2136,7 +2134,8 @@ void property_v_tp(unsigned int /* ndim */, unsigned int npts,
 
     QList<QVariant> variantList;
 
-    variantList.append(wfnFileName);
+    variantList.append(QVariant::fromValue(wfn));
+    variantList.append(QVariant::fromValue(grid));
 
     variantList.append(t);
     variantList.append(p);
@@ -2164,26 +2163,13 @@ void property_v_tp(unsigned int /* ndim */, unsigned int npts,
 
   // calculate
 
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Atomic Basin Integration"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int, int)),
-                   &dialog, SLOT(setRange(int, int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog,
-                   SLOT(setValue(int)));
-
   QFuture<QList<QVariant>> future =
     QtConcurrent::mapped(inputList, QTAIMEvaluatePropertyTP);
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
+  QTAIMWaitForStage(future, "Atomic Basin Integration",
+                    inputList.length(), progress);
 
   QList<QList<QVariant>> results;
-  if (futureWatcher.future().isCanceled()) {
+  if (future.isCanceled()) {
     results.clear();
   } else {
     results = future.results();
@@ -2193,7 +2179,8 @@ void property_v_tp(unsigned int /* ndim */, unsigned int npts,
   //  qDebug() << "results=" << results;
   for (qint64 i = 0; i < npts; ++i) {
     for (qint64 m = 0; m < nmode; ++m) {
-      fval[m * nmode + i] = results.at(i).at(m).toDouble();
+      fval[m * nmode + i] =
+        results.isEmpty() ? 0.0 : results.at(i).at(m).toDouble();
     }
   }
 }
@@ -2201,22 +2188,10 @@ void property_v_tp(unsigned int /* ndim */, unsigned int npts,
 namespace Avogadro {
 namespace QtPlugins {
 
-QTAIMCubature::QTAIMCubature(QTAIMWavefunction& wfn)
+QTAIMCubature::QTAIMCubature(const QTAIMWavefunction& wfn)
+  : m_wfn(new QTAIMWavefunction(wfn)),
+    m_accuracy(QTAIMDensityGrid::Analytic), m_progress(nullptr)
 {
-
-  m_wfn = &wfn;
-
-  m_temporaryFileName = QTAIMCubature::temporaryFileName();
-  m_wfn->saveToBinaryFile(m_temporaryFileName);
-
-  // Instantiate a Critical Point Locator
-  QTAIMCriticalPointLocator cpl(wfn);
-
-  // Locate the Nuclear Critical Points
-  cpl.locateNuclearCriticalPoints();
-
-  // QLists of results
-  m_ncpList = cpl.nuclearCriticalPoints();
 }
 
 QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
@@ -2228,6 +2203,24 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
   m_mode = mode;
   m_basins = basins;
 
+  if (m_ncpList.isEmpty()) {
+    // Instantiate a Critical Point Locator
+    QTAIMCriticalPointLocator cpl(*m_wfn);
+    cpl.setProgress(m_progress);
+
+    // Locate the Nuclear Critical Points
+    cpl.locateNuclearCriticalPoints();
+
+    // QLists of results
+    m_ncpList = cpl.nuclearCriticalPoints();
+  }
+
+  if (m_accuracy != QTAIMDensityGrid::Analytic && !m_grid)
+    computeDensityGrid();
+
+  if (m_progress && m_progress->isCanceled())
+    return value;
+
   double tol = 1.e-2;
   unsigned int maxEval = 0;
 
@@ -2263,7 +2256,9 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
         xmax[2] = 8. + m_ncpList.at(i).z();
 
         QVariantList paramVariantList;
-        paramVariantList.append(m_temporaryFileName);
+        paramVariantList.append(QVariant::fromValue(m_wfn));
+        paramVariantList.append(QVariant::fromValue(m_grid));
+        paramVariantList.append(QVariant::fromValue(m_progress));
 
         paramVariantList.append(
           m_ncpList.length()); // number of nuclear critical points
@@ -2289,7 +2284,9 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
         xmax[2] = 2.0 * pi;
 
         QVariantList paramVariantList;
-        paramVariantList.append(m_temporaryFileName);
+        paramVariantList.append(QVariant::fromValue(m_wfn));
+        paramVariantList.append(QVariant::fromValue(m_grid));
+        paramVariantList.append(QVariant::fromValue(m_progress));
 
         paramVariantList.append(
           m_ncpList.length()); // number of nuclear critical points
@@ -2324,7 +2321,9 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
       xmax[1] = 2.0 * pi;
 
       QVariantList paramVariantList;
-      paramVariantList.append(m_temporaryFileName);
+      paramVariantList.append(QVariant::fromValue(m_wfn));
+      paramVariantList.append(QVariant::fromValue(m_grid));
+      paramVariantList.append(QVariant::fromValue(m_progress));
 
       paramVariantList.append(
         m_ncpList.length()); // number of nuclear critical points
@@ -2351,6 +2350,12 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
     thisPair.second = err[0];
 
     value.append(thisPair);
+
+    // The results of a canceled integration are incomplete.
+    if (m_progress && m_progress->isCanceled()) {
+      value.clear();
+      break;
+    }
   }
 
   free(val);
@@ -2361,9 +2366,6 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
 
 QTAIMCubature::~QTAIMCubature()
 {
-  if (QFile::exists(m_temporaryFileName)) {
-    QFile::remove(m_temporaryFileName);
-  }
 }
 
 void QTAIMCubature::setMode(qint64 mode)
@@ -2371,21 +2373,23 @@ void QTAIMCubature::setMode(qint64 mode)
   m_mode = mode;
 }
 
-QString QTAIMCubature::temporaryFileName()
+void QTAIMCubature::setAccuracy(QTAIMDensityGrid::Accuracy accuracy)
 {
-  QTemporaryFile temporaryFile;
-  temporaryFile.open();
-  QString tempFileName = temporaryFile.fileName();
-  temporaryFile.close();
-  temporaryFile.remove();
-
-  // wait for temporary file to be deleted
-  QDir dir;
-  do {
-    // Nothing
-  } while (dir.exists(tempFileName));
-
-  return tempFileName;
+  if (accuracy != m_accuracy)
+    m_grid.clear();
+  m_accuracy = accuracy;
+}
+
+void QTAIMCubature::computeDensityGrid()
+{
+  QSharedPointer<QTAIMDensityGrid> grid(
+    new QTAIMDensityGrid(*m_wfn, m_accuracy));
+
+  QFuture<void> future = grid->compute();
+  if (QTAIMWaitForStage(future, "Electron Density Grid",
+                        static_cast<int>(grid->dimensions()(2)), m_progress)) {
+    m_grid = grid;
+  }
 }
 
 } // end namespace QtPlugins
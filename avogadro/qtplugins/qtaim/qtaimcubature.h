@@ -101,9 +101,11 @@ int adapt_integrate_v(unsigned int fdim, integrand_v f, void* fdata,
 //#endif /* __cplusplus */
 
 #include "qtaimcriticalpointlocator.h"
+#include "qtaimdensitygrid.h"
 #include "qtaimlsodaintegrator.h"
 #include "qtaimmathutilities.h"
 #include "qtaimodeintegrator.h"
+#include "qtaimprogress.h"
 #include "qtaimwavefunction.h"
 #include "qtaimwavefunctionevaluator.h"
 
@@ -119,21 +121,31 @@ public:
     ElectronDensityLaplacian = 1
   };
 
-  explicit QTAIMCubature(QTAIMWavefunction& wfn);
+  explicit QTAIMCubature(const QTAIMWavefunction& wfn);
   ~QTAIMCubature();
 
   QList<QPair<qreal, qreal>> integrate(qint64 mode, QList<qint64> basins);
 
   void setMode(qint64 mode);
 
+  // With an accuracy other than Analytic, the gradient paths are traced on a
+  // density grid of that accuracy, computed by the first integration.
+  void setAccuracy(QTAIMDensityGrid::Accuracy accuracy);
+
+  // The progress of the integration is reported to progress, which can cancel
+  // it. It is not owned, and may be null.
+  void setProgress(QTAIMProgress* progress) { m_progress = progress; }
+
 private:
-  QTAIMWavefunction* m_wfn;
+  void computeDensityGrid();
+
+  QTAIMSharedWavefunction m_wfn;
+  QTAIMDensityGrid::Accuracy m_accuracy;
+  QTAIMSharedDensityGrid m_grid;
+  QTAIMProgress* m_progress;
   qint64 m_mode;
   QList<qint64> m_basins;
 
-  QString m_temporaryFileName;
-  QString temporaryFileName();
-
   QList<QVector3D> m_ncpList;
 };
 
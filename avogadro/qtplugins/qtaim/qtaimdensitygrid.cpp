@@ -0,0 +1,204 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "qtaimdensitygrid.h"
+
+#include "qtaimwavefunctionevaluator.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <cmath>
+
+namespace Avogadro {
+namespace QtPlugins {
+
+namespace {
+// The margin around the nuclei, in bohr.
+const qreal padding = 3.0;
+// The largest number of points, the spacing grows for larger molecules. At
+// four floats per point a grid takes at most 128 MB, and avoqtaim holds one
+// per concurrent job.
+const qreal maximumPoints = 8.e6;
+// The gradient is evaluated analytically within this many grid spacings of
+// a nucleus, where the cusp spoils the interpolation.
+const qreal refinementSpacings = 4.0;
+// The gradient is evaluated analytically where its norm is below this, that
+// is close to the bond, ring and cage critical points.
+const qreal smallGradientNorm = 1.e-3;
+
+// The Catmull-Rom weights of the four points around t in [0, 1).
+void cubicWeights(qreal t, qreal weights[4])
+{
+  const qreal t2 = t * t;
+  const qreal t3 = t2 * t;
+  weights[0] = 0.5 * (-t3 + 2.0 * t2 - t);
+  weights[1] = 0.5 * (3.0 * t3 - 5.0 * t2 + 2.0);
+  weights[2] = 0.5 * (-3.0 * t3 + 4.0 * t2 + t);
+  weights[3] = 0.5 * (t3 - t2);
+}
+}
+
+qreal QTAIMDensityGrid::spacing(Accuracy accuracy)
+{
+  switch (accuracy) {
+    case Coarse:
+      return 0.25;
+    case Medium:
+      return 0.15;
+    case Fine:
+      return 0.10;
+    default:
+      return 0.0;
+  }
+}
+
+QTAIMDensityGrid::QTAIMDensityGrid(const QTAIMWavefunction& wfn,
+                                   Accuracy accuracy)
+  : m_wfn(wfn), m_accuracy(accuracy), m_spacing(spacing(accuracy))
+{
+  Matrix<qreal, 3, 1> minimum;
+  Matrix<qreal, 3, 1> maximum;
+  minimum.setConstant(0.0);
+  maximum.setConstant(0.0);
+  for (qint64 i = 0; i < m_wfn.numberOfNuclei(); ++i) {
+    Matrix<qreal, 3, 1> nucleus(m_wfn.xNuclearCoordinate(i),
+                                m_wfn.yNuclearCoordinate(i),
+                                m_wfn.zNuclearCoordinate(i));
+    if (i == 0) {
+      minimum = nucleus;
+      maximum = nucleus;
+    } else {
+      minimum = minimum.cwiseMin(nucleus);
+      maximum = maximum.cwiseMax(nucleus);
+    }
+  }
+  m_origin = (minimum.array() - padding).matrix();
+  const Matrix<qreal, 3, 1> extent = maximum - minimum;
+  const qreal volume = (extent.array() + 2.0 * padding).prod();
+  m_spacing = qMax(m_spacing, std::cbrt(volume / maximumPoints));
+  m_refinementRadiusSquared =
+    (refinementSpacings * m_spacing) * (refinementSpacings * m_spacing);
+
+  for (qint64 d = 0; d < 3; ++d) {
+    m_dimensions(d) = static_cast<qint64>(
+                        std::ceil((extent(d) + 2.0 * padding) / m_spacing)) +
+                      1;
+  }
+  m_values.resize(4 * m_dimensions.prod());
+  for (qint64 k = 0; k < m_dimensions(2); ++k)
+    m_slabs.append(k);
+}
+
+QFuture<void> QTAIMDensityGrid::compute()
+{
+  return QtConcurrent::map(m_slabs, SlabEvaluator(this));
+}
+
+void QTAIMDensityGrid::computeSlab(qint64 k)
+{
+  // Each slab has its own evaluator, they keep scratch space.
+  QTAIMWavefunctionEvaluator eval(m_wfn);
+
+  const qint64 nx = m_dimensions(0);
+  const qint64 ny = m_dimensions(1);
+  Matrix<qreal, 3, Dynamic> xyz(3, nx);
+  for (qint64 i = 0; i < nx; ++i)
+    xyz(0, i) = m_origin(0) + i * m_spacing;
+  xyz.row(2).setConstant(m_origin(2) + k * m_spacing);
+
+  float* values = m_values.data() + 4 * k * nx * ny;
+  for (qint64 j = 0; j < ny; ++j) {
+    xyz.row(1).setConstant(m_origin(1) + j * m_spacing);
+    const Matrix<qreal, Dynamic, 1> rho = eval.electronDensities(xyz);
+    const Matrix<qreal, 3, Dynamic> gradient =
+      eval.gradientsOfElectronDensity(xyz);
+    for (qint64 i = 0; i < nx; ++i) {
+      values[0] = static_cast<float>(rho(i));
+      values[1] = static_cast<float>(gradient(0, i));
+      values[2] = static_cast<float>(gradient(1, i));
+      values[3] = static_cast<float>(gradient(2, i));
+      values += 4;
+    }
+  }
+}
+
+bool QTAIMDensityGrid::electronDensity(const Matrix<qreal, 3, 1>& xyz,
+                                       qreal& density) const
+{
+  Matrix<qreal, 4, 1> values;
+  if (!interpolate(xyz, values))
+    return false;
+
+  density = values(0);
+  return true;
+}
+
+bool QTAIMDensityGrid::gradientOfElectronDensity(
+  const Matrix<qreal, 3, 1>& xyz, Matrix<qreal, 3, 1>& gradient) const
+{
+  Matrix<qreal, 4, 1> values;
+  if (!interpolate(xyz, values) ||
+      values.tail<3>().norm() < smallGradientNorm) {
+    return false;
+  }
+
+  gradient = values.tail<3>();
+  return true;
+}
+
+bool QTAIMDensityGrid::interpolate(const Matrix<qreal, 3, 1>& xyz,
+                                   Matrix<qreal, 4, 1>& values) const
+{
+  // The 4x4x4 stencil around the cell of xyz must be inside of the grid.
+  qint64 first[3];
+  qreal weights[3][4];
+  for (qint64 d = 0; d < 3; ++d) {
+    const qreal u = (xyz(d) - m_origin(d)) / m_spacing;
+    const qreal cell = std::floor(u);
+    if (!(cell >= 1.0 && cell <= m_dimensions(d) - 3))
+      return false;
+    first[d] = static_cast<qint64>(cell) - 1;
+    cubicWeights(u - cell, weights[d]);
+  }
+
+  for (qint64 i = 0; i < m_wfn.numberOfNuclei(); ++i) {
+    Matrix<qreal, 3, 1> nucleus(m_wfn.xNuclearCoordinate(i),
+                                m_wfn.yNuclearCoordinate(i),
+                                m_wfn.zNuclearCoordinate(i));
+    if ((xyz - nucleus).squaredNorm() < m_refinementRadiusSquared)
+      return false;
+  }
+
+  const qint64 nx = m_dimensions(0);
+  const qint64 ny = m_dimensions(1);
+  values.setZero();
+  for (qint64 c = 0; c < 4; ++c) {
+    for (qint64 b = 0; b < 4; ++b) {
+      const qreal weight = weights[2][c] * weights[1][b];
+      const float* row =
+        m_values.constData() +
+        4 * (((first[2] + c) * ny + first[1] + b) * nx + first[0]);
+      for (qint64 a = 0; a < 4; ++a) {
+        values += (weight * weights[0][a]) *
+                  Map<const Matrix<float, 4, 1>>(row + 4 * a).cast<qreal>();
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace QtPlugins
+} // namespace Avogadro
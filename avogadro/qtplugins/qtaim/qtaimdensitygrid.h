@@ -0,0 +1,133 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef QTAIMDENSITYGRID_H
+#define QTAIMDENSITYGRID_H
+
+#include <QFuture>
+#include <QList>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <Eigen/Core>
+
+#include "qtaimwavefunction.h"
+
+using namespace Eigen;
+
+namespace Avogadro {
+namespace QtPlugins {
+
+/**
+ * @brief The QTAIMDensityGrid class tabulates the electron density and its
+ * gradient on a regular grid around the nuclei, and interpolates them
+ * tricubically.
+ *
+ * The gradient paths of the basin integration take thousands of steps each,
+ * and the interpolated gradient is much cheaper than the analytic one. Close
+ * to the nuclei, where the density has a cusp, and where the gradient is
+ * small, that is close to the other critical points, the interpolation
+ * declines and the caller falls back to the analytic evaluation.
+ *
+ * The grid is evaluated in parallel with compute(), and is immutable
+ * afterwards: it is shared between the workers as a QTAIMSharedDensityGrid.
+ */
+class QTAIMDensityGrid
+{
+public:
+  enum Accuracy
+  {
+    Analytic = 0,
+    Coarse = 1,
+    Medium = 2,
+    Fine = 3
+  };
+
+  /**
+   * @return The grid spacing in bohr for @p accuracy, 0 for Analytic.
+   */
+  static qreal spacing(Accuracy accuracy);
+
+  /**
+   * Set up a grid of the given accuracy, which must not be Analytic. The grid
+   * is allocated, but not evaluated until compute() is called.
+   */
+  QTAIMDensityGrid(const QTAIMWavefunction& wfn, Accuracy accuracy);
+
+  /**
+   * Evaluate the grid in parallel, one slab of constant z per task.
+   * @return The future of the evaluation, which can be watched and canceled.
+   * A canceled grid must not be used.
+   */
+  QFuture<void> compute();
+
+  Accuracy accuracy() const { return m_accuracy; }
+  qreal spacing() const { return m_spacing; }
+  const Matrix<qreal, 3, 1>& origin() const { return m_origin; }
+  const Matrix<qint64, 3, 1>& dimensions() const { return m_dimensions; }
+
+  /**
+   * Interpolate the electron density at @p xyz.
+   * @return false if @p xyz is outside of the grid or close to a nucleus,
+   * @p density is unchanged then.
+   */
+  bool electronDensity(const Matrix<qreal, 3, 1>& xyz, qreal& density) const;
+
+  /**
+   * Interpolate the gradient of the electron density at @p xyz, with the
+   * convention of QTAIMWavefunctionEvaluator::gradientOfElectronDensity.
+   * @return false if @p xyz is outside of the grid, close to a nucleus or
+   * where the gradient is too small to be interpolated reliably, @p gradient
+   * is unchanged then.
+   */
+  bool gradientOfElectronDensity(const Matrix<qreal, 3, 1>& xyz,
+                                 Matrix<qreal, 3, 1>& gradient) const;
+
+private:
+  // Evaluates the slabs for QtConcurrent::map.
+  struct SlabEvaluator
+  {
+    explicit SlabEvaluator(QTAIMDensityGrid* grid) : m_grid(grid) {}
+    void operator()(qint64 k) const { m_grid->computeSlab(k); }
+    QTAIMDensityGrid* m_grid;
+  };
+
+  void computeSlab(qint64 k);
+  bool interpolate(const Matrix<qreal, 3, 1>& xyz,
+                   Matrix<qreal, 4, 1>& values) const;
+
+  const QTAIMWavefunction m_wfn;
+  Accuracy m_accuracy;
+  qreal m_spacing;
+  qreal m_refinementRadiusSquared;
+  Matrix<qreal, 3, 1> m_origin;
+  Matrix<qint64, 3, 1> m_dimensions;
+
+  // The density and the three components of the gradient of each point,
+  // x running fastest. Single precision is ample for the interpolation and
+  // halves the memory, the sums are still accumulated in qreal.
+  QVector<float> m_values;
+  QList<qint64> m_slabs;
+};
+
+typedef QSharedPointer<const QTAIMDensityGrid> QTAIMSharedDensityGrid;
+
+} // namespace QtPlugins
+} // namespace Avogadro
+
+Q_DECLARE_METATYPE(Avogadro::QtPlugins::QTAIMSharedDensityGrid)
+
+#endif // QTAIMDENSITYGRID_H
@@ -20,12 +20,16 @@
 #include <avogadro/qtgui/molecule.h>
 
 #include <QAction>
+#include <QCoreApplication>
 
 #include <QDebug>
 #include <QDir>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QList>
 #include <QPair>
+#include <QProgressDialog>
+#include <QSettings>
 #include <QString>
 #include <QVector3D>
 
@@ -51,6 +55,40 @@ enum QTAIMExtensionIndex
   ThirdAction
 };
 
+namespace {
+// Shows the progress of the QTAIM stages in a modal progress dialog.
+class QTAIMProgressDialog : public QTAIMProgress
+{
+public:
+  QTAIMProgressDialog()
+  {
+    m_dialog.setWindowTitle("QTAIM");
+    m_dialog.setWindowModality(Qt::ApplicationModal);
+    m_dialog.setMinimumDuration(0);
+  }
+
+  void begin(const QString& stage, int steps) override
+  {
+    if (m_dialog.wasCanceled())
+      return;
+    m_dialog.setLabelText(stage);
+    m_dialog.setRange(0, steps);
+    m_dialog.setValue(0);
+  }
+
+  void update(int done) override
+  {
+    m_dialog.setValue(done);
+    QCoreApplication::processEvents();
+  }
+
+  bool isCanceled() const override { return m_dialog.wasCanceled(); }
+
+private:
+  QProgressDialog m_dialog;
+};
+}
+
 QTAIMExtension::QTAIMExtension(QObject* aParent)
   : QtGui::ExtensionPlugin(aParent)
 {
@@ -146,6 +184,26 @@ void QTAIMExtension::triggered()
     return;
   }
 
+  // The gradient paths of the basin integration can be traced on a density
+  // grid, the last choice is remembered.
+  QTAIMDensityGrid::Accuracy accuracy = QTAIMDensityGrid::Analytic;
+  if (i == ThirdAction) {
+    QStringList items;
+    items << tr("Analytic (slowest)") << tr("Coarse grid") << tr("Medium grid")
+          << tr("Fine grid");
+    QSettings settings;
+    int current = settings.value("qtaim/integrationAccuracy", 0).toInt();
+    bool ok = false;
+    QString item = QInputDialog::getItem(
+      qobject_cast<QWidget*>(parent()), tr("Atomic Charge"),
+      tr("Gradient paths:"), items, qBound(0, current, items.size() - 1),
+      false, &ok);
+    if (!ok)
+      return;
+    accuracy = static_cast<QTAIMDensityGrid::Accuracy>(items.indexOf(item));
+    settings.setValue("qtaim/integrationAccuracy", static_cast<int>(accuracy));
+  }
+
   QtGui::Molecule::MoleculeChanges changes;
   if (m_molecule->atomCount() > 0)
     changes |= QtGui::Molecule::Atoms | QtGui::Molecule::Removed;
@@ -158,11 +216,15 @@ void QTAIMExtension::triggered()
   // Instantiate an Evaluator
   QTAIMWavefunctionEvaluator eval(wfn);
 
+  // The stages below report to a progress dialog, and stop if it is canceled.
+  QTAIMProgressDialog progress;
+
   switch (i) {
     case FirstAction: // Molecular Graph
     {
       // Instantiate a Critical Point Locator
       QTAIMCriticalPointLocator cpl(wfn);
+      cpl.setProgress(&progress);
 
       // Locate the Nuclear Critical Points
       cpl.locateNuclearCriticalPoints();
@@ -339,6 +401,7 @@ void QTAIMExtension::triggered()
     {
       // Instantiate a Critical Point Locator
       QTAIMCriticalPointLocator cpl(wfn);
+      cpl.setProgress(&progress);
 
       // Locate the Nuclear Critical Points
       cpl.locateNuclearCriticalPoints();
@@ -549,6 +612,7 @@ void QTAIMExtension::triggered()
       {
         // Instantiate a Critical Point Locator
         QTAIMCriticalPointLocator cpl(wfn);
+        cpl.setProgress(&progress);
 
         // Locate the Nuclear Critical Points
         cpl.locateNuclearCriticalPoints();
@@ -735,6 +799,8 @@ void QTAIMExtension::triggered()
         }
 
         QTAIMCubature cub(wfn);
+        cub.setAccuracy(accuracy);
+        cub.setProgress(&progress);
 
         //        QTime time;
         //        time.start();
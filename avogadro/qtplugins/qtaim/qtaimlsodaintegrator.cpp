@@ -46,6 +46,7 @@ QTAIMLSODAIntegrator::QTAIMLSODAIntegrator(QTAIMWavefunctionEvaluator& eval,
                                            const qint64 mode)
 {
   m_eval = &eval;
+  m_grid = nullptr;
   m_mode = mode;
 
   m_betaSpheres.empty();
@@ -179,7 +180,8 @@ void QTAIMLSODAIntegrator::f(int neq, double t, double* y, double* ydot)
   xyz << y[1], y[2], y[3];
 
   if (m_mode == SteepestAscentPathInElectronDensity) {
-    g = m_eval->gradientOfElectronDensity(xyz);
+    if (!m_grid || !m_grid->gradientOfElectronDensity(xyz, g))
+      g = m_eval->gradientOfElectronDensity(xyz);
   } else {
     if (m_mode == 1 || m_mode == 2 || m_mode == 3 || m_mode == 4) {
       gH = m_eval->gradientAndHessianOfElectronDensity(xyz);
@@ -24,6 +24,7 @@
 
 #include <Eigen/Core>
 
+#include "qtaimdensitygrid.h"
 #include "qtaimmathutilities.h"
 #include "qtaimwavefunction.h"
 #include "qtaimwavefunctionevaluator.h"
@@ -65,8 +66,13 @@ public:
   }
   qint64 associatedSphere() const { return m_associatedSphere; }
 
+  // Interpolate the steepest ascent paths from the grid where it can, the
+  // grid must outlive the integrator.
+  void setDensityGrid(const QTAIMDensityGrid* grid) { m_grid = grid; }
+
 private:
   QTAIMWavefunctionEvaluator* m_eval;
+  const QTAIMDensityGrid* m_grid;
   qint64 m_mode;
 
   qint64 m_status;
@@ -27,6 +27,7 @@ QTAIMODEIntegrator::QTAIMODEIntegrator(QTAIMWavefunctionEvaluator& eval,
                                        const qint64 mode)
 {
   m_eval = &eval;
+  m_grid = nullptr;
   m_mode = mode;
 
   m_betaSpheres.empty();
@@ -205,7 +206,8 @@ void QTAIMODEIntegrator::r8_f(qreal t, qreal y[], qreal yp[])
   xyz << y[0], y[1], y[2];
 
   if (m_mode == SteepestAscentPathInElectronDensity) {
-    g = m_eval->gradientOfElectronDensity(xyz);
+    if (!m_grid || !m_grid->gradientOfElectronDensity(xyz, g))
+      g = m_eval->gradientOfElectronDensity(xyz);
   } else {
     if (m_mode == 1 || m_mode == 2 || m_mode == 3 || m_mode == 4) {
       gH = m_eval->gradientAndHessianOfElectronDensity(xyz);
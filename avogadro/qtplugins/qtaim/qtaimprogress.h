@@ -0,0 +1,89 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef QTAIMPROGRESS_H
+#define QTAIMPROGRESS_H
+
+#include <QFuture>
+#include <QMetaType>
+#include <QString>
+#include <QThread>
+
+namespace Avogadro {
+namespace QtPlugins {
+
+/**
+ * @brief The QTAIMProgress class is notified of the progress of the QTAIM
+ * analysis, and can cancel it.
+ *
+ * The analysis runs in stages, each made of independent steps computed in
+ * parallel. The functions are called from the thread that started the
+ * analysis, while it waits for the steps.
+ */
+class QTAIMProgress
+{
+public:
+  virtual ~QTAIMProgress() {}
+
+  /**
+   * A stage named @p stage, of @p steps steps, starts.
+   */
+  virtual void begin(const QString& stage, int steps) = 0;
+
+  /**
+   * @p done steps of the current stage are complete.
+   */
+  virtual void update(int done) = 0;
+
+  /**
+   * @return true to cancel the analysis. The current stage stops, and the
+   * results of the analysis are incomplete.
+   */
+  virtual bool isCanceled() const = 0;
+};
+
+/**
+ * Wait for the @p steps steps of a stage computed by @p future, reporting to
+ * @p progress if it is not null.
+ * @return false if the stage was canceled.
+ */
+template <typename T>
+bool QTAIMWaitForStage(QFuture<T>& future, const QString& stage, int steps,
+                       QTAIMProgress* progress)
+{
+  if (progress) {
+    progress->begin(stage, steps);
+    while (!future.isFinished()) {
+      if (progress->isCanceled()) {
+        future.cancel();
+        break;
+      }
+      progress->update(future.progressValue());
+      QThread::msleep(50);
+    }
+  }
+  future.waitForFinished();
+  if (progress && !future.isCanceled())
+    progress->update(steps);
+  return !future.isCanceled();
+}
+
+} // namespace QtPlugins
+} // namespace Avogadro
+
+Q_DECLARE_METATYPE(Avogadro::QtPlugins::QTAIMProgress*)
+
+#endif // QTAIMPROGRESS_H
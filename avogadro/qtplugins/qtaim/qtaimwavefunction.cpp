@@ -28,6 +28,8 @@ namespace QtPlugins {
 QTAIMWavefunction::QTAIMWavefunction()
 {
   m_initializationSuccessful = false;
+  m_numberOfOccupiedMolecularOrbitals = 0;
+  m_numberOfGaussianPrimitiveCenters = 0;
 }
 
 bool QTAIMWavefunction::initializeWithWFNFile(const QString& fileName)
@@ -343,6 +345,8 @@ bool QTAIMWavefunction::initializeWithWFNFile(const QString& fileName)
        i < (m_numberOfMolecularOrbitals * m_numberOfGaussianPrimitives); ++i)
     m_molecularOrbitalCoefficients[i] = moCoefficientsList.at(i);
 
+  prepareEvaluation();
+
   m_initializationSuccessful = true;
 
   return m_initializationSuccessful;
@@ -506,10 +510,81 @@ bool QTAIMWavefunction::initializeWithMoleculeProperties(QtGui::Molecule*& mol)
 
     m_totalEnergy = totalEnergyVariant.toReal();
     m_virialRatio = virialRatioVariant.toReal();
+
+    prepareEvaluation();
   }
 
   return true;
 }
 
+void QTAIMWavefunction::prepareEvaluation()
+{
+  const qint64 nmo = m_numberOfMolecularOrbitals;
+  const qint64 nprim = m_numberOfGaussianPrimitives;
+
+  // Orbitals without electrons do not contribute to the density, keep the
+  // others with the coefficients of each primitive next to each other.
+  QList<qint64> occupied;
+  for (qint64 m = 0; m < nmo; ++m) {
+    if (m_molecularOrbitalOccupationNumbers.at(m) != 0.0)
+      occupied.append(m);
+  }
+  const qint64 noccmo = occupied.length();
+  m_numberOfOccupiedMolecularOrbitals = noccmo;
+  m_occupiedMolecularOrbitalOccupationNumbers.resize(noccmo);
+  m_occupiedMolecularOrbitalCoefficients.resize(noccmo * nprim);
+  for (qint64 k = 0; k < noccmo; ++k) {
+    const qint64 m = occupied.at(k);
+    m_occupiedMolecularOrbitalOccupationNumbers[k] =
+      m_molecularOrbitalOccupationNumbers.at(m);
+    for (qint64 p = 0; p < nprim; ++p) {
+      m_occupiedMolecularOrbitalCoefficients[p * noccmo + k] =
+        m_molecularOrbitalCoefficients.at(m * nprim + p);
+    }
+  }
+
+  // Group the primitives by center, with the smallest exponent of each
+  // center so that distant centers can be skipped as a whole.
+  QList<qint64> centerOfPrimitive;
+  QVector<qreal> centers;
+  QVector<qreal> minimumExponents;
+  for (qint64 p = 0; p < nprim; ++p) {
+    const qreal x = m_xGaussianPrimitiveCenterCoordinates.at(p);
+    const qreal y = m_yGaussianPrimitiveCenterCoordinates.at(p);
+    const qreal z = m_zGaussianPrimitiveCenterCoordinates.at(p);
+    const qreal exponent = m_gaussianPrimitiveExponentCoefficients.at(p);
+    qint64 c = 0;
+    const qint64 ncenter = minimumExponents.size();
+    while (c < ncenter && (centers.at(3 * c) != x ||
+                           centers.at(3 * c + 1) != y ||
+                           centers.at(3 * c + 2) != z)) {
+      ++c;
+    }
+    if (c == ncenter) {
+      centers << x << y << z;
+      minimumExponents.append(exponent);
+    } else if (exponent < minimumExponents.at(c)) {
+      minimumExponents[c] = exponent;
+    }
+    centerOfPrimitive.append(c);
+  }
+
+  const qint64 ncenter = minimumExponents.size();
+  m_numberOfGaussianPrimitiveCenters = ncenter;
+  m_gaussianPrimitiveCenterCoordinates = centers;
+  m_gaussianPrimitiveCenterMinimumExponents = minimumExponents;
+  m_gaussianPrimitiveCenterOffsets.fill(0, ncenter + 1);
+  for (qint64 p = 0; p < nprim; ++p)
+    ++m_gaussianPrimitiveCenterOffsets[centerOfPrimitive.at(p) + 1];
+  for (qint64 c = 0; c < ncenter; ++c) {
+    m_gaussianPrimitiveCenterOffsets[c + 1] +=
+      m_gaussianPrimitiveCenterOffsets.at(c);
+  }
+  m_gaussianPrimitivesByCenter.resize(nprim);
+  QVector<qint64> next = m_gaussianPrimitiveCenterOffsets;
+  for (qint64 p = 0; p < nprim; ++p)
+    m_gaussianPrimitivesByCenter[next[centerOfPrimitive.at(p)]++] = p;
+}
+
 } // end namespace QtPlugins
 } // end namespace Avogadro
@@ -19,10 +19,10 @@
 
 #include <QList>
 #include <QObject>
+#include <QSharedPointer>
 #include <QString>
 #include <QVector>
 
-#include <QDataStream>
 #include <QFile>
 #include <QIODevice>
 
@@ -42,62 +42,6 @@ class QTAIMWavefunction
 public:
   explicit QTAIMWavefunction();
 
-  void saveToBinaryFile(const QString& fileName)
-  {
-    QFile file(fileName);
-    file.open(QIODevice::WriteOnly);
-    QDataStream out(&file);
-    out << m_fileName;
-    out << m_comment;
-    out << m_numberOfMolecularOrbitals;
-    out << m_numberOfGaussianPrimitives;
-    out << m_numberOfNuclei;
-    out << m_xNuclearCoordinates;
-    out << m_yNuclearCoordinates;
-    out << m_zNuclearCoordinates;
-    out << m_nuclearCharges;
-    out << m_xGaussianPrimitiveCenterCoordinates;
-    out << m_yGaussianPrimitiveCenterCoordinates;
-    out << m_zGaussianPrimitiveCenterCoordinates;
-    out << m_xGaussianPrimitiveAngularMomenta;
-    out << m_yGaussianPrimitiveAngularMomenta;
-    out << m_zGaussianPrimitiveAngularMomenta;
-    out << m_gaussianPrimitiveExponentCoefficients;
-    out << m_molecularOrbitalOccupationNumbers;
-    out << m_molecularOrbitalEigenvalues;
-    out << m_molecularOrbitalCoefficients;
-    out << m_totalEnergy;
-    out << m_virialRatio;
-  }
-
-  void loadFromBinaryFile(const QString& fileName)
-  {
-    QFile file(fileName);
-    file.open(QIODevice::ReadOnly);
-    QDataStream in(&file);
-    in >> m_fileName;
-    in >> m_comment;
-    in >> m_numberOfMolecularOrbitals;
-    in >> m_numberOfGaussianPrimitives;
-    in >> m_numberOfNuclei;
-    in >> m_xNuclearCoordinates;
-    in >> m_yNuclearCoordinates;
-    in >> m_zNuclearCoordinates;
-    in >> m_nuclearCharges;
-    in >> m_xGaussianPrimitiveCenterCoordinates;
-    in >> m_yGaussianPrimitiveCenterCoordinates;
-    in >> m_zGaussianPrimitiveCenterCoordinates;
-    in >> m_xGaussianPrimitiveAngularMomenta;
-    in >> m_yGaussianPrimitiveAngularMomenta;
-    in >> m_zGaussianPrimitiveAngularMomenta;
-    in >> m_gaussianPrimitiveExponentCoefficients;
-    in >> m_molecularOrbitalOccupationNumbers;
-    in >> m_molecularOrbitalEigenvalues;
-    in >> m_molecularOrbitalCoefficients;
-    in >> m_totalEnergy;
-    in >> m_virialRatio;
-  }
-
   bool initializeWithWFNFile(const QString& fileName);
   //    bool initializeWithMoleculeProperties( Molecule &mol );
   bool initializeWithMoleculeProperties(QtGui::Molecule*& mol);
@@ -239,7 +183,50 @@ public:
   qreal totalEnergy() const { return m_totalEnergy; }
   qreal virialRatio() const { return m_virialRatio; }
 
+  // The layout used by the evaluator, set up by the initialization. Only the
+  // occupied molecular orbitals are kept, and their coefficients are stored
+  // by primitive: those of primitive p start at p * (number of occupied
+  // orbitals).
+  qint64 numberOfOccupiedMolecularOrbitals() const
+  {
+    return m_numberOfOccupiedMolecularOrbitals;
+  }
+  const qreal* occupiedMolecularOrbitalOccupationNumbers() const
+  {
+    return m_occupiedMolecularOrbitalOccupationNumbers.constData();
+  }
+  const qreal* occupiedMolecularOrbitalCoefficients() const
+  {
+    return m_occupiedMolecularOrbitalCoefficients.constData();
+  }
+
+  // The distinct centers of the primitives (x, y and z of each center in
+  // turn), the smallest exponent on each, and the primitives of center c at
+  // [offsets[c], offsets[c + 1]) of gaussianPrimitivesByCenter().
+  qint64 numberOfGaussianPrimitiveCenters() const
+  {
+    return m_numberOfGaussianPrimitiveCenters;
+  }
+  const qreal* gaussianPrimitiveCenterCoordinates() const
+  {
+    return m_gaussianPrimitiveCenterCoordinates.constData();
+  }
+  const qreal* gaussianPrimitiveCenterMinimumExponents() const
+  {
+    return m_gaussianPrimitiveCenterMinimumExponents.constData();
+  }
+  const qint64* gaussianPrimitiveCenterOffsets() const
+  {
+    return m_gaussianPrimitiveCenterOffsets.constData();
+  }
+  const qint64* gaussianPrimitivesByCenter() const
+  {
+    return m_gaussianPrimitivesByCenter.constData();
+  }
+
 private:
+  void prepareEvaluation();
+
   bool m_initializationSuccessful;
   bool m_fileDoesNotExist;
   bool m_ioError;
@@ -275,9 +262,25 @@ private:
 
   qreal m_totalEnergy;
   qreal m_virialRatio;
+
+  qint64 m_numberOfOccupiedMolecularOrbitals;
+  QVector<qreal> m_occupiedMolecularOrbitalOccupationNumbers;
+  QVector<qreal> m_occupiedMolecularOrbitalCoefficients;
+
+  qint64 m_numberOfGaussianPrimitiveCenters;
+  QVector<qreal> m_gaussianPrimitiveCenterCoordinates;
+  QVector<qreal> m_gaussianPrimitiveCenterMinimumExponents;
+  QVector<qint64> m_gaussianPrimitiveCenterOffsets;
+  QVector<qint64> m_gaussianPrimitivesByCenter;
 };
 
+// The wavefunction shared, read only, by the worker threads. Its arrays are
+// implicitly shared, so copying it to make one is cheap.
+typedef QSharedPointer<const QTAIMWavefunction> QTAIMSharedWavefunction;
+
 } // namespace QtPlugins
 } // namespace Avogadro
 
+Q_DECLARE_METATYPE(Avogadro::QtPlugins::QTAIMSharedWavefunction)
+
 #endif // QTAIMWAVEFUNCTION_H
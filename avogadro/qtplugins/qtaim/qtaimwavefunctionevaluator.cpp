@@ -21,81 +21,121 @@
 namespace Avogadro {
 namespace QtPlugins {
 
-QTAIMWavefunctionEvaluator::QTAIMWavefunctionEvaluator(QTAIMWavefunction& wfn)
+QTAIMWavefunctionEvaluator::QTAIMWavefunctionEvaluator(
+  const QTAIMWavefunction& wfn)
+  : m_wfn(wfn), m_nmo(m_wfn.numberOfMolecularOrbitals()),
+    m_nprim(m_wfn.numberOfGaussianPrimitives()),
+    m_nnuc(m_wfn.numberOfNuclei()),
+    m_noccmo(m_wfn.numberOfOccupiedMolecularOrbitals()),
+    m_nucxcoord(m_wfn.xNuclearCoordinates(), m_nnuc),
+    m_nucycoord(m_wfn.yNuclearCoordinates(), m_nnuc),
+    m_nuczcoord(m_wfn.zNuclearCoordinates(), m_nnuc),
+    m_nucz(m_wfn.nuclearCharges(), m_nnuc),
+    m_X0(m_wfn.xGaussianPrimitiveCenterCoordinates(), m_nprim),
+    m_Y0(m_wfn.yGaussianPrimitiveCenterCoordinates(), m_nprim),
+    m_Z0(m_wfn.zGaussianPrimitiveCenterCoordinates(), m_nprim),
+    m_xamom(m_wfn.xGaussianPrimitiveAngularMomenta(), m_nprim),
+    m_yamom(m_wfn.yGaussianPrimitiveAngularMomenta(), m_nprim),
+    m_zamom(m_wfn.zGaussianPrimitiveAngularMomenta(), m_nprim),
+    m_alpha(m_wfn.gaussianPrimitiveExponentCoefficients(), m_nprim),
+    m_orbe(m_wfn.molecularOrbitalEigenvalues(), m_nmo),
+    m_coef(m_wfn.molecularOrbitalCoefficients(), m_nmo, m_nprim),
+    m_occno(m_wfn.occupiedMolecularOrbitalOccupationNumbers(), m_noccmo),
+    m_occupiedCoef(m_wfn.occupiedMolecularOrbitalCoefficients(), m_noccmo,
+                   m_nprim),
+    m_ncenter(m_wfn.numberOfGaussianPrimitiveCenters()),
+    m_centers(m_wfn.gaussianPrimitiveCenterCoordinates(), 3, m_ncenter),
+    m_centerOffsets(m_wfn.gaussianPrimitiveCenterOffsets(), m_ncenter + 1),
+    m_centerPrimitives(m_wfn.gaussianPrimitivesByCenter(), m_nprim)
 {
-
-  m_nmo = wfn.numberOfMolecularOrbitals();
-  m_nprim = wfn.numberOfGaussianPrimitives();
-  m_nnuc = wfn.numberOfNuclei();
-
-  m_nucxcoord =
-    Map<const Matrix<qreal, Dynamic, 1>>(wfn.xNuclearCoordinates(), m_nnuc);
-  m_nucycoord =
-    Map<const Matrix<qreal, Dynamic, 1>>(wfn.yNuclearCoordinates(), m_nnuc);
-  m_nuczcoord =
-    Map<const Matrix<qreal, Dynamic, 1>>(wfn.zNuclearCoordinates(), m_nnuc);
-  m_nucz = Map<const Matrix<qint64, Dynamic, 1>>(wfn.nuclearCharges(), m_nnuc);
-  m_X0 = Map<const Matrix<qreal, Dynamic, 1>>(
-    wfn.xGaussianPrimitiveCenterCoordinates(), m_nprim, 1);
-  m_Y0 = Map<const Matrix<qreal, Dynamic, 1>>(
-    wfn.yGaussianPrimitiveCenterCoordinates(), m_nprim, 1);
-  m_Z0 = Map<const Matrix<qreal, Dynamic, 1>>(
-    wfn.zGaussianPrimitiveCenterCoordinates(), m_nprim, 1);
-  m_xamom = Map<const Matrix<qint64, Dynamic, 1>>(
-    wfn.xGaussianPrimitiveAngularMomenta(), m_nprim, 1);
-  m_yamom = Map<const Matrix<qint64, Dynamic, 1>>(
-    wfn.yGaussianPrimitiveAngularMomenta(), m_nprim, 1);
-  m_zamom = Map<const Matrix<qint64, Dynamic, 1>>(
-    wfn.zGaussianPrimitiveAngularMomenta(), m_nprim, 1);
-  m_alpha = Map<const Matrix<qreal, Dynamic, 1>>(
-    wfn.gaussianPrimitiveExponentCoefficients(), m_nprim, 1);
-  // TODO Implement screening for unoccupied molecular orbitals.
-  m_occno = Map<const Matrix<qreal, Dynamic, 1>>(
-    wfn.molecularOrbitalOccupationNumbers(), m_nmo, 1);
-  m_orbe = Map<const Matrix<qreal, Dynamic, 1>>(
-    wfn.molecularOrbitalEigenvalues(), m_nmo, 1);
-  m_coef = Map<const Matrix<qreal, Dynamic, Dynamic, RowMajor>>(
-    wfn.molecularOrbitalCoefficients(), m_nmo, m_nprim);
-  m_totalEnergy = wfn.totalEnergy();
-  m_virialRatio = wfn.virialRatio();
+  m_totalEnergy = m_wfn.totalEnergy();
+  m_virialRatio = m_wfn.virialRatio();
 
   m_cutoff = log(1.e-15);
 
-  m_cdg000.resize(m_nmo);
-  m_cdg100.resize(m_nmo);
-  m_cdg010.resize(m_nmo);
-  m_cdg001.resize(m_nmo);
-  m_cdg200.resize(m_nmo);
-  m_cdg110.resize(m_nmo);
-  m_cdg101.resize(m_nmo);
-  m_cdg020.resize(m_nmo);
-  m_cdg011.resize(m_nmo);
-  m_cdg002.resize(m_nmo);
-  m_cdg300.resize(m_nmo);
-  m_cdg120.resize(m_nmo);
-  m_cdg102.resize(m_nmo);
-  m_cdg210.resize(m_nmo);
-  m_cdg030.resize(m_nmo);
-  m_cdg012.resize(m_nmo);
-  m_cdg201.resize(m_nmo);
-  m_cdg021.resize(m_nmo);
-  m_cdg003.resize(m_nmo);
-  m_cdg111.resize(m_nmo);
-  m_cdg400.resize(m_nmo);
-  m_cdg220.resize(m_nmo);
-  m_cdg202.resize(m_nmo);
-  m_cdg310.resize(m_nmo);
-  m_cdg130.resize(m_nmo);
-  m_cdg112.resize(m_nmo);
-  m_cdg301.resize(m_nmo);
-  m_cdg121.resize(m_nmo);
-  m_cdg103.resize(m_nmo);
-  m_cdg040.resize(m_nmo);
-  m_cdg022.resize(m_nmo);
-  m_cdg211.resize(m_nmo);
-  m_cdg031.resize(m_nmo);
-  m_cdg013.resize(m_nmo);
-  m_cdg004.resize(m_nmo);
+  // A primitive is negligible where its exponential is below the cutoff, so
+  // all the primitives of a center are beyond the radius of the most diffuse.
+  Map<const Matrix<qreal, Dynamic, 1>> minimumExponents(
+    m_wfn.gaussianPrimitiveCenterMinimumExponents(), m_ncenter);
+  m_centerRadiusSquared = -m_cutoff * minimumExponents.cwiseInverse();
+
+  allocateScratch();
+}
+
+QTAIMWavefunctionEvaluator::QTAIMWavefunctionEvaluator(
+  const QTAIMWavefunctionEvaluator& other)
+  : QTAIMWavefunctionEvaluator(other.m_wfn)
+{
+}
+
+void QTAIMWavefunctionEvaluator::allocateScratch()
+{
+  m_screenedPrimitives.resize(m_nprim);
+  m_cdg000.resize(m_noccmo);
+  m_cdg100.resize(m_noccmo);
+  m_cdg010.resize(m_noccmo);
+  m_cdg001.resize(m_noccmo);
+  m_cdg200.resize(m_noccmo);
+  m_cdg110.resize(m_noccmo);
+  m_cdg101.resize(m_noccmo);
+  m_cdg020.resize(m_noccmo);
+  m_cdg011.resize(m_noccmo);
+  m_cdg002.resize(m_noccmo);
+  m_cdg300.resize(m_noccmo);
+  m_cdg120.resize(m_noccmo);
+  m_cdg102.resize(m_noccmo);
+  m_cdg210.resize(m_noccmo);
+  m_cdg030.resize(m_noccmo);
+  m_cdg012.resize(m_noccmo);
+  m_cdg201.resize(m_noccmo);
+  m_cdg021.resize(m_noccmo);
+  m_cdg003.resize(m_noccmo);
+  m_cdg111.resize(m_noccmo);
+  m_cdg400.resize(m_noccmo);
+  m_cdg220.resize(m_noccmo);
+  m_cdg202.resize(m_noccmo);
+  m_cdg310.resize(m_noccmo);
+  m_cdg130.resize(m_noccmo);
+  m_cdg112.resize(m_noccmo);
+  m_cdg301.resize(m_noccmo);
+  m_cdg121.resize(m_noccmo);
+  m_cdg103.resize(m_noccmo);
+  m_cdg040.resize(m_noccmo);
+  m_cdg022.resize(m_noccmo);
+  m_cdg211.resize(m_noccmo);
+  m_cdg031.resize(m_noccmo);
+  m_cdg013.resize(m_noccmo);
+  m_cdg004.resize(m_noccmo);
+}
+
+qint64 QTAIMWavefunctionEvaluator::screenPrimitives(
+  const Matrix<qreal, 3, 1>& xyz)
+{
+  qint64 nscreened = 0;
+  for (qint64 c = 0; c < m_ncenter; ++c) {
+    if ((m_centers.col(c) - xyz).squaredNorm() < m_centerRadiusSquared(c)) {
+      for (qint64 i = m_centerOffsets(c); i < m_centerOffsets(c + 1); ++i)
+        m_screenedPrimitives(nscreened++) = m_centerPrimitives(i);
+    }
+  }
+  return nscreened;
+}
+
+qint64 QTAIMWavefunctionEvaluator::screenPrimitives(
+  const Matrix<qreal, 3, Dynamic>& xyz)
+{
+  qint64 nscreened = 0;
+  if (xyz.cols() == 0)
+    return nscreened;
+  for (qint64 c = 0; c < m_ncenter; ++c) {
+    qreal distanceSquared =
+      (xyz.colwise() - m_centers.col(c)).colwise().squaredNorm().minCoeff();
+    if (distanceSquared < m_centerRadiusSquared(c)) {
+      for (qint64 i = m_centerOffsets(c); i < m_centerOffsets(c + 1); ++i)
+        m_screenedPrimitives(nscreened++) = m_centerPrimitives(i);
+    }
+  }
+  return nscreened;
 }
 
 qreal QTAIMWavefunctionEvaluator::molecularOrbital(
@@ -104,7 +144,9 @@ qreal QTAIMWavefunctionEvaluator::molecularOrbital(
 
   qreal value = 0.0;
 
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  const qint64 nscreened = screenPrimitives(xyz);
+  for (qint64 i = 0; i < nscreened; ++i) {
+    const qint64 p = m_screenedPrimitives(i);
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -133,7 +175,9 @@ qreal QTAIMWavefunctionEvaluator::electronDensity(const Matrix<qreal, 3, 1> xyz)
   qreal value;
 
   m_cdg000.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  const qint64 nscreened = screenPrimitives(xyz);
+  for (qint64 i = 0; i < nscreened; ++i) {
+    const qint64 p = m_screenedPrimitives(i);
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -149,14 +193,12 @@ qreal QTAIMWavefunctionEvaluator::electronDensity(const Matrix<qreal, 3, 1> xyz)
 
       qreal dg000 = ax0 * ay0 * az0 * b0;
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-      }
+      m_cdg000 += dg000 * m_occupiedCoef.col(p);
     }
   }
 
   value = 0.0;
-  for (qint64 m = 0; m < m_nmo; ++m) {
+  for (qint64 m = 0; m < m_noccmo; ++m) {
     value += m_occno(m) * ipow(m_cdg000(m), 2);
   }
 
@@ -176,7 +218,9 @@ const Matrix<qreal, 3, 1> QTAIMWavefunctionEvaluator::gradientOfElectronDensity(
   m_cdg100.setZero();
   m_cdg010.setZero();
   m_cdg001.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  const qint64 nscreened = screenPrimitives(xyz);
+  for (qint64 i = 0; i < nscreened; ++i) {
+    const qint64 p = m_screenedPrimitives(i);
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -233,17 +277,15 @@ const Matrix<qreal, 3, 1> QTAIMWavefunctionEvaluator::gradientOfElectronDensity(
       qreal dg010 = ax0 * az0 * b0 * (ay1 + ay0 * by1);
       qreal dg001 = ax0 * ay0 * b0 * (az1 + az0 * bz1);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-      }
+      m_cdg000 += dg000 * m_occupiedCoef.col(p);
+      m_cdg100 += dg100 * m_occupiedCoef.col(p);
+      m_cdg010 += dg010 * m_occupiedCoef.col(p);
+      m_cdg001 += dg001 * m_occupiedCoef.col(p);
     }
   }
 
   value.setZero();
-  for (qint64 m = 0; m < m_nmo; ++m) {
+  for (qint64 m = 0; m < m_noccmo; ++m) {
     value(0) += m_occno(m) * m_cdg100(m) * m_cdg000(m);
     value(1) += m_occno(m) * m_cdg010(m) * m_cdg000(m);
     value(2) += m_occno(m) * m_cdg001(m) * m_cdg000(m);
@@ -271,7 +313,9 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::hessianOfElectronDensity(
   m_cdg110.setZero();
   m_cdg101.setZero();
   m_cdg011.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  const qint64 nscreened = screenPrimitives(xyz);
+  for (qint64 i = 0; i < nscreened; ++i) {
+    const qint64 p = m_screenedPrimitives(i);
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -326,7 +370,7 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::hessianOfElectronDensity(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -334,7 +378,7 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::hessianOfElectronDensity(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -342,7 +386,7 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::hessianOfElectronDensity(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -367,23 +411,21 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::hessianOfElectronDensity(
       qreal dg101 = ay0 * b0 * (ax1 + ax0 * bx1) * (az1 + az0 * bz1);
       qreal dg011 = ax0 * b0 * (ay1 + ay0 * by1) * (az1 + az0 * bz1);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-        m_cdg110(m) += m_coef(m, p) * dg110;
-        m_cdg101(m) += m_coef(m, p) * dg101;
-        m_cdg011(m) += m_coef(m, p) * dg011;
-      }
+      m_cdg000 += dg000 * m_occupiedCoef.col(p);
+      m_cdg100 += dg100 * m_occupiedCoef.col(p);
+      m_cdg010 += dg010 * m_occupiedCoef.col(p);
+      m_cdg001 += dg001 * m_occupiedCoef.col(p);
+      m_cdg200 += dg200 * m_occupiedCoef.col(p);
+      m_cdg020 += dg020 * m_occupiedCoef.col(p);
+      m_cdg002 += dg002 * m_occupiedCoef.col(p);
+      m_cdg110 += dg110 * m_occupiedCoef.col(p);
+      m_cdg101 += dg101 * m_occupiedCoef.col(p);
+      m_cdg011 += dg011 * m_occupiedCoef.col(p);
     }
   }
 
   value.setZero();
-  for (qint64 m = 0; m < m_nmo; ++m) {
+  for (qint64 m = 0; m < m_noccmo; ++m) {
     value(0, 0) +=
       2 * m_occno(m) * (ipow(m_cdg100(m), 2) + m_cdg000(m) * m_cdg200(m));
     value(1, 1) +=
@@ -426,7 +468,9 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity(
   m_cdg110.setZero();
   m_cdg101.setZero();
   m_cdg011.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  const qint64 nscreened = screenPrimitives(xyz);
+  for (qint64 i = 0; i < nscreened; ++i) {
+    const qint64 p = m_screenedPrimitives(i);
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -481,7 +525,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -489,7 +533,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -497,7 +541,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -522,30 +566,28 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity(
       qreal dg101 = ay0 * b0 * (ax1 + ax0 * bx1) * (az1 + az0 * bz1);
       qreal dg011 = ax0 * b0 * (ay1 + ay0 * by1) * (az1 + az0 * bz1);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-        m_cdg110(m) += m_coef(m, p) * dg110;
-        m_cdg101(m) += m_coef(m, p) * dg101;
-        m_cdg011(m) += m_coef(m, p) * dg011;
-      }
+      m_cdg000 += dg000 * m_occupiedCoef.col(p);
+      m_cdg100 += dg100 * m_occupiedCoef.col(p);
+      m_cdg010 += dg010 * m_occupiedCoef.col(p);
+      m_cdg001 += dg001 * m_occupiedCoef.col(p);
+      m_cdg200 += dg200 * m_occupiedCoef.col(p);
+      m_cdg020 += dg020 * m_occupiedCoef.col(p);
+      m_cdg002 += dg002 * m_occupiedCoef.col(p);
+      m_cdg110 += dg110 * m_occupiedCoef.col(p);
+      m_cdg101 += dg101 * m_occupiedCoef.col(p);
+      m_cdg011 += dg011 * m_occupiedCoef.col(p);
     }
   }
 
   gValue.setZero();
-  for (qint64 m = 0; m < m_nmo; ++m) {
+  for (qint64 m = 0; m < m_noccmo; ++m) {
     gValue(0) += m_occno(m) * m_cdg100(m) * m_cdg000(m);
     gValue(1) += m_occno(m) * m_cdg010(m) * m_cdg000(m);
     gValue(2) += m_occno(m) * m_cdg001(m) * m_cdg000(m);
   }
 
   hValue.setZero();
-  for (qint64 m = 0; m < m_nmo; ++m) {
+  for (qint64 m = 0; m < m_noccmo; ++m) {
     hValue(0, 0) +=
       2 * m_occno(m) * (ipow(m_cdg100(m), 2) + m_cdg000(m) * m_cdg200(m));
     hValue(1, 1) +=
@@ -595,7 +637,9 @@ qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity(
   m_cdg200.setZero();
   m_cdg020.setZero();
   m_cdg002.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  const qint64 nscreened = screenPrimitives(xyz);
+  for (qint64 i = 0; i < nscreened; ++i) {
+    const qint64 p = m_screenedPrimitives(i);
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -650,7 +694,7 @@ qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -658,7 +702,7 @@ qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -666,7 +710,7 @@ qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -688,20 +732,18 @@ qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity(
       qreal dg020 = ax0 * az0 * b0 * (ay2 + 2 * ay1 * by1 + ay0 * by2);
       qreal dg002 = ax0 * ay0 * b0 * (az2 + 2 * az1 * bz1 + az0 * bz2);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-      }
+      m_cdg000 += dg000 * m_occupiedCoef.col(p);
+      m_cdg100 += dg100 * m_occupiedCoef.col(p);
+      m_cdg010 += dg010 * m_occupiedCoef.col(p);
+      m_cdg001 += dg001 * m_occupiedCoef.col(p);
+      m_cdg200 += dg200 * m_occupiedCoef.col(p);
+      m_cdg020 += dg020 * m_occupiedCoef.col(p);
+      m_cdg002 += dg002 * m_occupiedCoef.col(p);
     }
   }
 
   value = 0.0;
-  for (qint64 m = 0; m < m_nmo; ++m) {
+  for (qint64 m = 0; m < m_noccmo; ++m) {
     value +=
       2 * m_occno(m) * (ipow(m_cdg100(m), 2) + m_cdg000(m) * m_cdg200(m)) +
       2 * m_occno(m) * (ipow(m_cdg010(m), 2) + m_cdg000(m) * m_cdg020(m)) +
@@ -741,7 +783,9 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
   m_cdg021.setZero();
   m_cdg003.setZero();
   // m_cdg111.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  const qint64 nscreened = screenPrimitives(xyz);
+  for (qint64 i = 0; i < nscreened; ++i) {
+    const qint64 p = m_screenedPrimitives(i);
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -799,7 +843,7 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -807,7 +851,7 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -815,7 +859,7 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -826,7 +870,7 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
       if (m_xamom(p) < 3) {
         ax3 = zero;
       } else if (m_xamom(p) == 3) {
-        ax3 = one;
+        ax3 = aax3;
       } else {
         ax3 = aax3 * ipow(xx0, m_xamom(p) - 3);
       }
@@ -834,7 +878,7 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
       if (m_yamom(p) < 3) {
         ay3 = zero;
       } else if (m_yamom(p) == 3) {
-        ay3 = one;
+        ay3 = aay3;
       } else {
         ay3 = aay3 * ipow(yy0, m_yamom(p) - 3);
       }
@@ -842,7 +886,7 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
       if (m_zamom(p) < 3) {
         az3 = zero;
       } else if (m_zamom(p) == 3) {
-        az3 = one;
+        az3 = aaz3;
       } else {
         az3 = aaz3 * ipow(zz0, m_zamom(p) - 3);
       }
@@ -892,28 +936,26 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
         ax0 * b0 * (ay1 + ay0 * by1) * (az2 + 2 * az1 * bz1 + az0 * bz2);
       // qreal dg111 = b0*(ax1+ax0*bx1)*(ay1+ay0*by1)*(az1+az0*bz1);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-        m_cdg110(m) += m_coef(m, p) * dg110;
-        m_cdg101(m) += m_coef(m, p) * dg101;
-        m_cdg011(m) += m_coef(m, p) * dg011;
-        m_cdg300(m) += m_coef(m, p) * dg300;
-        m_cdg030(m) += m_coef(m, p) * dg030;
-        m_cdg003(m) += m_coef(m, p) * dg003;
-        m_cdg210(m) += m_coef(m, p) * dg210;
-        m_cdg201(m) += m_coef(m, p) * dg201;
-        m_cdg120(m) += m_coef(m, p) * dg120;
-        m_cdg021(m) += m_coef(m, p) * dg021;
-        m_cdg102(m) += m_coef(m, p) * dg102;
-        m_cdg012(m) += m_coef(m, p) * dg012;
-        // m_cdg111(m) += m_coef(m,p) * dg111;
-      }
+      m_cdg000 += dg000 * m_occupiedCoef.col(p);
+      m_cdg100 += dg100 * m_occupiedCoef.col(p);
+      m_cdg010 += dg010 * m_occupiedCoef.col(p);
+      m_cdg001 += dg001 * m_occupiedCoef.col(p);
+      m_cdg200 += dg200 * m_occupiedCoef.col(p);
+      m_cdg020 += dg020 * m_occupiedCoef.col(p);
+      m_cdg002 += dg002 * m_occupiedCoef.col(p);
+      m_cdg110 += dg110 * m_occupiedCoef.col(p);
+      m_cdg101 += dg101 * m_occupiedCoef.col(p);
+      m_cdg011 += dg011 * m_occupiedCoef.col(p);
+      m_cdg300 += dg300 * m_occupiedCoef.col(p);
+      m_cdg030 += dg030 * m_occupiedCoef.col(p);
+      m_cdg003 += dg003 * m_occupiedCoef.col(p);
+      m_cdg210 += dg210 * m_occupiedCoef.col(p);
+      m_cdg201 += dg201 * m_occupiedCoef.col(p);
+      m_cdg120 += dg120 * m_occupiedCoef.col(p);
+      m_cdg021 += dg021 * m_occupiedCoef.col(p);
+      m_cdg102 += dg102 * m_occupiedCoef.col(p);
+      m_cdg012 += dg012 * m_occupiedCoef.col(p);
+      // m_cdg111 += dg111 * m_occupiedCoef.col(p);
     }
   }
 
@@ -927,7 +969,7 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
   qreal deriv102 = zero;
   qreal deriv012 = zero;
   // qreal deriv111=zero;
-  for (qint64 m = 0; m < m_nmo; ++m) {
+  for (qint64 m = 0; m < m_noccmo; ++m) {
     deriv300 += (m_occno(m) * (6 * m_cdg100(m) * m_cdg200(m) +
                                2 * m_cdg000(m) * m_cdg300(m)));
     deriv030 += (m_occno(m) * (6 * m_cdg010(m) * m_cdg020(m) +
@@ -1010,7 +1052,9 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
   m_cdg121.setZero();
   m_cdg112.setZero();
 
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  const qint64 nscreened = screenPrimitives(xyz);
+  for (qint64 i = 0; i < nscreened; ++i) {
+    const qint64 p = m_screenedPrimitives(i);
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -1074,7 +1118,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -1082,7 +1126,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -1090,7 +1134,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -1101,7 +1145,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_xamom(p) < 3) {
         ax3 = zero;
       } else if (m_xamom(p) == 3) {
-        ax3 = one;
+        ax3 = aax3;
       } else {
         ax3 = aax3 * ipow(xx0, m_xamom(p) - 3);
       }
@@ -1109,7 +1153,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_yamom(p) < 3) {
         ay3 = zero;
       } else if (m_yamom(p) == 3) {
-        ay3 = one;
+        ay3 = aay3;
       } else {
         ay3 = aay3 * ipow(yy0, m_yamom(p) - 3);
       }
@@ -1117,7 +1161,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_zamom(p) < 3) {
         az3 = zero;
       } else if (m_zamom(p) == 3) {
-        az3 = one;
+        az3 = aaz3;
       } else {
         az3 = aaz3 * ipow(zz0, m_zamom(p) - 3);
       }
@@ -1128,7 +1172,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_xamom(p) < 4) {
         ax4 = zero;
       } else if (m_xamom(p) == 4) {
-        ax4 = one;
+        ax4 = aax4;
       } else {
         ax4 = aax4 * ipow(xx0, m_xamom(p) - 4);
       }
@@ -1136,7 +1180,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_yamom(p) < 4) {
         ay4 = zero;
       } else if (m_yamom(p) == 4) {
-        ay4 = one;
+        ay4 = aay4;
       } else {
         ay4 = aay4 * ipow(yy0, m_yamom(p) - 4);
       }
@@ -1144,7 +1188,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       if (m_zamom(p) < 4) {
         az4 = zero;
       } else if (m_zamom(p) == 4) {
-        az4 = one;
+        az4 = aaz4;
       } else {
         az4 = aaz4 * ipow(zz0, m_zamom(p) - 4);
       }
@@ -1237,43 +1281,41 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       qreal dg112 = b0 * (ax1 + ax0 * bx1) * (ay1 + ay0 * by1) *
                     (az2 + 2 * az1 * bz1 + az0 * bz2);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-        m_cdg110(m) += m_coef(m, p) * dg110;
-        m_cdg101(m) += m_coef(m, p) * dg101;
-        m_cdg011(m) += m_coef(m, p) * dg011;
-        m_cdg300(m) += m_coef(m, p) * dg300;
-        m_cdg030(m) += m_coef(m, p) * dg030;
-        m_cdg003(m) += m_coef(m, p) * dg003;
-        m_cdg210(m) += m_coef(m, p) * dg210;
-        m_cdg201(m) += m_coef(m, p) * dg201;
-        m_cdg120(m) += m_coef(m, p) * dg120;
-        m_cdg021(m) += m_coef(m, p) * dg021;
-        m_cdg102(m) += m_coef(m, p) * dg102;
-        m_cdg012(m) += m_coef(m, p) * dg012;
-        m_cdg111(m) += m_coef(m, p) * dg111;
-        m_cdg400(m) += m_coef(m, p) * dg400;
-        m_cdg040(m) += m_coef(m, p) * dg040;
-        m_cdg004(m) += m_coef(m, p) * dg004;
-        m_cdg310(m) += m_coef(m, p) * dg310;
-        m_cdg301(m) += m_coef(m, p) * dg301;
-        m_cdg130(m) += m_coef(m, p) * dg130;
-        m_cdg031(m) += m_coef(m, p) * dg031;
-        m_cdg103(m) += m_coef(m, p) * dg103;
-        m_cdg013(m) += m_coef(m, p) * dg013;
-        m_cdg220(m) += m_coef(m, p) * dg220;
-        m_cdg202(m) += m_coef(m, p) * dg202;
-        m_cdg022(m) += m_coef(m, p) * dg022;
-        m_cdg211(m) += m_coef(m, p) * dg211;
-        m_cdg121(m) += m_coef(m, p) * dg121;
-        m_cdg112(m) += m_coef(m, p) * dg112;
-      }
+      m_cdg000 += dg000 * m_occupiedCoef.col(p);
+      m_cdg100 += dg100 * m_occupiedCoef.col(p);
+      m_cdg010 += dg010 * m_occupiedCoef.col(p);
+      m_cdg001 += dg001 * m_occupiedCoef.col(p);
+      m_cdg200 += dg200 * m_occupiedCoef.col(p);
+      m_cdg020 += dg020 * m_occupiedCoef.col(p);
+      m_cdg002 += dg002 * m_occupiedCoef.col(p);
+      m_cdg110 += dg110 * m_occupiedCoef.col(p);
+      m_cdg101 += dg101 * m_occupiedCoef.col(p);
+      m_cdg011 += dg011 * m_occupiedCoef.col(p);
+      m_cdg300 += dg300 * m_occupiedCoef.col(p);
+      m_cdg030 += dg030 * m_occupiedCoef.col(p);
+      m_cdg003 += dg003 * m_occupiedCoef.col(p);
+      m_cdg210 += dg210 * m_occupiedCoef.col(p);
+      m_cdg201 += dg201 * m_occupiedCoef.col(p);
+      m_cdg120 += dg120 * m_occupiedCoef.col(p);
+      m_cdg021 += dg021 * m_occupiedCoef.col(p);
+      m_cdg102 += dg102 * m_occupiedCoef.col(p);
+      m_cdg012 += dg012 * m_occupiedCoef.col(p);
+      m_cdg111 += dg111 * m_occupiedCoef.col(p);
+      m_cdg400 += dg400 * m_occupiedCoef.col(p);
+      m_cdg040 += dg040 * m_occupiedCoef.col(p);
+      m_cdg004 += dg004 * m_occupiedCoef.col(p);
+      m_cdg310 += dg310 * m_occupiedCoef.col(p);
+      m_cdg301 += dg301 * m_occupiedCoef.col(p);
+      m_cdg130 += dg130 * m_occupiedCoef.col(p);
+      m_cdg031 += dg031 * m_occupiedCoef.col(p);
+      m_cdg103 += dg103 * m_occupiedCoef.col(p);
+      m_cdg013 += dg013 * m_occupiedCoef.col(p);
+      m_cdg220 += dg220 * m_occupiedCoef.col(p);
+      m_cdg202 += dg202 * m_occupiedCoef.col(p);
+      m_cdg022 += dg022 * m_occupiedCoef.col(p);
+      m_cdg211 += dg211 * m_occupiedCoef.col(p);
+      m_cdg121 += dg121 * m_occupiedCoef.col(p);
+      m_cdg112 += dg112 * m_occupiedCoef.col(p);
     }
   }
 
@@ -1292,7 +1334,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
   qreal deriv211 = zero;
   qreal deriv121 = zero;
   qreal deriv112 = zero;
-  for (qint64 m = 0; m < m_nmo; ++m) {
+  for (qint64 m = 0; m < m_noccmo; ++m) {
     deriv400 +=
       (m_occno(m) * (6 * ipow(m_cdg200(m), 2) + 8 * m_cdg100(m) * m_cdg300(m) +
                      2 * m_cdg000(m) * m_cdg400(m)));
@@ -1419,7 +1461,9 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
   m_cdg121.setZero();
   m_cdg112.setZero();
 
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  const qint64 nscreened = screenPrimitives(xyz);
+  for (qint64 i = 0; i < nscreened; ++i) {
+    const qint64 p = m_screenedPrimitives(i);
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -1483,7 +1527,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -1491,7 +1535,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -1499,7 +1543,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -1510,7 +1554,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_xamom(p) < 3) {
         ax3 = zero;
       } else if (m_xamom(p) == 3) {
-        ax3 = one;
+        ax3 = aax3;
       } else {
         ax3 = aax3 * ipow(xx0, m_xamom(p) - 3);
       }
@@ -1518,7 +1562,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_yamom(p) < 3) {
         ay3 = zero;
       } else if (m_yamom(p) == 3) {
-        ay3 = one;
+        ay3 = aay3;
       } else {
         ay3 = aay3 * ipow(yy0, m_yamom(p) - 3);
       }
@@ -1526,7 +1570,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_zamom(p) < 3) {
         az3 = zero;
       } else if (m_zamom(p) == 3) {
-        az3 = one;
+        az3 = aaz3;
       } else {
         az3 = aaz3 * ipow(zz0, m_zamom(p) - 3);
       }
@@ -1537,7 +1581,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_xamom(p) < 4) {
         ax4 = zero;
       } else if (m_xamom(p) == 4) {
-        ax4 = one;
+        ax4 = aax4;
       } else {
         ax4 = aax4 * ipow(xx0, m_xamom(p) - 4);
       }
@@ -1545,7 +1589,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_yamom(p) < 4) {
         ay4 = zero;
       } else if (m_yamom(p) == 4) {
-        ay4 = one;
+        ay4 = aay4;
       } else {
         ay4 = aay4 * ipow(yy0, m_yamom(p) - 4);
       }
@@ -1553,7 +1597,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       if (m_zamom(p) < 4) {
         az4 = zero;
       } else if (m_zamom(p) == 4) {
-        az4 = one;
+        az4 = aaz4;
       } else {
         az4 = aaz4 * ipow(zz0, m_zamom(p) - 4);
       }
@@ -1646,43 +1690,41 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       qreal dg112 = b0 * (ax1 + ax0 * bx1) * (ay1 + ay0 * by1) *
                     (az2 + 2 * az1 * bz1 + az0 * bz2);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-        m_cdg110(m) += m_coef(m, p) * dg110;
-        m_cdg101(m) += m_coef(m, p) * dg101;
-        m_cdg011(m) += m_coef(m, p) * dg011;
-        m_cdg300(m) += m_coef(m, p) * dg300;
-        m_cdg030(m) += m_coef(m, p) * dg030;
-        m_cdg003(m) += m_coef(m, p) * dg003;
-        m_cdg210(m) += m_coef(m, p) * dg210;
-        m_cdg201(m) += m_coef(m, p) * dg201;
-        m_cdg120(m) += m_coef(m, p) * dg120;
-        m_cdg021(m) += m_coef(m, p) * dg021;
-        m_cdg102(m) += m_coef(m, p) * dg102;
-        m_cdg012(m) += m_coef(m, p) * dg012;
-        m_cdg111(m) += m_coef(m, p) * dg111;
-        m_cdg400(m) += m_coef(m, p) * dg400;
-        m_cdg040(m) += m_coef(m, p) * dg040;
-        m_cdg004(m) += m_coef(m, p) * dg004;
-        m_cdg310(m) += m_coef(m, p) * dg310;
-        m_cdg301(m) += m_coef(m, p) * dg301;
-        m_cdg130(m) += m_coef(m, p) * dg130;
-        m_cdg031(m) += m_coef(m, p) * dg031;
-        m_cdg103(m) += m_coef(m, p) * dg103;
-        m_cdg013(m) += m_coef(m, p) * dg013;
-        m_cdg220(m) += m_coef(m, p) * dg220;
-        m_cdg202(m) += m_coef(m, p) * dg202;
-        m_cdg022(m) += m_coef(m, p) * dg022;
-        m_cdg211(m) += m_coef(m, p) * dg211;
-        m_cdg121(m) += m_coef(m, p) * dg121;
-        m_cdg112(m) += m_coef(m, p) * dg112;
-      }
+      m_cdg000 += dg000 * m_occupiedCoef.col(p);
+      m_cdg100 += dg100 * m_occupiedCoef.col(p);
+      m_cdg010 += dg010 * m_occupiedCoef.col(p);
+      m_cdg001 += dg001 * m_occupiedCoef.col(p);
+      m_cdg200 += dg200 * m_occupiedCoef.col(p);
+      m_cdg020 += dg020 * m_occupiedCoef.col(p);
+      m_cdg002 += dg002 * m_occupiedCoef.col(p);
+      m_cdg110 += dg110 * m_occupiedCoef.col(p);
+      m_cdg101 += dg101 * m_occupiedCoef.col(p);
+      m_cdg011 += dg011 * m_occupiedCoef.col(p);
+      m_cdg300 += dg300 * m_occupiedCoef.col(p);
+      m_cdg030 += dg030 * m_occupiedCoef.col(p);
+      m_cdg003 += dg003 * m_occupiedCoef.col(p);
+      m_cdg210 += dg210 * m_occupiedCoef.col(p);
+      m_cdg201 += dg201 * m_occupiedCoef.col(p);
+      m_cdg120 += dg120 * m_occupiedCoef.col(p);
+      m_cdg021 += dg021 * m_occupiedCoef.col(p);
+      m_cdg102 += dg102 * m_occupiedCoef.col(p);
+      m_cdg012 += dg012 * m_occupiedCoef.col(p);
+      m_cdg111 += dg111 * m_occupiedCoef.col(p);
+      m_cdg400 += dg400 * m_occupiedCoef.col(p);
+      m_cdg040 += dg040 * m_occupiedCoef.col(p);
+      m_cdg004 += dg004 * m_occupiedCoef.col(p);
+      m_cdg310 += dg310 * m_occupiedCoef.col(p);
+      m_cdg301 += dg301 * m_occupiedCoef.col(p);
+      m_cdg130 += dg130 * m_occupiedCoef.col(p);
+      m_cdg031 += dg031 * m_occupiedCoef.col(p);
+      m_cdg103 += dg103 * m_occupiedCoef.col(p);
+      m_cdg013 += dg013 * m_occupiedCoef.col(p);
+      m_cdg220 += dg220 * m_occupiedCoef.col(p);
+      m_cdg202 += dg202 * m_occupiedCoef.col(p);
+      m_cdg022 += dg022 * m_occupiedCoef.col(p);
+      m_cdg211 += dg211 * m_occupiedCoef.col(p);
+      m_cdg121 += dg121 * m_occupiedCoef.col(p);
+      m_cdg112 += dg112 * m_occupiedCoef.col(p);
     }
   }
 
@@ -1710,7 +1752,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
   qreal deriv211 = zero;
   qreal deriv121 = zero;
   qreal deriv112 = zero;
-  for (qint64 m = 0; m < m_nmo; ++m) {
+  for (qint64 m = 0; m < m_noccmo; ++m) {
     deriv300 += (m_occno(m) * (6 * m_cdg100(m) * m_cdg200(m) +
                                2 * m_cdg000(m) * m_cdg300(m)));
     deriv030 += (m_occno(m) * (6 * m_cdg010(m) * m_cdg020(m) +
@@ -1845,7 +1887,9 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityG(Matrix<qreal, 3, 1> xyz)
   m_cdg100.setZero();
   m_cdg010.setZero();
   m_cdg001.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  const qint64 nscreened = screenPrimitives(xyz);
+  for (qint64 i = 0; i < nscreened; ++i) {
+    const qint64 p = m_screenedPrimitives(i);
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -1902,17 +1946,15 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityG(Matrix<qreal, 3, 1> xyz)
       qreal dg010 = ax0 * az0 * b0 * (ay1 + ay0 * by1);
       qreal dg001 = ax0 * ay0 * b0 * (az1 + az0 * bz1);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-      }
+      m_cdg000 += dg000 * m_occupiedCoef.col(p);
+      m_cdg100 += dg100 * m_occupiedCoef.col(p);
+      m_cdg010 += dg010 * m_occupiedCoef.col(p);
+      m_cdg001 += dg001 * m_occupiedCoef.col(p);
     }
   }
 
   value = zero;
-  for (qint64 m = 0; m < m_nmo; ++m) {
+  for (qint64 m = 0; m < m_noccmo; ++m) {
     value +=
       (0.5) * (m_occno(m) * (ipow(m_cdg100(m), 2) + ipow(m_cdg010(m), 2) +
                              ipow(m_cdg001(m), 2)));
@@ -1934,7 +1976,9 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityK(
   m_cdg200.setZero();
   m_cdg020.setZero();
   m_cdg002.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  const qint64 nscreened = screenPrimitives(xyz);
+  for (qint64 i = 0; i < nscreened; ++i) {
+    const qint64 p = m_screenedPrimitives(i);
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -1989,7 +2033,7 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityK(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -1997,7 +2041,7 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityK(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -2005,7 +2049,7 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityK(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -2024,17 +2068,15 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityK(
       qreal dg020 = ax0 * az0 * b0 * (ay2 + 2 * ay1 * by1 + ay0 * by2);
       qreal dg002 = ax0 * ay0 * b0 * (az2 + 2 * az1 * bz1 + az0 * bz2);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-      }
+      m_cdg000 += dg000 * m_occupiedCoef.col(p);
+      m_cdg200 += dg200 * m_occupiedCoef.col(p);
+      m_cdg020 += dg020 * m_occupiedCoef.col(p);
+      m_cdg002 += dg002 * m_occupiedCoef.col(p);
     }
   }
 
   value = 0.0;
-  for (qint64 m = 0; m < m_nmo; ++m) {
+  for (qint64 m = 0; m < m_noccmo; ++m) {
     value +=
       (0.25) * (m_occno(m) *
                 (2 * m_cdg000(m) * (m_cdg200(m) + m_cdg020(m) + m_cdg002(m))));
@@ -2062,7 +2104,9 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::quantumStressTensor(
   m_cdg110.setZero();
   m_cdg101.setZero();
   m_cdg011.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  const qint64 nscreened = screenPrimitives(xyz);
+  for (qint64 i = 0; i < nscreened; ++i) {
+    const qint64 p = m_screenedPrimitives(i);
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -2117,7 +2161,7 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::quantumStressTensor(
       if (m_xamom(p) < 2) {
         ax2 = zero;
       } else if (m_xamom(p) == 2) {
-        ax2 = one;
+        ax2 = aax2;
       } else {
         ax2 = aax2 * ipow(xx0, m_xamom(p) - 2);
       }
@@ -2125,7 +2169,7 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::quantumStressTensor(
       if (m_yamom(p) < 2) {
         ay2 = zero;
       } else if (m_yamom(p) == 2) {
-        ay2 = one;
+        ay2 = aay2;
       } else {
         ay2 = aay2 * ipow(yy0, m_yamom(p) - 2);
       }
@@ -2133,7 +2177,7 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::quantumStressTensor(
       if (m_zamom(p) < 2) {
         az2 = zero;
       } else if (m_zamom(p) == 2) {
-        az2 = one;
+        az2 = aaz2;
       } else {
         az2 = aaz2 * ipow(zz0, m_zamom(p) - 2);
       }
@@ -2158,23 +2202,21 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::quantumStressTensor(
       qreal dg101 = ay0 * b0 * (ax1 + ax0 * bx1) * (az1 + az0 * bz1);
       qreal dg011 = ax0 * b0 * (ay1 + ay0 * by1) * (az1 + az0 * bz1);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-        m_cdg110(m) += m_coef(m, p) * dg110;
-        m_cdg101(m) += m_coef(m, p) * dg101;
-        m_cdg011(m) += m_coef(m, p) * dg011;
-      }
+      m_cdg000 += dg000 * m_occupiedCoef.col(p);
+      m_cdg100 += dg100 * m_occupiedCoef.col(p);
+      m_cdg010 += dg010 * m_occupiedCoef.col(p);
+      m_cdg001 += dg001 * m_occupiedCoef.col(p);
+      m_cdg200 += dg200 * m_occupiedCoef.col(p);
+      m_cdg020 += dg020 * m_occupiedCoef.col(p);
+      m_cdg002 += dg002 * m_occupiedCoef.col(p);
+      m_cdg110 += dg110 * m_occupiedCoef.col(p);
+      m_cdg101 += dg101 * m_occupiedCoef.col(p);
+      m_cdg011 += dg011 * m_occupiedCoef.col(p);
     }
   }
 
   value.setZero();
-  for (qint64 m = 0; m < m_nmo; ++m) {
+  for (qint64 m = 0; m < m_noccmo; ++m) {
     value(0, 0) +=
       (m_occno(m) * (2 * m_cdg000(m) * m_cdg200(m) - 2 * ipow(m_cdg100(m), 2)));
     value(0, 1) += (m_occno(m) * (2 * m_cdg000(m) * m_cdg110(m) -
@@ -2195,5 +2237,118 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::quantumStressTensor(
   return 0.25 * value;
 }
 
+void QTAIMWavefunctionEvaluator::occupiedOrbitals(
+  const Matrix<qreal, 3, Dynamic>& xyz, int order,
+  Matrix<qreal, Dynamic, Dynamic>& orbitals)
+{
+  // The columns of orbitals are the values at the points, then for order 1
+  // and up their x, y and z derivatives, then for order 2 their xx, yy and zz
+  // second derivatives, in blocks of npts columns.
+  const qint64 npts = xyz.cols();
+  const qint64 nblocks = order == 0 ? 1 : (order == 1 ? 4 : 7);
+  const qint64 nscreened = screenPrimitives(xyz);
+
+  Matrix<qreal, Dynamic, Dynamic, RowMajor> primitives(nscreened,
+                                                       nblocks * npts);
+  Matrix<qreal, Dynamic, Dynamic> coef(m_noccmo, nscreened);
+  primitives.setZero();
+  for (qint64 i = 0; i < nscreened; ++i) {
+    const qint64 p = m_screenedPrimitives(i);
+    coef.col(i) = m_occupiedCoef.col(p);
+    const qreal alpha = m_alpha(p);
+    const qint64 amom[3] = { m_xamom(p), m_yamom(p), m_zamom(p) };
+    for (qint64 j = 0; j < npts; ++j) {
+      const qreal xyz0[3] = { xyz(0, j) - m_X0(p), xyz(1, j) - m_Y0(p),
+                              xyz(2, j) - m_Z0(p) };
+
+      qreal b0arg = -alpha * (xyz0[0] * xyz0[0] + xyz0[1] * xyz0[1] +
+                              xyz0[2] * xyz0[2]);
+      if (b0arg <= m_cutoff)
+        continue;
+      qreal b0 = exp(b0arg);
+
+      // The factor along each axis, and its first and second derivatives.
+      qreal f0[3];
+      qreal f1[3];
+      qreal f2[3];
+      for (int k = 0; k < 3; ++k) {
+        const qint64 l = amom[k];
+        const qreal d = xyz0[k];
+        qreal a0 = ipow(d, l);
+        qreal a1 = l < 1 ? 0.0 : l * ipow(d, l - 1);
+        qreal a2 = l < 2 ? 0.0 : l * (l - 1) * ipow(d, l - 2);
+        qreal b1 = -2 * alpha * d;
+        qreal b2 = -2 * alpha + 4 * alpha * alpha * d * d;
+        f0[k] = a0;
+        f1[k] = a1 + a0 * b1;
+        f2[k] = a2 + 2 * a1 * b1 + a0 * b2;
+      }
+
+      primitives(i, j) = f0[0] * f0[1] * f0[2] * b0;
+      if (order >= 1) {
+        primitives(i, npts + j) = f1[0] * f0[1] * f0[2] * b0;
+        primitives(i, 2 * npts + j) = f0[0] * f1[1] * f0[2] * b0;
+        primitives(i, 3 * npts + j) = f0[0] * f0[1] * f1[2] * b0;
+      }
+      if (order >= 2) {
+        primitives(i, 4 * npts + j) = f2[0] * f0[1] * f0[2] * b0;
+        primitives(i, 5 * npts + j) = f0[0] * f2[1] * f0[2] * b0;
+        primitives(i, 6 * npts + j) = f0[0] * f0[1] * f2[2] * b0;
+      }
+    }
+  }
+
+  orbitals.noalias() = coef * primitives;
+}
+
+Matrix<qreal, Dynamic, 1> QTAIMWavefunctionEvaluator::electronDensities(
+  const Matrix<qreal, 3, Dynamic>& xyz)
+{
+  Matrix<qreal, Dynamic, Dynamic> orbitals;
+  occupiedOrbitals(xyz, 0, orbitals);
+
+  return orbitals.cwiseAbs2().transpose() * m_occno;
+}
+
+Matrix<qreal, 3, Dynamic>
+QTAIMWavefunctionEvaluator::gradientsOfElectronDensity(
+  const Matrix<qreal, 3, Dynamic>& xyz)
+{
+  const qint64 npts = xyz.cols();
+  Matrix<qreal, Dynamic, Dynamic> orbitals;
+  occupiedOrbitals(xyz, 1, orbitals);
+
+  Matrix<qreal, 3, Dynamic> value(3, npts);
+  for (qint64 k = 0; k < 3; ++k) {
+    value.row(k) =
+      m_occno.transpose() *
+      orbitals.middleCols((k + 1) * npts, npts)
+        .cwiseProduct(orbitals.leftCols(npts));
+  }
+
+  return value;
+}
+
+Matrix<qreal, Dynamic, 1>
+QTAIMWavefunctionEvaluator::laplaciansOfElectronDensity(
+  const Matrix<qreal, 3, Dynamic>& xyz)
+{
+  const qint64 npts = xyz.cols();
+  Matrix<qreal, Dynamic, Dynamic> orbitals;
+  occupiedOrbitals(xyz, 2, orbitals);
+
+  Matrix<qreal, Dynamic, Dynamic> sum =
+    orbitals.middleCols(npts, 3 * npts).cwiseAbs2();
+  for (qint64 k = 0; k < 3; ++k) {
+    sum.middleCols(k * npts, npts) +=
+      orbitals.leftCols(npts).cwiseProduct(
+        orbitals.middleCols((k + 4) * npts, npts));
+  }
+  Matrix<qreal, Dynamic, 1> value = 2 * sum.transpose() * m_occno;
+
+  return value.segment(0, npts) + value.segment(npts, npts) +
+         value.segment(2 * npts, npts);
+}
+
 } // namespace QtPlugins
 } // namespace Avogadro
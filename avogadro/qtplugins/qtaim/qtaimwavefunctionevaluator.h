@@ -28,12 +28,16 @@ namespace QtPlugins {
 
 class QTAIMWavefunction;
 
+// The evaluator keeps an implicitly shared copy of the wavefunction and maps
+// its arrays without copying them, so it is cheap to construct. It is not
+// thread-safe (it has scratch buffers), each thread needs its own evaluator.
 class QTAIMWavefunctionEvaluator
 {
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-  explicit QTAIMWavefunctionEvaluator(QTAIMWavefunction& wfn);
+  explicit QTAIMWavefunctionEvaluator(const QTAIMWavefunction& wfn);
+  QTAIMWavefunctionEvaluator(const QTAIMWavefunctionEvaluator& other);
 
   qreal molecularOrbital(const qint64 mo, const Matrix<qreal, 3, 1> xyz);
   qreal electronDensity(const Matrix<qreal, 3, 1> xyz);
@@ -58,26 +62,50 @@ public:
   qreal kineticEnergyDensityK(const Matrix<qreal, 3, 1> xyz);
   const Matrix<qreal, 3, 3> quantumStressTensor(const Matrix<qreal, 3, 1> xyz);
 
+  // Batched evaluation at the points in the columns of xyz, with the same
+  // conventions as the functions above. The primitives are evaluated at all
+  // the points together and combined with the orbital coefficients by one
+  // matrix product; batches of a few hundred points work well.
+  Matrix<qreal, Dynamic, 1> electronDensities(
+    const Matrix<qreal, 3, Dynamic>& xyz);
+  Matrix<qreal, 3, Dynamic> gradientsOfElectronDensity(
+    const Matrix<qreal, 3, Dynamic>& xyz);
+  Matrix<qreal, Dynamic, 1> laplaciansOfElectronDensity(
+    const Matrix<qreal, 3, Dynamic>& xyz);
+
 private:
+  // Declared first, the maps below point into its arrays.
+  const QTAIMWavefunction m_wfn;
+
   qint64 m_nmo;
   qint64 m_nprim;
   qint64 m_nnuc;
-  //    qint64 m_noccmo; // number of (significantly) occupied molecular
-  //    orbitals
-  Matrix<qreal, Dynamic, 1> m_nucxcoord;
-  Matrix<qreal, Dynamic, 1> m_nucycoord;
-  Matrix<qreal, Dynamic, 1> m_nuczcoord;
-  Matrix<qint64, Dynamic, 1> m_nucz;
-  Matrix<qreal, Dynamic, 1> m_X0;
-  Matrix<qreal, Dynamic, 1> m_Y0;
-  Matrix<qreal, Dynamic, 1> m_Z0;
-  Matrix<qint64, Dynamic, 1> m_xamom;
-  Matrix<qint64, Dynamic, 1> m_yamom;
-  Matrix<qint64, Dynamic, 1> m_zamom;
-  Matrix<qreal, Dynamic, 1> m_alpha;
-  Matrix<qreal, Dynamic, 1> m_occno;
-  Matrix<qreal, Dynamic, 1> m_orbe;
-  Matrix<qreal, Dynamic, Dynamic, RowMajor> m_coef;
+  qint64 m_noccmo; // number of occupied molecular orbitals
+  Map<const Matrix<qreal, Dynamic, 1>> m_nucxcoord;
+  Map<const Matrix<qreal, Dynamic, 1>> m_nucycoord;
+  Map<const Matrix<qreal, Dynamic, 1>> m_nuczcoord;
+  Map<const Matrix<qint64, Dynamic, 1>> m_nucz;
+  Map<const Matrix<qreal, Dynamic, 1>> m_X0;
+  Map<const Matrix<qreal, Dynamic, 1>> m_Y0;
+  Map<const Matrix<qreal, Dynamic, 1>> m_Z0;
+  Map<const Matrix<qint64, Dynamic, 1>> m_xamom;
+  Map<const Matrix<qint64, Dynamic, 1>> m_yamom;
+  Map<const Matrix<qint64, Dynamic, 1>> m_zamom;
+  Map<const Matrix<qreal, Dynamic, 1>> m_alpha;
+  Map<const Matrix<qreal, Dynamic, 1>> m_orbe;
+  Map<const Matrix<qreal, Dynamic, Dynamic, RowMajor>> m_coef;
+  // The occupied orbitals only, with one column per primitive.
+  Map<const Matrix<qreal, Dynamic, 1>> m_occno;
+  Map<const Matrix<qreal, Dynamic, Dynamic>> m_occupiedCoef;
+
+  // Primitive screening: the primitives of the centers farther from the
+  // point than their screening radius are negligible and skipped.
+  qint64 m_ncenter;
+  Map<const Matrix<qreal, 3, Dynamic>> m_centers;
+  Map<const Matrix<qint64, Dynamic, 1>> m_centerOffsets;
+  Map<const Matrix<qint64, Dynamic, 1>> m_centerPrimitives;
+  Matrix<qreal, Dynamic, 1> m_centerRadiusSquared;
+  Matrix<qint64, Dynamic, 1> m_screenedPrimitives;
   qreal m_totalEnergy;
   qreal m_virialRatio;
 
@@ -119,6 +147,15 @@ private:
   Matrix<qreal, Dynamic, 1> m_cdg013;
   Matrix<qreal, Dynamic, 1> m_cdg004;
 
+  void allocateScratch();
+  qint64 screenPrimitives(const Matrix<qreal, 3, 1>& xyz);
+  qint64 screenPrimitives(const Matrix<qreal, 3, Dynamic>& xyz);
+  void occupiedOrbitals(const Matrix<qreal, 3, Dynamic>& xyz, int order,
+                        Matrix<qreal, Dynamic, Dynamic>& orbitals);
+
+  // The maps cannot be reseated.
+  QTAIMWavefunctionEvaluator& operator=(const QTAIMWavefunctionEvaluator&);
+
   static inline qreal ipow(qreal a, qint64 n) { return (qreal)pow(a, (int)n); }
 };
 
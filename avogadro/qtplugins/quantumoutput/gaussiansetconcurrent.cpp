@@ -48,6 +48,9 @@ struct GaussianShell
   Cube* tCube;             // The target cube, used to initialise temp cubes too
   unsigned int pos;        // The index of the point to calculate the MO for
   unsigned int state;      // The MO number to calculate
+
+  const std::vector<Cube*>* cubes; // The cubes of several orbitals
+  const std::vector<int>* states;  // The orbitals of the cubes
 };
 
 GaussianSetConcurrent::GaussianSetConcurrent(QObject* p)
@@ -76,6 +79,18 @@ bool GaussianSetConcurrent::calculateMolecularOrbital(Core::Cube* cube,
   return setUpCalculation(cube, state, GaussianSetConcurrent::processOrbital);
 }
 
+bool GaussianSetConcurrent::calculateMolecularOrbitals(
+  const std::vector<Core::Cube*>& cubes, const std::vector<int>& states)
+{
+  if (cubes.empty() || cubes.size() != states.size())
+    return false;
+
+  m_cubes = cubes;
+  m_states = states;
+  return setUpCalculation(cubes.front(), 0,
+                          GaussianSetConcurrent::processOrbitals);
+}
+
 bool GaussianSetConcurrent::calculateElectronDensity(Core::Cube* cube)
 {
   return setUpCalculation(cube, 0, GaussianSetConcurrent::processDensity);
@@ -90,6 +105,10 @@ void GaussianSetConcurrent::calculationComplete()
 {
   disconnect(&m_watcher, SIGNAL(finished()), this, SLOT(calculationComplete()));
   (*m_gaussianShells)[0].tCube->lock()->unlock();
+  for (size_t i = 1; i < m_cubes.size(); ++i)
+    m_cubes[i]->lock()->unlock();
+  m_cubes.clear();
+  m_states.clear();
   delete m_gaussianShells;
   m_gaussianShells = 0;
   emit finished();
@@ -103,6 +122,10 @@ bool GaussianSetConcurrent::setUpCalculation(Core::Cube* cube,
     return false;
 
   m_set->initCalculation();
+  // The density matrices are generated once here, not by the workers.
+  if (func == GaussianSetConcurrent::processDensity ||
+      func == GaussianSetConcurrent::processSpinDensity)
+    m_set->generateDensityMatrix();
 
   // Set up the points we want to calculate the density at.
   m_gaussianShells =
@@ -113,10 +136,14 @@ bool GaussianSetConcurrent::setUpCalculation(Core::Cube* cube,
     (*m_gaussianShells)[i].tCube = cube;
     (*m_gaussianShells)[i].pos = i;
     (*m_gaussianShells)[i].state = state;
+    (*m_gaussianShells)[i].cubes = &m_cubes;
+    (*m_gaussianShells)[i].states = &m_states;
   }
 
   // Lock the cube until we are done.
   cube->lock()->lock();
+  for (size_t i = 1; i < m_cubes.size(); ++i)
+    m_cubes[i]->lock()->lock();
 
   // Watch for the future
   connect(&m_watcher, SIGNAL(finished()), this, SLOT(calculationComplete()));
@@ -136,6 +163,15 @@ void GaussianSetConcurrent::processOrbital(GaussianShell& shell)
     shell.pos, shell.tools->calculateMolecularOrbital(pos, shell.state));
 }
 
+void GaussianSetConcurrent::processOrbitals(GaussianShell& shell)
+{
+  Vector3 pos = shell.tCube->position(shell.pos);
+  std::vector<double> values =
+    shell.tools->calculateMolecularOrbitals(pos, *shell.states);
+  for (size_t i = 0; i < values.size(); ++i)
+    (*shell.cubes)[i]->setValue(shell.pos, values[i]);
+}
+
 void GaussianSetConcurrent::processDensity(GaussianShell& shell)
 {
   Vector3 pos = shell.tCube->position(shell.pos);
@@ -43,6 +43,8 @@
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QProgressDialog>
 
+#include <algorithm>
+
 namespace Avogadro {
 namespace QtPlugins {
 
@@ -52,7 +54,8 @@ using Core::Cube;
 QuantumOutput::QuantumOutput(QObject* p)
   : ExtensionPlugin(p), m_progressDialog(nullptr), m_molecule(nullptr),
     m_basis(nullptr), m_concurrent(nullptr), m_concurrent2(nullptr),
-    m_cube(nullptr), m_mesh1(nullptr), m_mesh2(nullptr),
+    m_cube(nullptr), m_orbitalCubesStale(false), m_batchCube(nullptr),
+    m_mesh1(nullptr), m_mesh2(nullptr),
     m_meshGenerator1(nullptr), m_meshGenerator2(nullptr), m_dialog(nullptr)
 {
   QAction* action = new QAction(this);
@@ -74,10 +77,19 @@ QuantumOutput::QuantumOutput(QObject* p)
 QuantumOutput::~QuantumOutput()
 {
   delete m_cube;
+  clearOrbitalCubes();
 }
 
 void QuantumOutput::setMolecule(QtGui::Molecule* mol)
 {
+  if (mol != m_molecule) {
+    if (m_molecule)
+      m_molecule->disconnect(this);
+    m_orbitalCubesStale = true;
+    connect(mol, SIGNAL(changed(unsigned int)),
+            SLOT(moleculeChanged(unsigned int)), Qt::UniqueConnection);
+  }
+
   if (mol->basisSet()) {
     m_basis = mol->basisSet();
     m_actions[0]->setEnabled(true);
@@ -145,6 +157,21 @@ void QuantumOutput::calculateSurface(int index, float isosurfaceValue,
 
     m_isoValue = isosurfaceValue;
     m_cube->setLimits(*m_molecule, resolutionStepSize, 5.0);
+
+    // Orbitals calculated with an earlier selection are shown right away. No
+    // calculation is running, the button is only enabled once it is done.
+    if (m_orbitalCubesStale)
+      clearOrbitalCubes();
+    auto cached = m_orbitalCubes.find(index);
+    if (index > 0 && cached != m_orbitalCubes.end() &&
+        cached->second->min() == m_cube->min() &&
+        cached->second->spacing() == m_cube->spacing() &&
+        cached->second->dimensions() == m_cube->dimensions()) {
+      m_cube->setData(*cached->second->data());
+      displayCube();
+      return;
+    }
+
     QString progressText;
     if (index == 0) {
       if (dynamic_cast<GaussianSet*>(m_basis)) {
@@ -153,6 +180,10 @@ void QuantumOutput::calculateSurface(int index, float isosurfaceValue,
         m_concurrent2->calculateElectronDensity(m_cube);
       }
       progressText = tr("Calculating electron density");
+    } else if (m_dialog->neighboringOrbitals() > 0) {
+      calculateOrbitals(index, m_dialog->neighboringOrbitals());
+      progressText =
+        tr("Calculating molecular orbitals around %L1").arg(index - 1);
     } else {
       if (dynamic_cast<GaussianSet*>(m_basis)) {
         m_concurrent->calculateMolecularOrbital(m_cube, index - 1);
@@ -198,11 +229,44 @@ void QuantumOutput::calculateSurface(int index, float isosurfaceValue,
   }
 }
 
+void QuantumOutput::calculateOrbitals(int index, int neighbors)
+{
+  // The orbitals around the selected one are calculated in one sweep, the
+  // basis functions are evaluated once per point for all of them. Their cubes
+  // are kept, and reused for later batches. The selected orbital is copied
+  // to the displayed cube when the batch finishes.
+  int first = std::max(1, index - neighbors);
+  int last = std::min(static_cast<int>(m_basis->molecularOrbitalCount()),
+                      index + neighbors);
+  std::vector<Cube*> cubes;
+  std::vector<int> states;
+  for (int i = first; i <= last; ++i) {
+    Cube*& cube = m_orbitalCubes[i];
+    if (!cube)
+      cube = new Cube;
+    cube->setLimits(*m_cube);
+    cube->setName(tr("MO %L1").arg(i).toStdString());
+    cubes.push_back(cube);
+    states.push_back(i - 1);
+  }
+  m_batchCube = m_orbitalCubes[index];
+
+  if (dynamic_cast<GaussianSet*>(m_basis))
+    m_concurrent->calculateMolecularOrbitals(cubes, states);
+  else
+    m_concurrent2->calculateMolecularOrbitals(cubes, states);
+}
+
 void QuantumOutput::displayCube()
 {
   if (!m_cube)
     return;
 
+  if (m_batchCube) {
+    m_cube->setData(*m_batchCube->data());
+    m_batchCube = nullptr;
+  }
+
   if (!m_mesh1)
     m_mesh1 = m_molecule->addMesh();
   if (!m_meshGenerator1) {
@@ -227,5 +291,20 @@ void QuantumOutput::meshFinished()
   m_dialog->reenableCalculateButton();
   m_molecule->emitChanged(QtGui::Molecule::Added);
 }
+
+void QuantumOutput::moleculeChanged(unsigned int changes)
+{
+  // The orbitals move with the atoms.
+  if (changes & QtGui::Molecule::Atoms)
+    m_orbitalCubesStale = true;
+}
+
+void QuantumOutput::clearOrbitalCubes()
+{
+  for (auto it = m_orbitalCubes.begin(); it != m_orbitalCubes.end(); ++it)
+    delete it->second;
+  m_orbitalCubes.clear();
+  m_orbitalCubesStale = false;
+}
 }
 }
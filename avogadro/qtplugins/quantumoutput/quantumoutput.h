@@ -18,6 +18,10 @@
 
 #include <avogadro/qtgui/extensionplugin.h>
 
+#include <QtCore/QPointer>
+
+#include <map>
+
 class QAction;
 class QDialog;
 class QProgressDialog;
@@ -70,12 +74,17 @@ private slots:
                         float resolutionStepSize);
   void displayCube();
   void meshFinished();
+  void moleculeChanged(unsigned int changes);
 
 private:
+  void calculateOrbitals(int index, int neighbors);
+  void clearOrbitalCubes();
+
   QList<QAction*> m_actions;
   QProgressDialog* m_progressDialog;
 
-  QtGui::Molecule* m_molecule;
+  // The previous molecule may already be deleted when the next one is set.
+  QPointer<QtGui::Molecule> m_molecule;
   Core::BasisSet* m_basis;
 
   GaussianSetConcurrent* m_concurrent;
@@ -83,6 +92,14 @@ private:
 
   Core::Cube* m_cube;
   std::vector<Core::Cube*> m_cubes;
+  // The cubes of the orbitals calculated with their neighbors, by surface
+  // index, owned by the plugin. They are discarded before the next
+  // calculation once the molecule changes.
+  std::map<int, Core::Cube*> m_orbitalCubes;
+  bool m_orbitalCubesStale;
+  // The cube of the selected orbital in a batch, copied to m_cube when the
+  // batch finishes.
+  Core::Cube* m_batchCube;
   Core::Mesh* m_mesh1;
   Core::Mesh* m_mesh2;
   QtGui::MeshGenerator* m_meshGenerator1;
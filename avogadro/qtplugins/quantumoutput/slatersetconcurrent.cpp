@@ -25,6 +25,8 @@
 
 #include <QtConcurrent/QtConcurrentMap>
 
+#include <algorithm>
+
 namespace Avogadro {
 namespace QtPlugins {
 
@@ -32,12 +34,22 @@ using Core::SlaterSet;
 using Core::SlaterSetTools;
 using Core::Cube;
 
+namespace {
+// The points of a cube are calculated in chunks of this size, each chunk
+// evaluated in blocks by SlaterSetTools.
+const unsigned int chunkSize = 1024;
+}
+
 struct SlaterShell
 {
   SlaterSetTools* tools; // A pointer to the tools, cannot write to member vars
   Cube* tCube;           // The target cube, used to initialise temp cubes too
-  unsigned int pos;      // The index of the point to calculate the MO for
+  unsigned int begin;    // The first point of the chunk to calculate
+  unsigned int end;      // Past the last point of the chunk
   unsigned int state;    // The MO number to calculate
+
+  const std::vector<Cube*>* cubes; // The cubes of several orbitals
+  const std::vector<int>* states;  // The orbitals of the cubes
 };
 
 SlaterSetConcurrent::SlaterSetConcurrent(QObject* p)
@@ -66,6 +78,18 @@ bool SlaterSetConcurrent::calculateMolecularOrbital(Core::Cube* cube,
   return setUpCalculation(cube, state, SlaterSetConcurrent::processOrbital);
 }
 
+bool SlaterSetConcurrent::calculateMolecularOrbitals(
+  const std::vector<Core::Cube*>& cubes, const std::vector<int>& states)
+{
+  if (cubes.empty() || cubes.size() != states.size())
+    return false;
+
+  m_cubes = cubes;
+  m_states = states;
+  return setUpCalculation(cubes.front(), 0,
+                          SlaterSetConcurrent::processOrbitals);
+}
+
 bool SlaterSetConcurrent::calculateElectronDensity(Core::Cube* cube)
 {
   return setUpCalculation(cube, 0, SlaterSetConcurrent::processDensity);
@@ -80,6 +104,10 @@ void SlaterSetConcurrent::calculationComplete()
 {
   disconnect(&m_watcher, SIGNAL(finished()), this, SLOT(calculationComplete()));
   (*m_shells)[0].tCube->lock()->unlock();
+  for (size_t i = 1; i < m_cubes.size(); ++i)
+    m_cubes[i]->lock()->unlock();
+  m_cubes.clear();
+  m_states.clear();
   delete m_shells;
   m_shells = 0;
   emit finished();
@@ -93,18 +121,25 @@ bool SlaterSetConcurrent::setUpCalculation(Core::Cube* cube, unsigned int state,
 
   m_set->initCalculation();
 
-  // Set up the points we want to calculate the density at.
-  m_shells = new QVector<SlaterShell>(static_cast<int>(cube->data()->size()));
+  // Set up the chunks of points we want to calculate the density at.
+  unsigned int size = static_cast<unsigned int>(cube->data()->size());
+  int chunks = static_cast<int>((size + chunkSize - 1) / chunkSize);
+  m_shells = new QVector<SlaterShell>(chunks);
 
   for (int i = 0; i < m_shells->size(); ++i) {
     (*m_shells)[i].tools = m_tools;
     (*m_shells)[i].tCube = cube;
-    (*m_shells)[i].pos = i;
+    (*m_shells)[i].begin = i * chunkSize;
+    (*m_shells)[i].end = std::min(size, (i + 1) * chunkSize);
     (*m_shells)[i].state = state;
+    (*m_shells)[i].cubes = &m_cubes;
+    (*m_shells)[i].states = &m_states;
   }
 
   // Lock the cube until we are done.
   cube->lock()->lock();
+  for (size_t i = 1; i < m_cubes.size(); ++i)
+    m_cubes[i]->lock()->lock();
 
   // Watch for the future
   connect(&m_watcher, SIGNAL(finished()), this, SLOT(calculationComplete()));
@@ -119,21 +154,27 @@ bool SlaterSetConcurrent::setUpCalculation(Core::Cube* cube, unsigned int state,
 
 void SlaterSetConcurrent::processOrbital(SlaterShell& shell)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(
-    shell.pos, shell.tools->calculateMolecularOrbital(pos, shell.state));
+  shell.tools->calculateMolecularOrbital(*shell.tCube, shell.state, shell.begin,
+                                         shell.end);
+}
+
+void SlaterSetConcurrent::processOrbitals(SlaterShell& shell)
+{
+  shell.tools->calculateMolecularOrbitals(*shell.cubes, *shell.states,
+                                          shell.begin, shell.end);
 }
 
 void SlaterSetConcurrent::processDensity(SlaterShell& shell)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos, shell.tools->calculateElectronDensity(pos));
+  shell.tools->calculateElectronDensity(*shell.tCube, shell.begin, shell.end);
 }
 
 void SlaterSetConcurrent::processSpinDensity(SlaterShell& shell)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos, shell.tools->calculateSpinDensity(pos));
+  for (unsigned int i = shell.begin; i < shell.end; ++i) {
+    Vector3 pos = shell.tCube->position(i);
+    shell.tCube->setValue(i, shell.tools->calculateSpinDensity(pos));
+  }
 }
 }
 }
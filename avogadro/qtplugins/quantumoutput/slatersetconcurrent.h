@@ -21,6 +21,8 @@
 #include <QtCore/QFutureWatcher>
 #include <QtCore/QObject>
 
+#include <vector>
+
 namespace Avogadro {
 
 namespace Core {
@@ -51,6 +53,16 @@ public:
   void setMolecule(Core::Molecule* mol);
 
   bool calculateMolecularOrbital(Core::Cube* cube, unsigned int state);
+
+  /**
+   * Calculate several molecular orbitals in one sweep over the points, the
+   * basis functions are evaluated once per point for all of them.
+   * @param cubes The cubes, one per orbital, with the same limits.
+   * @param states The molecular orbital numbers.
+   */
+  bool calculateMolecularOrbitals(const std::vector<Core::Cube*>& cubes,
+                                  const std::vector<int>& states);
+
   bool calculateElectronDensity(Core::Cube* cube);
   bool calculateSpinDensity(Core::Cube* cube);
 
@@ -73,6 +85,8 @@ private:
   QFutureWatcher<void> m_watcher;
   Core::Cube* m_cube;
   QVector<SlaterShell>* m_shells;
+  std::vector<Core::Cube*> m_cubes; // The cubes of several orbitals
+  std::vector<int> m_states;        // The orbitals of the cubes
 
   Core::SlaterSet* m_set;
   Core::SlaterSetTools* m_tools;
@@ -81,6 +95,7 @@ private:
                         void (*func)(SlaterShell&));
 
   static void processOrbital(SlaterShell& shell);
+  static void processOrbitals(SlaterShell& shell);
   static void processDensity(SlaterShell& shell);
   static void processSpinDensity(SlaterShell& shell);
 };
@@ -91,6 +91,7 @@ void SurfaceDialog::setupBasis(int numElectrons, int numMOs)
 
   m_ui->resolutionCombo->setEnabled(true);
   m_ui->isosurfaceLineEdit->setEnabled(true);
+  m_ui->neighborsSpinBox->setEnabled(true);
   m_ui->calculateButton->setEnabled(true);
 }
 
@@ -107,6 +108,7 @@ void SurfaceDialog::setupCube(int numCubes)
   }
   m_ui->surfaceCombo->setCurrentIndex(0);
 
+  m_ui->neighborsSpinBox->setEnabled(false);
   m_ui->isosurfaceLineEdit->setEnabled(true);
   m_ui->calculateButton->setEnabled(true);
 }
@@ -126,5 +128,10 @@ void SurfaceDialog::reenableCalculateButton()
   m_ui->calculateButton->setEnabled(true);
 }
 
+int SurfaceDialog::neighboringOrbitals() const
+{
+  return m_ui->neighborsSpinBox->value();
+}
+
 } // End namespace QtPlugins
 } // End namespace Avogadro
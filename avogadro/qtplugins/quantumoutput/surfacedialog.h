@@ -43,6 +43,12 @@ public:
   void setupCube(int numCubes);
   void reenableCalculateButton();
 
+  /**
+   * @return The number of orbitals below and above the selected one to
+   * calculate with it.
+   */
+  int neighboringOrbitals() const;
+
 public slots:
 
 protected slots:
@@ -0,0 +1,77 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "structureanalysis.h"
+
+#include "structureanalysisdialog.h"
+
+#include <QtWidgets/QAction>
+
+#include <QtCore/QStringList>
+
+namespace Avogadro {
+namespace QtPlugins {
+
+StructureAnalysis::StructureAnalysis(QObject* parent_)
+  : Avogadro::QtGui::ExtensionPlugin(parent_), m_action(new QAction(this)),
+    m_dialog(nullptr), m_molecule(nullptr)
+{
+  m_action->setEnabled(true);
+  m_action->setText(tr("&Radial Distribution..."));
+  connect(m_action, SIGNAL(triggered()), SLOT(showDialog()));
+}
+
+StructureAnalysis::~StructureAnalysis()
+{
+}
+
+QString StructureAnalysis::description() const
+{
+  return tr("Compute radial distribution functions, coordination numbers "
+            "and mean-square displacements.");
+}
+
+QList<QAction*> StructureAnalysis::actions() const
+{
+  return QList<QAction*>() << m_action;
+}
+
+QStringList StructureAnalysis::menuPath(QAction*) const
+{
+  return QStringList() << tr("&Extensions");
+}
+
+void StructureAnalysis::setMolecule(QtGui::Molecule* mol)
+{
+  if (mol == m_molecule)
+    return;
+
+  m_molecule = mol;
+  if (m_dialog)
+    m_dialog->setMolecule(m_molecule);
+}
+
+void StructureAnalysis::showDialog()
+{
+  if (!m_dialog) {
+    m_dialog = new StructureAnalysisDialog(
+      m_molecule, qobject_cast<QWidget*>(this->parent()));
+  }
+  m_dialog->show();
+}
+
+} // namespace QtPlugins
+} // namespace Avogadro
@@ -0,0 +1,57 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_QTPLUGINS_STRUCTUREANALYSIS_H
+#define AVOGADRO_QTPLUGINS_STRUCTUREANALYSIS_H
+
+#include <avogadro/qtgui/extensionplugin.h>
+
+namespace Avogadro {
+namespace QtPlugins {
+class StructureAnalysisDialog;
+
+/**
+ * @brief The StructureAnalysis class is an extension to launch a
+ * StructureAnalysisDialog.
+ */
+class StructureAnalysis : public Avogadro::QtGui::ExtensionPlugin
+{
+  Q_OBJECT
+public:
+  explicit StructureAnalysis(QObject* parent_ = 0);
+  ~StructureAnalysis();
+
+  QString name() const { return tr("Structure Analysis"); }
+  QString description() const;
+  QList<QAction*> actions() const;
+  QStringList menuPath(QAction*) const;
+
+public slots:
+  void setMolecule(QtGui::Molecule* mol);
+
+private slots:
+  void showDialog();
+
+private:
+  QAction* m_action;
+  StructureAnalysisDialog* m_dialog;
+  QtGui::Molecule* m_molecule;
+};
+
+} // namespace QtPlugins
+} // namespace Avogadro
+
+#endif // AVOGADRO_QTPLUGINS_STRUCTUREANALYSIS_H
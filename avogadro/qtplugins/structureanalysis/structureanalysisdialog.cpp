@@ -0,0 +1,253 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "structureanalysisdialog.h"
+#include "ui_structureanalysisdialog.h"
+
+#include <avogadro/core/elements.h>
+#include <avogadro/core/structureanalysis.h>
+#include <avogadro/qtgui/molecule.h>
+
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
+#include <QtWidgets/QFileDialog>
+#include <QtWidgets/QMessageBox>
+#include <QtWidgets/QTableWidgetItem>
+
+#include <vector>
+
+using Avogadro::Core::Elements;
+using Avogadro::Core::StructureAnalysis;
+
+namespace Avogadro {
+namespace QtPlugins {
+
+namespace {
+// The quantities of the combo box, other than the pairs of elements.
+const int allAtoms = -1;
+const int displacement = -2;
+
+QSharedPointer<StructureAnalysis> runAnalysis(
+  QSharedPointer<Core::Molecule> mol,
+  QSharedPointer<StructureAnalysis> analysis)
+{
+  if (!analysis->analyze(*mol))
+    analysis.clear();
+  return analysis;
+}
+
+QString pairName(unsigned char a, unsigned char b)
+{
+  return QString("%1-%2").arg(Elements::symbol(a)).arg(Elements::symbol(b));
+}
+}
+
+StructureAnalysisDialog::StructureAnalysisDialog(QtGui::Molecule* mol,
+                                                 QWidget* parent_)
+  : QDialog(parent_), m_molecule(nullptr),
+    m_ui(new Ui::StructureAnalysisDialog)
+{
+  m_ui->setupUi(this);
+
+  connect(m_ui->computeButton, SIGNAL(clicked()), SLOT(compute()));
+  connect(m_ui->saveButton, SIGNAL(clicked()), SLOT(save()));
+  connect(m_ui->quantityCombo, SIGNAL(currentIndexChanged(int)),
+          SLOT(showResults()));
+  connect(&m_watcher, SIGNAL(finished()), SLOT(analysisFinished()));
+  m_ui->saveButton->setEnabled(false);
+
+  setMolecule(mol);
+}
+
+StructureAnalysisDialog::~StructureAnalysisDialog()
+{
+  m_watcher.waitForFinished();
+  delete m_ui;
+}
+
+void StructureAnalysisDialog::setMolecule(QtGui::Molecule* mol)
+{
+  if (mol == m_molecule)
+    return;
+
+  if (m_molecule)
+    m_molecule->disconnect(this);
+
+  m_molecule = mol;
+  m_ui->computeButton->setEnabled(m_molecule && !m_watcher.isRunning());
+
+  if (!m_molecule)
+    return;
+
+  connect(m_molecule, SIGNAL(changed(unsigned int)), SLOT(moleculeChanged()));
+  connect(m_molecule, SIGNAL(destroyed()), SLOT(moleculeDestroyed()));
+  moleculeChanged();
+}
+
+void StructureAnalysisDialog::compute()
+{
+  if (!m_molecule || m_watcher.isRunning())
+    return;
+
+  // Analyze a copy, the molecule may be edited in the meantime.
+  QSharedPointer<Core::Molecule> copy(new Core::Molecule(*m_molecule));
+  QSharedPointer<StructureAnalysis> analysis(new StructureAnalysis);
+  analysis->setCutoff(m_ui->cutoffSpinBox->value());
+  analysis->setBinWidth(m_ui->binWidthSpinBox->value());
+
+  m_ui->computeButton->setEnabled(false);
+  m_ui->statusLabel->setText(tr("Computing..."));
+  m_watcher.setFuture(QtConcurrent::run(&runAnalysis, copy, analysis));
+}
+
+void StructureAnalysisDialog::analysisFinished()
+{
+  m_ui->computeButton->setEnabled(m_molecule != nullptr);
+  m_analysis = m_watcher.result();
+  if (!m_analysis) {
+    m_ui->statusLabel->setText(tr("The analysis failed, the molecule has no "
+                                  "atoms or a frame is incomplete."));
+    m_ui->saveButton->setEnabled(false);
+    m_ui->resultsTable->clear();
+    return;
+  }
+
+  // Keep the selected quantity if it is still available.
+  QVariant selected = m_ui->quantityCombo->currentData();
+  m_ui->quantityCombo->blockSignals(true);
+  m_ui->quantityCombo->clear();
+  m_ui->quantityCombo->addItem(tr("g(r) of all atoms"), allAtoms);
+  const std::vector<unsigned char>& elements = m_analysis->elements();
+  for (size_t i = 0; i < elements.size(); ++i) {
+    for (size_t j = i; j < elements.size(); ++j) {
+      m_ui->quantityCombo->addItem(
+        tr("g(r) of %1").arg(pairName(elements[i], elements[j])),
+        elements[i] << 8 | elements[j]);
+    }
+  }
+  m_ui->quantityCombo->addItem(tr("Mean-square displacement"), displacement);
+  int index = m_ui->quantityCombo->findData(selected);
+  m_ui->quantityCombo->setCurrentIndex(index >= 0 ? index : 0);
+  m_ui->quantityCombo->blockSignals(false);
+
+  int frames = static_cast<int>(m_analysis->frameCount());
+  m_ui->statusLabel->setText(tr("%n frame(s) analyzed.", "", frames));
+  m_ui->saveButton->setEnabled(true);
+  showResults();
+}
+
+void StructureAnalysisDialog::showResults()
+{
+  m_ui->resultsTable->clear();
+  if (!m_analysis)
+    return;
+
+  QStringList headers;
+  std::vector<std::vector<Real>> columns;
+  std::vector<Real> first;
+  int quantity = m_ui->quantityCombo->currentData().toInt();
+  if (quantity == displacement) {
+    headers << tr("Frame") << tr("MSD (Å²)");
+    for (Index f = 0; f < m_analysis->frameCount(); ++f)
+      first.push_back(static_cast<Real>(f));
+    columns.push_back(first);
+    columns.push_back(m_analysis->msd());
+    const std::vector<unsigned char>& elements = m_analysis->elements();
+    for (size_t i = 0; i < elements.size(); ++i) {
+      headers << tr("MSD %1 (Å²)").arg(Elements::symbol(elements[i]));
+      columns.push_back(m_analysis->msd(elements[i]));
+    }
+  } else {
+    headers << tr("r (Å)") << tr("g(r)");
+    for (Index bin = 0; bin < m_analysis->binCount(); ++bin)
+      first.push_back(m_analysis->binCenter(bin));
+    columns.push_back(first);
+    if (quantity == allAtoms) {
+      columns.push_back(m_analysis->rdf());
+    } else {
+      unsigned char a = static_cast<unsigned char>(quantity >> 8);
+      unsigned char b = static_cast<unsigned char>(quantity & 0xff);
+      columns.push_back(m_analysis->rdf(a, b));
+      headers << tr("n(r) %1").arg(pairName(a, b));
+      columns.push_back(m_analysis->coordination(a, b));
+      if (a != b) {
+        headers << tr("n(r) %1").arg(pairName(b, a));
+        columns.push_back(m_analysis->coordination(b, a));
+      }
+    }
+  }
+
+  m_ui->resultsTable->setColumnCount(headers.size());
+  m_ui->resultsTable->setRowCount(static_cast<int>(first.size()));
+  m_ui->resultsTable->setHorizontalHeaderLabels(headers);
+  for (size_t c = 0; c < columns.size(); ++c) {
+    for (size_t row = 0; row < columns[c].size(); ++row) {
+      QString text = c == 0 && quantity == displacement
+                       ? QString::number(row)
+                       : QString::number(columns[c][row], 'f', 4);
+      m_ui->resultsTable->setItem(static_cast<int>(row), static_cast<int>(c),
+                                  new QTableWidgetItem(text));
+    }
+  }
+}
+
+void StructureAnalysisDialog::save()
+{
+  QString fileName = QFileDialog::getSaveFileName(
+    this, tr("Save Analysis"), QString(),
+    tr("Comma-separated values (*.csv);;All files (*)"));
+  if (fileName.isEmpty())
+    return;
+
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    QMessageBox::warning(this, tr("Save Analysis"),
+                         tr("Cannot write to %1.").arg(fileName));
+    return;
+  }
+
+  QTextStream out(&file);
+  QStringList row;
+  for (int c = 0; c < m_ui->resultsTable->columnCount(); ++c)
+    row << m_ui->resultsTable->horizontalHeaderItem(c)->text();
+  out << row.join(",") << "\n";
+  for (int r = 0; r < m_ui->resultsTable->rowCount(); ++r) {
+    row.clear();
+    for (int c = 0; c < m_ui->resultsTable->columnCount(); ++c) {
+      QTableWidgetItem* item = m_ui->resultsTable->item(r, c);
+      row << (item ? item->text() : QString());
+    }
+    out << row.join(",") << "\n";
+  }
+}
+
+void StructureAnalysisDialog::moleculeChanged()
+{
+  if (m_analysis) {
+    m_ui->statusLabel->setText(
+      tr("The molecule changed, compute again to update the results."));
+  }
+}
+
+void StructureAnalysisDialog::moleculeDestroyed()
+{
+  m_molecule = nullptr;
+  m_ui->computeButton->setEnabled(false);
+}
+
+} // namespace QtPlugins
+} // namespace Avogadro
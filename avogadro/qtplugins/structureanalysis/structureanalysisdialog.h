@@ -0,0 +1,78 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_QTPLUGINS_STRUCTUREANALYSISDIALOG_H
+#define AVOGADRO_QTPLUGINS_STRUCTUREANALYSISDIALOG_H
+
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QSharedPointer>
+#include <QtWidgets/QDialog>
+
+namespace Avogadro {
+
+namespace Core {
+class StructureAnalysis;
+}
+
+namespace QtGui {
+class Molecule;
+}
+
+namespace QtPlugins {
+
+namespace Ui {
+class StructureAnalysisDialog;
+}
+
+/**
+ * @brief The StructureAnalysisDialog class computes the radial distribution
+ * functions, coordination numbers and mean-square displacement over the
+ * frames of a molecule, and shows them in a table that can be saved.
+ *
+ * The analysis runs on a copy of the molecule in the background.
+ */
+class StructureAnalysisDialog : public QDialog
+{
+  Q_OBJECT
+
+public:
+  explicit StructureAnalysisDialog(QtGui::Molecule* mol, QWidget* parent_ = 0);
+  ~StructureAnalysisDialog() override;
+
+public slots:
+  void setMolecule(QtGui::Molecule* mol);
+
+private slots:
+  void compute();
+  void analysisFinished();
+  void showResults();
+  void save();
+  void moleculeChanged();
+  void moleculeDestroyed();
+
+private:
+  typedef QSharedPointer<Core::StructureAnalysis> AnalysisPtr;
+
+  QtGui::Molecule* m_molecule;
+  Ui::StructureAnalysisDialog* m_ui;
+  QFutureWatcher<AnalysisPtr> m_watcher;
+  AnalysisPtr m_analysis;
+};
+
+} // namespace QtPlugins
+} // namespace Avogadro
+
+#endif // AVOGADRO_QTPLUGINS_STRUCTUREANALYSISDIALOG_H
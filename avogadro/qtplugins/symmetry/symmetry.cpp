@@ -43,10 +43,10 @@ namespace QtPlugins {
 
 Symmetry::Symmetry(QObject* parent_)
   : Avogadro::QtGui::ExtensionPlugin(parent_), m_molecule(NULL),
-    m_symmetryWidget(nullptr), m_viewSymmetryAction(new QAction(this))
+    m_symmetryWidget(nullptr), m_viewSymmetryAction(new QAction(this)),
+    m_detector(new SymmetryDetector(this))
 {
-
-  m_ctx = msymCreateContext();
+  connect(m_detector, SIGNAL(finished()), SLOT(symmetryDetected()));
 
   m_viewSymmetryAction->setText(tr("Symmetry Properties..."));
   connect(m_viewSymmetryAction, SIGNAL(triggered()), SLOT(viewSymmetry()));
@@ -76,10 +76,6 @@ Symmetry::~Symmetry()
 
   qDeleteAll(m_actions);
   m_actions.clear();
-
-  if (m_ctx != NULL) {
-    msymReleaseContext(m_ctx);
-  }
 }
 
 QList<QAction*> Symmetry::actions() const
@@ -101,6 +97,7 @@ void Symmetry::setMolecule(QtGui::Molecule* mol)
     m_molecule->disconnect(this);
 
   m_molecule = mol;
+  cancelDetection();
   if (m_symmetryWidget)
     m_symmetryWidget->setMolecule(m_molecule);
 
@@ -165,6 +162,10 @@ void Symmetry::viewSymmetry()
     m_symmetryWidget = new SymmetryWidget(qobject_cast<QWidget*>(parent()));
     m_symmetryWidget->setMolecule(m_molecule);
     connect(m_symmetryWidget, SIGNAL(detectSymmetry()), SLOT(detectSymmetry()));
+    connect(m_symmetryWidget, SIGNAL(cancelDetection()),
+            SLOT(cancelDetection()));
+    connect(m_detector, SIGNAL(progress(int, int)), m_symmetryWidget,
+            SLOT(setDetectionProgress(int, int)));
     connect(m_symmetryWidget, SIGNAL(symmetrizeMolecule()),
             SLOT(symmetrizeMolecule()));
   }
@@ -177,149 +178,74 @@ void Symmetry::viewSymmetry()
 
 void Symmetry::detectSymmetry()
 {
+  if (m_molecule == NULL || m_symmetryWidget == NULL)
+    return;
 
   unsigned int length = m_molecule->atomCount();
-
-  if (m_molecule == NULL || m_molecule->atomPositions3d().size() != length ||
-      length < 2)
-    return; // if one atom = Kh
+  if (m_molecule->atomPositions3d().size() != length || length < 1)
+    return;
 
   if (length == 1) {
+    m_detector->cancel();
+    m_symmetryWidget->setDetecting(false);
     m_symmetryWidget->setPointGroupSymbol(QString("K<sub>h</sub>"));
-    return;
-  }
-
-  // interface with libmsym
-  msym_error_t ret = MSYM_SUCCESS;
-  msym_element_t* elements = NULL;
-  const char* error = NULL;
-  char point_group[6];
-  double cm[3], radius = 0.0, symerr = 0.0;
-
-  /* Do not free these variables */
-  msym_symmetry_operation_t* msops = NULL;
-  msym_subgroup_t* msg = NULL;
-  int msgl = 0, msopsl = 0, mlength = 0;
-
-  // initialize the c-style array of atom names and coordinates
-  msym_element_t* a;
-  a = (msym_element_t*)malloc(length * sizeof(msym_element_t));
-  memset(a, 0, length * sizeof(msym_element_t));
-
-  for (Index i = 0; i < length; ++i) {
-    Vector3 ipos = m_molecule->atomPositions3d()[i];
-    a[i].n = m_molecule->atomicNumbers()[i];
-    a[i].v[0] = ipos[0];
-    a[i].v[1] = ipos[1];
-    a[i].v[2] = ipos[2];
-  }
-  elements = a;
-
-  if (m_ctx != NULL) {
-    msymReleaseContext(m_ctx);
-    m_ctx = msymCreateContext();
-  }
-
-  // Set the thresholds
-  // switch (m_dock->toleranceCombo->currentIndex()) {
-  msym_thresholds_t* thresholds = m_symmetryWidget->getThresholds();
-  msymSetThresholds(m_ctx, thresholds);
-
-  // At any point, we'll set the text to NULL which will use C1 instead
-
-  if (MSYM_SUCCESS != (ret = msymSetElements(m_ctx, length, elements))) {
-    free(elements);
-    m_symmetryWidget->setPointGroupSymbol(pointGroupSymbol(0));
     m_symmetryWidget->setSymmetryOperations(0, NULL);
     m_symmetryWidget->setSubgroups(0, NULL);
-    qDebug() << "Error:" << msymErrorString(ret) << " "
-             << msymGetErrorDetails();
+    m_result.clear();
+    m_dirty = false;
     return;
   }
 
-  if (MSYM_SUCCESS != (ret = msymFindSymmetry(m_ctx))) {
-    free(elements);
-    m_symmetryWidget->setPointGroupSymbol(pointGroupSymbol(0));
-    m_symmetryWidget->setSymmetryOperations(0, NULL);
-    m_symmetryWidget->setSubgroups(0, NULL);
-    qDebug() << "Error:" << msymErrorString(ret) << " "
-             << msymGetErrorDetails();
-    return;
-  }
+  // libmsym runs on a worker thread, unless the result for this geometry is
+  // cached, in which case symmetryDetected() is called right away.
+  m_symmetryWidget->setDetecting(true);
+  m_detector->detect(*m_molecule, *m_symmetryWidget->getThresholds());
+}
 
-  /* Get the point group name */
-  if (MSYM_SUCCESS !=
-      (ret = msymGetPointGroupName(m_ctx, sizeof(char[6]), point_group))) {
-    free(elements);
-    m_symmetryWidget->setPointGroupSymbol(pointGroupSymbol(0));
-    m_symmetryWidget->setSymmetryOperations(0, NULL);
-    m_symmetryWidget->setSubgroups(0, NULL);
-    qDebug() << "Error:" << msymErrorString(ret) << " "
-             << msymGetErrorDetails();
+void Symmetry::cancelDetection()
+{
+  m_detector->cancel();
+  if (!m_symmetryWidget)
     return;
-  }
+  m_symmetryWidget->setDetecting(false);
+  m_symmetryWidget->setPointGroupSymbol(
+    m_result && m_result->valid ? pointGroupSymbol(m_result->pointGroup)
+                                : QString());
+}
 
-  if (MSYM_SUCCESS !=
-      (ret = msymGetSymmetryOperations(m_ctx, &msopsl, &msops))) {
-    free(elements);
-    m_symmetryWidget->setPointGroupSymbol(pointGroupSymbol(0));
-    m_symmetryWidget->setSymmetryOperations(0, NULL);
-    m_symmetryWidget->setSubgroups(0, NULL);
-    qDebug() << "Error:" << msymErrorString(ret) << " "
-             << msymGetErrorDetails();
+void Symmetry::symmetryDetected()
+{
+  if (!m_molecule || !m_symmetryWidget)
     return;
-  }
 
-  if (MSYM_SUCCESS != (ret = msymGetCenterOfMass(m_ctx, cm))) {
-    free(elements);
-    m_symmetryWidget->setPointGroupSymbol(pointGroupSymbol(0));
-    m_symmetryWidget->setSymmetryOperations(0, NULL);
-    m_symmetryWidget->setSubgroups(0, NULL);
-    qDebug() << "Error:" << msymErrorString(ret) << " "
-             << msymGetErrorDetails();
-    return;
-  }
+  // Keep the previous result alive until the widget no longer points into it.
+  SymmetryResultPtr previous = m_result;
+  m_result = m_detector->result();
+  m_symmetryWidget->setDetecting(false);
 
-  if (MSYM_SUCCESS != (ret = msymGetRadius(m_ctx, &radius))) {
-    free(elements);
+  // At any point, we'll set the text to NULL which will use C1 instead
+  if (!m_result->valid) {
     m_symmetryWidget->setPointGroupSymbol(pointGroupSymbol(0));
     m_symmetryWidget->setSymmetryOperations(0, NULL);
     m_symmetryWidget->setSubgroups(0, NULL);
-    qDebug() << "Error:" << msymErrorString(ret) << " "
-             << msymGetErrorDetails();
-    return;
-  }
-
-  if (point_group[1] != '0') {
-    if (MSYM_SUCCESS != (ret = msymGetSubgroups(m_ctx, &msgl, &msg))) {
-      free(elements);
-      m_symmetryWidget->setPointGroupSymbol(pointGroupSymbol(0));
-      m_symmetryWidget->setSymmetryOperations(0, NULL);
-      m_symmetryWidget->setSubgroups(0, NULL);
-      qDebug() << "Error:" << msymErrorString(ret) << " "
-               << msymGetErrorDetails();
-      return;
-    }
   } else {
-    m_symmetryWidget->setSubgroups(0, NULL);
+    m_symmetryWidget->setPointGroupSymbol(
+      pointGroupSymbol(m_result->pointGroup));
+    m_symmetryWidget->setSymmetryOperations(m_result->operationCount,
+                                            m_result->operations);
+    m_symmetryWidget->setSubgroups(m_result->subgroupCount,
+                                   m_result->subgroups);
+    m_symmetryWidget->setCenterOfMass(m_result->centerOfMass);
+    m_symmetryWidget->setRadius(m_result->radius);
+    qDebug() << "detected symmetry" << m_result->pointGroup;
   }
 
-  // TODO: Subgroups
-  // if(MSYM_SUCCESS != (ret = msymGetSubgroups(ctx, &msgl, &msg))) goto err;
-  //    printf("Found point group [0] %s select subgroup\n",point_group);
-  // for(int i = 0; i < msgl;i++) printf("\t [%d] %s\n",i+1,msg[i].name);
-
-  m_symmetryWidget->setPointGroupSymbol(pointGroupSymbol(point_group));
-  m_symmetryWidget->setSymmetryOperations(msopsl, msops);
-  m_symmetryWidget->setSubgroups(msgl, msg);
-  m_symmetryWidget->setCenterOfMass(cm);
-  m_symmetryWidget->setRadius(radius);
-  // m_symmetryWidget->m_ui->pointGroupLabel->setText(pgSymbol(point_group));
-
-  qDebug() << "detected symmetry" << point_group;
-
-  free(elements);
-  m_dirty = false;
+  // The molecule may have changed while libmsym was running.
+  m_dirty = m_result->key !=
+            SymmetryDetector::key(*m_molecule,
+                                  *m_symmetryWidget->getThresholds());
+  if (m_dirty && m_symmetryWidget->isVisible())
+    detectSymmetry();
 }
 
 void Symmetry::symmetrizeMolecule()
@@ -331,16 +257,23 @@ void Symmetry::symmetrizeMolecule()
       length < 2)
     return; // if one atom = Kh
 
+  // The detected symmetry must belong to the current geometry.
+  if (!m_result || !m_result->valid || m_dirty || m_detector->isRunning())
+    return;
+
   msym_element_t* melements = NULL;
   int mlength = 0;
   double symerr = 0.0;
   msym_error_t ret = MSYM_SUCCESS;
+  msym_context ctx = m_result->context;
+
+  // The context no longer matches the geometry it was cached for.
+  m_detector->uncache(m_result);
 
-  // detectSymmetry();
-  if (MSYM_SUCCESS != (ret = msymSymmetrizeElements(m_ctx, &symerr)))
+  if (MSYM_SUCCESS != (ret = msymSymmetrizeElements(ctx, &symerr)))
     return;
 
-  if (MSYM_SUCCESS != (ret = msymGetElements(m_ctx, &mlength, &melements)))
+  if (MSYM_SUCCESS != (ret = msymGetElements(ctx, &mlength, &melements)))
     return;
 
   if (mlength != length)
@@ -19,6 +19,7 @@
 
 #include <avogadro/qtgui/extensionplugin.h>
 
+#include "symmetrydetector.h"
 #include "symmetrywidget.h"
 
 namespace msym {
@@ -58,6 +59,10 @@ private slots:
 
   void detectSymmetry();
 
+  void cancelDetection();
+
+  void symmetryDetected();
+
   void symmetrizeMolecule();
 
 private:
@@ -67,7 +72,9 @@ private:
 
   QAction* m_viewSymmetryAction;
 
-  msym::msym_context m_ctx;
+  SymmetryDetector* m_detector;
+  // The result shown, the widget points into its context.
+  SymmetryResultPtr m_result;
 
   bool m_dirty = true;
 };
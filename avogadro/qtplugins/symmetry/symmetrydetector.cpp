@@ -0,0 +1,235 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "symmetrydetector.h"
+
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/vector.h>
+
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDebug>
+
+#include <cstring>
+
+using Avogadro::Core::Molecule;
+
+using namespace msym;
+
+namespace Avogadro {
+namespace QtPlugins {
+
+namespace {
+// The number of geometries whose results are kept.
+const int maxCachedResults = 8;
+}
+
+SymmetryResult::SymmetryResult()
+  : valid(false), context(NULL), operations(NULL), operationCount(0),
+    subgroups(NULL), subgroupCount(0), radius(0.0)
+{
+  pointGroup[0] = '\0';
+  centerOfMass[0] = centerOfMass[1] = centerOfMass[2] = 0.0;
+}
+
+SymmetryResult::~SymmetryResult()
+{
+  if (context != NULL)
+    msymReleaseContext(context);
+}
+
+SymmetryDetector::SymmetryDetector(QObject* parent_)
+  : QObject(parent_), m_jobCount(0), m_running(false)
+{
+  connect(&m_watcher, SIGNAL(finished()), SLOT(detectionFinished()));
+}
+
+SymmetryDetector::~SymmetryDetector()
+{
+  // The workers report their progress to this object, wait for them.
+  cancel();
+  foreach (QFuture<SymmetryResultPtr> future, m_futures)
+    future.waitForFinished();
+}
+
+QByteArray SymmetryDetector::key(const Molecule& mol,
+                                 const msym_thresholds_t& thresholds)
+{
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  Index count = mol.atomCount();
+  hash.addData(reinterpret_cast<const char*>(&count), sizeof(count));
+  if (count > 0 && mol.atomPositions3d().size() == count) {
+    hash.addData(reinterpret_cast<const char*>(mol.atomicNumbers().data()),
+                 static_cast<int>(count));
+    hash.addData(
+      reinterpret_cast<const char*>(mol.atomPositions3d().data()),
+      static_cast<int>(count * sizeof(Vector3)));
+  }
+  hash.addData(reinterpret_cast<const char*>(&thresholds), sizeof(thresholds));
+  return hash.result();
+}
+
+void SymmetryDetector::detect(const Molecule& mol,
+                              const msym_thresholds_t& thresholds)
+{
+  cancel();
+
+  QByteArray resultKey = key(mol, thresholds);
+  for (int i = 0; i < m_cache.size(); ++i) {
+    if (m_cache[i]->key == resultKey) {
+      m_cache.move(i, 0);
+      finish(m_cache.front());
+      return;
+    }
+  }
+
+  // Copy the geometry, the molecule may change while the worker runs.
+  QSharedPointer<Job> job(new Job);
+  job->id = ++m_jobCount;
+  job->key = resultKey;
+  job->thresholds = thresholds;
+  Index count = mol.atomCount();
+  job->elements.resize(static_cast<int>(count));
+  memset(job->elements.data(), 0, count * sizeof(msym_element_t));
+  for (Index i = 0; i < count; ++i) {
+    const Vector3& pos = mol.atomPositions3d()[i];
+    job->elements[i].n = mol.atomicNumbers()[i];
+    job->elements[i].v[0] = pos[0];
+    job->elements[i].v[1] = pos[1];
+    job->elements[i].v[2] = pos[2];
+  }
+
+  // Forget the abandoned detections that are done by now.
+  for (int i = m_futures.size() - 1; i >= 0; --i) {
+    if (m_futures[i].isFinished())
+      m_futures.removeAt(i);
+  }
+
+  m_job = job;
+  m_running = true;
+  QFuture<SymmetryResultPtr> future =
+    QtConcurrent::run(&SymmetryDetector::run, this, job);
+  m_futures.append(future);
+  m_watcher.setFuture(future);
+}
+
+void SymmetryDetector::cancel()
+{
+  if (m_job)
+    m_job->canceled.storeRelease(1);
+  m_job.clear();
+  m_running = false;
+}
+
+void SymmetryDetector::uncache(const SymmetryResultPtr& result)
+{
+  m_cache.removeAll(result);
+}
+
+void SymmetryDetector::reportProgress(int job, int step)
+{
+  if (m_job && m_job->id == job)
+    emit progress(step, stepCount);
+}
+
+void SymmetryDetector::detectionFinished()
+{
+  if (!m_job)
+    return;
+  SymmetryResultPtr detected = m_watcher.result();
+  m_job.clear();
+  if (!detected)
+    return;
+
+  m_cache.prepend(detected);
+  while (m_cache.size() > maxCachedResults)
+    m_cache.removeLast();
+  finish(detected);
+}
+
+void SymmetryDetector::finish(const SymmetryResultPtr& result)
+{
+  m_running = false;
+  m_result = result;
+  emit finished();
+}
+
+SymmetryResultPtr SymmetryDetector::run(SymmetryDetector* detector,
+                                        QSharedPointer<Job> job)
+{
+  SymmetryResultPtr result(new SymmetryResult);
+  result->key = job->key;
+  result->context = msymCreateContext();
+  msym_context ctx = result->context;
+  msymSetThresholds(ctx, &job->thresholds);
+
+  msym_error_t ret = MSYM_SUCCESS;
+  for (int step = 1; step <= stepCount && ret == MSYM_SUCCESS; ++step) {
+    switch (step) {
+      case 1:
+        ret = msymSetElements(ctx, job->elements.size(), job->elements.data());
+        break;
+      case 2:
+        ret = msymFindSymmetry(ctx);
+        break;
+      case 3:
+        if (MSYM_SUCCESS != (ret = msymGetPointGroupName(
+                               ctx, sizeof(char[6]), result->pointGroup)))
+          break;
+        if (MSYM_SUCCESS !=
+            (ret = msymGetSymmetryOperations(ctx, &result->operationCount,
+                                             &result->operations)))
+          break;
+        if (MSYM_SUCCESS != (ret = msymGetCenterOfMass(ctx,
+                                                       result->centerOfMass)))
+          break;
+        ret = msymGetRadius(ctx, &result->radius);
+        break;
+      case 4:
+        if (result->pointGroup[1] != '0') {
+          ret = msymGetSubgroups(ctx, &result->subgroupCount,
+                                 &result->subgroups);
+        }
+        break;
+    }
+
+    // Stop between the steps if the detection was abandoned.
+    if (job->canceled.loadAcquire())
+      return SymmetryResultPtr();
+    if (ret == MSYM_SUCCESS) {
+      QMetaObject::invokeMethod(detector, "reportProgress",
+                                Qt::QueuedConnection, Q_ARG(int, job->id),
+                                Q_ARG(int, step));
+    }
+  }
+
+  if (ret != MSYM_SUCCESS) {
+    result->error =
+      QString("%1 %2").arg(msymErrorString(ret), msymGetErrorDetails());
+    qDebug() << "Error:" << result->error;
+    result->operations = NULL;
+    result->operationCount = 0;
+    result->subgroups = NULL;
+    result->subgroupCount = 0;
+    return result;
+  }
+
+  result->valid = true;
+  return result;
+}
+
+} // namespace QtPlugins
+} // namespace Avogadro
@@ -0,0 +1,169 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_QTPLUGINS_SYMMETRYDETECTOR_H
+#define AVOGADRO_QTPLUGINS_SYMMETRYDETECTOR_H
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
+#include <QtCore/QFuture>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+namespace msym {
+extern "C" {
+#include <libmsym/msym.h>
+}
+}
+
+namespace Avogadro {
+
+namespace Core {
+class Molecule;
+}
+
+namespace QtPlugins {
+
+/**
+ * @brief The SymmetryResult class holds the point group found for a
+ * geometry, along with the libmsym context its operations and subgroups
+ * point into.
+ */
+class SymmetryResult
+{
+public:
+  SymmetryResult();
+  ~SymmetryResult();
+
+  /** The geometry and thresholds the result was found for. */
+  QByteArray key;
+  /** False if libmsym failed, see error. */
+  bool valid;
+  QString error;
+
+  msym::msym_context context;
+  char pointGroup[6];
+  msym::msym_symmetry_operation_t* operations;
+  int operationCount;
+  msym::msym_subgroup_t* subgroups;
+  int subgroupCount;
+  double centerOfMass[3];
+  double radius;
+
+private:
+  // Non-copyable, owns the context.
+  SymmetryResult(const SymmetryResult&);
+  SymmetryResult& operator=(const SymmetryResult&);
+};
+
+typedef QSharedPointer<SymmetryResult> SymmetryResultPtr;
+
+/**
+ * @brief The SymmetryDetector class finds the point group of a molecule with
+ * libmsym on a worker thread.
+ *
+ * The results of the last few detections are cached by geometry and
+ * thresholds, so detecting the symmetry of a geometry seen before (e.g. after
+ * an undo) completes immediately. Starting a new detection, or cancel(),
+ * abandons the running one. As libmsym cannot be interrupted, an abandoned
+ * detection stops at the end of its current step and its result is dropped.
+ */
+class SymmetryDetector : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit SymmetryDetector(QObject* parent_ = 0);
+  ~SymmetryDetector() override;
+
+  /**
+   * @return The cache key for the geometry of @a mol with @a thresholds.
+   */
+  static QByteArray key(const Core::Molecule& mol,
+                        const msym::msym_thresholds_t& thresholds);
+
+  /**
+   * Start detecting the point group of @a mol with @a thresholds. If the
+   * result is cached, finished() is emitted before returning.
+   */
+  void detect(const Core::Molecule& mol,
+              const msym::msym_thresholds_t& thresholds);
+
+  /** Abandon the running detection, if any. */
+  void cancel();
+
+  /** @return True while a detection is running. */
+  bool isRunning() const { return m_running; }
+
+  /** @return The result of the last finished detection. */
+  SymmetryResultPtr result() const { return m_result; }
+
+  /**
+   * Remove @a result from the cache, e.g. once its context was used to
+   * symmetrize the molecule.
+   */
+  void uncache(const SymmetryResultPtr& result);
+
+  /** The number of steps reported by progress(). */
+  static const int stepCount = 4;
+
+signals:
+  /** Emitted as the running detection completes each of its steps. */
+  void progress(int step, int steps);
+
+  /** Emitted when a detection completes, see result(). */
+  void finished();
+
+private slots:
+  void reportProgress(int job, int step);
+  void detectionFinished();
+
+private:
+  // The input of a detection, shared with the worker thread.
+  struct Job
+  {
+    int id;
+    QAtomicInt canceled;
+    QByteArray key;
+    QVector<msym::msym_element_t> elements;
+    msym::msym_thresholds_t thresholds;
+  };
+
+  static SymmetryResultPtr run(SymmetryDetector* detector,
+                               QSharedPointer<Job> job);
+
+  void finish(const SymmetryResultPtr& result);
+
+  QFutureWatcher<SymmetryResultPtr> m_watcher;
+  // Every detection that may still be running, including abandoned ones.
+  QList<QFuture<SymmetryResultPtr>> m_futures;
+  QSharedPointer<Job> m_job;
+  int m_jobCount;
+  bool m_running;
+
+  SymmetryResultPtr m_result;
+  // The most recently used results first.
+  QList<SymmetryResultPtr> m_cache;
+};
+
+} // namespace QtPlugins
+} // namespace Avogadro
+
+#endif // AVOGADRO_QTPLUGINS_SYMMETRYDETECTOR_H
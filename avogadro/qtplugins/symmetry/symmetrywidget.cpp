@@ -77,7 +77,7 @@ SymmetryWidget::SymmetryWidget(QWidget* parent_)
   : QWidget(parent_), m_ui(new Ui::SymmetryWidget), m_molecule(NULL),
     m_operationsTableModel(new OperationsTableModel(this)),
     m_subgroupsTreeModel(new QStandardItemModel(this)), m_sops(NULL),
-    m_sg(NULL), m_sopsl(0), m_sgl(0), m_radius(0.0)
+    m_sg(NULL), m_sopsl(0), m_sgl(0), m_radius(0.0), m_detecting(false)
 {
   setWindowFlags(Qt::Dialog);
   m_ui->setupUi(this);
@@ -89,7 +89,7 @@ SymmetryWidget::SymmetryWidget(QWidget* parent_)
   m_ui->subgroupsTree->setItemDelegateForColumn(0, new RichTextDelegate(this));
 
   connect(m_ui->detectSymmetryButton, SIGNAL(clicked()),
-          SIGNAL(detectSymmetry()));
+          SLOT(detectClicked()));
   connect(m_ui->symmetrizeMoleculeButton, SIGNAL(clicked()),
           SIGNAL(symmetrizeMolecule()));
   connect(
@@ -248,6 +248,32 @@ void SymmetryWidget::subgroupsSelectionChanged(const QItemSelection& selected,
   selectionModel->select(selection, QItemSelectionModel::ClearAndSelect);
 }
 
+void SymmetryWidget::detectClicked()
+{
+  if (m_detecting)
+    emit cancelDetection();
+  else
+    emit detectSymmetry();
+}
+
+void SymmetryWidget::setDetecting(bool detecting)
+{
+  m_detecting = detecting;
+  m_ui->detectSymmetryButton->setText(detecting ? tr("Cancel")
+                                                : tr("Detect Symmetry"));
+  m_ui->symmetrizeMoleculeButton->setEnabled(!detecting);
+  if (detecting)
+    m_ui->pointGroupLabel->setText(tr("Detecting..."));
+}
+
+void SymmetryWidget::setDetectionProgress(int step, int steps)
+{
+  if (m_detecting) {
+    m_ui->pointGroupLabel->setText(
+      tr("Detecting (%1/%2)...").arg(step).arg(steps));
+  }
+}
+
 void SymmetryWidget::setRadius(double radius)
 {
   m_radius = radius;
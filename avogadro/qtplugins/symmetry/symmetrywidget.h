@@ -67,6 +67,7 @@ public:
 
 signals:
   void detectSymmetry();
+  void cancelDetection();
   void symmetrizeMolecule();
 
 public slots:
@@ -79,7 +80,15 @@ public slots:
   void setRadius(double radius);
   msym::msym_thresholds_t* getThresholds() const;
 
+  /**
+   * Show that the symmetry is being detected, the detect button cancels the
+   * detection meanwhile.
+   */
+  void setDetecting(bool detecting);
+  void setDetectionProgress(int step, int steps);
+
 private slots:
+  void detectClicked();
   void operationsSelectionChanged(const QItemSelection& selected,
                                   const QItemSelection& deselected);
   void subgroupsSelectionChanged(const QItemSelection& selected,
@@ -96,6 +105,7 @@ private:
   msym::msym_subgroup_t* m_sg;
   int m_sopsl, m_sgl;
   double m_radius;
+  bool m_detecting;
 
   void addSubgroup(QStandardItem*, msym::msym_subgroup_t*);
 };
@@ -16,6 +16,8 @@
 
 #include "gamessus.h"
 
+#include "numericblock.h"
+
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/utilities.h>
 
@@ -247,7 +249,9 @@ void GAMESSUSOutput::readEigenvectors(std::istream& in)
         newBlock = false;
       }
       for (size_t i = 0; i < parts.size() - 4; ++i) {
-        eigenvectors[i].push_back(Core::lexicalCast<double>(parts[i + 4], ok));
+        double value(0.0);
+        ok = parseNumber(parts[i + 4], value);
+        eigenvectors[i].push_back(value);
         if (!ok)
           appendError("Failed to cast to double for eigenvector: " + parts[i]);
       }
@@ -17,11 +17,15 @@
 
 #include "gaussianfchk.h"
 
+#include "numericblock.h"
+
 #include <avogadro/core/gaussianset.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/utilities.h>
 
+#include <fstream>
 #include <iostream>
+#include <limits>
 
 using std::vector;
 using std::string;
@@ -39,7 +43,9 @@ using Core::Uhf;
 using Core::Rohf;
 using Core::Unknown;
 
-GaussianFchk::GaussianFchk() : m_scftype(Rhf)
+GaussianFchk::GaussianFchk()
+  : m_electrons(0), m_electronsAlpha(0), m_electronsBeta(0),
+    m_numBasisFunctions(0), m_scftype(Rhf)
 {
 }
 
@@ -61,10 +67,56 @@ std::vector<std::string> GaussianFchk::mimeTypes() const
 
 bool GaussianFchk::read(std::istream& in, Core::Molecule& molecule)
 {
-  // Read the log file line by line, most sections are terminated by an empty
-  // line, so they should be retained.
-  while (!in.eof())
-    processLine(in);
+  // A first pass indexes the arrays by the offsets of their data, skipping
+  // over the data itself, which is then read in bulk as it is needed.
+  m_sections.clear();
+  indexSections(in);
+
+  m_aNums = readArrayI(in, "Atomic numbers");
+  m_aPos = readArrayD(in, "Current cartesian coordinates");
+  m_shellTypes = readArrayI(in, "Shell types");
+  m_shellNums = readArrayI(in, "Number of primitives per shell");
+  m_shelltoAtom = readArrayI(in, "Shell to atom map");
+  m_a = readArrayD(in, "Primitive exponents");
+  m_c = readArrayD(in, "Contraction coefficients");
+  m_csp = readArrayD(in, "P(S=P) Contraction coefficients");
+
+  // Beta orbitals are only written for unrestricted calculations.
+  if (m_sections.count("Beta Orbital Energies") ||
+      m_sections.count("Beta MO coefficients")) {
+    m_scftype = Uhf;
+  }
+  if (m_scftype == Uhf) {
+    m_alphaOrbitalEnergy = readArrayD(in, "Alpha Orbital Energies");
+    m_betaOrbitalEnergy = readArrayD(in, "Beta Orbital Energies");
+    m_alphaMOcoeffs = readArrayD(in, "Alpha MO coefficients");
+    m_betaMOcoeffs = readArrayD(in, "Beta MO coefficients");
+  } else {
+    m_orbitalEnergy = readArrayD(in, "Alpha Orbital Energies");
+    m_MOcoeffs = readArrayD(in, "Alpha MO coefficients");
+  }
+
+  // The density matrices are only needed for densities, and are as large as
+  // the orbitals. They are loaded when first needed if the file can be read
+  // again, and now otherwise.
+  const string densityKey("Total SCF Density");
+  const string spinDensityKey("Spin SCF Density");
+  std::map<string, Section>::const_iterator density =
+    m_sections.find(densityKey);
+  std::map<string, Section>::const_iterator spinDensity =
+    m_sections.find(spinDensityKey);
+  bool lazyDensity = !fileName().empty() && density != m_sections.end();
+  if (!lazyDensity && density != m_sections.end()) {
+    if (!readDensityMatrix(in, densityKey, density->second,
+                           m_numBasisFunctions, m_density)) {
+      cout << "Error reading in the SCF density matrix.\n";
+    }
+    if (spinDensity != m_sections.end() &&
+        !readDensityMatrix(in, spinDensityKey, spinDensity->second,
+                           m_numBasisFunctions, m_spinDensity)) {
+      cout << "Error reading in the SCF spin density matrix.\n";
+    }
+  }
 
   GaussianSet* basis = new GaussianSet;
 
@@ -80,23 +132,82 @@ bool GaussianFchk::read(std::istream& in, Core::Molecule& molecule)
   molecule.setBasisSet(basis);
   basis->setMolecule(&molecule);
   load(basis);
+
+  if (lazyDensity && basis->isValid()) {
+    const string file(fileName());
+    const Section densitySection(density->second);
+    const bool hasSpin = spinDensity != m_sections.end();
+    const Section spinSection(hasSpin ? spinDensity->second : Section());
+    const unsigned int n = m_numBasisFunctions;
+    basis->setDensityLoader([=](MatrixX& densityMatrix,
+                                MatrixX& spinDensityMatrix) {
+      std::ifstream stream(file.c_str(), std::ifstream::binary);
+      if (!stream.is_open() ||
+          !readDensityMatrix(stream, densityKey, densitySection, n,
+                             densityMatrix)) {
+        cout << "Error reading in the SCF density matrix.\n";
+        return false;
+      }
+      if (hasSpin && !readDensityMatrix(stream, spinDensityKey, spinSection,
+                                        n, spinDensityMatrix)) {
+        cout << "Error reading in the SCF spin density matrix.\n";
+      }
+      return true;
+    });
+  }
   return true;
 }
 
-void GaussianFchk::processLine(std::istream& in)
+void GaussianFchk::indexSections(std::istream& in)
 {
-  // First truncate the line, remove trailing white space and check any line of
-  // the required length. We are looking for keyword lines of the form,
-  // Charge                                     I                0
-  // If we are in any other kind of block that is not known skip through until
-  // we find a recognized block.
+  // Header lines are read, the lines of data of integer and real arrays are
+  // skipped, as their count and the number of values per line are known.
   string line;
-  if (!getline(in, line) || line.size() < 44)
+  std::streamoff offset = in.tellg();
+  while (getline(in, line)) {
+    processLine(line);
+
+    vector<string> list;
+    if (line.size() >= 44)
+      list = Core::split(line.substr(43), ' ');
+    if (list.size() > 2 && list[1] == "N=") {
+      Section section;
+      section.header = offset;
+      section.begin = in.tellg();
+      section.type = list[0][0];
+      section.count = Core::lexicalCast<unsigned int>(list[2]);
+
+      // Six integers, or five reals, to a line.
+      unsigned int perLine = 0;
+      if (section.type == 'I')
+        perLine = 6;
+      else if (section.type == 'R')
+        perLine = 5;
+      if (perLine > 0) {
+        unsigned int lines = (section.count + perLine - 1) / perLine;
+        for (unsigned int i = 0; i < lines && in; ++i)
+          in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+      }
+      // The last array may end the file.
+      if (in.eof())
+        in.clear();
+      section.end = in.tellg();
+      m_sections[Core::trimmed(line.substr(0, 42))] = section;
+    }
+    offset = in.tellg();
+  }
+  in.clear();
+}
+
+void GaussianFchk::processLine(const std::string& line)
+{
+  // Check any line of the required length. We are looking for keyword lines of
+  // the form,
+  // Charge                                     I                0
+  if (line.size() < 44)
     return;
 
   string key = line.substr(0, 42);
-
-  // cout << "Key:\t" << key << endl;
   key = Core::trimmed(key);
 
   string tmp = line.substr(43);
@@ -107,8 +218,6 @@ void GaussianFchk::processLine(std::istream& in)
     m_scftype = Rhf;
   } else if (Core::contains(key, "UHF")) {
     m_scftype = Uhf;
-  } else if (key == "Number of atoms" && list.size() > 1) {
-    cout << "Number of atoms = " << Core::lexicalCast<int>(list[1]) << endl;
   } else if (key == "Number of electrons" && list.size() > 1) {
     m_electrons = Core::lexicalCast<int>(list[1]);
   } else if (key == "Number of alpha electrons" && list.size() > 1) {
@@ -117,85 +226,6 @@ void GaussianFchk::processLine(std::istream& in)
     m_electronsBeta = Core::lexicalCast<int>(list[1]);
   } else if (key == "Number of basis functions" && list.size() > 1) {
     m_numBasisFunctions = Core::lexicalCast<int>(list[1]);
-    cout << "Number of basis functions = " << m_numBasisFunctions << endl;
-  } else if (key == "Atomic numbers" && list.size() > 2) {
-    m_aNums = readArrayI(in, Core::lexicalCast<int>(list[2]));
-    if (static_cast<int>(m_aNums.size()) != Core::lexicalCast<int>(list[2]))
-      cout << "Reading atomic numbers failed.\n";
-    else
-      cout << "Reading atomic numbers succeeded.\n";
-  }
-  // Now we get to the meat of it - coordinates of the atoms
-  else if (key == "Current cartesian coordinates" && list.size() > 2) {
-    m_aPos = readArrayD(in, Core::lexicalCast<int>(list[2]), 16);
-  }
-  // The real meat is here - basis sets etc!
-  else if (key == "Shell types" && list.size() > 2) {
-    m_shellTypes = readArrayI(in, Core::lexicalCast<int>(list[2]));
-  } else if (key == "Number of primitives per shell" && list.size() > 2) {
-    m_shellNums = readArrayI(in, Core::lexicalCast<int>(list[2]));
-  } else if (key == "Shell to atom map" && list.size() > 2) {
-    m_shelltoAtom = readArrayI(in, Core::lexicalCast<int>(list[2]));
-  }
-  // Now to get the exponents and coefficients(
-  else if (key == "Primitive exponents" && list.size() > 2) {
-    m_a = readArrayD(in, Core::lexicalCast<int>(list[2]), 16);
-  } else if (key == "Contraction coefficients" && list.size() > 2) {
-    m_c = readArrayD(in, Core::lexicalCast<int>(list[2]), 16);
-  } else if (key == "P(S=P) Contraction coefficients" && list.size() > 2) {
-    m_csp = readArrayD(in, Core::lexicalCast<int>(list[2]), 16);
-  } else if (key == "Alpha Orbital Energies") {
-    if (m_scftype == Rhf) {
-      m_orbitalEnergy = readArrayD(in, Core::lexicalCast<int>(list[2]), 16);
-      cout << "MO energies, n = " << m_orbitalEnergy.size() << endl;
-    } else if (m_scftype == Uhf) {
-      m_alphaOrbitalEnergy =
-        readArrayD(in, Core::lexicalCast<int>(list[2]), 16);
-      cout << "Alpha MO energies, n = " << m_alphaOrbitalEnergy.size() << endl;
-    }
-  } else if (key == "Beta Orbital Energies") {
-    if (m_scftype != Uhf) {
-      cout << "UHF detected. Reassigning Alpha properties." << endl;
-      m_scftype = Uhf;
-      m_alphaOrbitalEnergy = m_orbitalEnergy;
-      m_orbitalEnergy = vector<double>();
-
-      m_alphaMOcoeffs = m_MOcoeffs;
-      m_MOcoeffs = vector<double>();
-    }
-
-    m_betaOrbitalEnergy = readArrayD(in, Core::lexicalCast<int>(list[2]), 16);
-    cout << "Beta MO energies, n = " << m_betaOrbitalEnergy.size() << endl;
-  } else if (key == "Alpha MO coefficients" && list.size() > 2) {
-    if (m_scftype == Rhf) {
-      m_MOcoeffs = readArrayD(in, Core::lexicalCast<int>(list[2]), 16);
-      if (static_cast<int>(m_MOcoeffs.size()) ==
-          Core::lexicalCast<int>(list[2]))
-        cout << "MO coefficients, n = " << m_MOcoeffs.size() << endl;
-    } else if (m_scftype == Uhf) {
-      m_alphaMOcoeffs = readArrayD(in, Core::lexicalCast<int>(list[2]), 16);
-      if (static_cast<int>(m_alphaMOcoeffs.size()) ==
-          Core::lexicalCast<int>(list[2]))
-        cout << "Alpha MO coefficients, n = " << m_alphaMOcoeffs.size() << endl;
-    } else {
-      cout << "Error, alpha MO coefficients, n = " << m_MOcoeffs.size() << endl;
-    }
-  } else if (key == "Beta MO coefficients" && list.size() > 2) {
-    m_betaMOcoeffs = readArrayD(in, Core::lexicalCast<int>(list[2]), 16);
-    if (static_cast<int>(m_betaMOcoeffs.size()) ==
-        Core::lexicalCast<int>(list[2]))
-      cout << "Beta MO coefficients, n = " << m_betaMOcoeffs.size() << endl;
-  } else if (key == "Total SCF Density" && list.size() > 2) {
-    if (readDensityMatrix(in, Core::lexicalCast<int>(list[2]), 16))
-      cout << "SCF density matrix read in " << m_density.rows() << endl;
-    else
-      cout << "Error reading in the SCF density matrix.\n";
-  } else if (key == "Spin SCF Density" && list.size() > 2) {
-    if (readSpinDensityMatrix(in, Core::lexicalCast<int>(list[2]), 16))
-      cout << "SCF spin density matrix read in " << m_spinDensity.rows()
-           << endl;
-    else
-      cout << "Error reading in the SCF spin density matrix.\n";
   }
 }
 
@@ -296,243 +326,81 @@ void GaussianFchk::load(GaussianSet* basis)
   }
 }
 
-vector<int> GaussianFchk::readArrayI(std::istream& in, unsigned int n)
+namespace {
+template <typename T>
+vector<T> readArray(std::istream& in, std::streamoff begin,
+                    std::streamoff end, unsigned int n, const string& key)
 {
-  vector<int> tmp;
-  tmp.reserve(n);
-  bool ok(false);
-  while (tmp.size() < n) {
-    if (in.eof()) {
-      cout << "GaussianFchk::readArrayI could not read all elements " << n
-           << " expected " << tmp.size() << " parsed.\n";
-      return tmp;
-    }
-    string line;
-    if (getline(in, line), line.empty())
-      return tmp;
-
-    vector<string> list = Core::split(line, ' ');
-    for (size_t i = 0; i < list.size(); ++i) {
-      if (tmp.size() >= n) {
-        cout << "Too many variables read in. File may be inconsistent. "
-             << tmp.size() << " of " << n << endl;
-        return tmp;
-      }
-      tmp.push_back(Core::lexicalCast<int>(list[i], ok));
-      if (!ok) {
-        cout << "Warning: problem converting string to integer: " << list[i]
-             << " in GaussianFchk::readArrayI.\n";
-        return tmp;
-      }
-    }
+  vector<T> tmp;
+  string block;
+  if (!readBlock(in, begin, end, block)) {
+    cout << "GaussianFchk could not read " << key << ".\n";
+    return tmp;
+  }
+  tmp.resize(n);
+  size_t count =
+    parseNumbers(block.data(), block.data() + block.size(), tmp.data(), n);
+  if (count < n) {
+    cout << "GaussianFchk could not read all elements of " << key << ", " << n
+         << " expected " << count << " parsed.\n";
+    tmp.resize(count);
   }
   return tmp;
 }
+}
 
-vector<double> GaussianFchk::readArrayD(std::istream& in, unsigned int n,
-                                        int width)
+vector<int> GaussianFchk::readArrayI(std::istream& in, const string& key)
 {
-  vector<double> tmp;
-  tmp.reserve(n);
-  bool ok(false);
-  while (tmp.size() < n) {
-    if (in.eof()) {
-      cout << "GaussianFchk::readArrayD could not read all elements " << n
-           << " expected " << tmp.size() << " parsed.\n";
-      return tmp;
-    }
-    string line;
-    if (getline(in, line), line.empty())
-      return tmp;
-
-    if (width == 0) { // we can split by spaces
-      vector<string> list = Core::split(line, ' ');
-      for (size_t i = 0; i < list.size(); ++i) {
-        if (tmp.size() >= n) {
-          cout << "Too many variables read in. File may be inconsistent. "
-               << tmp.size() << " of " << n << endl;
-          return tmp;
-        }
-        tmp.push_back(Core::lexicalCast<double>(list[i], ok));
-        if (!ok) {
-          cout << "Warning: problem converting string to integer: " << list[i]
-               << " in GaussianFchk::readArrayD.\n";
-          return tmp;
-        }
-      }
-    } else { // Q-Chem files use 16 character fields
-      int maxColumns = 80 / width;
-      for (int i = 0; i < maxColumns; ++i) {
-        string substring = line.substr(i * width, width);
-        if (static_cast<int>(substring.length()) != width)
-          break;
-        if (tmp.size() >= n) {
-          cout << "Too many variables read in. File may be inconsistent. "
-               << tmp.size() << " of " << n << endl;
-          return tmp;
-        }
-        tmp.push_back(Core::lexicalCast<double>(substring, ok));
-        if (!ok) {
-          cout << "Warning: problem converting string to double: " << substring
-               << " in GaussianFchk::readArrayD.\n";
-          return tmp;
-        }
-      }
-    }
-  }
-  return tmp;
+  std::map<string, Section>::const_iterator it = m_sections.find(key);
+  if (it == m_sections.end() || it->second.type != 'I')
+    return vector<int>();
+  const Section& section = it->second;
+  return readArray<int>(in, section.begin, section.end, section.count, key);
 }
 
-bool GaussianFchk::readDensityMatrix(std::istream& in, unsigned int n,
-                                     int width)
+vector<double> GaussianFchk::readArrayD(std::istream& in, const string& key)
 {
-  // This function reads in the lower triangular density matrix
-  m_density.resize(m_numBasisFunctions, m_numBasisFunctions);
-  unsigned int cnt = 0;
-  unsigned int i = 0, j = 0;
-  unsigned int f = 1;
-  bool ok = false;
-  while (cnt < n) {
-    if (in.eof()) {
-      cout << "GaussianFchk::readDensityMatrix could not read all elements "
-           << n << " expected " << cnt << " parsed.\n";
-      return false;
-    }
-    string line;
-    if (getline(in, line), line.empty())
-      return false;
-
-    if (width == 0) { // we can split by spaces
-      vector<string> list = Core::split(line, ' ');
-      for (size_t k = 0; k < list.size(); ++k) {
-        if (cnt >= n) {
-          cout << "Too many variables read in. File may be inconsistent. "
-               << cnt << " of " << n << endl;
-          return false;
-        }
-        // Read in lower half matrix
-        m_density(i, j) = Core::lexicalCast<double>(list[k], ok);
-        if (ok) { // Valid double converted, carry on
-          ++j;
-          ++cnt;
-          if (j == f) {
-            // We need to move down to the next row and increment f - lower tri
-            j = 0;
-            ++f;
-            ++i;
-          }
-        } else { // Invalid conversion of a string to double
-          cout << "Warning: problem converting string to double: " << list.at(k)
-               << "\nIn GaussianFchk::readDensityMatrix.\n";
-          return false;
-        }
-      }
-    } else { // Q-Chem files use 16-character fields
-      int maxColumns = 80 / width;
-      for (int c = 0; c < maxColumns; ++c) {
-        string substring = line.substr(c * width, width);
-        if (static_cast<int>(substring.length()) != width) {
-          break;
-        } else if (cnt >= n) {
-          cout << "Too many variables read in. File may be inconsistent. "
-               << cnt << " of " << n << endl;
-          return false;
-        }
-        // Read in lower half matrix
-        m_density(i, j) = Core::lexicalCast<double>(substring, ok);
-        if (ok) { // Valid double converted, carry on
-          ++j;
-          ++cnt;
-          if (j == f) {
-            // We need to move down to the next row and increment f - lower tri
-            j = 0;
-            ++f;
-            ++i;
-          }
-        } else { // Invalid conversion of a string to double
-          cout << "Warning: problem converting string to double: " << substring
-               << "\nIn GaussianFchk::readDensityMatrix.\n";
-          return false;
-        }
-      }
-    }
-  }
-  return true;
+  std::map<string, Section>::const_iterator it = m_sections.find(key);
+  if (it == m_sections.end() || it->second.type != 'R')
+    return vector<double>();
+  const Section& section = it->second;
+  return readArray<double>(in, section.begin, section.end, section.count,
+                           key);
 }
-bool GaussianFchk::readSpinDensityMatrix(std::istream& in, unsigned int n,
-                                         int width)
+
+bool GaussianFchk::readDensityMatrix(std::istream& in, const string& key,
+                                     const Section& section, unsigned int n,
+                                     MatrixX& matrix)
 {
-  // This function reads in the lower triangular density matrix
-  m_spinDensity.resize(m_numBasisFunctions, m_numBasisFunctions);
-  unsigned int cnt = 0;
-  unsigned int i = 0, j = 0;
-  unsigned int f = 1;
-  bool ok = false;
-  while (cnt < n) {
-    if (in.eof()) {
-      cout << "GaussianFchk::readSpinDensityMatrix could not read all elements "
-           << n << " expected " << cnt << " parsed.\n";
-      return false;
-    }
-    string line;
-    if (getline(in, line), line.empty())
-      return false;
-
-    if (width == 0) { // we can split by spaces
-      vector<string> list = Core::split(line, ' ');
-      for (size_t k = 0; k < list.size(); ++k) {
-        if (cnt >= n) {
-          cout << "Too many variables read in. File may be inconsistent. "
-               << cnt << " of " << n << endl;
-          return false;
-        }
-        // Read in lower half matrix
-        m_spinDensity(i, j) = Core::lexicalCast<double>(list[k], ok);
-        if (ok) { // Valid double converted, carry on
-          ++j;
-          ++cnt;
-          if (j == f) {
-            // We need to move down to the next row and increment f - lower tri
-            j = 0;
-            ++f;
-            ++i;
-          }
-        } else { // Invalid conversion of a string to double
-          cout << "Warning: problem converting string to double: " << list[k]
-               << "\nIn GaussianFchk::readDensityMatrix.\n";
-          return false;
-        }
-      }
-    } else { // Q-Chem files use 16-character fields
-      int maxColumns = 80 / width;
-      for (int c = 0; c < maxColumns; ++c) {
-        string substring = line.substr(c * width, width);
-        if (static_cast<int>(substring.length()) != width) {
-          break;
-        } else if (cnt >= n) {
-          cout << "Too many variables read in. File may be inconsistent. "
-               << cnt << " of " << n << endl;
-          return false;
-        }
-        // Read in lower half matrix
-        m_spinDensity(i, j) = Core::lexicalCast<double>(substring, ok);
-        if (ok) { // Valid double converted, carry on
-          ++j;
-          ++cnt;
-          if (j == f) {
-            // We need to move down to the next row and increment f - lower tri
-            j = 0;
-            ++f;
-            ++i;
-          }
-        } else { // Invalid conversion of a string to double
-          cout << "Warning: problem converting string to double: " << substring
-               << "\nIn GaussianFchk::readSpinDensityMatrix.\n";
-          return false;
-        }
+  // The file may have changed since it was indexed.
+  string header;
+  if (!readBlock(in, section.header, section.begin, header) ||
+      header.compare(0, key.size(), key) != 0 ||
+      section.count != n * (n + 1) / 2) {
+    return false;
+  }
+  string block;
+  if (!readBlock(in, section.begin, section.end, block))
+    return false;
+
+  // The lower triangle is stored by rows, it is parsed straight into the
+  // columns of the upper triangle, and mirrored.
+  matrix.resize(n, n);
+  const char* p = block.data();
+  const char* end = block.data() + block.size();
+  for (unsigned int j = 0; j < n; ++j) {
+    double* column = matrix.data() + static_cast<size_t>(j) * n;
+    for (unsigned int i = 0; i <= j; ++i) {
+      if (!(p = parseNumber(p, end, column[i]))) {
+        matrix.resize(0, 0);
+        return false;
       }
     }
   }
+  for (unsigned int j = 0; j < n; ++j) {
+    for (unsigned int i = j + 1; i < n; ++i)
+      matrix(i, j) = matrix(j, i);
+  }
   return true;
 }
 
@@ -22,6 +22,8 @@
 #include <avogadro/core/gaussianset.h>
 #include <avogadro/io/fileformat.h>
 
+#include <map>
+#include <string>
 #include <vector>
 
 namespace Avogadro {
@@ -64,13 +66,26 @@ public:
   void outputAll();
 
 private:
-  void processLine(std::istream& in);
+  /**
+   * The position in the file of an array, found by the index pass.
+   */
+  struct Section
+  {
+    std::streamoff header; /// The header line naming the array
+    std::streamoff begin;  /// The first line of data
+    std::streamoff end;    /// Past the last line of data
+    char type;             /// I, R, C or L, as in the header
+    unsigned int count;    /// The number of values
+  };
+
+  void indexSections(std::istream& in);
+  void processLine(const std::string& line);
   void load(Core::GaussianSet* basis);
-  std::vector<int> readArrayI(std::istream& in, unsigned int n);
-  std::vector<double> readArrayD(std::istream& in, unsigned int n,
-                                 int width = 0);
-  bool readDensityMatrix(std::istream& in, unsigned int n, int width = 0);
-  bool readSpinDensityMatrix(std::istream& in, unsigned int n, int width = 0);
+  std::vector<int> readArrayI(std::istream& in, const std::string& key);
+  std::vector<double> readArrayD(std::istream& in, const std::string& key);
+  static bool readDensityMatrix(std::istream& in, const std::string& key,
+                                const Section& section, unsigned int n,
+                                MatrixX& matrix);
 
   /**
    * Use either m_electrons, or m_electronsAlpha and m_electronsBeta.
@@ -96,6 +111,7 @@ private:
   std::vector<double> m_betaMOcoeffs;
   MatrixX m_density;     /// Total density matrix
   MatrixX m_spinDensity; /// Spin density matrix
+  std::map<std::string, Section> m_sections; /// The arrays in the file
   Core::ScfType m_scftype;
 };
 }
@@ -17,6 +17,8 @@
 
 #include "molden.h"
 
+#include "numericblock.h"
+
 #include <avogadro/core/gaussianset.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/utilities.h>
@@ -157,12 +159,20 @@ void MoldenFile::processLine(std::istream& in)
             getline(in, line);
             line = Core::trimmed(line);
             list = Core::split(line, ' ');
-            if (list.size() > 1) {
-              m_a.push_back(Core::lexicalCast<double>(list[0]));
-              m_c.push_back(Core::lexicalCast<double>(list[1]));
+            // A primitive that cannot be read is dropped from its shell, so
+            // the exponents and coefficients stay in step with the shells.
+            bool sp = shellType == GaussianSet::SP;
+            double a(0.0), c(0.0), csp(0.0);
+            if (list.size() < (sp ? 3u : 2u) || !parseNumber(list[0], a) ||
+                !parseNumber(list[1], c) ||
+                (sp && !parseNumber(list[2], csp))) {
+              --m_shellNums.back();
+              continue;
             }
-            if (shellType == GaussianSet::SP && list.size() > 2)
-              m_csp.push_back(Core::lexicalCast<double>(list[2]));
+            m_a.push_back(a);
+            m_c.push_back(c);
+            if (sp)
+              m_csp.push_back(csp);
           }
           // Start reading the next shell.
           getline(in, line);
@@ -180,17 +190,20 @@ void MoldenFile::processLine(std::istream& in)
             m_electrons += Core::lexicalCast<int>(list[1]);
         }
 
-        // Parse the molecular orbital coefficients.
+        // Parse the molecular orbital coefficients, an index and a value to
+        // a line, in place.
         while (!line.empty() && !Core::contains(line, "=")) {
-          list = Core::split(line, ' ');
-          if (list.size() < 2)
+          const char* end = line.data() + line.size();
+          int index(0);
+          double coefficient(0.0);
+          const char* p = parseNumber(line.data(), end, index);
+          if (!p || !parseNumber(p, end, coefficient))
             break;
 
-          m_MOcoeffs.push_back(Core::lexicalCast<double>(list[1]));
+          m_MOcoeffs.push_back(coefficient);
 
           getline(in, line);
           line = Core::trimmed(line);
-          list = Core::split(line, ' ');
         }
         break;
       default:
@@ -0,0 +1,205 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "numericblock.h"
+
+#include <avogadro/core/utilities.h>
+
+#include <cstdint>
+
+namespace Avogadro {
+namespace QuantumIO {
+
+namespace {
+// The powers of ten held exactly by a double.
+const double powersOfTen[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                               1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                               1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                               1e18, 1e19, 1e20, 1e21, 1e22 };
+const int maxExactPower = 22;
+
+// The largest integer held exactly by a double, and the digits that fit in a
+// 64 bit integer.
+const uint64_t maxExactMantissa = uint64_t(1) << 53;
+const int maxDigits = 19;
+
+inline bool isBlank(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline bool isDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+inline const char* skipBlanks(const char* begin, const char* end)
+{
+  while (begin < end && isBlank(*begin))
+    ++begin;
+  return begin;
+}
+}
+
+const char* parseNumber(const char* begin, const char* end, double& value)
+{
+  const char* p = skipBlanks(begin, end);
+  const char* start = p;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+'))
+    negative = *p++ == '-';
+
+  // The significant digits are gathered in an integer, and scaled by a power
+  // of ten.
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  bool anyDigit = false;
+  bool truncated = false;
+  for (; p < end && isDigit(*p); ++p) {
+    anyDigit = true;
+    if (digits < maxDigits) {
+      mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+      if (mantissa > 0)
+        ++digits;
+    } else {
+      ++exponent;
+      truncated = true;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (++p; p < end && isDigit(*p); ++p) {
+      anyDigit = true;
+      if (digits < maxDigits) {
+        mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+        if (mantissa > 0)
+          ++digits;
+        --exponent;
+      } else {
+        truncated = true;
+      }
+    }
+  }
+  if (!anyDigit)
+    return nullptr;
+
+  if (p < end && (*p == 'e' || *p == 'E' || *p == 'd' || *p == 'D')) {
+    ++p;
+    bool negativeExponent = false;
+    if (p < end && (*p == '-' || *p == '+'))
+      negativeExponent = *p++ == '-';
+    if (p == end || !isDigit(*p))
+      return nullptr;
+    int power = 0;
+    for (; p < end && isDigit(*p); ++p) {
+      if (power < 10000)
+        power = power * 10 + (*p - '0');
+    }
+    exponent += negativeExponent ? -power : power;
+  }
+  if (p < end && !isBlank(*p))
+    return nullptr;
+
+  if (mantissa == 0) {
+    value = negative ? -0.0 : 0.0;
+  } else if (!truncated && mantissa <= maxExactMantissa &&
+             exponent >= -maxExactPower && exponent <= maxExactPower) {
+    // Both factors are exact, so the result is rounded once, as strtod does.
+    value = static_cast<double>(mantissa);
+    if (exponent < 0)
+      value /= powersOfTen[-exponent];
+    else
+      value *= powersOfTen[exponent];
+    if (negative)
+      value = -value;
+  } else {
+    // Rare numbers with many digits or large exponents take the slow path.
+    std::string number(start, p);
+    for (size_t i = 0; i < number.size(); ++i) {
+      if (number[i] == 'd' || number[i] == 'D')
+        number[i] = 'E';
+    }
+    bool ok = false;
+    value = Core::lexicalCast<double>(number, ok);
+    if (!ok)
+      return nullptr;
+  }
+  return p;
+}
+
+const char* parseNumber(const char* begin, const char* end, int& value)
+{
+  const char* p = skipBlanks(begin, end);
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+'))
+    negative = *p++ == '-';
+  if (p == end || !isDigit(*p))
+    return nullptr;
+
+  int64_t result = 0;
+  for (; p < end && isDigit(*p); ++p) {
+    result = result * 10 + (*p - '0');
+    if (result > INT32_MAX)
+      return nullptr;
+  }
+  if (p < end && !isBlank(*p))
+    return nullptr;
+  value = static_cast<int>(negative ? -result : result);
+  return p;
+}
+
+bool parseNumber(const std::string& string, double& value)
+{
+  const char* end = string.data() + string.size();
+  const char* p = parseNumber(string.data(), end, value);
+  return p && skipBlanks(p, end) == end;
+}
+
+size_t parseNumbers(const char* begin, const char* end, double* values,
+                    size_t count)
+{
+  size_t n = 0;
+  while (n < count && (begin = parseNumber(begin, end, values[n])))
+    ++n;
+  return n;
+}
+
+size_t parseNumbers(const char* begin, const char* end, int* values,
+                    size_t count)
+{
+  size_t n = 0;
+  while (n < count && (begin = parseNumber(begin, end, values[n])))
+    ++n;
+  return n;
+}
+
+bool readBlock(std::istream& in, std::streamoff begin, std::streamoff end,
+               std::string& block)
+{
+  if (end < begin)
+    return false;
+  in.clear();
+  if (!in.seekg(begin))
+    return false;
+  block.resize(static_cast<size_t>(end - begin));
+  in.read(&block[0], end - begin);
+  // Streams translating line endings may read less than the offsets span.
+  block.resize(static_cast<size_t>(in.gcount()));
+  return !in.bad();
+}
+
+} // End namespace QuantumIO
+} // End namespace Avogadro
@@ -0,0 +1,80 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_QUANTUMIO_NUMERICBLOCK_H
+#define AVOGADRO_QUANTUMIO_NUMERICBLOCK_H
+
+#include "avogadroquantumioexport.h"
+
+#include <cstddef>
+#include <istream>
+#include <string>
+
+namespace Avogadro {
+namespace QuantumIO {
+
+/**
+ * @brief Parse the number at @p begin, after any white space, ending at white
+ * space or at @p end. Exponents may be marked by E or D, as Fortran programs
+ * write them. The parsing does not depend on the locale, and does not
+ * allocate unless the number has more significant digits than a double holds.
+ * @return A pointer past the number, or nullptr if there is no number.
+ */
+AVOGADROQUANTUMIO_EXPORT const char* parseNumber(const char* begin,
+                                                 const char* end,
+                                                 double& value);
+
+/**
+ * @brief Parse the integer at @p begin, after any white space, ending at white
+ * space or at @p end.
+ * @return A pointer past the integer, or nullptr if there is no integer.
+ */
+AVOGADROQUANTUMIO_EXPORT const char* parseNumber(const char* begin,
+                                                 const char* end, int& value);
+
+/**
+ * @brief Parse a string holding a single number.
+ * @return True on success, false if @p string is not a number.
+ */
+AVOGADROQUANTUMIO_EXPORT bool parseNumber(const std::string& string,
+                                          double& value);
+
+/**
+ * @brief Parse up to @p count numbers separated by white space, line breaks
+ * included, from the block between @p begin and @p end into @p values.
+ * @return The number of values parsed, less than @p count if the block ends
+ * or holds something other than a number first.
+ */
+AVOGADROQUANTUMIO_EXPORT size_t parseNumbers(const char* begin,
+                                             const char* end, double* values,
+                                             size_t count);
+AVOGADROQUANTUMIO_EXPORT size_t parseNumbers(const char* begin,
+                                             const char* end, int* values,
+                                             size_t count);
+
+/**
+ * @brief Read the bytes of @p in between the offsets @p begin and @p end into
+ * @p block in one read, to be parsed in bulk.
+ * @return False if the stream could not be read.
+ */
+AVOGADROQUANTUMIO_EXPORT bool readBlock(std::istream& in,
+                                        std::streamoff begin,
+                                        std::streamoff end, std::string& block);
+
+} // End namespace QuantumIO
+} // End namespace Avogadro
+
+#endif // AVOGADRO_QUANTUMIO_NUMERICBLOCK_H
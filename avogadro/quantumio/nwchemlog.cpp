@@ -16,6 +16,8 @@
 
 #include "nwchemlog.h"
 
+#include "numericblock.h"
+
 #include <avogadro/core/elements.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/utilities.h>
@@ -166,8 +168,10 @@ void NWChemLog::readFrequencies(const std::string& firstLine, std::istream& in,
 
   // Main block of numbers.
   while (parts.size() >= 2) {
-    for (size_t i = 1; i < parts.size(); ++i) {
-      cols[i - 1].push_back(Core::lexicalCast<double>(parts[i], ok));
+    for (size_t i = 1; i < parts.size() && i <= cols.size(); ++i) {
+      double value(0.0);
+      ok = parseNumber(parts[i], value);
+      cols[i - 1].push_back(value);
       if (!ok) {
         appendError("Couldn't convert " + parts[i] + " to double.");
         return;
@@ -21,6 +21,7 @@
 #include "scene.h"
 
 #include "bufferobject.h"
+#include "renderstatistics.h"
 
 #include "shader.h"
 #include "shaderprogram.h"
@@ -524,11 +525,30 @@ const float ao_points[] = {
   -0.26286555606f,
   -0.951056516295f,
 };
+
+// The directions above are the vertices of a subdivided icosahedron, the first
+// 12 and 42 of them are the coarser subdivision levels. Baking proceeds level
+// by level so that a coarse result can be shown early and refined later.
+const int num_ao_levels = 3;
+const int ao_level_directions[num_ao_levels] = { 12, 42, num_ao_points };
+
+// Approximate number of sphere impostors drawn per frame while baking.
+const int ao_sphere_budget = 200000;
+// Preferred size of a sphere's tile in the AO texture [pixels], and the range
+// of texture sizes used.
+const int ao_tile_texels = 64;
+const int ao_min_texture_size = 512;
+const int ao_max_texture_size = 2048;
+// Spheres closer than this to the surface of a changed sphere are re-baked.
+const float ao_rebake_distance = 4.0f;
 }
 
 #include "avogadrogl.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <unordered_map>
 
 using std::cout;
 using std::endl;
@@ -553,9 +573,11 @@ class AmbientOcclusionBaker
 public:
   AmbientOcclusionBaker(AmbientOcclusionRenderer* renderer, GLint textureSize_)
     : m_renderer(renderer), m_textureSize(textureSize_), m_depthTexture(0),
-      m_depthFBO(0), m_aoTexture(0), m_aoFBO(0)
+      m_depthFBO(0), m_frontTexture(0), m_backTexture(0), m_aoFBO(0)
   {
+    m_openglState.save();
     initialize();
+    m_openglState.load();
   }
 
   void destroy()
@@ -563,16 +585,71 @@ public:
     // delete framebuffers
     glDeleteFramebuffers(1, &m_depthFBO);
     glDeleteFramebuffers(1, &m_aoFBO);
-    // delete depth texture
+    // delete textures
     glDeleteTextures(1, &m_depthTexture);
-    // note: ao texture not deleted since it contains the computed data...
+    glDeleteTextures(1, &m_frontTexture);
+    glDeleteTextures(1, &m_backTexture);
   }
 
   GLint textureSize() const { return m_textureSize; }
 
-  GLuint aoTexture() const { return m_aoTexture; }
+  /**
+   * The texture holding the last completed bake, safe to render with.
+   */
+  GLuint aoTexture() const { return m_frontTexture; }
+
+  /**
+   * Start a new bake into the back texture. If @p keep is true the completed
+   * bake is copied over first, so tiles that are not baked again keep their
+   * values.
+   */
+  void begin(bool keep)
+  {
+    m_openglState.save();
+
+    if (keep) {
+      // read from the front texture, copy into the back texture
+      glBindFramebuffer(GL_FRAMEBUFFER, m_aoFBO);
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                             GL_TEXTURE_2D, m_frontTexture, 0);
+      glReadBuffer(GL_COLOR_ATTACHMENT0);
+      glBindTexture(GL_TEXTURE_2D, m_backTexture);
+      glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, m_textureSize,
+                          m_textureSize);
+      glReadBuffer(GL_NONE);
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                             GL_TEXTURE_2D, m_backTexture, 0);
+    } else {
+      // the alpha channel is left untouched when accumulating, initialize it
+      glBindFramebuffer(GL_FRAMEBUFFER, m_aoFBO);
+      glClearColor(0.0, 0.0, 0.0, 1.0);
+      glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    m_openglState.load();
+  }
+
+  /**
+   * Make the back texture, which must be completely baked, the front texture.
+   */
+  void finish()
+  {
+    std::swap(m_frontTexture, m_backTexture);
+
+    m_openglState.save();
+    glBindFramebuffer(GL_FRAMEBUFFER, m_aoFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           m_backTexture, 0);
+    m_openglState.load();
+  }
 
-  void accumulateAO(const Vector3f& center, float radius)
+  /**
+   * Accumulate the AO for the light directions in [first, last) into the back
+   * texture. The bake is normalized for @p numDirections directions in total,
+   * the first direction overwrites the previous contents of the tiles.
+   */
+  void accumulateAO(const Vector3f& center, float radius, int first, int last,
+                    int numDirections)
   {
     // save OpenGL state
     m_openglState.save();
@@ -581,14 +658,11 @@ public:
     glViewport(0, 0, m_textureSize, m_textureSize);
     // set the clear depth value
     glClearDepth(1.0f);
-    // set the clear color
-    glClearColor(0.0, 0.0, 0.0, 1.0);
     // enable polygon offset to resolve depth fighting
     glEnable(GL_POLYGON_OFFSET_FILL);
     glPolygonOffset(2.0f, 4.0f);
     // enable alpha blending
     glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE);
     // bind the depth texture for depth lookup
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, m_depthTexture);
@@ -598,12 +672,13 @@ public:
                                  radius);
     Eigen::Matrix4f projection(camera.projection().matrix());
 
-    // clear draw buffer once, AO wil be accumulated using blending
-    glBindFramebuffer(GL_FRAMEBUFFER, m_aoFBO);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    for (int i = first; i < last; ++i) {
+      // the first direction replaces the color, the others are accumulated
+      if (i == 0)
+        glBlendFuncSeparate(GL_ONE, GL_ZERO, GL_ZERO, GL_ONE);
+      else
+        glBlendFunc(GL_ONE, GL_ONE);
 
-    for (int i = 0; i < num_ao_points; ++i) {
       // random light direction
       Vector3f dir(ao_points[i * 3], ao_points[i * 3 + 1],
                    ao_points[i * 3 + 2]);
@@ -613,7 +688,7 @@ public:
       // render depth to texture
       renderDepth(modelView, projection);
       // accumulate AO
-      renderAO(modelView, projection, num_ao_points);
+      renderAO(modelView, projection, numDirections);
     }
 
     // load OpenGL state
@@ -626,8 +701,9 @@ private:
     // create depth texture & FBO
     createDepthTexture();
     createDepthFBO();
-    // create AO texture & FBO
-    createAOTexture();
+    // create AO textures & FBO
+    createAOTexture(m_frontTexture);
+    createAOTexture(m_backTexture);
     createAOFBO();
   }
 
@@ -739,12 +815,12 @@ private:
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
   }
 
-  void createAOTexture()
+  void createAOTexture(GLuint& texture)
   {
     // create AO texture
-    glGenTextures(1, &m_aoTexture);
+    glGenTextures(1, &texture);
     // bind the AO texture
-    glBindTexture(GL_TEXTURE_2D, m_aoTexture);
+    glBindTexture(GL_TEXTURE_2D, texture);
     // allocate storage for the texture
     glTexImage2D(GL_TEXTURE_2D,                // target
                  0,                            // level
@@ -772,7 +848,7 @@ private:
     glBindFramebuffer(GL_FRAMEBUFFER, m_aoFBO);
     // attach the depth texture to the depth FBO
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
-                           m_aoTexture, 0);
+                           m_backTexture, 0);
 
     // disable draw and read buffer
     glReadBuffer(GL_NONE);
@@ -805,6 +881,8 @@ private:
   {
     void save()
     {
+      // bound framebuffer
+      glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
       // bound texture
       glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
       // viewport
@@ -825,6 +903,8 @@ private:
 
     void load()
     {
+      // bound framebuffer
+      glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
       // bound texture
       glBindTexture(GL_TEXTURE_2D, boundTexture);
       // viewport
@@ -842,8 +922,16 @@ private:
       else
         glEnable(GL_BLEND);
       glBlendFunc(blendSrc, blendDst);
+      // polygon offset
+      if (!polygonOffset)
+        glDisable(GL_POLYGON_OFFSET_FILL);
+      else
+        glEnable(GL_POLYGON_OFFSET_FILL);
+      glPolygonOffset(polygonOffsetFactor, polygonOffsetUnits);
     }
 
+    // bound framebuffer
+    GLint framebuffer;
     // bound texture
     GLint boundTexture;
     // viewport
@@ -869,28 +957,44 @@ private:
 
   GLuint m_depthTexture;
   GLuint m_depthFBO;
-  GLuint m_aoTexture;
+  GLuint m_frontTexture;
+  GLuint m_backTexture;
   GLuint m_aoFBO;
 };
 
 class SphereAmbientOcclusionRenderer : public AmbientOcclusionRenderer
 {
 public:
-  SphereAmbientOcclusionRenderer(BufferObject& vbo, BufferObject& ibo,
-                                 int numSpheres, int numVertices,
-                                 int numIndices)
-    : m_vbo(vbo), m_ibo(ibo), m_numSpheres(numSpheres),
-      m_numVertices(numVertices), m_numIndices(numIndices)
+  SphereAmbientOcclusionRenderer()
+    : m_vbo(nullptr), m_ibo(nullptr), m_aoIbo(nullptr), m_tilesPerRow(1),
+      m_numVertices(0), m_numIndices(0), m_numAOIndices(0)
   {
     initialize();
   }
 
+  /**
+   * Set the buffers to bake from. All spheres in @p ibo cast shadows, only
+   * the tiles of the spheres in @p aoIbo are baked.
+   */
+  void setGeometry(BufferObject* vbo, BufferObject* ibo, BufferObject* aoIbo,
+                   int tilesPerRow, int numVertices, int numIndices,
+                   int numAOIndices)
+  {
+    m_vbo = vbo;
+    m_ibo = ibo;
+    m_aoIbo = aoIbo;
+    m_tilesPerRow = tilesPerRow;
+    m_numVertices = numVertices;
+    m_numIndices = numIndices;
+    m_numAOIndices = numAOIndices;
+  }
+
   void renderDepth(const Eigen::Matrix4f& modelView,
                    const Eigen::Matrix4f& projection)
   {
     // bind buffer objects
-    m_vbo.bind();
-    m_ibo.bind();
+    m_vbo->bind();
+    m_ibo->bind();
 
     m_depthProgram.bind();
 
@@ -924,9 +1028,10 @@ public:
     glDrawRangeElements(GL_TRIANGLES, 0, static_cast<GLuint>(m_numVertices),
                         static_cast<GLsizei>(m_numIndices), GL_UNSIGNED_INT,
                         reinterpret_cast<const GLvoid*>(NULL));
+    RenderStatistics::countDrawCall(m_numIndices);
 
-    m_vbo.release();
-    m_ibo.release();
+    m_vbo->release();
+    m_ibo->release();
 
     m_depthProgram.disableAttributeArray("a_pos");
     m_depthProgram.disableAttributeArray("a_corner");
@@ -939,8 +1044,8 @@ public:
                 float numDirections)
   {
     // bind buffer objects
-    m_vbo.bind();
-    m_ibo.bind();
+    m_vbo->bind();
+    m_aoIbo->bind();
 
     m_aoProgram.bind();
 
@@ -956,8 +1061,7 @@ public:
       cout << m_aoProgram.error() << endl;
     }
     if (!m_aoProgram.setUniformValue(
-          "u_tileSize",
-          1.0f / std::ceil(std::sqrt(static_cast<float>(m_numSpheres))))) {
+          "u_tileSize", 1.0f / static_cast<float>(m_tilesPerRow))) {
       cout << m_aoProgram.error() << endl;
     }
     if (!m_aoProgram.setUniformValue("u_depthTex", 0)) {
@@ -996,11 +1100,12 @@ public:
 
     // draw
     glDrawRangeElements(GL_TRIANGLES, 0, static_cast<GLuint>(m_numVertices),
-                        static_cast<GLsizei>(m_numIndices), GL_UNSIGNED_INT,
+                        static_cast<GLsizei>(m_numAOIndices), GL_UNSIGNED_INT,
                         reinterpret_cast<const GLvoid*>(NULL));
+    RenderStatistics::countDrawCall(m_numAOIndices);
 
-    m_vbo.release();
-    m_ibo.release();
+    m_vbo->release();
+    m_aoIbo->release();
 
     m_aoProgram.disableAttributeArray("a_pos");
     m_aoProgram.disableAttributeArray("a_corner");
@@ -1065,20 +1170,278 @@ private:
   Shader m_aoFragmentShader;
   ShaderProgram m_aoProgram;
 
-  BufferObject& m_vbo;
-  BufferObject& m_ibo;
-  int m_numSpheres;
+  BufferObject* m_vbo;
+  BufferObject* m_ibo;
+  BufferObject* m_aoIbo;
+  int m_tilesPerRow;
   int m_numVertices;
   int m_numIndices;
+  int m_numAOIndices;
+};
+
+namespace {
+int aoTextureSize(int tilesPerRow)
+{
+  GLint maxSize = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+  int size = ao_min_texture_size;
+  while (size < tilesPerRow * ao_tile_texels && size < ao_max_texture_size)
+    size *= 2;
+  return maxSize > 0 ? std::min(size, static_cast<int>(maxSize)) : size;
+}
+
+bool sameShadow(const SphereColor& a, const SphereColor& b)
+{
+  return a.center == b.center && a.radius == b.radius;
+}
+
+long long cellKey(int x, int y, int z)
+{
+  return (static_cast<long long>(x & 0x1fffff) << 42) |
+         (static_cast<long long>(y & 0x1fffff) << 21) |
+         static_cast<long long>(z & 0x1fffff);
+}
+}
+
+class AmbientOcclusionBakeCache::Private
+{
+public:
+  Private()
+    : renderer(nullptr), baker(nullptr), tilesPerRow(0), radius(0.0f),
+      fullBake(true), baked(false), level(num_ao_levels), direction(0)
+  {
+  }
+
+  ~Private() { release(); }
+
+  void release()
+  {
+    if (baker) {
+      baker->destroy();
+      delete baker;
+      baker = nullptr;
+    }
+    if (renderer) {
+      renderer->destroy();
+      delete renderer;
+      renderer = nullptr;
+    }
+    spheres = Core::Array<SphereColor>();
+    pending.clear();
+    baked = false;
+    level = num_ao_levels;
+    direction = 0;
+  }
+
+  bool isComplete() const { return level >= num_ao_levels; }
+
+  void schedule(const Core::Array<SphereColor>& newSpheres, int tilesPerRow_,
+                int textureSize);
+  void addNearby(const Core::Array<SphereColor>& newSpheres,
+                 const std::vector<SphereColor>& changed);
+  void bake(int budget);
+
+  SphereAmbientOcclusionRenderer* renderer;
+  AmbientOcclusionBaker* baker;
+
+  // The spheres and tile layout of the current bake.
+  Core::Array<SphereColor> spheres;
+  int tilesPerRow;
+  Vector3f center;
+  float radius;
+
+  // The spheres being baked, and whether these are all of them.
+  std::vector<size_t> pending;
+  bool fullBake;
+
+  // True once the AO texture holds a completed bake.
+  bool baked;
+  // The level being baked, and the next direction within the level.
+  int level;
+  int direction;
 };
 
+void AmbientOcclusionBakeCache::Private::schedule(
+  const Core::Array<SphereColor>& newSpheres, int tilesPerRow_,
+  int textureSize)
+{
+  if (!baker || baker->textureSize() != textureSize) {
+    release();
+    renderer = new SphereAmbientOcclusionRenderer;
+    baker = new AmbientOcclusionBaker(renderer, textureSize);
+  }
+
+  if (!baked || tilesPerRow != tilesPerRow_) {
+    fullBake = true;
+  } else {
+    // Collect the changed spheres, at both their old and new positions.
+    std::vector<SphereColor> changed;
+    for (size_t i = 0; i < std::max(newSpheres.size(), spheres.size()); ++i) {
+      if (i < newSpheres.size() && i < spheres.size() &&
+          sameShadow(newSpheres[i], spheres[i])) {
+        continue;
+      }
+      if (i < spheres.size())
+        changed.push_back(spheres[i]);
+      if (i < newSpheres.size())
+        changed.push_back(newSpheres[i]);
+    }
+
+    // Nothing moved, keep refining the current bake.
+    if (changed.empty()) {
+      spheres = newSpheres;
+      return;
+    }
+
+    if (isComplete()) {
+      fullBake = false;
+      pending.clear();
+    }
+    if (changed.size() > newSpheres.size() / 2)
+      fullBake = true;
+    if (!fullBake) {
+      addNearby(newSpheres, changed);
+      if (pending.empty()) {
+        spheres = newSpheres;
+        level = num_ao_levels;
+        return;
+      }
+    }
+  }
+
+  if (fullBake) {
+    pending.resize(newSpheres.size());
+    for (size_t i = 0; i < pending.size(); ++i)
+      pending[i] = i;
+  }
+
+  spheres = newSpheres;
+  tilesPerRow = tilesPerRow_;
+  level = 0;
+  direction = 0;
+
+  // calculate center
+  center = Vector3f::Zero();
+  for (size_t i = 0; i < spheres.size(); ++i)
+    center += spheres[i].center;
+  center /= static_cast<float>(spheres.size());
+
+  // calculate radius
+  radius = 0.0f;
+  for (size_t i = 0; i < spheres.size(); ++i)
+    radius = std::max(radius, (spheres[i].center - center).norm());
+}
+
+void AmbientOcclusionBakeCache::Private::addNearby(
+  const Core::Array<SphereColor>& newSpheres,
+  const std::vector<SphereColor>& changed)
+{
+  // Hash the changed spheres into a grid with cells large enough that all
+  // spheres within range of a sphere are found in the neighboring cells.
+  float maxRadius = 0.0f;
+  for (size_t i = 0; i < newSpheres.size(); ++i)
+    maxRadius = std::max(maxRadius, newSpheres[i].radius);
+  for (size_t i = 0; i < changed.size(); ++i)
+    maxRadius = std::max(maxRadius, changed[i].radius);
+  const float cellSize = 2.0f * maxRadius + ao_rebake_distance;
+
+  std::unordered_map<long long, std::vector<size_t>> grid;
+  for (size_t i = 0; i < changed.size(); ++i) {
+    Vector3f cell = changed[i].center / cellSize;
+    grid[cellKey(static_cast<int>(std::floor(cell.x())),
+                 static_cast<int>(std::floor(cell.y())),
+                 static_cast<int>(std::floor(cell.z())))]
+      .push_back(i);
+  }
+
+  std::vector<bool> selected(newSpheres.size(), false);
+  for (size_t i = 0; i < pending.size(); ++i) {
+    if (pending[i] < selected.size())
+      selected[pending[i]] = true;
+  }
+
+  for (size_t i = 0; i < newSpheres.size(); ++i) {
+    if (selected[i])
+      continue;
+    const SphereColor& sphere = newSpheres[i];
+    Vector3f cell = sphere.center / cellSize;
+    int x = static_cast<int>(std::floor(cell.x()));
+    int y = static_cast<int>(std::floor(cell.y()));
+    int z = static_cast<int>(std::floor(cell.z()));
+    for (int dx = -1; dx <= 1 && !selected[i]; ++dx) {
+      for (int dy = -1; dy <= 1 && !selected[i]; ++dy) {
+        for (int dz = -1; dz <= 1 && !selected[i]; ++dz) {
+          auto it = grid.find(cellKey(x + dx, y + dy, z + dz));
+          if (it == grid.end())
+            continue;
+          for (size_t j = 0; j < it->second.size(); ++j) {
+            const SphereColor& other = changed[it->second[j]];
+            float range = sphere.radius + other.radius + ao_rebake_distance;
+            if ((sphere.center - other.center).squaredNorm() < range * range) {
+              selected[i] = true;
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  pending.clear();
+  for (size_t i = 0; i < selected.size(); ++i) {
+    if (selected[i])
+      pending.push_back(i);
+  }
+}
+
+void AmbientOcclusionBakeCache::Private::bake(int budget)
+{
+  while (!isComplete() && budget > 0) {
+    int numDirections = ao_level_directions[level];
+    // Partial bakes start from the previous result.
+    if (direction == 0)
+      baker->begin(!fullBake);
+
+    int last = std::min(numDirections, direction + budget);
+    baker->accumulateAO(center, radius + 2.0f, direction, last, numDirections);
+    budget -= last - direction;
+    direction = last;
+
+    if (direction == numDirections) {
+      baker->finish();
+      baked = true;
+      direction = 0;
+      ++level;
+    }
+  }
+}
+
+AmbientOcclusionBakeCache::AmbientOcclusionBakeCache() : d(new Private)
+{
+}
+
+AmbientOcclusionBakeCache::~AmbientOcclusionBakeCache()
+{
+  delete d;
+}
+
+void AmbientOcclusionBakeCache::clear()
+{
+  d->release();
+}
+
 class AmbientOcclusionSphereGeometry::Private
 {
 public:
-  Private() : aoTextureSize(1024) {}
+  Private()
+    : numberOfVertices(0), numberOfIndices(0), numberOfAOIndices(0),
+      cache(&ownCache), tilesPerRow(1), aoTextureSize(ao_min_texture_size)
+  {
+  }
 
   BufferObject vbo;
   BufferObject ibo;
+  BufferObject aoIbo;
 
   Shader vertexShader;
   Shader fragmentShader;
@@ -1086,10 +1449,12 @@ public:
 
   size_t numberOfVertices;
   size_t numberOfIndices;
+  size_t numberOfAOIndices;
 
-  Eigen::Matrix4f translate;
+  AmbientOcclusionBakeCache ownCache;
+  AmbientOcclusionBakeCache* cache;
+  int tilesPerRow;
   int aoTextureSize;
-  int aoTexture;
 };
 
 AmbientOcclusionSphereGeometry::AmbientOcclusionSphereGeometry()
@@ -1100,7 +1465,7 @@ AmbientOcclusionSphereGeometry::AmbientOcclusionSphereGeometry()
 AmbientOcclusionSphereGeometry::AmbientOcclusionSphereGeometry(
   const AmbientOcclusionSphereGeometry& other)
   : Drawable(other), m_spheres(other.m_spheres), m_indices(other.m_indices),
-    m_dirty(true), d(new Private)
+    m_bounds(other.m_bounds), m_dirty(true), d(new Private)
 {
 }
 
@@ -1119,17 +1484,20 @@ void AmbientOcclusionSphereGeometry::update()
   if (m_indices.empty() || m_spheres.empty())
     return;
 
+  AmbientOcclusionBakeCache::Private* bake = d->cache->d;
+
   // Check if the VBOs are ready, if not get them ready.
-  if (!d->vbo.ready() || m_dirty) {
+  if (!d->vbo.ready() || !bake->baker || m_dirty) {
     std::vector<unsigned int> sphereIndices;
     std::vector<ColorTextureVertex> sphereVertices;
     sphereIndices.reserve(m_indices.size() * 4);
     sphereVertices.reserve(m_spheres.size() * 4);
 
     int nSpheres = static_cast<int>(m_spheres.size());
-    int nSpheresSquared =
+    d->tilesPerRow =
       static_cast<int>(std::ceil(std::sqrt(static_cast<float>(nSpheres))));
-    float tileSize = 1.0f / static_cast<float>(nSpheresSquared);
+    d->aoTextureSize = aoTextureSize(d->tilesPerRow);
+    float tileSize = 1.0f / static_cast<float>(d->tilesPerRow);
     float halfTileSize = tileSize / 2.0f;
     int tileX = 0;
     int tileY = 0;
@@ -1137,27 +1505,6 @@ void AmbientOcclusionSphereGeometry::update()
     std::vector<size_t>::const_iterator itIndex = m_indices.begin();
     std::vector<SphereColor>::const_iterator itSphere = m_spheres.begin();
 
-    // calculate center
-    Vector3f center(Vector3f::Zero());
-    for (std::vector<SphereColor>::const_iterator i = m_spheres.begin();
-         i != m_spheres.end(); ++i)
-      center += i->center;
-    center /= static_cast<float>(nSpheres);
-
-    /*
-    d->translate = Eigen::Matrix4f::Identity();
-    d->translate(0, 3) = center.x();
-    d->translate(1, 3) = center.y();
-    d->translate(2, 3) = center.z();
-    */
-
-    // calculate radius
-    float radius = 0.0f;
-    for (std::vector<SphereColor>::const_iterator i = m_spheres.begin();
-         i != m_spheres.end(); ++i)
-      if ((i->center - center).norm() > radius)
-        radius = (i->center - center).norm();
-
     for (unsigned int i = 0;
          itIndex != m_indices.end() && itSphere != m_spheres.end();
          ++i, ++itIndex, ++itSphere) {
@@ -1185,7 +1532,7 @@ void AmbientOcclusionSphereGeometry::update()
       sphereIndices.push_back(index + 1);
 
       ++tileX;
-      if (tileX >= nSpheresSquared) {
+      if (tileX >= d->tilesPerRow) {
         // start new tile row
         tileX = 0;
         ++tileY;
@@ -1197,19 +1544,33 @@ void AmbientOcclusionSphereGeometry::update()
     d->numberOfVertices = sphereVertices.size();
     d->numberOfIndices = sphereIndices.size();
 
-    SphereAmbientOcclusionRenderer aoSphereRenderer(
-      d->vbo, d->ibo, static_cast<int>(m_spheres.size()),
-      static_cast<int>(d->numberOfVertices),
-      static_cast<int>(d->numberOfIndices));
-    AmbientOcclusionBaker baker(&aoSphereRenderer, d->aoTextureSize);
-    baker.accumulateAO(center, radius + 2.0f);
-    d->aoTexture = baker.aoTexture();
-    baker.destroy();
-    aoSphereRenderer.destroy();
+    // Work out which spheres need to be baked, and upload their quads.
+    bake->schedule(m_spheres, d->tilesPerRow, d->aoTextureSize);
+    std::vector<unsigned int> aoIndices;
+    aoIndices.reserve(bake->pending.size() * 6);
+    for (size_t i = 0; i < bake->pending.size(); ++i) {
+      std::vector<unsigned int>::const_iterator quad =
+        sphereIndices.begin() + 6 * bake->pending[i];
+      aoIndices.insert(aoIndices.end(), quad, quad + 6);
+    }
+    if (!aoIndices.empty())
+      d->aoIbo.upload(aoIndices, BufferObject::ElementArrayBuffer);
+    d->numberOfAOIndices = aoIndices.size();
 
     m_dirty = false;
   }
 
+  // Bake a few more light directions, a larger share for smaller molecules.
+  if (!bake->isComplete()) {
+    bake->renderer->setGeometry(&d->vbo, &d->ibo, &d->aoIbo, d->tilesPerRow,
+                                static_cast<int>(d->numberOfVertices),
+                                static_cast<int>(d->numberOfIndices),
+                                static_cast<int>(d->numberOfAOIndices));
+    int budget = ao_sphere_budget /
+                 static_cast<int>(m_spheres.size() + bake->pending.size());
+    bake->bake(std::max(budget, ao_level_directions[0]));
+  }
+
   // Build and link the shader if it has not been used yet.
   if (d->vertexShader.type() == Shader::Unknown) {
     d->vertexShader.setType(Shader::Vertex);
@@ -1236,7 +1597,7 @@ void AmbientOcclusionSphereGeometry::render(const Camera& camera)
   update();
 
   glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, d->aoTexture);
+  glBindTexture(GL_TEXTURE_2D, d->cache->d->baker->aoTexture());
 
   if (!d->program.bind())
     cout << d->program.error() << endl;
@@ -1298,7 +1659,7 @@ void AmbientOcclusionSphereGeometry::render(const Camera& camera)
   // width of a singl texel in texture coordinates [0, 1]
   float texel = 1.0f / static_cast<float>(d->aoTextureSize);
   // with of a single tile in texture coordinates [0, 1]
-  float tile = 1.f / std::ceil(std::sqrt(static_cast<float>(m_spheres.size())));
+  float tile = 1.f / static_cast<float>(d->tilesPerRow);
 
   // The uv coordinates, centered around the tileOffset are originally in the
   // range [-1, 1]. The denominator below ensures that these are scaled to
@@ -1307,8 +1668,7 @@ void AmbientOcclusionSphereGeometry::render(const Camera& camera)
   // interpolation taking values from neighboring texels into account.
   if (!d->program.setUniformValue(
         "u_texScale", (1.0f - 2.0f * texel / tile) /
-                        (2.0f * std::ceil(std::sqrt(
-                                  static_cast<float>(m_spheres.size())))))) {
+                        (2.0f * static_cast<float>(d->tilesPerRow)))) {
     cout << d->program.error() << endl;
   }
 
@@ -1316,6 +1676,7 @@ void AmbientOcclusionSphereGeometry::render(const Camera& camera)
   glDrawRangeElements(GL_TRIANGLES, 0, static_cast<GLuint>(d->numberOfVertices),
                       static_cast<GLsizei>(d->numberOfIndices), GL_UNSIGNED_INT,
                       reinterpret_cast<const GLvoid*>(NULL));
+  RenderStatistics::countDrawCall(d->numberOfIndices);
 
   d->vbo.release();
   d->ibo.release();
@@ -1328,6 +1689,27 @@ void AmbientOcclusionSphereGeometry::render(const Camera& camera)
   d->program.release();
 }
 
+bool AmbientOcclusionSphereGeometry::isBakeComplete() const
+{
+  return d->cache->d->isComplete();
+}
+
+void AmbientOcclusionSphereGeometry::setBakeCache(
+  AmbientOcclusionBakeCache* cache)
+{
+  if (!cache)
+    cache = &d->ownCache;
+  if (cache == d->cache)
+    return;
+  d->cache = cache;
+  m_dirty = true;
+}
+
+AmbientOcclusionBakeCache* AmbientOcclusionSphereGeometry::bakeCache() const
+{
+  return d->cache;
+}
+
 std::multimap<float, Identifier> AmbientOcclusionSphereGeometry::hits(
   const Vector3f& rayOrigin, const Vector3f& rayEnd,
   const Vector3f& rayDirection) const
@@ -1369,6 +1751,8 @@ void AmbientOcclusionSphereGeometry::addSphere(const Vector3f& position,
                                                float radius)
 {
   m_dirty = true;
+  const Vector3f extent(radius, radius, radius);
+  m_bounds.extend(position - extent).extend(position + extent);
   m_spheres.push_back(SphereColor(position, radius, color));
   m_indices.push_back(m_indices.size());
 }
@@ -1377,6 +1761,7 @@ void AmbientOcclusionSphereGeometry::clear()
 {
   m_spheres.clear();
   m_indices.clear();
+  m_bounds.setEmpty();
 }
 
 } // End namespace Rendering
@@ -27,6 +27,39 @@
 namespace Avogadro {
 namespace Rendering {
 
+/**
+ * @class AmbientOcclusionBakeCache ambientocclusionspheregeometry.h
+ * <avogadro/rendering/ambientocclusionspheregeometry.h>
+ * @brief The AmbientOcclusionBakeCache class keeps a baked ambient occlusion
+ * texture alive between AmbientOcclusionSphereGeometry objects.
+ *
+ * Scenes are usually rebuilt from scratch when the molecule changes. A
+ * geometry that uses the cache of its predecessor only re-bakes the spheres
+ * close to the ones that changed, and continues an unfinished bake. The cache
+ * holds OpenGL resources, so it must be used with a single context and should
+ * only be used by one geometry at a time. The GLRenderer keeps one for the
+ * scene it renders, see GLRenderVisitor::setBakeCache().
+ */
+class AVOGADRORENDERING_EXPORT AmbientOcclusionBakeCache
+{
+public:
+  AmbientOcclusionBakeCache();
+  ~AmbientOcclusionBakeCache();
+
+  /**
+   * Release the baked texture, the next geometry is baked from scratch.
+   */
+  void clear();
+
+private:
+  AmbientOcclusionBakeCache(const AmbientOcclusionBakeCache&);
+  AmbientOcclusionBakeCache& operator=(const AmbientOcclusionBakeCache&);
+
+  friend class AmbientOcclusionSphereGeometry;
+  class Private;
+  Private* d;
+};
+
 /**
  * @class AmbientOcclusionSphereGeometry ambientocclusionspheregeometry.h
  * <avogadro/rendering/ambientocclusionspheregeometry.h>
@@ -40,6 +73,9 @@ namespace Rendering {
  * ID for the purposes of picking.
  *
  * Unlike the SphereGeometry class, this class also supports ambient occlusion.
+ * The ambient occlusion is baked progressively over several frames, a coarse
+ * result is shown first and refined while isBakeComplete() returns false.
+ * The resolution of the bake depends on the number of spheres.
  */
 
 class AVOGADRORENDERING_EXPORT AmbientOcclusionSphereGeometry : public Drawable
@@ -69,6 +105,23 @@ public:
    */
   void render(const Camera& camera);
 
+  /**
+   * @return True if the ambient occlusion is fully baked, false if further
+   * calls to render() will refine it.
+   */
+  bool isBakeComplete() const;
+
+  /**
+   * Use @p cache to store the baked ambient occlusion, the geometry does not
+   * take ownership. If the cache holds the bake of a previous geometry, only
+   * the spheres near those that changed are baked again. By default every
+   * geometry bakes into its own cache.
+   * @{
+   */
+  void setBakeCache(AmbientOcclusionBakeCache* cache);
+  AmbientOcclusionBakeCache* bakeCache() const;
+  /** @} */
+
   /**
    * Return the primitives that are hit by the ray.
    * @param rayOrigin Origin of the ray.
@@ -80,6 +133,11 @@ public:
                                         const Vector3f& rayEnd,
                                         const Vector3f& rayDirection) const;
 
+  /**
+   * Get the bounding box of all spheres in the geometry.
+   */
+  Eigen::AlignedBox3f boundingBox() const override { return m_bounds; }
+
   /**
    * Add a sphere to the geometry object.
    */
@@ -105,6 +163,7 @@ public:
 private:
   Core::Array<SphereColor> m_spheres;
   Core::Array<size_t> m_indices;
+  Eigen::AlignedBox3f m_bounds;
 
   bool m_dirty;
 
@@ -127,6 +186,7 @@ inline void swap(AmbientOcclusionSphereGeometry& lhs,
   swap(static_cast<Drawable&>(lhs), static_cast<Drawable&>(rhs));
   swap(lhs.m_spheres, rhs.m_spheres);
   swap(lhs.m_indices, rhs.m_indices);
+  swap(lhs.m_bounds, rhs.m_bounds);
   lhs.m_dirty = rhs.m_dirty = true;
 }
 
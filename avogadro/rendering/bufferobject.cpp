@@ -17,6 +17,7 @@
 #include "bufferobject.h"
 
 #include "avogadrogl.h"
+#include "renderstatistics.h"
 
 namespace Avogadro {
 namespace Rendering {
@@ -101,6 +102,7 @@ bool BufferObject::uploadInternal(const void* buffer, size_t size,
   glBindBuffer(d->type, d->handle);
   glBufferData(d->type, size, static_cast<const GLvoid*>(buffer),
                GL_STATIC_DRAW);
+  RenderStatistics::countUpload(size);
   m_dirty = false;
   return true;
 }
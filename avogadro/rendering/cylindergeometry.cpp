@@ -17,10 +17,12 @@
 #include "cylindergeometry.h"
 
 #include "camera.h"
+#include "frustum.h"
 #include "scene.h"
 #include "visitor.h"
 
 #include "bufferobject.h"
+#include "renderstatistics.h"
 
 #include "shader.h"
 #include "shaderprogram.h"
@@ -34,6 +36,7 @@ namespace {
 
 #include <avogadro/core/matrix.h>
 
+#include <algorithm>
 #include <iostream>
 
 using std::cout;
@@ -42,6 +45,15 @@ using std::endl;
 namespace Avogadro {
 namespace Rendering {
 
+namespace {
+// Number of cylinders sharing a bounding box for frustum culling.
+const size_t chunkSize = 512;
+// Each cylinder is a tube with 12 points per circle, giving 24 vertices and
+// 72 indices, see update() for the details.
+const size_t verticesPerCylinder = 24;
+const size_t indicesPerCylinder = 72;
+}
+
 class CylinderGeometry::Private
 {
 public:
@@ -49,6 +61,7 @@ public:
 
   BufferObject vbo;
   BufferObject ibo;
+  BufferObject translationVbo;
 
   Shader vertexShader;
   Shader fragmentShader;
@@ -64,7 +77,9 @@ CylinderGeometry::CylinderGeometry() : m_dirty(false), d(new Private)
 
 CylinderGeometry::CylinderGeometry(const CylinderGeometry& other)
   : Drawable(other), m_cylinders(other.m_cylinders), m_indices(other.m_indices),
-    m_indexMap(other.m_indexMap), m_dirty(true), d(new Private)
+    m_indexMap(other.m_indexMap), m_bounds(other.m_bounds),
+    m_chunkBounds(other.m_chunkBounds), m_chunkRadii(other.m_chunkRadii),
+    m_dirty(true), d(new Private)
 {
 }
 
@@ -86,7 +101,8 @@ void CylinderGeometry::update()
   // Check if the VBOs are ready, if not get them ready.
   if (!d->vbo.ready() || m_dirty) {
     // Set some defaults for our cylinders.
-    const unsigned int resolution = 12; // points per circle
+    const unsigned int resolution =
+      static_cast<unsigned int>(verticesPerCylinder / 2); // points per circle
     const float resolutionRadians =
       2.0f * static_cast<float>(M_PI) / static_cast<float>(resolution);
     std::vector<Vector3f> radials;
@@ -155,6 +171,14 @@ void CylinderGeometry::update()
     m_dirty = false;
   }
 
+  if (m_translationsDirty) {
+    if (!m_translations.empty() &&
+        !d->translationVbo.upload(m_translations, BufferObject::ArrayBuffer)) {
+      cout << d->translationVbo.error() << endl;
+    }
+    m_translationsDirty = false;
+  }
+
   // Build and link the shader if it has not been used yet.
   if (d->vertexShader.type() == Shader::Unknown) {
     d->vertexShader.setType(Shader::Vertex);
@@ -173,6 +197,11 @@ void CylinderGeometry::update()
 }
 
 void CylinderGeometry::render(const Camera& camera)
+{
+  render(camera, 0.0f);
+}
+
+void CylinderGeometry::render(const Camera& camera, float minimumPixelRadius)
 {
   if (m_indices.empty() || m_cylinders.empty())
     return;
@@ -209,6 +238,25 @@ void CylinderGeometry::render(const Camera& camera)
     cout << d->program.error() << endl;
   }
 
+  // Draw a copy of the cylinders for each translation, as instances where
+  // supported and otherwise one after the other.
+  const size_t copies = std::max(m_translations.size(), static_cast<size_t>(1));
+  const bool instanced = copies > 1 && GLEW_VERSION_3_3;
+  if (instanced) {
+    d->translationVbo.bind();
+    if (!d->program.enableAttributeArray("translation"))
+      cout << d->program.error() << endl;
+    if (!d->program.useAttributeArray("translation", 0, sizeof(Vector3f),
+                                      FloatType, 3,
+                                      ShaderProgram::NoNormalize)) {
+      cout << d->program.error() << endl;
+    }
+    if (!d->program.setAttributeDivisor("translation", 1))
+      cout << d->program.error() << endl;
+  } else if (!d->program.setAttributeValue("translation", Vector3f::Zero())) {
+    cout << d->program.error() << endl;
+  }
+
   // Set up our uniforms (model-view and projection matrices right now).
   if (!d->program.setUniformValue("modelView", camera.modelView().matrix())) {
     cout << d->program.error() << endl;
@@ -220,10 +268,60 @@ void CylinderGeometry::render(const Camera& camera)
   if (!d->program.setUniformValue("normalMatrix", normalMatrix))
     std::cout << d->program.error() << std::endl;
 
-  // Render the loaded spheres using the shader and bound VBO.
-  glDrawRangeElements(GL_TRIANGLES, 0, static_cast<GLuint>(d->numberOfVertices),
-                      static_cast<GLsizei>(d->numberOfIndices), GL_UNSIGNED_INT,
-                      reinterpret_cast<const GLvoid*>(NULL));
+  // Render the loaded cylinders using the shader and bound VBO, skipping the
+  // chunks outside of the view frustum or too thin to cover a pixel.
+  // Consecutive visible chunks are drawn in a single call.
+  Frustum frustum(camera);
+  const size_t numberOfChunks = m_chunkBounds.size();
+  size_t runStart = 0;
+  bool inRun = false;
+  for (size_t chunk = 0; chunk <= numberOfChunks; ++chunk) {
+    Eigen::AlignedBox3f bounds;
+    if (chunk < numberOfChunks)
+      bounds = translatedBox(m_chunkBounds[chunk]);
+    bool visible = chunk < numberOfChunks && frustum.intersects(bounds);
+    if (visible && minimumPixelRadius > 0.0f) {
+      visible = frustum.projectedRadius(bounds, m_chunkRadii[chunk]) >=
+                minimumPixelRadius;
+    }
+    if (visible && !inRun) {
+      runStart = chunk;
+      inRun = true;
+    } else if (!visible && inRun) {
+      inRun = false;
+      size_t first = runStart * chunkSize;
+      size_t last =
+        std::min(chunk * chunkSize, d->numberOfIndices / indicesPerCylinder);
+      if (last <= first)
+        continue;
+      const GLsizei count =
+        static_cast<GLsizei>((last - first) * indicesPerCylinder);
+      const GLvoid* offset = reinterpret_cast<const GLvoid*>(
+        first * indicesPerCylinder * sizeof(unsigned int));
+      if (instanced) {
+        glDrawElementsInstanced(GL_TRIANGLES, count, GL_UNSIGNED_INT, offset,
+                                static_cast<GLsizei>(copies));
+        RenderStatistics::countDrawCall((last - first) * indicesPerCylinder *
+                                        copies);
+        continue;
+      }
+      for (size_t copy = 0; copy < copies; ++copy) {
+        if (!m_translations.empty())
+          d->program.setAttributeValue("translation", m_translations[copy]);
+        glDrawRangeElements(
+          GL_TRIANGLES, static_cast<GLuint>(first * verticesPerCylinder),
+          static_cast<GLuint>(last * verticesPerCylinder - 1), count,
+          GL_UNSIGNED_INT, offset);
+        RenderStatistics::countDrawCall((last - first) * indicesPerCylinder);
+      }
+    }
+  }
+
+  if (instanced) {
+    d->program.setAttributeDivisor("translation", 0);
+    d->program.disableAttributeArray("translation");
+    d->translationVbo.release();
+  }
 
   d->vbo.release();
   d->ibo.release();
@@ -241,8 +339,16 @@ std::multimap<float, Identifier> CylinderGeometry::hits(
 {
   std::multimap<float, Identifier> result;
 
-  for (size_t i = 0; i < m_cylinders.size(); ++i) {
-    const CylinderColor& cylinder = m_cylinders[i];
+  // Check every copy of the cylinders, the copies are identified as the
+  // cylinder itself.
+  const size_t copies = std::max(m_translations.size(), static_cast<size_t>(1));
+  for (size_t k = 0; k < m_cylinders.size() * copies; ++k) {
+    const size_t i = k % m_cylinders.size();
+    CylinderColor cylinder = m_cylinders[i];
+    if (!m_translations.empty()) {
+      cylinder.end1 += m_translations[k / m_cylinders.size()];
+      cylinder.end2 += m_translations[k / m_cylinders.size()];
+    }
 
     // Check for cylinder intersection with the ray.
     Vector3f ao = rayOrigin - cylinder.end1;
@@ -303,6 +409,18 @@ void CylinderGeometry::addCylinder(const Vector3f& pos1, const Vector3f& pos2,
                                    const Vector3ub& colorEnd)
 {
   m_dirty = true;
+  if (m_cylinders.size() % chunkSize == 0) {
+    m_chunkBounds.push_back(Eigen::AlignedBox3f());
+    m_chunkRadii.push_back(0.0f);
+  }
+  const Vector3f extent(radius, radius, radius);
+  m_chunkBounds.back()
+    .extend(pos1 - extent)
+    .extend(pos1 + extent)
+    .extend(pos2 - extent)
+    .extend(pos2 + extent);
+  m_chunkRadii.back() = std::max(m_chunkRadii.back(), radius);
+  m_bounds.extend(m_chunkBounds.back());
   m_cylinders.push_back(
     CylinderColor(pos1, pos2, radius, colorStart, colorEnd));
   m_indices.push_back(m_indices.size());
@@ -329,6 +447,9 @@ void CylinderGeometry::clear()
   m_cylinders.clear();
   m_indices.clear();
   m_indexMap.clear();
+  m_bounds.setEmpty();
+  m_chunkBounds.clear();
+  m_chunkRadii.clear();
 }
 
 } // End namespace Rendering
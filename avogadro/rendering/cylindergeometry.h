@@ -72,6 +72,15 @@ public:
    */
   void render(const Camera& camera);
 
+  /**
+   * @brief Render the cylinder geometry with level of detail.
+   * @param camera The current camera to be used for rendering.
+   * @param minimumPixelRadius Chunks of cylinders whose largest radius would
+   * project to less than this number of pixels are not drawn. A value of zero
+   * disables level of detail.
+   */
+  void render(const Camera& camera, float minimumPixelRadius);
+
   /**
    * Return the primitives that are hit by the ray.
    * @param rayOrigin Origin of the ray.
@@ -83,6 +92,14 @@ public:
                                         const Vector3f& rayEnd,
                                         const Vector3f& rayDirection) const;
 
+  /**
+   * Get the bounding box of all cylinders in the geometry.
+   */
+  Eigen::AlignedBox3f boundingBox() const override
+  {
+    return translatedBox(m_bounds);
+  }
+
   /**
    * @brief Add a cylinder to the geometry object.
    * @param position Base of the cylinder.
@@ -153,6 +170,12 @@ private:
   std::vector<size_t> m_indices;
   std::map<size_t, size_t> m_indexMap;
 
+  // Bounds of the whole geometry, and of consecutive chunks of cylinders used
+  // for view frustum culling, along with the largest radius in each chunk.
+  Eigen::AlignedBox3f m_bounds;
+  std::vector<Eigen::AlignedBox3f> m_chunkBounds;
+  std::vector<float> m_chunkRadii;
+
   bool m_dirty;
 
   class Private;
@@ -173,6 +196,9 @@ inline void swap(CylinderGeometry& lhs, CylinderGeometry& rhs)
   swap(lhs.m_cylinders, rhs.m_cylinders);
   swap(lhs.m_indices, rhs.m_indices);
   swap(lhs.m_indexMap, rhs.m_indexMap);
+  swap(lhs.m_bounds, rhs.m_bounds);
+  swap(lhs.m_chunkBounds, rhs.m_chunkBounds);
+  swap(lhs.m_chunkRadii, rhs.m_chunkRadii);
   lhs.m_dirty = rhs.m_dirty = true;
 }
 
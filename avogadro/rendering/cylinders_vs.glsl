@@ -1,4 +1,5 @@
 attribute vec4 vertex;
+attribute vec3 translation;
 attribute vec3 color;
 attribute vec3 normal;
 
@@ -11,6 +12,6 @@ varying vec3 fnormal;
 void main()
 {
   gl_FrontColor = vec4(color, 1.0);
-  gl_Position = projection * modelView * vertex;
+  gl_Position = projection * modelView * (vertex + vec4(translation, 0.0));
   fnormal = normalize(normalMatrix * normal);
 }
@@ -22,13 +22,16 @@ namespace Avogadro {
 namespace Rendering {
 
 Drawable::Drawable()
-  : m_parent(nullptr), m_visible(true), m_renderPass(OpaquePass)
+  : m_parent(nullptr), m_visible(true), m_renderPass(OpaquePass),
+    m_translationsDirty(false)
 {
 }
 
 Drawable::Drawable(const Drawable& other)
   : m_parent(other.m_parent), m_visible(other.m_visible),
-    m_renderPass(other.m_renderPass), m_identifier(other.m_identifier)
+    m_renderPass(other.m_renderPass), m_identifier(other.m_identifier),
+    m_translations(other.m_translations),
+    m_translationBounds(other.m_translationBounds), m_translationsDirty(true)
 {
 }
 
@@ -52,10 +55,33 @@ std::multimap<float, Identifier> Drawable::hits(const Vector3f&,
   return std::multimap<float, Identifier>();
 }
 
+Eigen::AlignedBox3f Drawable::boundingBox() const
+{
+  return Eigen::AlignedBox3f();
+}
+
 void Drawable::clear()
 {
 }
 
+void Drawable::setTranslations(const std::vector<Vector3f>& translations)
+{
+  m_translations = translations;
+  m_translationBounds.setEmpty();
+  for (size_t i = 0; i < m_translations.size(); ++i)
+    m_translationBounds.extend(m_translations[i]);
+  m_translationsDirty = true;
+}
+
+Eigen::AlignedBox3f Drawable::translatedBox(
+  const Eigen::AlignedBox3f& box) const
+{
+  if (m_translations.empty() || box.isEmpty())
+    return box;
+  return Eigen::AlignedBox3f(box.min() + m_translationBounds.min(),
+                             box.max() + m_translationBounds.max());
+}
+
 void Drawable::setParent(GeometryNode* parent_)
 {
   m_parent = parent_;
@@ -23,7 +23,10 @@
 #include "primitive.h"
 #include <avogadro/core/vector.h>
 
+#include <Eigen/Geometry>
+
 #include <map>
+#include <vector>
 
 namespace Avogadro {
 namespace Rendering {
@@ -109,14 +112,39 @@ public:
     const Vector3f& rayOrigin, const Vector3f& rayEnd,
     const Vector3f& rayDirection) const;
 
+  /**
+   * Get the axis-aligned bounding box of the drawable in scene coordinates,
+   * used to cull drawables that are outside of the view frustum. The default
+   * implementation returns an empty box, which is never culled.
+   */
+  virtual Eigen::AlignedBox3f boundingBox() const;
+
   /**
    * Clear the contents of the node.
    */
   virtual void clear();
 
+  /**
+   * The translations of the copies of the geometry to draw, e.g. to show the
+   * periodic images of a crystal. The copies are drawn with instancing where
+   * supported, so the geometry itself is not duplicated. When empty (the
+   * default) the geometry is drawn once without translation, otherwise the
+   * zero translation must be included to draw the geometry itself. Only some
+   * drawables support translations.
+   * @{
+   */
+  void setTranslations(const std::vector<Vector3f>& translations);
+  const std::vector<Vector3f>& translations() const { return m_translations; }
+  /** @} */
+
 protected:
   friend class GeometryNode;
 
+  /**
+   * @return The box bounding the copies of @a box for all translations.
+   */
+  Eigen::AlignedBox3f translatedBox(const Eigen::AlignedBox3f& box) const;
+
   /**
    * @brief Set the parent node for the node.
    * @param parent The parent, a value of nullptr denotes no parent node.
@@ -127,6 +155,9 @@ protected:
   bool m_visible;
   RenderPass m_renderPass;
   Identifier m_identifier;
+  std::vector<Vector3f> m_translations;
+  Eigen::AlignedBox3f m_translationBounds;
+  bool m_translationsDirty;
 };
 
 inline Drawable& Drawable::operator=(Drawable rhs)
@@ -143,6 +174,9 @@ inline void swap(Drawable& lhs, Drawable& rhs)
   swap(lhs.m_visible, rhs.m_visible);
   swap(lhs.m_renderPass, rhs.m_renderPass);
   swap(lhs.m_identifier, rhs.m_identifier);
+  swap(lhs.m_translations, rhs.m_translations);
+  swap(lhs.m_translationBounds, rhs.m_translationBounds);
+  lhs.m_translationsDirty = rhs.m_translationsDirty = true;
 }
 
 } // End namespace Rendering
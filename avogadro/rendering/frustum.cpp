@@ -0,0 +1,132 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "frustum.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace Avogadro {
+namespace Rendering {
+
+Frustum::Frustum()
+  : m_pixelsPerUnit(0.0f), m_perspective(true)
+{
+  // With all planes zeroed everything is considered inside.
+  m_planes.setZero();
+  m_modelView.setIdentity();
+}
+
+Frustum::Frustum(const Camera& camera)
+{
+  setCamera(camera);
+}
+
+void Frustum::setCamera(const Camera& camera)
+{
+  const Eigen::Matrix4f mvp =
+    camera.projection().matrix() * camera.modelView().matrix();
+
+  // Gribb/Hartmann plane extraction, planes point into the frustum.
+  m_planes.row(0) = mvp.row(3) + mvp.row(0); // left
+  m_planes.row(1) = mvp.row(3) - mvp.row(0); // right
+  m_planes.row(2) = mvp.row(3) + mvp.row(1); // bottom
+  m_planes.row(3) = mvp.row(3) - mvp.row(1); // top
+  m_planes.row(4) = mvp.row(3) + mvp.row(2); // near
+  m_planes.row(5) = mvp.row(3) - mvp.row(2); // far
+
+  // Normalize so that plane distances are in scene units.
+  for (int i = 0; i < 6; ++i) {
+    float norm = m_planes.row(i).head<3>().norm();
+    if (norm > 0.0f)
+      m_planes.row(i) /= norm;
+  }
+
+  m_modelView = camera.modelView();
+  // Perspective projections copy the view space depth into w.
+  m_perspective = camera.projection()(3, 2) != 0.0f;
+  // Element (1, 1) maps view space y to normalized device coordinates, which
+  // span two units over the height of the viewport.
+  m_pixelsPerUnit = 0.5f * static_cast<float>(camera.height()) *
+                    std::abs(camera.projection()(1, 1));
+}
+
+bool Frustum::intersects(const Eigen::AlignedBox3f& box) const
+{
+  if (box.isEmpty())
+    return true;
+
+  const Vector3f& minCorner = box.min();
+  const Vector3f& maxCorner = box.max();
+  for (int i = 0; i < 6; ++i) {
+    // Take the corner furthest along the plane normal, if it is behind the
+    // plane the whole box is outside.
+    Vector3f corner(m_planes(i, 0) >= 0.0f ? maxCorner.x() : minCorner.x(),
+                    m_planes(i, 1) >= 0.0f ? maxCorner.y() : minCorner.y(),
+                    m_planes(i, 2) >= 0.0f ? maxCorner.z() : minCorner.z());
+    if (m_planes.row(i).head<3>().dot(corner) + m_planes(i, 3) < 0.0f)
+      return false;
+  }
+  return true;
+}
+
+bool Frustum::intersects(const Vector3f& center, float radius) const
+{
+  for (int i = 0; i < 6; ++i) {
+    if (m_planes.row(i).head<3>().dot(center) + m_planes(i, 3) < -radius)
+      return false;
+  }
+  return true;
+}
+
+float Frustum::projectedRadius(const Vector3f& point, float radius) const
+{
+  // Without a viewport there is nothing to measure against.
+  if (m_pixelsPerUnit <= 0.0f)
+    return std::numeric_limits<float>::max();
+  if (!m_perspective)
+    return radius * m_pixelsPerUnit;
+
+  // The camera looks down the negative z axis in view space.
+  float depth = -(m_modelView * point).z() - radius;
+  if (depth <= std::numeric_limits<float>::epsilon())
+    return std::numeric_limits<float>::max();
+  return radius * m_pixelsPerUnit / depth;
+}
+
+float Frustum::projectedRadius(const Eigen::AlignedBox3f& box,
+                               float radius) const
+{
+  if (box.isEmpty() || m_pixelsPerUnit <= 0.0f)
+    return std::numeric_limits<float>::max();
+  if (!m_perspective)
+    return radius * m_pixelsPerUnit;
+
+  // Find the smallest depth of any corner of the box in view space.
+  float depth = std::numeric_limits<float>::max();
+  for (int i = 0; i < 8; ++i) {
+    Vector3f corner =
+      box.corner(static_cast<Eigen::AlignedBox3f::CornerType>(i));
+    depth = std::min(depth, -(m_modelView * corner).z());
+  }
+  depth -= radius;
+  if (depth <= std::numeric_limits<float>::epsilon())
+    return std::numeric_limits<float>::max();
+  return radius * m_pixelsPerUnit / depth;
+}
+
+} // End namespace Rendering
+} // End namespace Avogadro
@@ -0,0 +1,88 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_RENDERING_FRUSTUM_H
+#define AVOGADRO_RENDERING_FRUSTUM_H
+
+#include "avogadrorenderingexport.h"
+
+#include "camera.h"
+
+#include <avogadro/core/vector.h>
+
+#include <Eigen/Geometry>
+
+namespace Avogadro {
+namespace Rendering {
+
+/**
+ * @class Frustum frustum.h <avogadro/rendering/frustum.h>
+ * @brief The Frustum class holds the six clipping planes of a Camera.
+ *
+ * The planes are extracted from the combined projection and model view
+ * matrices, and are expressed in scene coordinates so that bounding volumes
+ * of drawables can be tested directly. It also provides an estimate of the
+ * size of an object once projected to the viewport, used for level of detail.
+ */
+
+class AVOGADRORENDERING_EXPORT Frustum
+{
+public:
+  Frustum();
+  explicit Frustum(const Camera& camera);
+
+  /**
+   * Extract the clipping planes from @p camera.
+   */
+  void setCamera(const Camera& camera);
+
+  /**
+   * @return True if the box @p box is at least partially inside the frustum.
+   * Empty boxes are considered to be visible, as they are used to denote
+   * drawables with unknown extent.
+   */
+  bool intersects(const Eigen::AlignedBox3f& box) const;
+
+  /**
+   * @return True if the sphere with @p center and @p radius is at least
+   * partially inside the frustum.
+   */
+  bool intersects(const Vector3f& center, float radius) const;
+
+  /**
+   * @return The approximate radius in pixels of an object of @p radius
+   * located at @p point once projected to the viewport. For perspective
+   * projections the closest point of the object to the eye is used.
+   */
+  float projectedRadius(const Vector3f& point, float radius) const;
+
+  /**
+   * @return The smallest radius in pixels that an object of @p radius
+   * anywhere inside @p box would have once projected to the viewport.
+   */
+  float projectedRadius(const Eigen::AlignedBox3f& box, float radius) const;
+
+private:
+  Eigen::Matrix<float, 6, 4> m_planes;
+  Eigen::Affine3f m_modelView;
+  float m_pixelsPerUnit;
+  bool m_perspective;
+};
+
+} // End namespace Rendering
+} // End namespace Avogadro
+
+#endif // AVOGADRO_RENDERING_FRUSTUM_H
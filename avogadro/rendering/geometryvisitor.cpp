@@ -20,6 +20,8 @@
 #include "linestripgeometry.h"
 #include "spheregeometry.h"
 
+#include <algorithm>
+
 namespace Avogadro {
 namespace Rendering {
 
@@ -61,6 +63,22 @@ void GeometryVisitor::visit(SphereGeometry& geometry)
     }
   }
   tmpRadius = std::sqrt(tmpRadius);
+
+  // Include the translated copies of the spheres, if any.
+  const std::vector<Vector3f>& translations = geometry.translations();
+  if (!translations.empty()) {
+    Vector3f meanTranslation(Vector3f::Zero());
+    for (size_t i = 0; i < translations.size(); ++i)
+      meanTranslation += translations[i];
+    meanTranslation /= static_cast<float>(translations.size());
+    float maxOffset(0.0f);
+    for (size_t i = 0; i < translations.size(); ++i)
+      maxOffset =
+        std::max(maxOffset, (translations[i] - meanTranslation).norm());
+    tmpCenter += meanTranslation;
+    tmpRadius += maxOffset;
+  }
+
   m_centers.push_back(tmpCenter);
   m_radii.push_back(tmpRadius);
 }
@@ -18,12 +18,15 @@
 
 #include "avogadrogl.h"
 
+#include "ambientocclusionspheregeometry.h"
+
 #include "geometrynode.h"
 #include "glrendervisitor.h"
 #include "shader.h"
 #include "shaderprogram.h"
 #include "textlabel2d.h"
 #include "textlabel3d.h"
+#include "textlabelbatch.h"
 #include "textrenderstrategy.h"
 #include "visitor.h"
 
@@ -35,14 +38,18 @@ namespace Avogadro {
 namespace Rendering {
 
 GLRenderer::GLRenderer()
-  : m_valid(false), m_textRenderStrategy(nullptr), m_center(Vector3f::Zero()),
-    m_radius(20.0)
+  : m_valid(false), m_textRenderStrategy(nullptr),
+    m_textLabelBatch(new TextLabelBatch),
+    m_bakeCache(new AmbientOcclusionBakeCache), m_center(Vector3f::Zero()),
+    m_radius(20.0), m_lodThreshold(0.0f), m_refining(false)
 {
   m_overlayCamera.setIdentity();
 }
 
 GLRenderer::~GLRenderer()
 {
+  delete m_bakeCache;
+  delete m_textLabelBatch;
   delete m_textRenderStrategy;
 }
 
@@ -77,34 +84,67 @@ void GLRenderer::render()
   if (!m_valid)
     return;
 
+  m_statistics.beginFrame();
+  RenderStatistics* stats =
+    m_statistics.isEnabled() ? &m_statistics : nullptr;
+
   Vector4ub c = m_scene.backgroundColor();
   glClearColor(c[0] / 255.0f, c[1] / 255.0f, c[2] / 255.0f, c[3] / 255.0f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   applyProjection();
 
+  // Text labels are queued during each pass and drawn in one batch from a
+  // shared atlas of rasterized strings.
+  m_textLabelBatch->atlas().setTextRenderStrategy(m_textRenderStrategy);
   GLRenderVisitor visitor(m_camera, m_textRenderStrategy);
+  visitor.setLevelOfDetailThreshold(m_lodThreshold);
+  visitor.setTextLabelBatch(m_textLabelBatch);
+  visitor.setBakeCache(m_bakeCache);
+  visitor.setStatistics(stats);
   // Setup for opaque geometry
+  m_statistics.beginSection("pass/opaque");
   visitor.setRenderPass(OpaquePass);
   glEnable(GL_DEPTH_TEST);
   glDisable(GL_BLEND);
   m_scene.rootNode().accept(visitor);
+  renderTextLabels(m_camera);
+  m_statistics.endSection();
 
   // Setup for transparent geometry
+  m_statistics.beginSection("pass/translucent");
   visitor.setRenderPass(TranslucentPass);
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   m_scene.rootNode().accept(visitor);
+  renderTextLabels(m_camera);
+  m_statistics.endSection();
 
   // Setup for 3d overlay rendering
+  m_statistics.beginSection("pass/overlay3d");
   visitor.setRenderPass(Overlay3DPass);
   glClear(GL_DEPTH_BUFFER_BIT);
   m_scene.rootNode().accept(visitor);
+  renderTextLabels(m_camera);
+  m_statistics.endSection();
 
   // Setup for 2d overlay rendering
+  m_statistics.beginSection("pass/overlay2d");
   visitor.setRenderPass(Overlay2DPass);
   visitor.setCamera(m_overlayCamera);
   glDisable(GL_DEPTH_TEST);
   m_scene.rootNode().accept(visitor);
+  renderTextLabels(m_overlayCamera);
+  m_statistics.endSection();
+
+  m_refining = visitor.isRefining();
+  m_statistics.endFrame();
+}
+
+void GLRenderer::renderTextLabels(const Camera& camera)
+{
+  m_statistics.beginSection("drawable/textlabels");
+  m_textLabelBatch->render(camera);
+  m_statistics.endSection();
 }
 
 void GLRenderer::resetCamera()
@@ -147,6 +187,8 @@ void GLRenderer::setTextRenderStrategy(TextRenderStrategy* tren)
 
     delete m_textRenderStrategy;
     m_textRenderStrategy = tren;
+    // The cached strings were rasterized by the old strategy.
+    m_textLabelBatch->atlas().setTextRenderStrategy(m_textRenderStrategy);
   }
 }
 
@@ -22,6 +22,7 @@
 #include "bufferobject.h"
 #include "camera.h"
 #include "primitive.h"
+#include "renderstatistics.h"
 #include "scene.h"
 #include "shader.h"
 #include "shaderprogram.h"
@@ -32,7 +33,9 @@
 
 namespace Avogadro {
 namespace Rendering {
+class AmbientOcclusionBakeCache;
 class GeometryNode;
+class TextLabelBatch;
 class TextRenderStrategy;
 
 /**
@@ -102,12 +105,42 @@ public:
   void setTextRenderStrategy(TextRenderStrategy* tren);
   /** @} */
 
+  /**
+   * The minimum radius in pixels a cylinder must project to in order to be
+   * rendered. Thinner cylinders, such as bonds in a zoomed out view of a large
+   * system, are skipped. The default of zero disables level of detail.
+   * @{
+   */
+  void setLevelOfDetailThreshold(float pixels) { m_lodThreshold = pixels; }
+  float levelOfDetailThreshold() const { return m_lodThreshold; }
+  /** @} */
+
+  /**
+   * @return True if the last call to render() left progressive work, such as
+   * baking ambient occlusion, unfinished. Render again to refine the image.
+   */
+  bool isRefining() const { return m_refining; }
+
+  /**
+   * Timings and counters of the last frame, broken down by render pass and
+   * drawable type. Collection must be enabled on the statistics first.
+   * @{
+   */
+  RenderStatistics& statistics() { return m_statistics; }
+  const RenderStatistics& statistics() const { return m_statistics; }
+  /** @} */
+
 private:
   /**
    * Apply the projection matrix.
    */
   void applyProjection();
 
+  /**
+   * Draw the text labels queued during the current pass.
+   */
+  void renderTextLabels(const Camera& camera);
+
   /**
    * @brief Detect hits in a group node.
    */
@@ -130,9 +163,16 @@ private:
   Camera m_overlayCamera;
   Scene m_scene;
   TextRenderStrategy* m_textRenderStrategy;
+  TextLabelBatch* m_textLabelBatch;
+  // Keeps the ambient occlusion of the scene between its rebuilds, in the
+  // context of the renderer.
+  AmbientOcclusionBakeCache* m_bakeCache;
 
   Vector3f m_center;
   float m_radius;
+  float m_lodThreshold;
+  bool m_refining;
+  RenderStatistics m_statistics;
 };
 
 inline const Camera& GLRenderer::camera() const
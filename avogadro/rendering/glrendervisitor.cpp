@@ -20,16 +20,43 @@
 #include "cylindergeometry.h"
 #include "linestripgeometry.h"
 #include "meshgeometry.h"
+#include "renderstatistics.h"
 #include "spheregeometry.h"
 #include "textlabel2d.h"
 #include "textlabel3d.h"
+#include "textlabelbatch.h"
 
 namespace Avogadro {
 namespace Rendering {
 
+namespace {
+// Times the enclosing scope as a section of the statistics, if any.
+class ScopedSection
+{
+public:
+  ScopedSection(RenderStatistics* statistics, const char* name)
+    : m_statistics(statistics)
+  {
+    if (m_statistics)
+      m_statistics->beginSection(name);
+  }
+  ~ScopedSection()
+  {
+    if (m_statistics)
+      m_statistics->endSection();
+  }
+
+private:
+  RenderStatistics* m_statistics;
+};
+}
+
 GLRenderVisitor::GLRenderVisitor(const Camera& camera_,
                                  const TextRenderStrategy* trs)
-  : m_camera(camera_), m_textRenderStrategy(trs), m_renderPass(NotRendering)
+  : m_camera(camera_), m_frustum(camera_), m_textRenderStrategy(trs),
+    m_textLabelBatch(nullptr), m_bakeCache(nullptr),
+    m_bakeCacheUser(nullptr), m_renderPass(NotRendering),
+    m_lodThreshold(0.0f), m_refining(false), m_statistics(nullptr)
 {
 }
 
@@ -37,39 +64,72 @@ GLRenderVisitor::~GLRenderVisitor()
 {
 }
 
+bool GLRenderVisitor::shouldRender(const Drawable& drawable) const
+{
+  if (drawable.renderPass() != m_renderPass)
+    return false;
+  // Overlays may be drawn with their own camera, such as the axes, so the
+  // frustum of the scene does not apply to them.
+  if (m_renderPass == Overlay3DPass || m_renderPass == Overlay2DPass)
+    return true;
+  return m_frustum.intersects(drawable.boundingBox());
+}
+
 void GLRenderVisitor::visit(Drawable& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (shouldRender(geometry)) {
+    ScopedSection section(m_statistics, "drawable/other");
     geometry.render(m_camera);
+  }
 }
 
 void GLRenderVisitor::visit(SphereGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (shouldRender(geometry)) {
+    ScopedSection section(m_statistics, "drawable/spheres");
     geometry.render(m_camera);
+  }
 }
 
 void GLRenderVisitor::visit(AmbientOcclusionSphereGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  // A cache only holds the bake of one geometry.
+  if (m_bakeCache && (!m_bakeCacheUser || m_bakeCacheUser == &geometry)) {
+    m_bakeCacheUser = &geometry;
+    geometry.setBakeCache(m_bakeCache);
+  }
+  if (shouldRender(geometry)) {
+    ScopedSection section(m_statistics, "drawable/ambientocclusionspheres");
     geometry.render(m_camera);
+    if (!geometry.isBakeComplete())
+      m_refining = true;
+  }
 }
 
 void GLRenderVisitor::visit(CylinderGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
-    geometry.render(m_camera);
+  if (shouldRender(geometry)) {
+    ScopedSection section(m_statistics, "drawable/cylinders");
+    geometry.render(m_camera, m_lodThreshold);
+  }
 }
 
 void GLRenderVisitor::visit(MeshGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (shouldRender(geometry)) {
+    ScopedSection section(m_statistics, "drawable/meshes");
     geometry.render(m_camera);
+  }
 }
 
 void GLRenderVisitor::visit(TextLabel2D& geometry)
 {
-  if (geometry.renderPass() == m_renderPass) {
+  if (shouldRender(geometry)) {
+    if (m_textLabelBatch) {
+      m_textLabelBatch->addLabel(geometry);
+      return;
+    }
+    ScopedSection section(m_statistics, "drawable/textlabels");
     if (m_textRenderStrategy)
       geometry.buildTexture(*m_textRenderStrategy);
     geometry.render(m_camera);
@@ -78,7 +138,12 @@ void GLRenderVisitor::visit(TextLabel2D& geometry)
 
 void GLRenderVisitor::visit(TextLabel3D& geometry)
 {
-  if (geometry.renderPass() == m_renderPass) {
+  if (shouldRender(geometry)) {
+    if (m_textLabelBatch) {
+      m_textLabelBatch->addLabel(geometry);
+      return;
+    }
+    ScopedSection section(m_statistics, "drawable/textlabels");
     if (m_textRenderStrategy)
       geometry.buildTexture(*m_textRenderStrategy);
     geometry.render(m_camera);
@@ -87,8 +152,10 @@ void GLRenderVisitor::visit(TextLabel3D& geometry)
 
 void GLRenderVisitor::visit(LineStripGeometry& geometry)
 {
-  if (geometry.renderPass() == m_renderPass)
+  if (shouldRender(geometry)) {
+    ScopedSection section(m_statistics, "drawable/linestrips");
     geometry.render(m_camera);
+  }
 }
 
 } // End namespace Rendering
@@ -21,9 +21,13 @@
 
 #include "avogadrorendering.h"
 #include "camera.h"
+#include "frustum.h"
 
 namespace Avogadro {
 namespace Rendering {
+class AmbientOcclusionBakeCache;
+class RenderStatistics;
+class TextLabelBatch;
 class TextRenderStrategy;
 
 /**
@@ -32,7 +36,9 @@ class TextRenderStrategy;
  * @brief Visitor that takes care of rendering the scene.
  * @author Marcus D. Hanwell
  *
- * This visitor will render elements in the scene.
+ * This visitor will render elements in the scene. In the opaque and
+ * translucent passes, drawables whose bounding box lies outside of the view
+ * frustum of the camera are skipped.
  */
 
 class AVOGADRORENDERING_EXPORT GLRenderVisitor : public Visitor
@@ -66,9 +72,38 @@ public:
   void visit(TextLabel3D& geometry) override;
   void visit(LineStripGeometry& geometry) override;
 
-  void setCamera(const Camera& camera_) { m_camera = camera_; }
+  void setCamera(const Camera& camera_)
+  {
+    m_camera = camera_;
+    m_frustum.setCamera(m_camera);
+  }
   Camera camera() const { return m_camera; }
 
+  /**
+   * The minimum radius in pixels a cylinder must project to in order to be
+   * rendered, thinner cylinders are skipped. Defaults to zero, which disables
+   * level of detail.
+   * @{
+   */
+  void setLevelOfDetailThreshold(float pixels) { m_lodThreshold = pixels; }
+  float levelOfDetailThreshold() const { return m_lodThreshold; }
+  /** @} */
+
+  /**
+   * @return True if a drawable rendered by this visitor is still being
+   * refined progressively, and should be rendered again.
+   */
+  bool isRefining() const { return m_refining; }
+
+  /**
+   * If set, the rendering of each drawable is timed as a section named after
+   * its type. The visitor does not take ownership of the statistics.
+   * @{
+   */
+  void setStatistics(RenderStatistics* stats) { m_statistics = stats; }
+  RenderStatistics* statistics() const { return m_statistics; }
+  /** @} */
+
   /**
    * A TextRenderStrategy implementation used to render text for annotations.
    * If nullptr, no text will be produced.
@@ -84,10 +119,44 @@ public:
   }
   /** @} */
 
+  /**
+   * If set, text labels are queued in @p batch to be drawn together at the
+   * end of the pass rather than rendered individually. The visitor does not
+   * take ownership of the batch.
+   * @{
+   */
+  void setTextLabelBatch(TextLabelBatch* batch) { m_textLabelBatch = batch; }
+  TextLabelBatch* textLabelBatch() const { return m_textLabelBatch; }
+  /** @} */
+
+  /**
+   * If set, the first AmbientOcclusionSphereGeometry visited keeps its ambient
+   * occlusion in @p cache, so that it is only re-baked where the scene changed
+   * since the geometry that used it before. The cache holds OpenGL resources,
+   * it must belong to the renderer of the visitor. The visitor does not take
+   * ownership of the cache.
+   * @{
+   */
+  void setBakeCache(AmbientOcclusionBakeCache* cache) { m_bakeCache = cache; }
+  AmbientOcclusionBakeCache* bakeCache() const { return m_bakeCache; }
+  /** @} */
+
 private:
+  /**
+   * @return True if the drawable should be rendered in the current pass.
+   */
+  bool shouldRender(const Drawable& drawable) const;
+
   Camera m_camera;
+  Frustum m_frustum;
   const TextRenderStrategy* m_textRenderStrategy;
+  TextLabelBatch* m_textLabelBatch;
+  AmbientOcclusionBakeCache* m_bakeCache;
+  AmbientOcclusionSphereGeometry* m_bakeCacheUser;
   RenderPass m_renderPass;
+  float m_lodThreshold;
+  bool m_refining;
+  RenderStatistics* m_statistics;
 };
 
 } // End namespace Rendering
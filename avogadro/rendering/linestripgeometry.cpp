@@ -18,6 +18,7 @@
 
 #include "avogadrogl.h"
 #include "bufferobject.h"
+#include "renderstatistics.h"
 #include "camera.h"
 #include "scene.h"
 #include "shader.h"
@@ -162,6 +163,7 @@ void LineStripGeometry::render(const Camera& camera)
     glLineWidth(*widthIter);
     glDrawArrays(GL_LINE_STRIP, static_cast<GLint>(startIndex),
                  static_cast<GLsizei>(endIndex - startIndex));
+    RenderStatistics::countDrawCall(endIndex - startIndex);
     ++startIter;
     ++widthIter;
   }
@@ -172,6 +174,7 @@ void LineStripGeometry::render(const Camera& camera)
   glLineWidth(*widthIter);
   glDrawArrays(GL_LINE_STRIP, static_cast<GLint>(startIndex),
                static_cast<GLsizei>(endIndex - startIndex));
+  RenderStatistics::countDrawCall(endIndex - startIndex);
 
   d->vbo.release();
 
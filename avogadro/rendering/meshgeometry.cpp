@@ -18,6 +18,7 @@
 
 #include "avogadrogl.h"
 #include "bufferobject.h"
+#include "renderstatistics.h"
 #include "camera.h"
 #include "scene.h"
 #include "shader.h"
@@ -72,7 +73,8 @@ MeshGeometry::MeshGeometry()
 
 MeshGeometry::MeshGeometry(const MeshGeometry& other)
   : Drawable(other), m_vertices(other.m_vertices), m_indices(other.m_indices),
-    m_color(other.m_color), m_opacity(other.m_opacity),
+    m_bounds(other.m_bounds), m_color(other.m_color),
+    m_opacity(other.m_opacity),
     m_dirty(true), // Force rendering internals to be rebuilt
     d(new Private)
 {
@@ -172,6 +174,7 @@ void MeshGeometry::render(const Camera& camera)
                       static_cast<GLuint>(d->numberOfVertices - 1),
                       static_cast<GLsizei>(d->numberOfIndices), GL_UNSIGNED_INT,
                       reinterpret_cast<const GLvoid*>(NULL));
+  RenderStatistics::countDrawCall(d->numberOfIndices);
 
   d->vbo.release();
   d->ibo.release();
@@ -200,6 +203,9 @@ unsigned int MeshGeometry::addVertices(const Core::Array<Vector3f>& v,
   while (vIter != vEnd)
     m_vertices.push_back(PackedVertex(*(cIter++), *(nIter++), *(vIter++)));
 
+  for (vIter = v.begin(); vIter != vEnd; ++vIter)
+    m_bounds.extend(*vIter);
+
   m_dirty = true;
 
   return static_cast<unsigned int>(result);
@@ -225,6 +231,9 @@ unsigned int MeshGeometry::addVertices(const Core::Array<Vector3f>& v,
     m_vertices.push_back(PackedVertex(tmpColor, *(nIter++), *(vIter++)));
   }
 
+  for (vIter = v.begin(); vIter != vEnd; ++vIter)
+    m_bounds.extend(*vIter);
+
   m_dirty = true;
 
   return static_cast<unsigned int>(result);
@@ -246,6 +255,9 @@ unsigned int MeshGeometry::addVertices(const Core::Array<Vector3f>& v,
   while (vIter != vEnd)
     m_vertices.push_back(PackedVertex(tmpColor, *(nIter++), *(vIter++)));
 
+  for (vIter = v.begin(); vIter != vEnd; ++vIter)
+    m_bounds.extend(*vIter);
+
   m_dirty = true;
 
   return static_cast<unsigned int>(result);
@@ -272,6 +284,7 @@ void MeshGeometry::clear()
 {
   m_vertices.clear();
   m_indices.clear();
+  m_bounds.setEmpty();
   m_dirty = true;
 }
 
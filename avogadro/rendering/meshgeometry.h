@@ -73,6 +73,11 @@ public:
    */
   void render(const Camera& camera);
 
+  /**
+   * Get the bounding box of the vertices in the mesh.
+   */
+  Eigen::AlignedBox3f boundingBox() const override { return m_bounds; }
+
   /**
    * Add vertices to the object. Note that this just adds vertices to the
    * object. Use addTriangles with size_t indices to actually draw them.
@@ -156,6 +161,7 @@ private:
 
   Core::Array<PackedVertex> m_vertices;
   Core::Array<unsigned int> m_indices;
+  Eigen::AlignedBox3f m_bounds;
   Vector3ub m_color;
   unsigned char m_opacity;
 
@@ -178,6 +184,7 @@ inline void swap(MeshGeometry& lhs, MeshGeometry& rhs)
   swap(static_cast<Drawable&>(lhs), static_cast<Drawable&>(rhs));
   swap(lhs.m_vertices, rhs.m_vertices);
   swap(lhs.m_indices, rhs.m_indices);
+  swap(lhs.m_bounds, rhs.m_bounds);
   swap(lhs.m_color, rhs.m_color);
   swap(lhs.m_opacity, rhs.m_opacity);
   lhs.m_dirty = rhs.m_dirty = true;
@@ -22,6 +22,7 @@
 #include "meshgeometry.h"
 #include "spheregeometry.h"
 
+#include <algorithm>
 #include <iostream>
 #include <ostream>
 
@@ -128,8 +129,13 @@ void POVRayVisitor::visit(Drawable& geometry)
 void POVRayVisitor::visit(SphereGeometry& geometry)
 {
   ostringstream str;
-  for (size_t i = 0; i < geometry.spheres().size(); ++i) {
-    Rendering::SphereColor s = geometry.spheres()[i];
+  const std::vector<Vector3f>& translations = geometry.translations();
+  const size_t copies = std::max(translations.size(), static_cast<size_t>(1));
+  const size_t count = geometry.spheres().size();
+  for (size_t i = 0; i < count * copies; ++i) {
+    Rendering::SphereColor s = geometry.spheres()[i % count];
+    if (!translations.empty())
+      s.center += translations[i / count];
     str << "sphere {\n\t<" << s.center << ">, " << s.radius
         << "\n\tpigment { rgbt <" << s.color << ", 0.0> }\n}\n";
   }
@@ -144,8 +150,15 @@ void POVRayVisitor::visit(AmbientOcclusionSphereGeometry& geometry)
 void POVRayVisitor::visit(CylinderGeometry& geometry)
 {
   ostringstream str;
-  for (size_t i = 0; i < geometry.cylinders().size(); ++i) {
-    Rendering::CylinderColor c = geometry.cylinders()[i];
+  const std::vector<Vector3f>& translations = geometry.translations();
+  const size_t copies = std::max(translations.size(), static_cast<size_t>(1));
+  const size_t count = geometry.cylinders().size();
+  for (size_t i = 0; i < count * copies; ++i) {
+    Rendering::CylinderColor c = geometry.cylinders()[i % count];
+    if (!translations.empty()) {
+      c.end1 += translations[i / count];
+      c.end2 += translations[i / count];
+    }
     str << "cylinder {\n"
         << "\t<" << c.end1 << ">,\n"
         << "\t<" << c.end2 << ">, " << c.radius << "\n\tpigment { rgbt <"
@@ -0,0 +1,231 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "renderstatistics.h"
+
+#include "avogadrogl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+namespace Avogadro {
+namespace Rendering {
+
+namespace {
+// Milliseconds since an arbitrary, fixed point in time.
+double now()
+{
+  using namespace std::chrono;
+  return duration<double, std::milli>(steady_clock::now().time_since_epoch())
+    .count();
+}
+
+std::string escape(const std::string& str)
+{
+  std::string result;
+  for (size_t i = 0; i < str.size(); ++i) {
+    if (str[i] == '"' || str[i] == '\\')
+      result += '\\';
+    result += str[i];
+  }
+  return result;
+}
+
+void writeTimings(std::ostream& out,
+                  const std::map<std::string, RenderStatistics::Timing>& map,
+                  bool gpu, const std::string& indent)
+{
+  out << "{";
+  std::map<std::string, RenderStatistics::Timing>::const_iterator it;
+  for (it = map.begin(); it != map.end(); ++it) {
+    out << (it == map.begin() ? "\n" : ",\n") << indent << "  \""
+        << escape(it->first) << "\": { \"cpuTime\": " << it->second.cpuTime;
+    if (gpu)
+      out << ", \"gpuTime\": " << it->second.gpuTime;
+    out << ", \"calls\": " << it->second.calls << " }";
+  }
+  if (!map.empty())
+    out << "\n" << indent;
+  out << "}";
+}
+}
+
+RenderStatistics* RenderStatistics::s_current = nullptr;
+
+RenderStatistics::RenderStatistics()
+  : m_enabled(false), m_gpuTimingEnabled(true), m_gpuTimings(false),
+    m_inFrame(false), m_drawCalls(0), m_vertices(0), m_uploadedBytes(0),
+    m_frameStart(0.0), m_frameQuery(-1), m_usedQueries(0)
+{
+}
+
+RenderStatistics::~RenderStatistics()
+{
+  if (s_current == this)
+    s_current = nullptr;
+  if (!m_queries.empty())
+    glDeleteQueries(static_cast<GLsizei>(m_queries.size()), &m_queries[0]);
+}
+
+void RenderStatistics::beginFrame()
+{
+  m_inFrame = false;
+  if (s_current == this)
+    s_current = nullptr;
+  if (!m_enabled)
+    return;
+
+  m_gpuTimings =
+    m_gpuTimingEnabled && (GLEW_VERSION_3_3 || GLEW_ARB_timer_query);
+  m_frameTimings.clear();
+  m_frameTime = Timing();
+  m_drawCalls = 0;
+  m_vertices = 0;
+  m_uploadedBytes = 0;
+  m_openSections.clear();
+  m_queryPairs.clear();
+  m_usedQueries = 0;
+
+  m_inFrame = true;
+  s_current = this;
+  m_frameStart = now();
+  m_frameQuery = timestampQuery();
+}
+
+void RenderStatistics::endFrame()
+{
+  if (!m_inFrame)
+    return;
+  while (!m_openSections.empty())
+    endSection();
+
+  int frameEndQuery = timestampQuery();
+  m_frameTime.cpuTime = now() - m_frameStart;
+  m_frameTime.calls = 1;
+  m_inFrame = false;
+  if (s_current == this)
+    s_current = nullptr;
+
+  if (!m_gpuTimings)
+    return;
+
+  // Wait for the timestamps, and add up the time elapsed in each section.
+  std::vector<GLuint64> timestamps(m_usedQueries, 0);
+  for (size_t i = 0; i < m_usedQueries; ++i)
+    glGetQueryObjectui64v(m_queries[i], GL_QUERY_RESULT, &timestamps[i]);
+  for (size_t i = 0; i < m_queryPairs.size(); ++i) {
+    const QueryPair& pair = m_queryPairs[i];
+    m_frameTimings[pair.name].gpuTime +=
+      static_cast<double>(timestamps[pair.end] - timestamps[pair.begin]) /
+      1.0e6;
+  }
+  m_frameTime.gpuTime =
+    static_cast<double>(timestamps[frameEndQuery] - timestamps[m_frameQuery]) /
+    1.0e6;
+}
+
+void RenderStatistics::beginSection(const std::string& name)
+{
+  if (!m_inFrame)
+    return;
+  OpenSection section;
+  section.name = name;
+  section.query = timestampQuery();
+  section.start = now();
+  m_openSections.push_back(section);
+}
+
+void RenderStatistics::endSection()
+{
+  if (!m_inFrame || m_openSections.empty())
+    return;
+  const OpenSection& section = m_openSections.back();
+  Timing& timing = m_frameTimings[section.name];
+  timing.cpuTime += now() - section.start;
+  ++timing.calls;
+  if (section.query >= 0) {
+    QueryPair pair;
+    pair.name = section.name;
+    pair.begin = section.query;
+    pair.end = timestampQuery();
+    m_queryPairs.push_back(pair);
+  }
+  m_openSections.pop_back();
+}
+
+void RenderStatistics::beginScene()
+{
+  m_sceneTimings.clear();
+}
+
+void RenderStatistics::addSceneTime(const std::string& name,
+                                    double milliseconds)
+{
+  if (!m_enabled)
+    return;
+  Timing& timing = m_sceneTimings[name];
+  timing.cpuTime += milliseconds;
+  ++timing.calls;
+}
+
+void RenderStatistics::countDrawCall(size_t vertices)
+{
+  if (s_current) {
+    ++s_current->m_drawCalls;
+    s_current->m_vertices += vertices;
+  }
+}
+
+void RenderStatistics::countUpload(size_t bytes)
+{
+  if (s_current)
+    s_current->m_uploadedBytes += bytes;
+}
+
+std::string RenderStatistics::toJson() const
+{
+  std::ostringstream out;
+  out << "{\n  \"frame\": {\n    \"cpuTime\": " << m_frameTime.cpuTime;
+  if (m_gpuTimings)
+    out << ",\n    \"gpuTime\": " << m_frameTime.gpuTime;
+  out << ",\n    \"drawCalls\": " << m_drawCalls
+      << ",\n    \"vertices\": " << m_vertices
+      << ",\n    \"uploadedBytes\": " << m_uploadedBytes
+      << ",\n    \"sections\": ";
+  writeTimings(out, m_frameTimings, m_gpuTimings, "    ");
+  out << "\n  },\n  \"scene\": ";
+  writeTimings(out, m_sceneTimings, false, "  ");
+  out << "\n}\n";
+  return out.str();
+}
+
+int RenderStatistics::timestampQuery()
+{
+  if (!m_gpuTimings)
+    return -1;
+  if (m_usedQueries == m_queries.size()) {
+    size_t count = std::max(m_queries.size(), static_cast<size_t>(16));
+    std::vector<unsigned int> queries(count, 0);
+    glGenQueries(static_cast<GLsizei>(count), &queries[0]);
+    m_queries.insert(m_queries.end(), queries.begin(), queries.end());
+  }
+  glQueryCounter(m_queries[m_usedQueries], GL_TIMESTAMP);
+  return static_cast<int>(m_usedQueries++);
+}
+
+} // End namespace Rendering
+} // End namespace Avogadro
@@ -0,0 +1,195 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_RENDERING_RENDERSTATISTICS_H
+#define AVOGADRO_RENDERING_RENDERSTATISTICS_H
+
+#include "avogadrorenderingexport.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Avogadro {
+namespace Rendering {
+
+/**
+ * @class RenderStatistics renderstatistics.h
+ * <avogadro/rendering/renderstatistics.h>
+ * @brief The RenderStatistics class collects timings and counters for frames.
+ *
+ * Frames are divided into named sections, such as the render passes and the
+ * drawable types, which are timed on the CPU and, when timer queries are
+ * supported, on the GPU. Sections may be nested and sections with the same
+ * name are accumulated. The time spent building the scene, e.g. in each scene
+ * plugin, is recorded separately as it happens outside of frames.
+ *
+ * Draw calls, vertices and uploaded bytes are counted through the static
+ * functions, which report to the statistics of the frame being rendered.
+ * Collection is disabled by default, and reading back the GPU timings
+ * synchronizes with the GPU at the end of each frame.
+ */
+
+class AVOGADRORENDERING_EXPORT RenderStatistics
+{
+public:
+  /** Accumulated timings of a section, in milliseconds. */
+  struct Timing
+  {
+    Timing() : cpuTime(0.0), gpuTime(0.0), calls(0) {}
+    double cpuTime;
+    double gpuTime;
+    int calls;
+  };
+
+  RenderStatistics();
+  ~RenderStatistics();
+
+  /**
+   * Enable or disable the collection of statistics.
+   * @{
+   */
+  void setEnabled(bool enable) { m_enabled = enable; }
+  bool isEnabled() const { return m_enabled; }
+  /** @} */
+
+  /**
+   * Start and finish a frame. A new frame discards the statistics of the
+   * previous one, and makes this object the target of the static counters.
+   * Must be called with the OpenGL context current.
+   * @{
+   */
+  void beginFrame();
+  void endFrame();
+  /** @} */
+
+  /**
+   * Start and finish a named section of the current frame.
+   * @{
+   */
+  void beginSection(const std::string& name);
+  void endSection();
+  /** @} */
+
+  /**
+   * Discard the scene timings, called before the scene is rebuilt.
+   */
+  void beginScene();
+
+  /**
+   * Add @p milliseconds of CPU time spent building the scene to @p name.
+   */
+  void addSceneTime(const std::string& name, double milliseconds);
+
+  /**
+   * Count a draw call of @p vertices vertices, or an upload of @p bytes bytes
+   * to the GPU, in the frame currently being rendered (if any).
+   * @{
+   */
+  static void countDrawCall(size_t vertices);
+  static void countUpload(size_t bytes);
+  /** @} */
+
+  /**
+   * The timings of the last frame, and of the last scene update.
+   * @{
+   */
+  const std::map<std::string, Timing>& frameTimings() const
+  {
+    return m_frameTimings;
+  }
+  const std::map<std::string, Timing>& sceneTimings() const
+  {
+    return m_sceneTimings;
+  }
+  /** @} */
+
+  /**
+   * The totals of the last frame.
+   * @{
+   */
+  Timing frameTime() const { return m_frameTime; }
+  size_t drawCalls() const { return m_drawCalls; }
+  size_t vertices() const { return m_vertices; }
+  size_t uploadedBytes() const { return m_uploadedBytes; }
+  /** @} */
+
+  /**
+   * Enable or disable GPU timer queries, enabled by default. They are only
+   * used if supported by the OpenGL implementation.
+   * @{
+   */
+  void setGpuTimingEnabled(bool enable) { m_gpuTimingEnabled = enable; }
+  bool isGpuTimingEnabled() const { return m_gpuTimingEnabled; }
+  /** @} */
+
+  /**
+   * @return True if the GPU timings of the last frame were measured.
+   */
+  bool hasGpuTimings() const { return m_gpuTimings; }
+
+  /**
+   * @return The statistics of the last frame and scene update as JSON.
+   */
+  std::string toJson() const;
+
+private:
+  // Non-copyable, holds OpenGL query objects.
+  RenderStatistics(const RenderStatistics&);
+  RenderStatistics& operator=(const RenderStatistics&);
+
+  struct OpenSection
+  {
+    std::string name;
+    double start;
+    int query;
+  };
+
+  struct QueryPair
+  {
+    std::string name;
+    int begin;
+    int end;
+  };
+
+  int timestampQuery();
+
+  bool m_enabled;
+  bool m_gpuTimingEnabled;
+  bool m_gpuTimings;
+  bool m_inFrame;
+
+  std::map<std::string, Timing> m_frameTimings;
+  std::map<std::string, Timing> m_sceneTimings;
+  Timing m_frameTime;
+  size_t m_drawCalls;
+  size_t m_vertices;
+  size_t m_uploadedBytes;
+
+  double m_frameStart;
+  int m_frameQuery;
+  std::vector<OpenSection> m_openSections;
+  std::vector<QueryPair> m_queryPairs;
+  std::vector<unsigned int> m_queries;
+  size_t m_usedQueries;
+
+  static RenderStatistics* s_current;
+};
+
+} // End namespace Rendering
+} // End namespace Avogadro
+
+#endif // AVOGADRO_RENDERING_RENDERSTATISTICS_H
@@ -276,6 +276,31 @@ bool ShaderProgram::useAttributeArray(const std::string& name, int offset,
   return true;
 }
 
+bool ShaderProgram::setAttributeDivisor(const std::string& name,
+                                        unsigned int divisor)
+{
+  GLint location = static_cast<GLint>(findAttributeArray(name));
+  if (location == -1) {
+    m_error = "Could not set divisor of attribute " + name +
+              ". No such attribute.";
+    return false;
+  }
+  glVertexAttribDivisor(location, divisor);
+  return true;
+}
+
+bool ShaderProgram::setAttributeValue(const std::string& name,
+                                      const Vector3f& v)
+{
+  GLint location = static_cast<GLint>(findAttributeArray(name));
+  if (location == -1) {
+    m_error = "Could not set attribute " + name + ". No such attribute.";
+    return false;
+  }
+  glVertexAttrib3fv(location, v.data());
+  return true;
+}
+
 bool ShaderProgram::setTextureSampler(const std::string& name,
                                       const Texture2D& texture)
 {
@@ -122,6 +122,19 @@ public:
                          Avogadro::Type elementType, int elementTupleSize,
                          NormalizeOption normalize);
 
+  /** Set the rate at which the named attribute array advances, in instances
+   * per element for instanced drawing. 0 (the default) advances once per
+   * vertex. Requires OpenGL 3.3, return false if the attribute array is not
+   * contained in the linked shader program.
+   */
+  bool setAttributeDivisor(const std::string& name, unsigned int divisor);
+
+  /** Set the value of the named attribute for every vertex, used while its
+   * attribute array is disabled. Return false if the attribute is not
+   * contained in the linked shader program.
+   */
+  bool setAttributeValue(const std::string& name, const Vector3f& v);
+
   /** Upload the supplied array of tightly packed values to the named attribute.
    * BufferObject attributes should be preferred and this may be removed in
    * future.
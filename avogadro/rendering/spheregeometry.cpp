@@ -17,9 +17,11 @@
 #include "spheregeometry.h"
 
 #include "camera.h"
+#include "frustum.h"
 #include "scene.h"
 
 #include "bufferobject.h"
+#include "renderstatistics.h"
 
 #include "shader.h"
 #include "shaderprogram.h"
@@ -33,6 +35,7 @@ namespace {
 
 #include "avogadrogl.h"
 
+#include <algorithm>
 #include <iostream>
 
 using std::cout;
@@ -41,6 +44,11 @@ using std::endl;
 namespace Avogadro {
 namespace Rendering {
 
+namespace {
+// Number of spheres sharing a bounding box for frustum culling.
+const size_t chunkSize = 1024;
+}
+
 class SphereGeometry::Private
 {
 public:
@@ -48,6 +56,7 @@ public:
 
   BufferObject vbo;
   BufferObject ibo;
+  BufferObject translationVbo;
 
   Shader vertexShader;
   Shader fragmentShader;
@@ -63,7 +72,8 @@ SphereGeometry::SphereGeometry() : m_dirty(false), d(new Private)
 
 SphereGeometry::SphereGeometry(const SphereGeometry& other)
   : Drawable(other), m_spheres(other.m_spheres), m_indices(other.m_indices),
-    m_dirty(true), d(new Private)
+    m_bounds(other.m_bounds), m_chunkBounds(other.m_chunkBounds), m_dirty(true),
+    d(new Private)
 {
 }
 
@@ -131,6 +141,14 @@ void SphereGeometry::update()
     m_dirty = false;
   }
 
+  if (m_translationsDirty) {
+    if (!m_translations.empty() &&
+        !d->translationVbo.upload(m_translations, BufferObject::ArrayBuffer)) {
+      cout << d->translationVbo.error() << endl;
+    }
+    m_translationsDirty = false;
+  }
+
   // Build and link the shader if it has not been used yet.
   if (d->vertexShader.type() == Shader::Unknown) {
     d->vertexShader.setType(Shader::Vertex);
@@ -185,6 +203,25 @@ void SphereGeometry::render(const Camera& camera)
     cout << d->program.error() << endl;
   }
 
+  // Draw a copy of the spheres for each translation, as instances where
+  // supported and otherwise one after the other.
+  const size_t copies = std::max(m_translations.size(), static_cast<size_t>(1));
+  const bool instanced = copies > 1 && GLEW_VERSION_3_3;
+  if (instanced) {
+    d->translationVbo.bind();
+    if (!d->program.enableAttributeArray("translation"))
+      cout << d->program.error() << endl;
+    if (!d->program.useAttributeArray("translation", 0, sizeof(Vector3f),
+                                      FloatType, 3,
+                                      ShaderProgram::NoNormalize)) {
+      cout << d->program.error() << endl;
+    }
+    if (!d->program.setAttributeDivisor("translation", 1))
+      cout << d->program.error() << endl;
+  } else if (!d->program.setAttributeValue("translation", Vector3f::Zero())) {
+    cout << d->program.error() << endl;
+  }
+
   // Set up our uniforms (model-view and projection matrices right now).
   if (!d->program.setUniformValue("modelView", camera.modelView().matrix())) {
     cout << d->program.error() << endl;
@@ -193,10 +230,50 @@ void SphereGeometry::render(const Camera& camera)
     cout << d->program.error() << endl;
   }
 
-  // Render the loaded spheres using the shader and bound VBO.
-  glDrawRangeElements(GL_TRIANGLES, 0, static_cast<GLuint>(d->numberOfVertices),
-                      static_cast<GLsizei>(d->numberOfIndices), GL_UNSIGNED_INT,
-                      reinterpret_cast<const GLvoid*>(NULL));
+  // Render the loaded spheres using the shader and bound VBO, skipping the
+  // chunks outside of the view frustum. Each sphere is a quad of 4 vertices
+  // and 6 indices, consecutive visible chunks are drawn in a single call.
+  Frustum frustum(camera);
+  const size_t numberOfChunks = m_chunkBounds.size();
+  size_t runStart = 0;
+  bool inRun = false;
+  for (size_t chunk = 0; chunk <= numberOfChunks; ++chunk) {
+    bool visible = chunk < numberOfChunks &&
+                   frustum.intersects(translatedBox(m_chunkBounds[chunk]));
+    if (visible && !inRun) {
+      runStart = chunk;
+      inRun = true;
+    } else if (!visible && inRun) {
+      inRun = false;
+      size_t first = runStart * chunkSize;
+      size_t last = std::min(chunk * chunkSize, d->numberOfIndices / 6);
+      if (last <= first)
+        continue;
+      const GLsizei count = static_cast<GLsizei>((last - first) * 6);
+      const GLvoid* offset =
+        reinterpret_cast<const GLvoid*>(first * 6 * sizeof(unsigned int));
+      if (instanced) {
+        glDrawElementsInstanced(GL_TRIANGLES, count, GL_UNSIGNED_INT, offset,
+                                static_cast<GLsizei>(copies));
+        RenderStatistics::countDrawCall((last - first) * 6 * copies);
+        continue;
+      }
+      for (size_t copy = 0; copy < copies; ++copy) {
+        if (!m_translations.empty())
+          d->program.setAttributeValue("translation", m_translations[copy]);
+        glDrawRangeElements(GL_TRIANGLES, static_cast<GLuint>(first * 4),
+                            static_cast<GLuint>(last * 4 - 1), count,
+                            GL_UNSIGNED_INT, offset);
+        RenderStatistics::countDrawCall((last - first) * 6);
+      }
+    }
+  }
+
+  if (instanced) {
+    d->program.setAttributeDivisor("translation", 0);
+    d->program.disableAttributeArray("translation");
+    d->translationVbo.release();
+  }
 
   d->vbo.release();
   d->ibo.release();
@@ -214,11 +291,16 @@ std::multimap<float, Identifier> SphereGeometry::hits(
 {
   std::multimap<float, Identifier> result;
 
-  // Check for intersection.
-  for (size_t i = 0; i < m_spheres.size(); ++i) {
-    const SphereColor& sphere = m_spheres[i];
+  // Check for intersection, with every copy of the spheres. The copies are
+  // identified as the sphere itself.
+  const size_t copies = std::max(m_translations.size(), static_cast<size_t>(1));
+  for (size_t i = 0; i < m_spheres.size() * copies; ++i) {
+    const SphereColor& sphere = m_spheres[i % m_spheres.size()];
+    Vector3f center = sphere.center;
+    if (!m_translations.empty())
+      center += m_translations[i / m_spheres.size()];
 
-    Vector3f distance = sphere.center - rayOrigin;
+    Vector3f distance = center - rayOrigin;
     float B = distance.dot(rayDirection);
     float C = distance.dot(distance) - (sphere.radius * sphere.radius);
     float D = B * B - C;
@@ -228,13 +310,13 @@ std::multimap<float, Identifier> SphereGeometry::hits(
       continue;
 
     // Test for clipping
-    if (B < 0 || (sphere.center - rayEnd).dot(rayDirection) > 0)
+    if (B < 0 || (center - rayEnd).dot(rayDirection) > 0)
       continue;
 
     Identifier id;
     id.molecule = m_identifier.molecule;
     id.type = m_identifier.type;
-    id.index = i;
+    id.index = i % m_spheres.size();
     if (id.type != InvalidType) {
       float rootD = static_cast<float>(sqrt(D));
       float depth = std::min(std::abs(B + rootD), std::abs(B - rootD));
@@ -248,6 +330,11 @@ void SphereGeometry::addSphere(const Vector3f& position, const Vector3ub& color,
                                float radius)
 {
   m_dirty = true;
+  if (m_spheres.size() % chunkSize == 0)
+    m_chunkBounds.push_back(Eigen::AlignedBox3f());
+  const Vector3f extent(radius, radius, radius);
+  m_chunkBounds.back().extend(position - extent).extend(position + extent);
+  m_bounds.extend(m_chunkBounds.back());
   m_spheres.push_back(SphereColor(position, radius, color));
   m_indices.push_back(m_indices.size());
 }
@@ -256,6 +343,8 @@ void SphereGeometry::clear()
 {
   m_spheres.clear();
   m_indices.clear();
+  m_bounds.setEmpty();
+  m_chunkBounds.clear();
 }
 
 } // End namespace Rendering
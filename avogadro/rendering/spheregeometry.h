@@ -22,6 +22,8 @@
 #include <avogadro/core/array.h>
 #include <avogadro/core/vector.h>
 
+#include <vector>
+
 namespace Avogadro {
 namespace Rendering {
 
@@ -85,6 +87,14 @@ public:
                                         const Vector3f& rayEnd,
                                         const Vector3f& rayDirection) const;
 
+  /**
+   * Get the bounding box of all spheres in the geometry.
+   */
+  Eigen::AlignedBox3f boundingBox() const override
+  {
+    return translatedBox(m_bounds);
+  }
+
   /**
    * Add a sphere to the geometry object.
    */
@@ -111,6 +121,11 @@ private:
   Core::Array<SphereColor> m_spheres;
   Core::Array<size_t> m_indices;
 
+  // Bounds of the whole geometry, and of consecutive chunks of spheres used
+  // to cull the parts of the geometry outside of the view frustum.
+  Eigen::AlignedBox3f m_bounds;
+  std::vector<Eigen::AlignedBox3f> m_chunkBounds;
+
   bool m_dirty;
 
   class Private;
@@ -130,6 +145,8 @@ inline void swap(SphereGeometry& lhs, SphereGeometry& rhs)
   swap(static_cast<Drawable&>(lhs), static_cast<Drawable&>(rhs));
   swap(lhs.m_spheres, rhs.m_spheres);
   swap(lhs.m_indices, rhs.m_indices);
+  swap(lhs.m_bounds, rhs.m_bounds);
+  swap(lhs.m_chunkBounds, rhs.m_chunkBounds);
   lhs.m_dirty = rhs.m_dirty = true;
 }
 
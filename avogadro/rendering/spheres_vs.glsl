@@ -1,4 +1,5 @@
 attribute vec4 vertex;
+attribute vec3 translation;
 attribute vec3 color;
 attribute vec2 texCoordinate;
 varying vec2 v_texCoord;
@@ -14,7 +15,7 @@ void main()
   radius = abs(texCoordinate.x);
   fColor = color;
   v_texCoord = texCoordinate / radius;
-  gl_Position = modelView * vertex;
+  gl_Position = modelView * (vertex + vec4(translation, 0.0));
   eyePosition = gl_Position;
 
   // Test if the closest point on the sphere would be clipped.
@@ -0,0 +1,141 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "textlabelatlas.h"
+
+#include "textrenderstrategy.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Avogadro {
+namespace Rendering {
+
+namespace {
+// Empty pixels between neighboring strings, avoids bleeding when sampling.
+const int padding = 1;
+// Initial height of the atlas image.
+const int initialHeight = 64;
+const size_t bytesPerPixel = 4; // RGBA
+}
+
+TextLabelAtlas::TextLabelAtlas(int width, int maxHeight)
+  : m_tren(nullptr), m_width(width), m_height(0), m_maxHeight(maxHeight),
+    m_cursor(0, 0), m_shelfHeight(0), m_generation(0), m_modified(false)
+{
+}
+
+TextLabelAtlas::~TextLabelAtlas()
+{
+}
+
+void TextLabelAtlas::setTextRenderStrategy(const TextRenderStrategy* tren)
+{
+  if (tren != m_tren) {
+    m_tren = tren;
+    clear();
+  }
+}
+
+const TextLabelAtlas::Entry* TextLabelAtlas::entry(
+  const std::string& text, const TextProperties& tprop)
+{
+  Key key(text, tprop);
+  std::map<Key, Entry>::const_iterator it = m_entries.find(key);
+  if (it != m_entries.end())
+    return &it->second;
+
+  if (!m_tren)
+    return nullptr;
+
+  int bbox[4];
+  m_tren->boundingBox(text, tprop, bbox);
+  const Vector2i dims(bbox[1] - bbox[0] + 1, bbox[3] - bbox[2] + 1);
+  if (dims[0] <= 0 || dims[1] <= 0 || dims[0] > m_width - padding ||
+      dims[1] > m_maxHeight - padding) {
+    return nullptr;
+  }
+
+  // Start over once the atlas is full, the caller must check generation() to
+  // know whether previously returned entries are still valid.
+  Vector2i origin;
+  if (!allocate(dims, origin)) {
+    clear();
+    if (!allocate(dims, origin))
+      return nullptr;
+  }
+
+  // Rasterize the string, then copy it in place row by row.
+  Core::Array<unsigned char> buffer(
+    static_cast<size_t>(dims[0] * dims[1]) * bytesPerPixel, 0);
+  m_tren->render(text, tprop, buffer.data(), dims);
+  const size_t rowBytes = static_cast<size_t>(dims[0]) * bytesPerPixel;
+  for (int row = 0; row < dims[1]; ++row) {
+    size_t target =
+      (static_cast<size_t>(origin[1] + row) * m_width + origin[0]) *
+      bytesPerPixel;
+    std::memcpy(m_image.data() + target,
+                buffer.data() + static_cast<size_t>(row) * rowBytes, rowBytes);
+  }
+  m_modified = true;
+
+  Entry& result = m_entries[key];
+  result.origin = origin;
+  result.dimensions = dims;
+  return &result;
+}
+
+void TextLabelAtlas::clear()
+{
+  m_entries.clear();
+  m_image.clear();
+  m_height = 0;
+  m_cursor = Vector2i(0, 0);
+  m_shelfHeight = 0;
+  ++m_generation;
+  m_modified = true;
+}
+
+bool TextLabelAtlas::allocate(const Vector2i& dims, Vector2i& origin)
+{
+  // Start a new shelf when the current one is full.
+  if (m_cursor[0] + dims[0] + padding > m_width) {
+    m_cursor = Vector2i(0, m_cursor[1] + m_shelfHeight);
+    m_shelfHeight = 0;
+  }
+
+  const int requiredHeight = m_cursor[1] + dims[1] + padding;
+  if (requiredHeight > m_maxHeight)
+    return false;
+
+  // Grow the image in powers of two, appending rows keeps existing entries in
+  // place.
+  if (requiredHeight > m_height) {
+    int newHeight = std::max(m_height, initialHeight);
+    while (newHeight < requiredHeight)
+      newHeight *= 2;
+    m_height = std::min(newHeight, m_maxHeight);
+    m_image.resize(static_cast<size_t>(m_width * m_height) * bytesPerPixel, 0);
+  }
+
+  origin = m_cursor;
+  m_cursor[0] += dims[0] + padding;
+  m_shelfHeight = std::max(m_shelfHeight, dims[1] + padding);
+  return true;
+}
+
+} // namespace Rendering
+} // namespace Avogadro
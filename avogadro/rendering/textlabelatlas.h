@@ -0,0 +1,134 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_RENDERING_TEXTLABELATLAS_H
+#define AVOGADRO_RENDERING_TEXTLABELATLAS_H
+
+#include "avogadrorenderingexport.h"
+
+#include "textproperties.h"
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/vector.h>
+
+#include <map>
+#include <string>
+#include <utility>
+
+namespace Avogadro {
+namespace Rendering {
+class TextRenderStrategy;
+
+/**
+ * @class TextLabelAtlas textlabelatlas.h
+ * <avogadro/rendering/textlabelatlas.h>
+ * @brief The TextLabelAtlas class caches rasterized strings in a single image.
+ *
+ * Each distinct combination of text and TextProperties is rendered once with
+ * the current TextRenderStrategy and packed into rows ("shelves") of a shared
+ * RGBA image, so that any number of labels can be drawn from one texture.
+ * Rasterized strings are kept until the strategy changes or the atlas runs
+ * out of space, in which case it is cleared and its generation() incremented.
+ */
+class AVOGADRORENDERING_EXPORT TextLabelAtlas
+{
+public:
+  /** The location of a rasterized string in the atlas image, in pixels. */
+  struct Entry
+  {
+    Vector2i origin;
+    Vector2i dimensions;
+  };
+
+  /**
+   * @param width The width of the atlas image in pixels.
+   * @param maxHeight The height the atlas image may grow to before it is
+   * cleared.
+   */
+  explicit TextLabelAtlas(int width = 1024, int maxHeight = 4096);
+  ~TextLabelAtlas();
+
+  /**
+   * The strategy used to rasterize strings. Changing it clears the atlas. The
+   * atlas does not take ownership of the strategy.
+   * @{
+   */
+  void setTextRenderStrategy(const TextRenderStrategy* tren);
+  const TextRenderStrategy* textRenderStrategy() const { return m_tren; }
+  /** @} */
+
+  /**
+   * Get the entry for @p text rendered with @p tprop, rasterizing it if it is
+   * not yet in the atlas. Returned pointers remain valid until the atlas is
+   * cleared.
+   * @return The entry, or nullptr if there is no render strategy or the
+   * string does not fit in the atlas.
+   */
+  const Entry* entry(const std::string& text, const TextProperties& tprop);
+
+  /** Remove all strings from the atlas. */
+  void clear();
+
+  /** @return The number of strings stored in the atlas. */
+  size_t size() const { return m_entries.size(); }
+
+  /**
+   * @return The number of times the atlas has been cleared. Entries obtained
+   * under an older generation are no longer valid.
+   */
+  unsigned int generation() const { return m_generation; }
+
+  /** @return The dimensions of the atlas image in pixels. */
+  Vector2i dimensions() const { return Vector2i(m_width, m_height); }
+
+  /**
+   * @return The RGBA atlas image, with the top scan row at the beginning.
+   */
+  const Core::Array<unsigned char>& image() const { return m_image; }
+
+  /**
+   * True if the image has changed since the flag was last reset, i.e. it
+   * needs to be uploaded again.
+   * @{
+   */
+  bool isModified() const { return m_modified; }
+  void setModified(bool modified) { m_modified = modified; }
+  /** @} */
+
+private:
+  typedef std::pair<std::string, TextProperties> Key;
+
+  // Find space for a block of the given dimensions, growing the image if
+  // needed. Returns false if the atlas is full.
+  bool allocate(const Vector2i& dims, Vector2i& origin);
+
+  const TextRenderStrategy* m_tren;
+  std::map<Key, Entry> m_entries;
+  Core::Array<unsigned char> m_image;
+  int m_width;
+  int m_height;
+  int m_maxHeight;
+  // Current shelf position and height.
+  Vector2i m_cursor;
+  int m_shelfHeight;
+  unsigned int m_generation;
+  bool m_modified;
+};
+
+} // namespace Rendering
+} // namespace Avogadro
+
+#endif // AVOGADRO_RENDERING_TEXTLABELATLAS_H
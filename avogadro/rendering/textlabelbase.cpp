@@ -18,6 +18,7 @@
 
 #include "avogadrogl.h"
 #include "bufferobject.h"
+#include "renderstatistics.h"
 #include "camera.h"
 #include "shader.h"
 #include "shaderprogram.h"
@@ -124,40 +125,10 @@ void TextLabelBase::RenderImpl::setOffsets(const Vector2i& dimensions,
                                            TextProperties::HAlign hAlign,
                                            TextProperties::VAlign vAlign)
 {
-  Vector2i& tl = vertices[0].offset;
-  Vector2i& tr = vertices[1].offset;
-  Vector2i& bl = vertices[2].offset;
-  Vector2i& br = vertices[3].offset;
-
-  switch (hAlign) {
-    case TextProperties::HLeft:
-      bl.x() = tl.x() = 0;
-      br.x() = tr.x() = dimensions.x() - 1;
-      break;
-    case TextProperties::HCenter:
-      bl.x() = tl.x() = -(dimensions.x() / 2);
-      br.x() = tr.x() = dimensions.x() / 2 + (dimensions.x() % 2 == 0 ? 1 : 0);
-      break;
-    case TextProperties::HRight:
-      bl.x() = tl.x() = -(dimensions.x() - 1);
-      br.x() = tr.x() = 0;
-      break;
-  }
-
-  switch (vAlign) {
-    case TextProperties::VTop:
-      bl.y() = br.y() = -(dimensions.y() - 1);
-      tl.y() = tr.y() = 0;
-      break;
-    case TextProperties::VCenter:
-      bl.y() = br.y() = -(dimensions.y() / 2);
-      tl.y() = tr.y() = dimensions.y() / 2 - (dimensions.y() % 2 == 0 ? 1 : 0);
-      break;
-    case TextProperties::VBottom:
-      bl.y() = br.y() = 0;
-      tl.y() = tr.y() = dimensions.y() - 1;
-      break;
-  }
+  Vector2i offsets[4];
+  TextLabelBase::quadOffsets(dimensions, hAlign, vAlign, offsets);
+  for (size_t i = 0; i < 4; ++i)
+    vertices[i].offset = offsets[i];
 
   vboInvalid = true;
 }
@@ -215,6 +186,7 @@ void TextLabelBase::RenderImpl::render(const Camera& cam)
 
   // Draw texture
   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  RenderStatistics::countDrawCall(4);
 
   // Release resources:
   shaderProgram.disableAttributeArray("texCoords");
@@ -359,6 +331,47 @@ float TextLabelBase::getRadiusInternal() const
   return m_render->radius;
 }
 
+void TextLabelBase::quadOffsets(const Vector2i& dimensions,
+                                TextProperties::HAlign hAlign,
+                                TextProperties::VAlign vAlign,
+                                Vector2i offsets[4])
+{
+  Vector2i& tl = offsets[0];
+  Vector2i& tr = offsets[1];
+  Vector2i& bl = offsets[2];
+  Vector2i& br = offsets[3];
+
+  switch (hAlign) {
+    case TextProperties::HLeft:
+      bl.x() = tl.x() = 0;
+      br.x() = tr.x() = dimensions.x() - 1;
+      break;
+    case TextProperties::HCenter:
+      bl.x() = tl.x() = -(dimensions.x() / 2);
+      br.x() = tr.x() = dimensions.x() / 2 + (dimensions.x() % 2 == 0 ? 1 : 0);
+      break;
+    case TextProperties::HRight:
+      bl.x() = tl.x() = -(dimensions.x() - 1);
+      br.x() = tr.x() = 0;
+      break;
+  }
+
+  switch (vAlign) {
+    case TextProperties::VTop:
+      bl.y() = br.y() = -(dimensions.y() - 1);
+      tl.y() = tr.y() = 0;
+      break;
+    case TextProperties::VCenter:
+      bl.y() = br.y() = -(dimensions.y() / 2);
+      tl.y() = tr.y() = dimensions.y() / 2 - (dimensions.y() % 2 == 0 ? 1 : 0);
+      break;
+    case TextProperties::VBottom:
+      bl.y() = br.y() = 0;
+      tl.y() = tr.y() = dimensions.y() - 1;
+      break;
+  }
+}
+
 void TextLabelBase::markDirty()
 {
   m_render->shadersInvalid = true;
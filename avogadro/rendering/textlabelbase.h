@@ -75,6 +75,8 @@ public:
   void resetTexture();
 
 protected:
+  friend class TextLabelBatch;
+
   std::string m_text;
   TextProperties m_textProperties;
   Vector2i m_imageDimensions;
@@ -90,6 +92,12 @@ protected:
 
   void markDirty();
 
+  // Pixel offsets of the top left, top right, bottom left and bottom right
+  // corners of a label with the given dimensions relative to its anchor.
+  static void quadOffsets(const Vector2i& dimensions,
+                          TextProperties::HAlign hAlign,
+                          TextProperties::VAlign vAlign, Vector2i offsets[4]);
+
 private:
   // Container for rendering cache:
   class RenderImpl;
@@ -0,0 +1,274 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "textlabelbatch.h"
+
+#include "avogadrogl.h"
+#include "bufferobject.h"
+#include "renderstatistics.h"
+#include "camera.h"
+#include "shader.h"
+#include "shaderprogram.h"
+#include "textlabelbase.h"
+#include "texture2d.h"
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/matrix.h>
+
+namespace {
+#include "textlabelbase_fs.h"
+#include "textlabelbatch_vs.h"
+} // end anon namespace
+
+#include <iostream>
+
+using Avogadro::Core::Array;
+
+namespace Avogadro {
+namespace Rendering {
+
+class TextLabelBatch::Private
+{
+public:
+  struct PackedVertex
+  {
+    Vector3f anchor; // 12 bytes (12)
+    float radius;    //  4 bytes (16)
+    Vector2i offset; //  8 bytes (24)
+    Vector2f tcoord; //  8 bytes (32)
+
+    static int anchorOffset() { return 0; }
+    static int radiusOffset() { return static_cast<int>(sizeof(Vector3f)); }
+    static int offsetOffset()
+    {
+      return radiusOffset() + static_cast<int>(sizeof(float));
+    }
+    static int tcoordOffset()
+    {
+      return offsetOffset() + static_cast<int>(sizeof(Vector2i));
+    }
+  };
+
+  Private() : shadersInvalid(true)
+  {
+    texture.setMinFilter(Texture2D::Nearest);
+    texture.setMagFilter(Texture2D::Nearest);
+    texture.setWrappingS(Texture2D::ClampToEdge);
+    texture.setWrappingT(Texture2D::ClampToEdge);
+  }
+
+  bool compileShaders();
+
+  Array<PackedVertex> vertices;
+  BufferObject vbo;
+  Texture2D texture;
+
+  Shader vertexShader;
+  Shader fragmentShader;
+  ShaderProgram shaderProgram;
+
+  bool shadersInvalid;
+};
+
+bool TextLabelBatch::Private::compileShaders()
+{
+  vertexShader.setType(Shader::Vertex);
+  vertexShader.setSource(textlabelbatch_vs);
+  if (!vertexShader.compile()) {
+    std::cerr << vertexShader.error() << std::endl;
+    return false;
+  }
+
+  fragmentShader.setType(Shader::Fragment);
+  fragmentShader.setSource(textlabelbase_fs);
+  if (!fragmentShader.compile()) {
+    std::cerr << fragmentShader.error() << std::endl;
+    return false;
+  }
+
+  shaderProgram.attachShader(vertexShader);
+  shaderProgram.attachShader(fragmentShader);
+  if (!shaderProgram.link()) {
+    std::cerr << shaderProgram.error() << std::endl;
+    return false;
+  }
+
+  shadersInvalid = false;
+  return true;
+}
+
+TextLabelBatch::TextLabelBatch() : d(new Private)
+{
+}
+
+TextLabelBatch::~TextLabelBatch()
+{
+  delete d;
+}
+
+void TextLabelBatch::addLabel(const TextLabelBase& label)
+{
+  if (!label.text().empty())
+    m_labels.push_back(&label);
+}
+
+bool TextLabelBatch::buildVertices()
+{
+  const unsigned int generation = m_atlas.generation();
+  d->vertices.clear();
+  d->vertices.reserve(m_labels.size() * 6);
+
+  // Texture coordinates are computed once the atlas has its final size, as it
+  // may grow while new strings are added. Store pixel coordinates for now.
+  Vector2i offsets[4];
+  for (std::vector<const TextLabelBase*>::const_iterator it = m_labels.begin(),
+                                                         itEnd = m_labels.end();
+       it != itEnd; ++it) {
+    const TextLabelBase& label = **it;
+    const TextLabelAtlas::Entry* entry =
+      m_atlas.entry(label.text(), label.textProperties());
+    if (m_atlas.generation() != generation)
+      return false;
+    if (!entry)
+      continue;
+
+    TextLabelBase::quadOffsets(entry->dimensions,
+                               label.textProperties().hAlign(),
+                               label.textProperties().vAlign(), offsets);
+
+    // The pixel centers of the corners of the string in the atlas.
+    const Vector2f minCorner(entry->origin.cast<float>() +
+                             Vector2f(0.5f, 0.5f));
+    const Vector2f maxCorner(
+      (entry->origin + entry->dimensions).cast<float>() -
+      Vector2f(0.5f, 0.5f));
+    const Vector2f tcoords[4] = { minCorner,
+                                  Vector2f(maxCorner.x(), minCorner.y()),
+                                  Vector2f(minCorner.x(), maxCorner.y()),
+                                  maxCorner };
+
+    // Two triangles per label: tl, tr, bl and bl, tr, br.
+    static const int corners[6] = { 0, 1, 2, 2, 1, 3 };
+    Private::PackedVertex vertex;
+    vertex.anchor = label.getAnchorInternal();
+    vertex.radius = label.getRadiusInternal();
+    for (int i = 0; i < 6; ++i) {
+      vertex.offset = offsets[corners[i]];
+      vertex.tcoord = tcoords[corners[i]];
+      d->vertices.push_back(vertex);
+    }
+  }
+  return true;
+}
+
+void TextLabelBatch::render(const Camera& camera)
+{
+  if (m_labels.empty())
+    return;
+
+  // If the atlas fills up it is cleared, and only the strings from this batch
+  // are added back on the second attempt.
+  if (!buildVertices() && !buildVertices()) {
+    std::cerr << "Too many distinct text labels to fit in the atlas."
+              << std::endl;
+  }
+  m_labels.clear();
+  if (d->vertices.empty())
+    return;
+
+  // Normalize the texture coordinates now the atlas size is known.
+  const Vector2f atlasDims(m_atlas.dimensions().cast<float>());
+  for (Array<Private::PackedVertex>::iterator it = d->vertices.begin(),
+                                              itEnd = d->vertices.end();
+       it != itEnd; ++it) {
+    it->tcoord = it->tcoord.cwiseQuotient(atlasDims);
+  }
+
+  if (m_atlas.isModified()) {
+    if (!d->texture.upload(m_atlas.image(), m_atlas.dimensions(),
+                           Texture2D::IncomingRGBA, Texture2D::InternalRGBA)) {
+      std::cerr << "Error uploading text label atlas: " << d->texture.error()
+                << std::endl;
+      return;
+    }
+    m_atlas.setModified(false);
+  }
+
+  if (d->shadersInvalid && !d->compileShaders())
+    return;
+
+  if (!d->vbo.upload(d->vertices, BufferObject::ArrayBuffer)) {
+    std::cerr << "TextLabelBatch VBO error: " << d->vbo.error() << std::endl;
+    return;
+  }
+
+  const Matrix4f mv(camera.modelView().matrix());
+  const Matrix4f proj(camera.projection().matrix());
+  const Vector2i vpDims(camera.width(), camera.height());
+
+  if (!d->vbo.bind()) {
+    std::cerr << "Error while binding TextLabelBatch VBO: " << d->vbo.error()
+              << std::endl;
+    return;
+  }
+
+  typedef Private::PackedVertex PackedVertex;
+  ShaderProgram& program = d->shaderProgram;
+  if (!program.bind() || !program.setUniformValue("mv", mv) ||
+      !program.setUniformValue("proj", proj) ||
+      !program.setUniformValue("vpDims", vpDims) ||
+      !program.setTextureSampler("texture", d->texture) ||
+
+      !program.enableAttributeArray("anchor") ||
+      !program.useAttributeArray("anchor", PackedVertex::anchorOffset(),
+                                 sizeof(PackedVertex), FloatType, 3,
+                                 ShaderProgram::NoNormalize) ||
+
+      !program.enableAttributeArray("radius") ||
+      !program.useAttributeArray("radius", PackedVertex::radiusOffset(),
+                                 sizeof(PackedVertex), FloatType, 1,
+                                 ShaderProgram::NoNormalize) ||
+
+      !program.enableAttributeArray("offset") ||
+      !program.useAttributeArray("offset", PackedVertex::offsetOffset(),
+                                 sizeof(PackedVertex), IntType, 2,
+                                 ShaderProgram::NoNormalize) ||
+
+      !program.enableAttributeArray("texCoord") ||
+      !program.useAttributeArray("texCoord", PackedVertex::tcoordOffset(),
+                                 sizeof(PackedVertex), FloatType, 2,
+                                 ShaderProgram::NoNormalize)) {
+    std::cerr << "Error setting up TextLabelBatch shader program: "
+              << program.error() << std::endl;
+    d->vbo.release();
+    program.release();
+    return;
+  }
+
+  // All labels in a single draw call.
+  glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(d->vertices.size()));
+  RenderStatistics::countDrawCall(d->vertices.size());
+
+  program.disableAttributeArray("texCoord");
+  program.disableAttributeArray("offset");
+  program.disableAttributeArray("radius");
+  program.disableAttributeArray("anchor");
+  program.release();
+  d->vbo.release();
+}
+
+} // namespace Rendering
+} // namespace Avogadro
@@ -0,0 +1,87 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_RENDERING_TEXTLABELBATCH_H
+#define AVOGADRO_RENDERING_TEXTLABELBATCH_H
+
+#include "avogadrorenderingexport.h"
+
+#include "textlabelatlas.h"
+
+#include <vector>
+
+namespace Avogadro {
+namespace Rendering {
+class Camera;
+class TextLabelBase;
+
+/**
+ * @class TextLabelBatch textlabelbatch.h <avogadro/rendering/textlabelbatch.h>
+ * @brief The TextLabelBatch class renders many text labels in one draw call.
+ *
+ * Labels are queued with addLabel() while the scene is visited, and drawn
+ * together by render() using a single vertex buffer and the texture of a
+ * shared TextLabelAtlas. The atlas persists between frames, so each distinct
+ * string is only rasterized once.
+ */
+class AVOGADRORENDERING_EXPORT TextLabelBatch
+{
+public:
+  TextLabelBatch();
+  ~TextLabelBatch();
+
+  /**
+   * The atlas holding the rasterized strings.
+   * @{
+   */
+  TextLabelAtlas& atlas() { return m_atlas; }
+  const TextLabelAtlas& atlas() const { return m_atlas; }
+  /** @} */
+
+  /**
+   * Queue @p label to be drawn by the next call to render(). The label must
+   * remain valid until then.
+   */
+  void addLabel(const TextLabelBase& label);
+
+  /** @return The number of queued labels. */
+  size_t size() const { return m_labels.size(); }
+
+  /**
+   * Draw all queued labels using @p camera, then clear the queue. Requires a
+   * current GL context.
+   */
+  void render(const Camera& camera);
+
+  /** Clear the queue without drawing. */
+  void clear() { m_labels.clear(); }
+
+private:
+  // Fill the vertex array for the queued labels, returns false if the atlas
+  // had to be cleared while doing so.
+  bool buildVertices();
+
+  TextLabelAtlas m_atlas;
+  std::vector<const TextLabelBase*> m_labels;
+
+  class Private;
+  Private* const d;
+};
+
+} // namespace Rendering
+} // namespace Avogadro
+
+#endif // AVOGADRO_RENDERING_TEXTLABELBATCH_H
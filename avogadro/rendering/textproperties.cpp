@@ -75,5 +75,23 @@ bool TextProperties::operator==(const TextProperties& other) const
          m_rgba[3] == other.m_rgba[3];
 }
 
+bool TextProperties::operator<(const TextProperties& other) const
+{
+  if (m_pixelHeight != other.m_pixelHeight)
+    return m_pixelHeight < other.m_pixelHeight;
+  if (m_hAlign != other.m_hAlign)
+    return m_hAlign < other.m_hAlign;
+  if (m_vAlign != other.m_vAlign)
+    return m_vAlign < other.m_vAlign;
+  if (m_rotationDegreesCW != other.m_rotationDegreesCW)
+    return m_rotationDegreesCW < other.m_rotationDegreesCW;
+  if (m_fontFamily != other.m_fontFamily)
+    return m_fontFamily < other.m_fontFamily;
+  if (m_fontStyles != other.m_fontStyles)
+    return m_fontStyles < other.m_fontStyles;
+  return std::lexicographical_compare(m_rgba, m_rgba + 4, other.m_rgba,
+                                      other.m_rgba + 4);
+}
+
 } // namespace Rendering
 } // namespace Avogadro
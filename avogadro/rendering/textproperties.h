@@ -80,6 +80,12 @@ public:
     return !operator==(other);
   }
 
+  /**
+   * Strict weak ordering of the properties, allowing them to be used as keys
+   * in sorted containers.
+   */
+  bool operator<(const TextProperties& other) const;
+
   /**
    * The height of the text in pixels.
    */
@@ -19,6 +19,8 @@
 
 #include "avogadrorenderingexport.h"
 
+#include "renderstatistics.h"
+
 #include <avogadro/core/avogadrocore.h>
 #include <avogadro/core/types.h>
 #include <avogadro/core/vector.h>
@@ -222,6 +224,8 @@ inline bool Texture2D::upload(const ContainerT& buffer, const Vector2i& dims,
       return false;
   }
 
+  RenderStatistics::countUpload(buffer.size() *
+                                sizeof(typename ContainerT::value_type));
   return uploadInternal(&buffer[0], dims, incomingFormat, incomingType,
                         internalFormat);
 }
@@ -22,6 +22,7 @@
 #include "meshgeometry.h"
 #include "spheregeometry.h"
 
+#include <algorithm>
 #include <iostream>
 #include <ostream>
 
@@ -110,8 +111,13 @@ void VRMLVisitor::visit(Drawable& geometry)
 void VRMLVisitor::visit(SphereGeometry& geometry)
 {
   ostringstream str;
-  for (size_t i = 0; i < geometry.spheres().size(); ++i) {
-    Rendering::SphereColor s = geometry.spheres()[i];
+  const std::vector<Vector3f>& translations = geometry.translations();
+  const size_t copies = std::max(translations.size(), static_cast<size_t>(1));
+  const size_t count = geometry.spheres().size();
+  for (size_t i = 0; i < count * copies; ++i) {
+    Rendering::SphereColor s = geometry.spheres()[i % count];
+    if (!translations.empty())
+      s.center += translations[i / count];
 
     str << "Transform {\n"
         << "\ttranslation\t" << s.center[0] << "\t" << s.center[1] << "\t"
@@ -132,8 +138,15 @@ void VRMLVisitor::visit(AmbientOcclusionSphereGeometry& geometry)
 void VRMLVisitor::visit(CylinderGeometry& geometry)
 {
   ostringstream str;
-  for (size_t i = 0; i < geometry.cylinders().size(); ++i) {
-    Rendering::CylinderColor c = geometry.cylinders()[i];
+  const std::vector<Vector3f>& translations = geometry.translations();
+  const size_t copies = std::max(translations.size(), static_cast<size_t>(1));
+  const size_t count = geometry.cylinders().size();
+  for (size_t i = 0; i < count * copies; ++i) {
+    Rendering::CylinderColor c = geometry.cylinders()[i % count];
+    if (!translations.empty()) {
+      c.end1 += translations[i / count];
+      c.end2 += translations[i / count];
+    }
 
     // double scale = 1.0;
     double x1, x2, y1, y2, z1, z2;
@@ -0,0 +1,31 @@
+# Runs avocrystal with several pipelines on a conventional cell of copper,
+# space group Fm-3m (225), and checks the status and atom count of each.
+
+# Check that the pipeline in steps ends with the status and atom count given.
+function(check_pipeline steps expected)
+  execute_process(COMMAND "${AVOCRYSTAL}" -s ${steps} "${INPUT}"
+    OUTPUT_VARIABLE output OUTPUT_STRIP_TRAILING_WHITESPACE ERROR_QUIET)
+  if(NOT output MATCHES "${expected}")
+    message(FATAL_ERROR
+      "avocrystal -s ${steps}: expected '${expected}', got:\n${output}")
+  endif()
+  message(STATUS "avocrystal -s ${steps}: ${output}")
+endfunction()
+
+# The other pipelines need spglib to detect the space group.
+execute_process(COMMAND "${AVOCRYSTAL}" -s spacegroup "${INPUT}"
+  OUTPUT_VARIABLE output OUTPUT_STRIP_TRAILING_WHITESPACE ERROR_QUIET)
+if(NOT output MATCHES "\tok\t4\t225\t")
+  message(STATUS "spglib did not detect the space group, skipping:\n${output}")
+  return()
+endif()
+
+check_pipeline(wrap,niggli,orient "\tok\t4$")
+check_pipeline(spacegroup,primitive "\tok\t1\t225\t")
+# The operations of the conventional cell do not apply to the primitive one.
+check_pipeline(spacegroup,primitive,fill "\tfill failed\t1\t225\t")
+check_pipeline(spacegroup,primitive,asymmetric "\tasymmetric failed\t1\t225\t")
+# The space group is detected again once the cell is conventional.
+check_pipeline(primitive,conventional,fill "\tok\t4\t225\t")
+check_pipeline(spacegroup,primitive,conventional,asymmetric "\tok\t1\t225\t")
+check_pipeline(asymmetric,fill "\tok\t4\t225\t")
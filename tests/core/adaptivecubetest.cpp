@@ -0,0 +1,119 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/adaptivecube.h>
+#include <avogadro/core/molecule.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using Avogadro::Vector3;
+using Avogadro::Vector3i;
+using Avogadro::Core::AdaptiveCube;
+using Avogadro::Core::Molecule;
+
+namespace {
+// Two blobs, one positive and one negative, like the lobes of an orbital.
+double lobes(const Vector3& position)
+{
+  return std::exp(-(position - Vector3(-1.0, 0.0, 0.0)).squaredNorm()) -
+         std::exp(-(position - Vector3(1.2, 0.3, 0.0)).squaredNorm());
+}
+}
+
+TEST(AdaptiveCubeTest, limits)
+{
+  AdaptiveCube cube;
+  EXPECT_FALSE(cube.evaluate(lobes, 0.1));
+  EXPECT_TRUE(cube.setLimits(Vector3(1.0, 2.0, 3.0), Vector3i(20, 10, 9), 0.1));
+  EXPECT_EQ(cube.brickDimensions(), Vector3i(3, 2, 1));
+  EXPECT_EQ(cube.dimensions(), Vector3i(25, 17, 9));
+  EXPECT_EQ(cube.min(), Vector3(1.0, 2.0, 3.0));
+  EXPECT_FALSE(cube.setLimits(Vector3::Zero(), Vector3i(1, 10, 10), 0.1));
+}
+
+TEST(AdaptiveCubeTest, refinement)
+{
+  AdaptiveCube cube;
+  cube.setLimits(Vector3(-6.0, -6.0, -6.0), Vector3i(61, 61, 61), 0.2);
+  const double iso = 0.1;
+  EXPECT_TRUE(cube.evaluate(lobes, iso));
+
+  const Vector3i bricks = cube.brickDimensions();
+  EXPECT_GT(cube.activeBricks().size(), 0u);
+  EXPECT_LT(cube.activeBricks().size(), static_cast<size_t>(bricks.prod() / 4));
+
+  // The values of the active bricks are those of the function.
+  const Vector3i& first = cube.activeBricks().front();
+  for (int i = 0; i <= AdaptiveCube::brickCells; i += 4) {
+    Vector3i point = first * AdaptiveCube::brickCells + Vector3i(i, 1, 8 - i);
+    Vector3 position = cube.min() + point.cast<double>() * 0.2;
+    EXPECT_DOUBLE_EQ(cube.brickValue(0, i, 1, 8 - i), lobes(position));
+    EXPECT_DOUBLE_EQ(cube.value(point.x(), point.y(), point.z()),
+                     lobes(position));
+  }
+
+  // Every cell crossed by a surface is in an active brick.
+  const Vector3i points = cube.dimensions();
+  std::vector<double> values;
+  for (int i = 0; i < points.x(); ++i) {
+    for (int j = 0; j < points.y(); ++j) {
+      for (int k = 0; k < points.z(); ++k)
+        values.push_back(lobes(cube.min() + Vector3(i, j, k) * 0.2));
+    }
+  }
+  for (int i = 0; i < points.x() - 1; ++i) {
+    for (int j = 0; j < points.y() - 1; ++j) {
+      for (int k = 0; k < points.z() - 1; ++k) {
+        double low = values[(i * points.y() + j) * points.z() + k];
+        double high = low;
+        for (int c = 1; c < 8; ++c) {
+          int index = ((i + (c & 1)) * points.y() + j + ((c >> 1) & 1)) *
+                        points.z() +
+                      k + (c >> 2);
+          low = std::min(low, values[index]);
+          high = std::max(high, values[index]);
+        }
+        if ((low <= iso && high > iso) || (low < -iso && high >= -iso)) {
+          EXPECT_TRUE(cube.isActive(Vector3i(i, j, k) /
+                                    AdaptiveCube::brickCells));
+        }
+      }
+    }
+  }
+}
+
+TEST(AdaptiveCubeTest, atoms)
+{
+  Molecule molecule;
+  molecule.addAtom(6).setPosition3d(Vector3(0.5, 0.5, 0.5));
+  AdaptiveCube cube;
+  EXPECT_FALSE(cube.setLimits(molecule, 0.0, 4.0));
+  EXPECT_FALSE(cube.setLimits(molecule, -0.1, 4.0));
+  EXPECT_TRUE(cube.setLimits(molecule, 0.1, 4.0));
+
+  // The function has no surface, the bricks around the atom are still kept.
+  EXPECT_TRUE(cube.evaluate([](const Vector3&) { return 0.0; }, 1.0));
+  Vector3i center =
+    ((Vector3(0.5, 0.5, 0.5) - cube.min()) / 0.1).cast<int>() /
+    AdaptiveCube::brickCells;
+  EXPECT_TRUE(cube.isActive(center));
+  EXPECT_FALSE(cube.isActive(Vector3i(0, 0, 0)));
+  EXPECT_EQ(cube.maxValue(), 0.0);
+}
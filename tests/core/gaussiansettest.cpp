@@ -0,0 +1,256 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/adaptivecube.h>
+#include <avogadro/core/gaussianset.h>
+#include <avogadro/core/gaussiansettools.h>
+#include <avogadro/core/molecule.h>
+
+#include <vector>
+
+using Avogadro::MatrixX;
+using Avogadro::Vector3;
+using Avogadro::Vector3i;
+using Avogadro::Core::AdaptiveCube;
+using Avogadro::Core::BasisSet;
+using Avogadro::Core::GaussianSet;
+using Avogadro::Core::GaussianSetTools;
+using Avogadro::Core::Molecule;
+using std::vector;
+
+namespace {
+const unsigned int basisCount = 4;
+
+// Four s functions, with four arbitrary molecular orbitals.
+void setUpBasis(GaussianSet& basis, BasisSet::ElectronType type)
+{
+  if (basis.gtoA().empty()) {
+    for (unsigned int i = 0; i < basisCount; ++i) {
+      basis.addBasis(0, GaussianSet::S);
+      basis.addGto(i, 1.0, 0.5 + i);
+    }
+  }
+  vector<double> mos;
+  for (unsigned int j = 0; j < basisCount; ++j) {
+    for (unsigned int i = 0; i < basisCount; ++i)
+      mos.push_back(0.1 * (i + 1) - 0.07 * j * j + (type == BasisSet::Beta));
+  }
+  basis.setMolecularOrbitals(mos, type);
+}
+
+// The density matrix element by element, as sum_k n_k C_ik C_jk.
+MatrixX naiveDensity(const MatrixX& c, const vector<double>& n)
+{
+  MatrixX density = MatrixX::Zero(c.rows(), c.rows());
+  for (int i = 0; i < c.rows(); ++i) {
+    for (int j = 0; j < c.rows(); ++j) {
+      for (size_t k = 0; k < n.size(); ++k)
+        density(i, j) += n[k] * c(i, k) * c(j, k);
+    }
+  }
+  return density;
+}
+
+const unsigned int moleculeBasisCount = 1 + 3 + 5 + 7;
+
+// Two atoms with s, p, d and f shells, the shells of the first atom come last
+// to exercise the grouping by atom.
+GaussianSet* setUpMolecule(Molecule& molecule)
+{
+  molecule.addAtom(8).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  molecule.addAtom(1).setPosition3d(Vector3(0.0, 0.0, 0.96));
+  GaussianSet* basis = new GaussianSet;
+  basis->addBasis(1, GaussianSet::S);
+  basis->addGto(0, 0.4, 1.2);
+  basis->addGto(0, 0.7, 0.2);
+  basis->addBasis(0, GaussianSet::P);
+  basis->addGto(1, 1.0, 0.9);
+  basis->addBasis(0, GaussianSet::D5);
+  basis->addGto(2, 1.0, 1.5);
+  basis->addBasis(0, GaussianSet::F7);
+  basis->addGto(3, 1.0, 0.8);
+  vector<double> mos;
+  for (unsigned int j = 0; j < moleculeBasisCount; ++j) {
+    for (unsigned int i = 0; i < moleculeBasisCount; ++i)
+      mos.push_back(i == j ? 1.0 : 0.01 * i);
+  }
+  basis->setMolecularOrbitals(mos);
+  basis->setElectronCount(4);
+  molecule.setBasisSet(basis);
+  basis->setMolecule(&molecule);
+  return basis;
+}
+}
+
+TEST(GaussianSetTest, restrictedDensity)
+{
+  GaussianSet basis;
+  setUpBasis(basis, BasisSet::Paired);
+  basis.setElectronCount(4);
+
+  EXPECT_TRUE(basis.generateDensityMatrix());
+  MatrixX expected = naiveDensity(basis.moMatrix(), { 2.0, 2.0 });
+  EXPECT_TRUE(basis.densityMatrix().isApprox(expected));
+  EXPECT_EQ(basis.spinDensityMatrix().size(), 0);
+}
+
+TEST(GaussianSetTest, unrestrictedDensity)
+{
+  GaussianSet basis;
+  basis.setScfType(Avogadro::Core::Uhf);
+  setUpBasis(basis, BasisSet::Alpha);
+  setUpBasis(basis, BasisSet::Beta);
+  basis.setElectronCount(3, BasisSet::Alpha);
+  basis.setElectronCount(1, BasisSet::Beta);
+
+  EXPECT_TRUE(basis.generateDensityMatrix());
+  MatrixX alpha =
+    naiveDensity(basis.moMatrix(BasisSet::Alpha), { 1.0, 1.0, 1.0 });
+  MatrixX beta = naiveDensity(basis.moMatrix(BasisSet::Beta), { 1.0 });
+  EXPECT_TRUE(basis.densityMatrix().isApprox(alpha + beta));
+  EXPECT_TRUE(basis.spinDensityMatrix().isApprox(alpha - beta));
+}
+
+TEST(GaussianSetTest, restrictedOpenShellDensity)
+{
+  GaussianSet basis;
+  basis.setScfType(Avogadro::Core::Rohf);
+  setUpBasis(basis, BasisSet::Paired);
+  basis.setElectronCount(3, BasisSet::Alpha);
+  basis.setElectronCount(1, BasisSet::Beta);
+
+  EXPECT_TRUE(basis.generateDensityMatrix());
+  MatrixX expected = naiveDensity(basis.moMatrix(), { 2.0, 1.0, 1.0 });
+  EXPECT_TRUE(basis.densityMatrix().isApprox(expected));
+  expected = naiveDensity(basis.moMatrix(), { 0.0, 1.0, 1.0 });
+  EXPECT_TRUE(basis.spinDensityMatrix().isApprox(expected));
+}
+
+TEST(GaussianSetTest, fractionalOccupancy)
+{
+  GaussianSet basis;
+  setUpBasis(basis, BasisSet::Paired);
+  basis.setElectronCount(4);
+  vector<double> occ = { 1.98, 1.5, 0.5, 0.02 };
+  basis.setMolecularOrbitalOccupancy(occ);
+
+  EXPECT_TRUE(basis.generateDensityMatrix());
+  MatrixX expected = naiveDensity(basis.moMatrix(), occ);
+  EXPECT_TRUE(basis.densityMatrix().isApprox(expected));
+}
+
+TEST(GaussianSetTest, densityCache)
+{
+  GaussianSet basis;
+  setUpBasis(basis, BasisSet::Paired);
+  basis.setElectronCount(2);
+  EXPECT_TRUE(basis.generateDensityMatrix());
+  MatrixX expected = naiveDensity(basis.moMatrix(), { 2.0 });
+  EXPECT_TRUE(basis.densityMatrix().isApprox(expected));
+
+  // New electron counts discard the generated matrix.
+  basis.setElectronCount(4);
+  EXPECT_EQ(basis.densityMatrix().size(), 0);
+  EXPECT_TRUE(basis.generateDensityMatrix());
+  expected = naiveDensity(basis.moMatrix(), { 2.0, 2.0 });
+  EXPECT_TRUE(basis.densityMatrix().isApprox(expected));
+
+  // A density matrix that was set is kept.
+  MatrixX density = MatrixX::Identity(basisCount, basisCount);
+  basis.setDensityMatrix(density);
+  setUpBasis(basis, BasisSet::Paired);
+  EXPECT_TRUE(basis.generateDensityMatrix());
+  EXPECT_TRUE(basis.densityMatrix().isApprox(density));
+}
+
+TEST(GaussianSetTest, screening)
+{
+  Molecule molecule;
+  GaussianSet* basis = setUpMolecule(molecule);
+  const unsigned int count = moleculeBasisCount;
+
+  // The tools are set up first, they must follow the changes of precision.
+  GaussianSetTools tools(&molecule);
+  basis->setCutoffPrecision(0.0);
+  vector<double> expected;
+  vector<Vector3> points;
+  for (int i = -12; i <= 12; ++i) {
+    points.push_back(Vector3(0.3 * i, 0.2 * i, 0.5 * i));
+    for (unsigned int mo = 0; mo < count; ++mo)
+      expected.push_back(tools.calculateMolecularOrbital(points.back(), mo));
+  }
+  const Vector3 far(10.0, 0.0, 0.0);
+  EXPECT_NE(tools.calculateMolecularOrbital(far, 0), 0.0);
+
+  basis->setCutoffPrecision(1e-10);
+  size_t index = 0;
+  for (size_t i = 0; i < points.size(); ++i) {
+    for (unsigned int mo = 0; mo < count; ++mo) {
+      EXPECT_NEAR(tools.calculateMolecularOrbital(points[i], mo),
+                  expected[index++], 1e-8);
+    }
+  }
+
+  // Far enough, every shell is screened.
+  EXPECT_EQ(tools.calculateMolecularOrbital(far, 0), 0.0);
+}
+
+TEST(GaussianSetTest, batchOrbitals)
+{
+  Molecule molecule;
+  GaussianSet* basis = setUpMolecule(molecule);
+  basis->generateDensityMatrix();
+  GaussianSetTools tools(&molecule);
+
+  vector<int> mos = { 3, 0, 15, 7 };
+  for (int i = -5; i <= 5; ++i) {
+    Vector3 position(0.2 * i, -0.1 * i, 0.3 * i);
+    vector<double> values = tools.calculateMolecularOrbitals(position, mos,
+                                                             true);
+    ASSERT_EQ(values.size(), mos.size() + 1);
+    for (size_t j = 0; j < mos.size(); ++j) {
+      EXPECT_NEAR(values[j], tools.calculateMolecularOrbital(position, mos[j]),
+                  1e-12);
+    }
+    EXPECT_NEAR(values.back(), tools.calculateElectronDensity(position), 1e-12);
+  }
+}
+
+TEST(GaussianSetTest, adaptiveCube)
+{
+  Molecule molecule;
+  GaussianSet* basis = setUpMolecule(molecule);
+  basis->generateDensityMatrix();
+  GaussianSetTools tools(&molecule);
+
+  AdaptiveCube cube;
+  cube.setLimits(molecule, 0.2, 3.0);
+  EXPECT_FALSE(tools.calculateMolecularOrbital(cube, moleculeBasisCount, 0.02));
+  EXPECT_TRUE(tools.calculateMolecularOrbital(cube, 1, 0.02));
+  ASSERT_GT(cube.activeBricks().size(), 0u);
+  Vector3i point = cube.activeBricks().back() * AdaptiveCube::brickCells;
+  Vector3 position = cube.min() + point.cast<double>() * 0.2;
+  EXPECT_DOUBLE_EQ(cube.value(point.x(), point.y(), point.z()),
+                   tools.calculateMolecularOrbital(position, 1));
+
+  EXPECT_TRUE(tools.calculateElectronDensity(cube, 0.02));
+  point = cube.activeBricks().front() * AdaptiveCube::brickCells;
+  position = cube.min() + point.cast<double>() * 0.2;
+  EXPECT_DOUBLE_EQ(cube.value(point.x(), point.y(), point.z()),
+                   tools.calculateElectronDensity(position));
+}
@@ -135,6 +135,43 @@ TEST_F(MoleculeTest, removeAtom)
   EXPECT_EQ(0, molecule.atomCount());
 }
 
+TEST_F(MoleculeTest, removeAtoms)
+{
+  Molecule molecule;
+  Atom atom0 = molecule.addAtom(6);
+  Atom atom1 = molecule.addAtom(1);
+  Atom atom2 = molecule.addAtom(8);
+  Atom atom3 = molecule.addAtom(1);
+  Atom atom4 = molecule.addAtom(7);
+  atom2.setPosition3d(Vector3(2.0, 0.0, 0.0));
+  atom4.setPosition3d(Vector3(4.0, 0.0, 0.0));
+  molecule.addBond(atom0, atom1, 1);
+  molecule.addBond(atom2, atom4, 2);
+  molecule.addBond(atom0, atom3, 1);
+
+  Array<Index> indices;
+  indices.push_back(3);
+  indices.push_back(0);
+  indices.push_back(3);
+  indices.push_back(42);
+  EXPECT_TRUE(molecule.removeAtoms(indices));
+
+  // The remaining atoms keep their order, and their bonds are renumbered.
+  ASSERT_EQ(3, molecule.atomCount());
+  EXPECT_EQ(1, molecule.atomicNumber(0));
+  EXPECT_EQ(8, molecule.atomicNumber(1));
+  EXPECT_EQ(7, molecule.atomicNumber(2));
+  EXPECT_EQ(Vector3(4.0, 0.0, 0.0), molecule.atomPosition3d(2));
+  ASSERT_EQ(1, molecule.bondCount());
+  EXPECT_EQ(1, molecule.bondPairs()[0].first);
+  EXPECT_EQ(2, molecule.bondPairs()[0].second);
+  EXPECT_EQ(2, molecule.bondOrders()[0]);
+  EXPECT_EQ(3, molecule.graph().size());
+
+  EXPECT_FALSE(molecule.removeAtoms(Array<Index>()));
+  EXPECT_EQ(3, molecule.atomCount());
+}
+
 TEST_F(MoleculeTest, addBond)
 {
   Molecule molecule;
@@ -0,0 +1,174 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/neighborlist.h>
+#include <avogadro/core/unitcell.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+using Avogadro::DEG_TO_RAD;
+using Avogadro::Index;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Vector3i;
+using Avogadro::Core::Array;
+using Avogadro::Core::NeighborList;
+using Avogadro::Core::UnitCell;
+
+namespace {
+typedef std::pair<Index, std::vector<int>> Neighbor;
+
+// The neighbors of each atom, found by checking every image in range.
+std::vector<std::vector<Neighbor>> bruteForce(const UnitCell& cell,
+                                              const Array<Vector3>& positions,
+                                              Real cutoff, int range)
+{
+  std::vector<std::vector<Neighbor>> result(positions.size());
+  for (Index i = 0; i < positions.size(); ++i) {
+    for (Index j = 0; j < positions.size(); ++j) {
+      for (int a = -range; a <= range; ++a) {
+        for (int b = -range; b <= range; ++b) {
+          for (int c = -range; c <= range; ++c) {
+            if (i == j && a == 0 && b == 0 && c == 0)
+              continue;
+            Vector3 delta =
+              positions[j] + cell.imageOffset(a, b, c) - positions[i];
+            if (delta.norm() <= cutoff) {
+              std::vector<int> image = { a, b, c };
+              result[i].push_back(Neighbor(j, image));
+            }
+          }
+        }
+      }
+    }
+    std::sort(result[i].begin(), result[i].end());
+  }
+  return result;
+}
+
+std::vector<std::vector<Neighbor>> toSorted(const NeighborList& list)
+{
+  std::vector<std::vector<Neighbor>> result(list.atomCount());
+  for (Index i = 0; i < list.atomCount(); ++i) {
+    for (Index k = list.offsets()[i]; k < list.offsets()[i + 1]; ++k) {
+      const Vector3i& n = list.images()[k];
+      std::vector<int> image = { n[0], n[1], n[2] };
+      result[i].push_back(Neighbor(list.neighbors()[k], image));
+    }
+    std::sort(result[i].begin(), result[i].end());
+  }
+  return result;
+}
+
+Array<Vector3> randomPositions(const UnitCell& cell, int count)
+{
+  Array<Vector3> positions;
+  for (int i = 0; i < count; ++i) {
+    // Include atoms outside of the unit cell.
+    Vector3 frac(rand() % 1000 / 500.0 - 0.5, rand() % 1000 / 1000.0,
+                 rand() % 1000 / 1000.0);
+    positions.push_back(cell.toCartesian(frac));
+  }
+  return positions;
+}
+}
+
+TEST(NeighborListTest, simpleCubic)
+{
+  // One atom, its neighbors are all images of itself.
+  UnitCell cell(3.0, 3.0, 3.0, 90.0 * DEG_TO_RAD, 90.0 * DEG_TO_RAD,
+                90.0 * DEG_TO_RAD);
+  Array<Vector3> positions;
+  positions.push_back(Vector3(0.5, 0.5, 0.5));
+
+  NeighborList list;
+  list.setCutoff(3.1);
+  EXPECT_TRUE(list.build(cell, positions));
+  ASSERT_EQ(list.atomCount(), static_cast<Index>(1));
+  EXPECT_EQ(list.neighborCount(0), static_cast<Index>(6));
+  for (Index k = 0; k < list.neighbors().size(); ++k) {
+    EXPECT_EQ(list.neighbors()[k], static_cast<Index>(0));
+    EXPECT_NEAR(list.distances()[k], 3.0, 1e-10);
+    EXPECT_EQ(list.images()[k].cwiseAbs().sum(), 1);
+  }
+
+  // Larger than the cell, the face diagonals are also in range.
+  list.setCutoff(4.3);
+  EXPECT_TRUE(list.build(cell, positions));
+  EXPECT_EQ(list.neighborCount(0), static_cast<Index>(18));
+
+  list.setCutoff(0.0);
+  EXPECT_FALSE(list.build(cell, positions));
+  EXPECT_EQ(list.atomCount(), static_cast<Index>(0));
+}
+
+TEST(NeighborListTest, triclinic)
+{
+  UnitCell cell(4.0, 5.0, 6.0, 70.0 * DEG_TO_RAD, 80.0 * DEG_TO_RAD,
+                115.0 * DEG_TO_RAD);
+  srand(42);
+  Array<Vector3> positions = randomPositions(cell, 20);
+
+  NeighborList list;
+  // Short, about half of the cell, and longer than the cell.
+  const Real cutoffs[] = { 1.5, 2.5, 7.0 };
+  for (int i = 0; i < 3; ++i) {
+    list.setCutoff(cutoffs[i]);
+    EXPECT_TRUE(list.build(cell, positions));
+    EXPECT_EQ(toSorted(list), bruteForce(cell, positions, cutoffs[i], 4));
+  }
+}
+
+TEST(NeighborListTest, verletSkin)
+{
+  UnitCell cell(8.0, 8.0, 9.0, 90.0 * DEG_TO_RAD, 90.0 * DEG_TO_RAD,
+                120.0 * DEG_TO_RAD);
+  srand(7);
+  Array<Vector3> positions = randomPositions(cell, 30);
+
+  NeighborList list;
+  list.setCutoff(3.0);
+  list.setSkin(1.0);
+  EXPECT_TRUE(list.update(cell, positions));
+  EXPECT_TRUE(list.wasRebuilt());
+  EXPECT_EQ(toSorted(list), bruteForce(cell, positions, 3.0, 2));
+
+  // Small moves only update the distances.
+  for (Index i = 0; i < positions.size(); ++i)
+    positions[i] += Vector3(0.2, -0.2, 0.1);
+  EXPECT_TRUE(list.update(cell, positions));
+  EXPECT_FALSE(list.wasRebuilt());
+  EXPECT_EQ(toSorted(list), bruteForce(cell, positions, 3.0, 2));
+
+  // A large move searches again.
+  positions[0] += Vector3(0.6, 0.0, 0.0);
+  EXPECT_TRUE(list.update(cell, positions));
+  EXPECT_TRUE(list.wasRebuilt());
+  EXPECT_EQ(toSorted(list), bruteForce(cell, positions, 3.0, 2));
+
+  // The same result on one thread.
+  NeighborList serial;
+  serial.setCutoff(3.0);
+  serial.setMaxThreads(1);
+  EXPECT_TRUE(serial.build(cell, positions));
+  EXPECT_EQ(toSorted(serial), toSorted(list));
+}
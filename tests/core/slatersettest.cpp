@@ -0,0 +1,156 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/cube.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/slaterset.h>
+#include <avogadro/core/slatersettools.h>
+
+#include <cmath>
+#include <vector>
+
+using Avogadro::MatrixX;
+using Avogadro::Vector3;
+using Avogadro::Vector3i;
+using Avogadro::Core::Cube;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::SlaterSet;
+using Avogadro::Core::SlaterSetTools;
+using std::vector;
+
+namespace {
+const int basisCount = 8;
+
+// A carbon with s, p and two d functions and a hydrogen with an s function,
+// as in a MOPAC AUX file. The overlap is the identity, so the orbitals are
+// the eigenvectors.
+SlaterSet* setUpMolecule(Molecule& molecule)
+{
+  molecule.addAtom(6).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  molecule.addAtom(1).setPosition3d(Vector3(0.0, 0.4, 1.1));
+  SlaterSet* basis = new SlaterSet;
+  basis->addSlaterIndices({ 0, 0, 0, 0, 0, 0, 0, 1 });
+  basis->addSlaterTypes({ SlaterSet::S, SlaterSet::PX, SlaterSet::PY,
+                          SlaterSet::PZ, SlaterSet::Z2, SlaterSet::XY,
+                          SlaterSet::X2, SlaterSet::S });
+  basis->addZetas({ 1.8, 1.6, 1.6, 1.6, 1.1, 1.1, 1.1, 1.2 });
+  basis->addPQNs({ 2, 2, 2, 2, 3, 3, 3, 1 });
+  basis->addOverlapMatrix(MatrixX::Identity(basisCount, basisCount));
+
+  MatrixX eigenVectors(basisCount, basisCount);
+  MatrixX density(basisCount, basisCount);
+  for (int i = 0; i < basisCount; ++i) {
+    for (int j = 0; j < basisCount; ++j) {
+      eigenVectors(i, j) = (i == j ? 1.0 : 0.05 * (i - j));
+      density(i, j) = (i == j ? 1.0 : 0.1 / (1 + i + j));
+    }
+  }
+  basis->addEigenVectors(eigenVectors);
+  basis->addDensityMatrix(density);
+  molecule.setBasisSet(basis);
+  basis->setMolecule(&molecule);
+  return basis;
+}
+}
+
+TEST(SlaterSetTest, values)
+{
+  Molecule molecule;
+  SlaterSet* basis = setUpMolecule(molecule);
+  basis->addEigenVectors(MatrixX::Identity(basisCount, basisCount));
+  SlaterSetTools tools(&molecule);
+
+  // The 1s function of the hydrogen, with the exponent in inverse bohr.
+  const double zeta = 1.2;
+  const double factor = std::pow(2.0 * zeta, 1.5) * std::sqrt(0.125 / M_PI);
+  const Vector3 hydrogen(0.0, 0.4, 1.1);
+  for (int i = 0; i < 5; ++i) {
+    Vector3 position = hydrogen + Vector3(0.1, -0.2, 0.3) * i;
+    double r = (position - hydrogen).norm() / Avogadro::BOHR_TO_ANGSTROM_D;
+    EXPECT_NEAR(tools.calculateMolecularOrbital(position, basisCount),
+                factor * std::exp(-zeta * r), 1e-10);
+  }
+}
+
+TEST(SlaterSetTest, cube)
+{
+  Molecule molecule;
+  setUpMolecule(molecule);
+  SlaterSetTools tools(&molecule);
+
+  // More points than a block, and not a multiple of it.
+  Cube cube;
+  cube.setLimits(Vector3(-2.0, -2.0, -2.0), Vector3i(7, 6, 5), 0.7);
+  const size_t size = cube.data()->size();
+
+  vector<Cube> cubes(2);
+  cubes[0].setLimits(cube);
+  cubes[1].setLimits(cube);
+  vector<Cube*> cubePointers = { &cubes[0], &cubes[1] };
+  vector<int> mos = { 2, 6 };
+
+  for (int mo = 1; mo <= basisCount; ++mo) {
+    EXPECT_TRUE(tools.calculateMolecularOrbital(cube, mo));
+    for (size_t i = 0; i < size; ++i) {
+      Vector3 position = cube.position(static_cast<unsigned int>(i));
+      EXPECT_NEAR((*cube.data())[i],
+                  tools.calculateMolecularOrbital(position, mo), 1e-12);
+    }
+  }
+
+  // In two ranges, as the concurrent calculations do.
+  EXPECT_TRUE(tools.calculateElectronDensity(cube, 0, 100));
+  EXPECT_TRUE(tools.calculateElectronDensity(cube, 100, size));
+  EXPECT_TRUE(tools.calculateMolecularOrbitals(cubePointers, mos, 0, size));
+  for (size_t i = 0; i < size; ++i) {
+    Vector3 position = cube.position(static_cast<unsigned int>(i));
+    vector<double> values = tools.calculateMolecularOrbitals(position, mos);
+    EXPECT_NEAR((*cubes[0].data())[i], values[0], 1e-12);
+    EXPECT_NEAR((*cubes[1].data())[i], values[1], 1e-12);
+    EXPECT_NEAR((*cube.data())[i], tools.calculateElectronDensity(position),
+                1e-12);
+  }
+}
+
+TEST(SlaterSetTest, screening)
+{
+  Molecule molecule;
+  SlaterSet* basis = setUpMolecule(molecule);
+  basis->setCutoffPrecision(0.0);
+  SlaterSetTools tools(&molecule);
+
+  vector<Vector3> points;
+  vector<double> expected;
+  for (int i = -12; i <= 12; ++i) {
+    points.push_back(Vector3(0.4 * i, 0.3 * i, -0.5 * i));
+    for (int mo = 1; mo <= basisCount; ++mo)
+      expected.push_back(tools.calculateMolecularOrbital(points.back(), mo));
+  }
+
+  basis->setCutoffPrecision(1e-10);
+  size_t index = 0;
+  for (size_t i = 0; i < points.size(); ++i) {
+    for (int mo = 1; mo <= basisCount; ++mo) {
+      EXPECT_NEAR(tools.calculateMolecularOrbital(points[i], mo),
+                  expected[index++], 1e-8);
+    }
+  }
+
+  // Far enough, every function is screened.
+  EXPECT_EQ(tools.calculateMolecularOrbital(Vector3(80.0, 0.0, 0.0), 1), 0.0);
+}
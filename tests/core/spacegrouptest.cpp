@@ -16,6 +16,7 @@
 
 #include <gtest/gtest.h>
 
+#include <avogadro/core/array.h>
 #include <avogadro/core/avospglib.h>
 #include <avogadro/core/matrix.h>
 #include <avogadro/core/molecule.h>
@@ -23,8 +24,10 @@
 #include <avogadro/core/unitcell.h>
 #include <avogadro/core/vector.h>
 
+using Avogadro::Index;
 using Avogadro::Matrix3;
 using Avogadro::Vector3;
+using Avogadro::Core::Array;
 using Avogadro::Core::AvoSpglib;
 using Avogadro::Core::Molecule;
 using Avogadro::Core::SpaceGroups;
@@ -68,6 +71,22 @@ TEST(SpaceGroupTest, getSpaceGroup)
   EXPECT_EQ(schoenflies, std::string("D4h^14"));
   EXPECT_EQ(hallSymbol, std::string("-P 4n 2n"));
   EXPECT_EQ(intSymbol, std::string("P 4_2/m 2_1/n 2/m"));
+
+  // The dataset comes from the cache now, and matches the Hall number.
+  AvoSpglib::Dataset dataset;
+  EXPECT_TRUE(AvoSpglib::getDataset(mol, dataset, cartTol));
+  EXPECT_EQ(dataset.hallNumber, hallNumber);
+  EXPECT_EQ(dataset.spaceGroupNumber, 136);
+  EXPECT_EQ(dataset.rotations.size(), 16);
+  EXPECT_EQ(dataset.translations.size(), 16);
+  EXPECT_EQ(dataset.wyckoffs, std::string("ffffaa"));
+  ASSERT_EQ(dataset.equivalentAtoms.size(), 6);
+  EXPECT_EQ(dataset.equivalentAtoms[3], 0);
+  EXPECT_EQ(dataset.equivalentAtoms[5], 4);
+
+  // Removing an atom changes the structure, and the result.
+  mol.removeAtom(5);
+  EXPECT_NE(AvoSpglib::getHallNumber(mol, cartTol), hallNumber);
 }
 
 // We're going to take a conventional cell, reduce it to the primitive form,
@@ -505,3 +524,49 @@ TEST(SpaceGroupTest, reduceToAsymmetricUnit)
   ASSERT_EQ(mol2.atomCount(), 4);
   ASSERT_EQ(mol2.atomicNumbers().size(), 4);
 }
+
+TEST(SpaceGroupTest, transforms)
+{
+  // hallNumber 6 is P 1 21 1: "x,y,z -x,1/2+y,-z"
+  ASSERT_EQ(SpaceGroups::transformsCount(6), 2);
+  Array<Vector3> transforms =
+    SpaceGroups::getTransforms(6, Vector3(0.1, 0.2, 0.3));
+  ASSERT_EQ(transforms.size(), 2);
+  EXPECT_TRUE(transforms[0].isApprox(Vector3(0.1, 0.2, 0.3)));
+  EXPECT_TRUE(transforms[1].isApprox(Vector3(-0.1, 0.7, -0.3)));
+
+  Array<Matrix3> rotations;
+  Array<Vector3> translations;
+  ASSERT_TRUE(SpaceGroups::getOperations(6, rotations, translations));
+  ASSERT_EQ(rotations.size(), 2);
+  ASSERT_EQ(translations.size(), 2);
+  EXPECT_TRUE(rotations[1].isApprox(Vector3(-1.0, 1.0, -1.0).asDiagonal() *
+                                    Matrix3::Identity()));
+  EXPECT_TRUE(translations[1].isApprox(Vector3(0.0, 0.5, 0.0)));
+
+  // Invalid hall numbers
+  EXPECT_EQ(SpaceGroups::transformsCount(0), 0);
+  EXPECT_EQ(SpaceGroups::transformsCount(531), 0);
+  EXPECT_EQ(SpaceGroups::getTransforms(531, Vector3::Zero()).size(), 0);
+  EXPECT_FALSE(SpaceGroups::getOperations(0, rotations, translations));
+  EXPECT_EQ(rotations.size(), 0);
+
+  // The batched transforms match the transforms of each position.
+  Array<Vector3> positions;
+  positions.push_back(Vector3(0.1, 0.2, 0.3));
+  positions.push_back(Vector3(0.5, 0.25, 0.75));
+  positions.push_back(Vector3(0.9, 0.05, 0.45));
+  for (unsigned short hall = 1; hall <= 530; ++hall) {
+    Index numOps = SpaceGroups::transformsCount(hall);
+    Array<Vector3> batch = SpaceGroups::applyTransforms(hall, positions);
+    ASSERT_EQ(batch.size(), positions.size() * numOps);
+    for (Index i = 0; i < positions.size(); ++i) {
+      Array<Vector3> single = SpaceGroups::getTransforms(hall, positions[i]);
+      ASSERT_EQ(single.size(), numOps);
+      // The first transform is always the identity.
+      EXPECT_TRUE(single[0].isApprox(positions[i]));
+      for (Index j = 0; j < numOps; ++j)
+        EXPECT_TRUE(batch[i * numOps + j].isApprox(single[j]));
+    }
+  }
+}
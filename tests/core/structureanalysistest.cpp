@@ -0,0 +1,182 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/structureanalysis.h>
+#include <avogadro/core/unitcell.h>
+
+#include <cmath>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Matrix3;
+using Avogadro::PI;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::StructureAnalysis;
+using Avogadro::Core::UnitCell;
+
+namespace {
+// A simple cubic lattice of 4x4x4 atoms 2 Angstrom apart, alternating between
+// sodium and chlorine.
+void buildLattice(Molecule& mol)
+{
+  mol.setUnitCell(new UnitCell(Matrix3(Matrix3::Identity() * 8.0)));
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      for (int k = 0; k < 4; ++k) {
+        unsigned char element = (i + j + k) % 2 == 0 ? 11 : 17;
+        mol.addAtom(element).setPosition3d(Vector3(2.0 * i, 2.0 * j, 2.0 * k));
+      }
+    }
+  }
+}
+}
+
+TEST(StructureAnalysisTest, coordination)
+{
+  Molecule mol;
+  buildLattice(mol);
+  StructureAnalysis analysis;
+  analysis.setCutoff(3.0);
+  analysis.setBinWidth(0.1);
+  ASSERT_TRUE(analysis.analyze(mol));
+  EXPECT_EQ(analysis.frameCount(), static_cast<Index>(1));
+  EXPECT_EQ(analysis.binCount(), static_cast<Index>(30));
+  ASSERT_EQ(analysis.elements().size(), static_cast<size_t>(2));
+
+  // Each sodium has six chlorine neighbors at 2 Angstrom, then twelve sodium
+  // neighbors at 2.83 Angstrom.
+  std::vector<Real> naCl = analysis.coordination(11, 17);
+  std::vector<Real> naNa = analysis.coordination(11, 11);
+  ASSERT_EQ(naCl.size(), static_cast<size_t>(30));
+  EXPECT_DOUBLE_EQ(naCl[18], 0.0);
+  EXPECT_DOUBLE_EQ(naCl[20], 6.0);
+  EXPECT_DOUBLE_EQ(naCl[29], 6.0);
+  EXPECT_DOUBLE_EQ(naNa[27], 0.0);
+  EXPECT_DOUBLE_EQ(naNa[28], 12.0);
+  EXPECT_TRUE(analysis.coordination(11, 8).empty());
+
+  // The integral of g(r) over the shells gives the coordination numbers.
+  std::vector<Real> g = analysis.rdf(11, 17);
+  std::vector<Real> gReverse = analysis.rdf(17, 11);
+  ASSERT_EQ(g.size(), static_cast<size_t>(30));
+  Real density = 32.0 / 512.0;
+  Real integral = 0.0;
+  for (Index bin = 0; bin < g.size(); ++bin) {
+    EXPECT_DOUBLE_EQ(g[bin], gReverse[bin]);
+    Real shell = 4.0 / 3.0 * PI * std::pow(0.1, 3) *
+                 (std::pow(bin + 1.0, 3) - std::pow(bin, 3));
+    integral += g[bin] * shell * density;
+    EXPECT_NEAR(integral, naCl[bin], 1e-10);
+  }
+
+  // The total is the average of the partials, weighted by composition.
+  std::vector<Real> total = analysis.rdf();
+  std::vector<Real> clCl = analysis.rdf(17, 17);
+  std::vector<Real> naNaRdf = analysis.rdf(11, 11);
+  for (Index bin = 0; bin < total.size(); ++bin) {
+    EXPECT_NEAR(total[bin],
+                0.25 * (naNaRdf[bin] + clCl[bin] + g[bin] + gReverse[bin]),
+                1e-10);
+  }
+}
+
+TEST(StructureAnalysisTest, molecule)
+{
+  // Without a unit cell, only the atoms themselves are paired.
+  Molecule mol;
+  mol.addAtom(1).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  mol.addAtom(1).setPosition3d(Vector3(0.74, 0.0, 0.0));
+  StructureAnalysis analysis;
+  analysis.setCutoff(2.0);
+  analysis.setBinWidth(0.1);
+  ASSERT_TRUE(analysis.analyze(mol));
+  std::vector<Real> hh = analysis.coordination(1, 1);
+  EXPECT_DOUBLE_EQ(hh[6], 0.0);
+  EXPECT_DOUBLE_EQ(hh[7], 1.0);
+  EXPECT_DOUBLE_EQ(hh[19], 1.0);
+
+  EXPECT_FALSE(analysis.analyze(Molecule()));
+}
+
+TEST(StructureAnalysisTest, trajectory)
+{
+  Molecule mol;
+  buildLattice(mol);
+  Array<Vector3> positions = mol.atomPositions3d();
+  const Index frames = 20;
+  for (Index f = 0; f < frames; ++f) {
+    // The first atom moves along -x, across the cell boundary.
+    Array<Vector3> frame = positions;
+    frame[0] = Vector3(-0.1 * f, 0.01 * f, 0.0);
+    mol.unitCell()->wrapCartesian(frame[0], frame[0]);
+    mol.setCoordinate3d(frame, static_cast<int>(f));
+  }
+
+  StructureAnalysis serial;
+  serial.setCutoff(4.0);
+  serial.setMaxThreads(1);
+  ASSERT_TRUE(serial.analyze(mol));
+  EXPECT_EQ(serial.frameCount(), frames);
+
+  // The displacement is followed across the boundary.
+  std::vector<Real> msd = serial.msd();
+  std::vector<Real> msdNa = serial.msd(11);
+  std::vector<Real> msdCl = serial.msd(17);
+  ASSERT_EQ(msd.size(), frames);
+  for (Index f = 0; f < frames; ++f) {
+    Real square = 0.0101 * f * f;
+    EXPECT_NEAR(msd[f], square / 64.0, 1e-10);
+    EXPECT_NEAR(msdNa[f], square / 32.0, 1e-10);
+    EXPECT_NEAR(msdCl[f], 0.0, 1e-10);
+  }
+
+  // Threads and streaming give the same results.
+  StructureAnalysis parallel;
+  parallel.setCutoff(4.0);
+  parallel.setMaxThreads(4);
+  ASSERT_TRUE(parallel.analyze(mol));
+  StructureAnalysis streaming;
+  streaming.setCutoff(4.0);
+  ASSERT_TRUE(streaming.begin(mol.atomicNumbers()));
+  for (Index f = 0; f < frames; ++f) {
+    ASSERT_TRUE(
+      streaming.addFrame(mol.coordinate3dSet(static_cast<int>(f)),
+                         mol.unitCell()));
+  }
+  EXPECT_FALSE(streaming.addFrame(Array<Vector3>(3), mol.unitCell()));
+  EXPECT_EQ(streaming.frameCount(), frames);
+
+  std::vector<Real> expected = serial.rdf(11, 17);
+  std::vector<Real> threaded = parallel.rdf(11, 17);
+  std::vector<Real> streamed = streaming.rdf(11, 17);
+  ASSERT_EQ(threaded.size(), expected.size());
+  ASSERT_EQ(streamed.size(), expected.size());
+  for (Index bin = 0; bin < expected.size(); ++bin) {
+    EXPECT_NEAR(threaded[bin], expected[bin], 1e-10);
+    EXPECT_NEAR(streamed[bin], expected[bin], 1e-10);
+  }
+  std::vector<Real> streamedMsd = streaming.msd();
+  ASSERT_EQ(streamedMsd.size(), frames);
+  for (Index f = 0; f < frames; ++f)
+    EXPECT_NEAR(streamedMsd[f], msd[f], 1e-10);
+}
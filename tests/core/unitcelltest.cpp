@@ -268,3 +268,52 @@ TEST(UnitCellTest, wrapAtomsToUnitCell)
     EXPECT_LE(it->z(), static_cast<Real>(1.0));
   }
 }
+
+TEST(UnitCellTest, buildSupercell)
+{
+  Molecule mol = createCrystal(
+    static_cast<Real>(2.0), static_cast<Real>(2.0), static_cast<Real>(2.0),
+    static_cast<Real>(90.0), static_cast<Real>(90.0), static_cast<Real>(90.0));
+  Atom h = mol.addAtom(1);
+  Atom o = mol.addAtom(8);
+  Atom c = mol.addAtom(6);
+  h.setPosition3d(Vector3(0.2, 1.0, 1.0));
+  o.setPosition3d(Vector3(1.8, 1.0, 1.0));
+  c.setPosition3d(Vector3(0.6, 1.0, 1.0));
+  mol.formalCharges().resize(3, 0);
+  mol.formalCharges()[1] = -1;
+  // The H-O bond crosses the cell boundary, the H-C bond does not.
+  mol.addBond(h, o, 1);
+  mol.addBond(h, c, 2);
+
+  EXPECT_TRUE(CrystalTools::buildSupercell(mol, 3, 2, 1));
+  EXPECT_TRUE(checkParams(*mol.unitCell(), 6.0, 4.0, 2.0, 90.0, 90.0, 90.0));
+  ASSERT_EQ(mol.atomCount(), static_cast<Index>(18));
+  ASSERT_EQ(mol.atomPositions3d().size(), static_cast<Index>(18));
+  ASSERT_EQ(mol.formalCharges().size(), static_cast<Index>(18));
+  ASSERT_EQ(mol.bondCount(), static_cast<Index>(12));
+
+  // Subcell (1, 1, 0) is the fourth block of atoms.
+  EXPECT_EQ(mol.atomicNumber(10), 8);
+  EXPECT_EQ(mol.formalCharge(10), -1);
+  EXPECT_TRUE(mol.atomPosition3d(10).isApprox(Vector3(3.8, 3.0, 1.0)));
+
+  // Every bond is between the nearest images, and each atom has one bond of
+  // each kind.
+  std::vector<int> bondsPerAtom(mol.atomCount(), 0);
+  for (Index i = 0; i < mol.bondCount(); ++i) {
+    Bond bond = mol.bond(i);
+    Vector3 delta = bond.atom2().position3d() - bond.atom1().position3d();
+    EXPECT_NEAR(mol.unitCell()->minimumImage(delta).norm(), 0.4, 1e-6);
+    bool ho = bond.atom1().atomicNumber() == 8 ||
+              bond.atom2().atomicNumber() == 8;
+    EXPECT_EQ(bond.order(), ho ? 1 : 2);
+    ++bondsPerAtom[bond.atom1().index()];
+    ++bondsPerAtom[bond.atom2().index()];
+  }
+  for (Index i = 0; i < mol.atomCount(); ++i)
+    EXPECT_EQ(bondsPerAtom[i], mol.atomicNumber(i) == 1 ? 2 : 1);
+
+  // The original H is bonded to the O of the last subcell along a.
+  EXPECT_TRUE(mol.bond(0, 13).isValid());
+}
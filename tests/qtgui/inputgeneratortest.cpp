@@ -20,18 +20,38 @@
 
 #include <avogadro/molequeue/inputgenerator.h>
 #include <avogadro/qtgui/generichighlighter.h>
+#include <avogadro/qtgui/pythonscript.h>
 
 #include <avogadro/core/molecule.h>
 
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QFile>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QTemporaryDir>
 
 #include <qjsonarray.h>
 #include <qjsonobject.h>
 
 using Avogadro::QtGui::GenericHighlighter;
+using Avogadro::QtGui::PythonScript;
 using Avogadro::MoleQueue::InputGenerator;
 
+namespace {
+
+QString writeScript(const QTemporaryDir& dir, const QString& name,
+                    const QByteArray& source)
+{
+  QString path(dir.path() + "/" + name);
+  QFile file(path);
+  if (!file.open(QFile::WriteOnly) || file.write(source) != source.size())
+    return QString();
+  return path;
+}
+
+} // end anon namespace
+
 TEST(InputGeneratorTest, exercise)
 {
   QString scriptFilePath(AVOGADRO_DATA
@@ -122,3 +142,114 @@ TEST(InputGeneratorTest, exercise)
   EXPECT_TRUE(highlighter == nullptr);
   delete highlighter;
 }
+
+TEST(InputGeneratorTest, persistent)
+{
+  // The workers of the pool run in a thread with an event loop.
+  int argc = 1;
+  char argName[] = "FakeApp.exe";
+  char* argv[2] = { argName, nullptr };
+  QCoreApplication app(argc, argv);
+  Q_UNUSED(app);
+
+  QTemporaryDir dir;
+  ASSERT_TRUE(dir.isValid());
+  // Writes to fd 1 behind the back of sys.stdout must not reach the output.
+  QString echo(writeScript(dir, "echo.py",
+                           "import os, sys\n"
+                           "sys.__stdout__.write('stray\\n')\n"
+                           "sys.__stdout__.flush()\n"
+                           "os.write(1, b'raw\\n')\n"
+                           "data = sys.argv[1] + sys.stdin.read()\n"
+                           "sys.stdout.write(data)\n"));
+  QString fail(writeScript(dir, "fail.py", "import sys\n"
+                                           "sys.stdout.write('failed')\n"
+                                           "sys.exit(3)\n"));
+  ASSERT_FALSE(echo.isEmpty() || fail.isEmpty());
+
+  // A normal call, twice so the second reuses the worker.
+  PythonScript script(echo);
+  script.setPersistent(true);
+  EXPECT_TRUE(script.persistent());
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(script.execute(QStringList() << "in", "put").toStdString(),
+              std::string("input"));
+    EXPECT_FALSE(script.hasErrors())
+      << script.errorList().join("\n").toStdString();
+  }
+
+  // A nonzero exit reports the status and the output of the script.
+  script.setScriptFilePath(fail);
+  EXPECT_TRUE(script.execute(QStringList()).isEmpty());
+  ASSERT_EQ(1, script.errorList().size());
+  EXPECT_TRUE(script.errorList().first().contains("Abnormal exit status 3"));
+  EXPECT_TRUE(script.errorList().first().contains("failed"));
+}
+
+TEST(InputGeneratorTest, persistentCrash)
+{
+  int argc = 1;
+  char argName[] = "FakeApp.exe";
+  char* argv[2] = { argName, nullptr };
+  QCoreApplication app(argc, argv);
+  Q_UNUSED(app);
+
+  QTemporaryDir dir;
+  ASSERT_TRUE(dir.isValid());
+  QString echo(writeScript(dir, "echo.py",
+                           "import sys\n"
+                           "data = sys.argv[1] + sys.stdin.read()\n"
+                           "sys.stdout.write(data)\n"));
+  QString crash(writeScript(dir, "crash.py", "import os\n"
+                                             "os._exit(9)\n"));
+  ASSERT_FALSE(echo.isEmpty() || crash.isEmpty());
+
+  // A worker that dies is reported, and replaced for the next call.
+  PythonScript script(crash);
+  script.setPersistent(true);
+  EXPECT_TRUE(script.execute(QStringList()).isEmpty());
+  ASSERT_EQ(1, script.errorList().size());
+  EXPECT_TRUE(script.errorList().first().contains("python worker stopped"));
+  script.clearErrors();
+  script.setScriptFilePath(echo);
+  EXPECT_EQ(script.execute(QStringList() << "after ", "crash").toStdString(),
+            std::string("after crash"));
+  EXPECT_FALSE(script.hasErrors());
+}
+
+TEST(InputGeneratorTest, persistentTimeout)
+{
+  int argc = 1;
+  char argName[] = "FakeApp.exe";
+  char* argv[2] = { argName, nullptr };
+  QCoreApplication app(argc, argv);
+  Q_UNUSED(app);
+
+  QTemporaryDir dir;
+  ASSERT_TRUE(dir.isValid());
+  QString echo(writeScript(dir, "echo.py",
+                           "import sys\n"
+                           "data = sys.argv[1] + sys.stdin.read()\n"
+                           "sys.stdout.write(data)\n"));
+  QString hang(writeScript(dir, "hang.py", "import time\n"
+                                           "time.sleep(30)\n"));
+  ASSERT_FALSE(echo.isEmpty() || hang.isEmpty());
+
+  // A worker that does not answer in time is given up on, and replaced.
+  PythonScript script(hang);
+  script.setPersistent(true);
+  script.setTimeout(500);
+  EXPECT_EQ(500, script.timeout());
+  QElapsedTimer timer;
+  timer.start();
+  EXPECT_TRUE(script.execute(QStringList()).isEmpty());
+  EXPECT_LT(timer.elapsed(), 10000);
+  ASSERT_EQ(1, script.errorList().size());
+  EXPECT_TRUE(script.errorList().first().contains("Timed out"));
+  script.clearErrors();
+  script.setScriptFilePath(echo);
+  script.setTimeout(10000);
+  EXPECT_EQ(script.execute(QStringList() << "after ", "timeout").toStdString(),
+            std::string("after timeout"));
+  EXPECT_FALSE(script.hasErrors());
+}
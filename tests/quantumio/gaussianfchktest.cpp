@@ -0,0 +1,66 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "quantumiotests.h"
+
+#include <avogadro/core/gaussiansettools.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/quantumio/gaussianfchk.h>
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using Avogadro::Vector3;
+using Avogadro::Core::GaussianSetTools;
+using Avogadro::Core::Molecule;
+using Avogadro::QuantumIO::GaussianFchk;
+
+TEST(GaussianFchkTest, density)
+{
+  // Read from a file, the density matrix is loaded when first needed.
+  const std::string fileName(QUANTUMIO_DATA "/h2.fchk");
+  GaussianFchk fileReader;
+  Molecule fromFile;
+  ASSERT_TRUE(fileReader.readFile(fileName, fromFile));
+  EXPECT_EQ(fromFile.atomCount(), 2);
+
+  // Read from a string, it is loaded up front.
+  std::ifstream file(fileName.c_str());
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  GaussianFchk stringReader;
+  Molecule fromString;
+  ASSERT_TRUE(stringReader.readString(contents.str(), fromString));
+
+  // A single point is evaluated right away, with the density of the file.
+  const Vector3 point(0.1, 0.2, 0.3);
+  GaussianSetTools fileTools(&fromFile);
+  GaussianSetTools stringTools(&fromString);
+  double density = stringTools.calculateElectronDensity(point);
+  EXPECT_GT(density, 0.0);
+  EXPECT_DOUBLE_EQ(fileTools.calculateElectronDensity(point), density);
+  std::vector<double> values(
+    fileTools.calculateMolecularOrbitals(point, std::vector<int>(1, 0), true));
+  ASSERT_EQ(values.size(), 2);
+  EXPECT_NE(values[0], 0.0);
+  EXPECT_DOUBLE_EQ(values[1], density);
+
+  // The file has no spin density, a closed shell has none.
+  EXPECT_EQ(fileTools.calculateSpinDensity(point), 0.0);
+}
@@ -0,0 +1,127 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/quantumio/numericblock.h>
+
+#include <cmath>
+#include <sstream>
+
+using std::string;
+using Avogadro::QuantumIO::parseNumber;
+using Avogadro::QuantumIO::parseNumbers;
+using Avogadro::QuantumIO::readBlock;
+
+TEST(NumericBlockTest, numbers)
+{
+  double value = 0.0;
+  EXPECT_TRUE(parseNumber(string("1.5"), value));
+  EXPECT_EQ(value, 1.5);
+  EXPECT_TRUE(parseNumber(string("  -2.25e-3 "), value));
+  EXPECT_EQ(value, -2.25e-3);
+  EXPECT_TRUE(parseNumber(string("+42"), value));
+  EXPECT_EQ(value, 42.0);
+  EXPECT_TRUE(parseNumber(string(".5"), value));
+  EXPECT_EQ(value, 0.5);
+  EXPECT_TRUE(parseNumber(string("-0.0"), value));
+  EXPECT_EQ(value, 0.0);
+  EXPECT_TRUE(std::signbit(value));
+}
+
+TEST(NumericBlockTest, fortranExponents)
+{
+  double value = 0.0;
+  EXPECT_TRUE(parseNumber(string("0.1234D+02"), value));
+  EXPECT_EQ(value, 12.34);
+  EXPECT_TRUE(parseNumber(string("-5.0d-3"), value));
+  EXPECT_EQ(value, -5.0e-3);
+  EXPECT_TRUE(parseNumber(string("0.71616956D-01"), value));
+  EXPECT_EQ(value, 0.71616956e-01);
+  EXPECT_TRUE(parseNumber(string("1.0E+300"), value));
+  EXPECT_EQ(value, 1.0e300);
+  EXPECT_TRUE(parseNumber(string("2.5D-310"), value));
+  EXPECT_EQ(value, 2.5e-310);
+}
+
+TEST(NumericBlockTest, longMantissas)
+{
+  // More digits than the fast path gathers, or a mantissa past 2^53, are
+  // rounded once by the slow path.
+  double value = 0.0;
+  EXPECT_TRUE(parseNumber(string("0.123456789012345678901234"), value));
+  EXPECT_EQ(value, 0.123456789012345678901234);
+  EXPECT_TRUE(parseNumber(string("12345678901234567890123"), value));
+  EXPECT_EQ(value, 12345678901234567890123.0);
+  EXPECT_TRUE(parseNumber(string("9007199254740993"), value));
+  EXPECT_EQ(value, 9007199254740993.0);
+  EXPECT_TRUE(parseNumber(string("1.2345678901234567890D-05"), value));
+  EXPECT_EQ(value, 1.2345678901234567890e-05);
+  EXPECT_TRUE(parseNumber(string("0.000000000000000000000000001"), value));
+  EXPECT_EQ(value, 1e-27);
+}
+
+TEST(NumericBlockTest, rejected)
+{
+  double value = 0.0;
+  EXPECT_FALSE(parseNumber(string(""), value));
+  EXPECT_FALSE(parseNumber(string("abc"), value));
+  EXPECT_FALSE(parseNumber(string("1.0-100"), value));
+  EXPECT_FALSE(parseNumber(string("1.0e"), value));
+  EXPECT_FALSE(parseNumber(string("1.0D+"), value));
+  EXPECT_FALSE(parseNumber(string("--1"), value));
+  EXPECT_FALSE(parseNumber(string("."), value));
+  EXPECT_FALSE(parseNumber(string("1.5x"), value));
+  EXPECT_FALSE(parseNumber(string("1.5 2.5"), value));
+
+  int integer = 0;
+  string text("2147483648 3.0 -7");
+  const char* end = text.data() + text.size();
+  EXPECT_EQ(parseNumber(text.data(), end, integer), nullptr);
+  EXPECT_EQ(parseNumber(text.data() + 10, end, integer), nullptr);
+  EXPECT_EQ(parseNumber(text.data() + 14, end, integer), end);
+  EXPECT_EQ(integer, -7);
+}
+
+TEST(NumericBlockTest, blocks)
+{
+  string text("  1.0 -2.0D+01\n3.5E-1\r\n  4\n 5.0-100 6.0");
+  double values[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+  const char* begin = text.data();
+  const char* end = begin + text.size();
+  EXPECT_EQ(parseNumbers(begin, end, values, 6), 4);
+  EXPECT_EQ(values[0], 1.0);
+  EXPECT_EQ(values[1], -20.0);
+  EXPECT_EQ(values[2], 0.35);
+  EXPECT_EQ(values[3], 4.0);
+  EXPECT_EQ(parseNumbers(begin, end, values, 2), 2);
+
+  int integers[3] = { 0, 0, 0 };
+  string indices(" 1  2\n   3 ");
+  EXPECT_EQ(parseNumbers(indices.data(), indices.data() + indices.size(),
+                         integers, 3),
+            3);
+  EXPECT_EQ(integers[2], 3);
+}
+
+TEST(NumericBlockTest, readBlock)
+{
+  std::istringstream in("header\n1.0 2.0\nfooter\n");
+  string block;
+  EXPECT_TRUE(readBlock(in, 7, 15, block));
+  EXPECT_EQ(block, "1.0 2.0\n");
+  EXPECT_FALSE(readBlock(in, 15, 7, block));
+}
@@ -0,0 +1,89 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/rendering/camera.h>
+#include <avogadro/rendering/frustum.h>
+
+#include <Eigen/Geometry>
+
+using Avogadro::Rendering::Camera;
+using Avogadro::Rendering::Frustum;
+using Avogadro::Vector3f;
+
+namespace {
+// A camera at the origin looking down the negative z axis.
+Camera perspectiveCamera()
+{
+  Camera camera;
+  camera.setViewport(100, 100);
+  camera.calculatePerspective(40, 1, 100);
+  return camera;
+}
+}
+
+TEST(FrustumTest, boxes)
+{
+  Frustum frustum(perspectiveCamera());
+
+  Eigen::AlignedBox3f inside(Vector3f(-1, -1, -11), Vector3f(1, 1, -9));
+  Eigen::AlignedBox3f behind(Vector3f(-1, -1, 9), Vector3f(1, 1, 11));
+  Eigen::AlignedBox3f beside(Vector3f(50, -1, -11), Vector3f(52, 1, -9));
+  Eigen::AlignedBox3f tooFar(Vector3f(-1, -1, -200), Vector3f(1, 1, -150));
+  Eigen::AlignedBox3f straddling(Vector3f(-100, -1, -11),
+                                 Vector3f(100, 1, -9));
+
+  EXPECT_TRUE(frustum.intersects(inside));
+  EXPECT_FALSE(frustum.intersects(behind));
+  EXPECT_FALSE(frustum.intersects(beside));
+  EXPECT_FALSE(frustum.intersects(tooFar));
+  EXPECT_TRUE(frustum.intersects(straddling));
+  // Empty boxes denote unknown extents, and are never culled.
+  EXPECT_TRUE(frustum.intersects(Eigen::AlignedBox3f()));
+}
+
+TEST(FrustumTest, spheres)
+{
+  Frustum frustum(perspectiveCamera());
+
+  EXPECT_TRUE(frustum.intersects(Vector3f(0, 0, -10), 1.0f));
+  EXPECT_FALSE(frustum.intersects(Vector3f(0, 0, 10), 1.0f));
+  // Straddles the near plane.
+  EXPECT_TRUE(frustum.intersects(Vector3f(0, 0, -0.5f), 1.0f));
+}
+
+TEST(FrustumTest, projectedRadius)
+{
+  Frustum frustum(perspectiveCamera());
+
+  float nearRadius = frustum.projectedRadius(Vector3f(0, 0, -10), 1.0f);
+  float farRadius = frustum.projectedRadius(Vector3f(0, 0, -50), 1.0f);
+  EXPECT_GT(nearRadius, farRadius);
+  EXPECT_GT(farRadius, 0.0f);
+
+  // The box version uses the closest corner.
+  Eigen::AlignedBox3f box(Vector3f(-1, -1, -50), Vector3f(1, 1, -10));
+  EXPECT_FLOAT_EQ(nearRadius, frustum.projectedRadius(box, 1.0f));
+
+  Camera camera;
+  camera.setViewport(100, 100);
+  camera.calculateOrthographic(-10, 10, -10, 10, 1, 100);
+  frustum.setCamera(camera);
+  // 20 units span the 100 pixel viewport.
+  EXPECT_FLOAT_EQ(5.0f, frustum.projectedRadius(Vector3f(0, 0, -10), 1.0f));
+  EXPECT_FLOAT_EQ(5.0f, frustum.projectedRadius(Vector3f(0, 0, -90), 1.0f));
+}
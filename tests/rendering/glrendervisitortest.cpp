@@ -0,0 +1,127 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/rendering/ambientocclusionspheregeometry.h>
+#include <avogadro/rendering/camera.h>
+#include <avogadro/rendering/drawable.h>
+#include <avogadro/rendering/glrendervisitor.h>
+
+using Avogadro::Rendering::AmbientOcclusionBakeCache;
+using Avogadro::Rendering::AmbientOcclusionSphereGeometry;
+using Avogadro::Rendering::Camera;
+using Avogadro::Rendering::Drawable;
+using Avogadro::Rendering::GLRenderVisitor;
+using Avogadro::Vector3f;
+
+namespace {
+// Unit axes at the origin, counting the times they are rendered.
+class AxesDrawable : public Drawable
+{
+public:
+  AxesDrawable() : renderCount(0) {}
+
+  void render(const Camera&) override { ++renderCount; }
+  Eigen::AlignedBox3f boundingBox() const override
+  {
+    return Eigen::AlignedBox3f(Vector3f::Zero(), Vector3f::Ones());
+  }
+
+  int renderCount;
+};
+
+// A camera looking down the negative z axis, with the origin well outside of
+// its view.
+Camera offsetCamera()
+{
+  Camera camera;
+  camera.setViewport(100, 100);
+  camera.calculatePerspective(40, 1, 100);
+  camera.translate(Vector3f(50, 0, -10));
+  return camera;
+}
+}
+
+TEST(GLRenderVisitorTest, culling)
+{
+  GLRenderVisitor visitor(offsetCamera());
+  AxesDrawable axes;
+
+  visitor.setRenderPass(Avogadro::Rendering::OpaquePass);
+  visitor.visit(axes);
+  EXPECT_EQ(axes.renderCount, 0);
+
+  // Back in view.
+  Camera camera(offsetCamera());
+  camera.translate(Vector3f(-50, 0, 0));
+  visitor.setCamera(camera);
+  visitor.visit(axes);
+  EXPECT_EQ(axes.renderCount, 1);
+}
+
+TEST(GLRenderVisitorTest, overlays)
+{
+  // Overlays may be drawn with a camera of their own, they are not culled.
+  GLRenderVisitor visitor(offsetCamera());
+  AxesDrawable axes;
+
+  axes.setRenderPass(Avogadro::Rendering::Overlay3DPass);
+  visitor.setRenderPass(Avogadro::Rendering::Overlay3DPass);
+  visitor.visit(axes);
+  EXPECT_EQ(axes.renderCount, 1);
+
+  axes.setRenderPass(Avogadro::Rendering::Overlay2DPass);
+  visitor.setRenderPass(Avogadro::Rendering::Overlay2DPass);
+  visitor.visit(axes);
+  EXPECT_EQ(axes.renderCount, 2);
+
+  // Drawables of another pass are still skipped.
+  visitor.setRenderPass(Avogadro::Rendering::Overlay3DPass);
+  visitor.visit(axes);
+  EXPECT_EQ(axes.renderCount, 2);
+}
+
+TEST(GLRenderVisitorTest, bakeCache)
+{
+  // The cache of the renderer goes to the first ambient occlusion geometry
+  // only, the others keep their own.
+  GLRenderVisitor visitor;
+  AmbientOcclusionBakeCache cache;
+  visitor.setBakeCache(&cache);
+  EXPECT_EQ(visitor.bakeCache(), &cache);
+
+  AmbientOcclusionSphereGeometry first;
+  AmbientOcclusionSphereGeometry second;
+  AmbientOcclusionBakeCache* own = second.bakeCache();
+  EXPECT_NE(own, &cache);
+  for (int pass = 0; pass < 2; ++pass) {
+    visitor.setRenderPass(pass == 0 ? Avogadro::Rendering::OpaquePass
+                                    : Avogadro::Rendering::TranslucentPass);
+    visitor.visit(first);
+    visitor.visit(second);
+    EXPECT_EQ(first.bakeCache(), &cache);
+    EXPECT_EQ(second.bakeCache(), own);
+  }
+
+  // Without a cache, the geometries are left alone.
+  GLRenderVisitor other;
+  AmbientOcclusionSphereGeometry third;
+  own = third.bakeCache();
+  other.setRenderPass(Avogadro::Rendering::OpaquePass);
+  other.visit(third);
+  EXPECT_EQ(third.bakeCache(), own);
+}
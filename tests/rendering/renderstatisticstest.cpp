@@ -0,0 +1,107 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/rendering/renderstatistics.h>
+
+using Avogadro::Rendering::RenderStatistics;
+
+TEST(RenderStatisticsTest, disabled)
+{
+  RenderStatistics stats;
+  stats.beginFrame();
+  stats.beginSection("pass/opaque");
+  RenderStatistics::countDrawCall(6);
+  stats.endSection();
+  stats.addSceneTime("plugin/test", 1.0);
+  stats.endFrame();
+
+  EXPECT_TRUE(stats.frameTimings().empty());
+  EXPECT_TRUE(stats.sceneTimings().empty());
+  EXPECT_EQ(stats.drawCalls(), static_cast<size_t>(0));
+}
+
+TEST(RenderStatisticsTest, frame)
+{
+  RenderStatistics stats;
+  stats.setEnabled(true);
+  // No OpenGL context to run timer queries in.
+  stats.setGpuTimingEnabled(false);
+
+  stats.beginFrame();
+  stats.beginSection("pass/opaque");
+  stats.beginSection("drawable/spheres");
+  RenderStatistics::countDrawCall(6);
+  RenderStatistics::countUpload(128);
+  stats.endSection();
+  stats.beginSection("drawable/spheres");
+  RenderStatistics::countDrawCall(12);
+  stats.endSection();
+  // Left open, closed by the end of the frame.
+  stats.beginSection("pass/overlay2d");
+  stats.endFrame();
+
+  // Nothing is counted outside of a frame.
+  RenderStatistics::countDrawCall(100);
+
+  EXPECT_FALSE(stats.hasGpuTimings());
+  EXPECT_EQ(stats.drawCalls(), static_cast<size_t>(2));
+  EXPECT_EQ(stats.vertices(), static_cast<size_t>(18));
+  EXPECT_EQ(stats.uploadedBytes(), static_cast<size_t>(128));
+  ASSERT_EQ(stats.frameTimings().size(), static_cast<size_t>(3));
+  const RenderStatistics::Timing& spheres =
+    stats.frameTimings().find("drawable/spheres")->second;
+  const RenderStatistics::Timing& opaque =
+    stats.frameTimings().find("pass/opaque")->second;
+  EXPECT_EQ(spheres.calls, 2);
+  EXPECT_EQ(opaque.calls, 1);
+  EXPECT_GE(opaque.cpuTime, spheres.cpuTime);
+  EXPECT_GE(stats.frameTime().cpuTime, opaque.cpuTime);
+
+  // A new frame starts from scratch.
+  stats.beginFrame();
+  stats.endFrame();
+  EXPECT_TRUE(stats.frameTimings().empty());
+  EXPECT_EQ(stats.drawCalls(), static_cast<size_t>(0));
+}
+
+TEST(RenderStatisticsTest, json)
+{
+  RenderStatistics stats;
+  stats.setEnabled(true);
+  stats.setGpuTimingEnabled(false);
+  stats.beginScene();
+  stats.addSceneTime("plugin/Ball and \"Stick\"", 2.5);
+  stats.beginFrame();
+  stats.beginSection("pass/opaque");
+  RenderStatistics::countDrawCall(3);
+  stats.endSection();
+  stats.endFrame();
+
+  std::string json = stats.toJson();
+  EXPECT_NE(json.find("\"drawCalls\": 1"), std::string::npos);
+  EXPECT_NE(json.find("\"vertices\": 3"), std::string::npos);
+  EXPECT_NE(json.find("\"pass/opaque\": { \"cpuTime\": "), std::string::npos);
+  EXPECT_NE(json.find("\"plugin/Ball and \\\"Stick\\\"\": { \"cpuTime\": 2.5"),
+            std::string::npos);
+  EXPECT_EQ(json.find("gpuTime"), std::string::npos);
+
+  // Scene timings are kept until the scene is rebuilt.
+  EXPECT_EQ(stats.sceneTimings().size(), static_cast<size_t>(1));
+  stats.beginScene();
+  EXPECT_TRUE(stats.sceneTimings().empty());
+}
@@ -72,4 +72,37 @@ TEST(SphereGeometryTest, clear)
   EXPECT_EQ(node.size(), static_cast<size_t>(1));
   node.clear();
   EXPECT_EQ(node.size(), static_cast<size_t>(0));
+  EXPECT_TRUE(node.boundingBox().isEmpty());
+}
+
+TEST(SphereGeometryTest, boundingBox)
+{
+  SphereGeometry node;
+  EXPECT_TRUE(node.boundingBox().isEmpty());
+  node.addSphere(Vector3f(1.0, 2.0, 3.0), Vector3ub(200, 100, 50), 1.0);
+  node.addSphere(Vector3f(-1.0, 0.0, 5.0), Vector3ub(200, 100, 50), 2.0);
+  EXPECT_TRUE(node.boundingBox().min().isApprox(Vector3f(-3.0, -2.0, 2.0)));
+  EXPECT_TRUE(node.boundingBox().max().isApprox(Vector3f(2.0, 3.0, 7.0)));
+}
+
+TEST(SphereGeometryTest, translations)
+{
+  SphereGeometry node;
+  node.identifier().type = Avogadro::Rendering::AtomType;
+  node.addSphere(Vector3f(1.0, 2.0, 3.0), Vector3ub(200, 100, 50), 1.0);
+  std::vector<Vector3f> translations;
+  translations.push_back(Vector3f::Zero());
+  translations.push_back(Vector3f(10.0, 0.0, 0.0));
+  node.setTranslations(translations);
+  EXPECT_EQ(node.size(), static_cast<size_t>(1));
+  EXPECT_TRUE(node.boundingBox().min().isApprox(Vector3f(0.0, 1.0, 2.0)));
+  EXPECT_TRUE(node.boundingBox().max().isApprox(Vector3f(12.0, 3.0, 4.0)));
+
+  // The copy is picked as the sphere itself.
+  std::multimap<float, Avogadro::Rendering::Identifier> hits =
+    node.hits(Vector3f(11.0, 2.0, -10.0), Vector3f(11.0, 2.0, 10.0),
+              Vector3f(0.0, 0.0, 1.0));
+  ASSERT_EQ(hits.size(), static_cast<size_t>(1));
+  EXPECT_EQ(hits.begin()->second.index, static_cast<size_t>(0));
+  EXPECT_FLOAT_EQ(hits.begin()->first, 12.0f);
 }
@@ -0,0 +1,132 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2018 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/rendering/textlabelatlas.h>
+#include <avogadro/rendering/textproperties.h>
+#include <avogadro/rendering/textrenderstrategy.h>
+
+#include <algorithm>
+
+using Avogadro::Rendering::TextLabelAtlas;
+using Avogadro::Rendering::TextProperties;
+using Avogadro::Rendering::TextRenderStrategy;
+using Avogadro::Vector2i;
+
+namespace {
+// Renders each character as a 4x8 block filled with the character value, and
+// counts how many strings were rasterized.
+class BlockTextRenderStrategy : public TextRenderStrategy
+{
+public:
+  BlockTextRenderStrategy() : renderCount(0) {}
+
+  TextRenderStrategy* newInstance() const override
+  {
+    return new BlockTextRenderStrategy;
+  }
+
+  void boundingBox(const std::string& string, const TextProperties&,
+                   int bbox[4]) const override
+  {
+    bbox[0] = 0;
+    bbox[1] = static_cast<int>(string.size()) * 4 - 1;
+    bbox[2] = 0;
+    bbox[3] = 7;
+  }
+
+  void render(const std::string& string, const TextProperties&,
+              unsigned char* buffer, const Vector2i& dims) const override
+  {
+    ++renderCount;
+    for (int y = 0; y < dims[1]; ++y) {
+      for (int x = 0; x < dims[0]; ++x) {
+        unsigned char* pixel = buffer + 4 * (y * dims[0] + x);
+        std::fill(pixel, pixel + 4,
+                  static_cast<unsigned char>(string[x / 4]));
+      }
+    }
+  }
+
+  mutable int renderCount;
+};
+}
+
+TEST(TextLabelAtlasTest, caching)
+{
+  BlockTextRenderStrategy tren;
+  TextLabelAtlas atlas;
+  TextProperties tprop;
+
+  EXPECT_EQ(nullptr, atlas.entry("C", tprop));
+  atlas.setTextRenderStrategy(&tren);
+
+  const TextLabelAtlas::Entry* carbon = atlas.entry("C", tprop);
+  ASSERT_NE(nullptr, carbon);
+  EXPECT_EQ(Vector2i(4, 8), carbon->dimensions);
+  EXPECT_EQ(carbon, atlas.entry("C", tprop));
+  EXPECT_EQ(1, tren.renderCount);
+  EXPECT_TRUE(atlas.isModified());
+
+  // The rasterized string is copied into the atlas image.
+  const Vector2i dims = atlas.dimensions();
+  const size_t pixel =
+    4 * (static_cast<size_t>(carbon->origin[1]) * dims[0] + carbon->origin[0]);
+  EXPECT_EQ('C', atlas.image()[pixel]);
+
+  const TextLabelAtlas::Entry* hydrogen = atlas.entry("HH", tprop);
+  ASSERT_NE(nullptr, hydrogen);
+  EXPECT_EQ(Vector2i(8, 8), hydrogen->dimensions);
+  EXPECT_NE(carbon->origin, hydrogen->origin);
+
+  // Different properties are cached separately.
+  tprop.setBold(true);
+  atlas.entry("C", tprop);
+  EXPECT_EQ(3, tren.renderCount);
+  EXPECT_EQ(static_cast<size_t>(3), atlas.size());
+
+  // Changing the strategy invalidates the cache.
+  BlockTextRenderStrategy otherTren;
+  unsigned int generation = atlas.generation();
+  atlas.setTextRenderStrategy(&otherTren);
+  EXPECT_EQ(static_cast<size_t>(0), atlas.size());
+  EXPECT_NE(generation, atlas.generation());
+}
+
+TEST(TextLabelAtlasTest, overflow)
+{
+  BlockTextRenderStrategy tren;
+  // Room for two shelves of three single character strings.
+  TextLabelAtlas atlas(16, 18);
+  atlas.setTextRenderStrategy(&tren);
+  TextProperties tprop;
+
+  const unsigned int generation = atlas.generation();
+  const std::string strings("abcdef");
+  for (size_t i = 0; i < strings.size(); ++i)
+    EXPECT_NE(nullptr, atlas.entry(strings.substr(i, 1), tprop));
+  EXPECT_EQ(generation, atlas.generation());
+  EXPECT_EQ(static_cast<size_t>(6), atlas.size());
+
+  // The next string does not fit, so the atlas starts over.
+  EXPECT_NE(nullptr, atlas.entry("g", tprop));
+  EXPECT_NE(generation, atlas.generation());
+  EXPECT_EQ(static_cast<size_t>(1), atlas.size());
+
+  // Strings wider than the atlas are rejected.
+  EXPECT_EQ(nullptr, atlas.entry("wider than sixteen", tprop));
+}